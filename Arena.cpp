@@ -0,0 +1,34 @@
+#include "Arena.h"
+
+Arena::Arena(void* memory, size_t size) {
+  // The usable part starts and ends on the alignment
+  uintptr_t start = ((uintptr_t)memory + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+  size_t skipped = start - (uintptr_t)memory;
+  _memory = (uint8_t*)start;
+  _size = size > skipped ? (size - skipped) & ~(size_t)(ARENA_ALIGN - 1) : 0;
+  _used = 0;
+  _highWater = 0;
+  _failures = 0;
+}
+
+void* Arena::allocate(size_t size) {
+  size_t needed = footprint(size);
+  if (size == 0 || needed > _size - _used) {
+    _failures++;
+    return NULL;
+  }
+
+  void* block = _memory + _used;
+  _used += needed;
+  if (_used > _highWater) {
+    _highWater = _used;
+  }
+  return block;
+}
+
+void Arena::release(size_t mark) {
+  // Scopes end in reverse order, an older mark never lies above the level
+  if (mark < _used) {
+    _used = mark;
+  }
+}
\ No newline at end of file
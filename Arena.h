@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// Scoped allocation from one block reserved at boot
+//
+// Allocations only move a fill level up. ArenaScope remembers the level and
+// puts it back when it goes out of scope, which frees everything allocated
+// since in one step, so the block never fragments however requests of
+// different sizes interleave. A request that does not fit gets NULL and is
+// counted; the high-water mark shows what the heaviest request so far needed.
+//
+// No Arduino dependencies, the arena can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ARENA_ALIGN 4
+
+class Arena {
+  public:
+    Arena(void* memory, size_t size);
+
+    void* allocate(size_t size);
+    // Bytes allocate() takes for a request of size, alignment included
+    static size_t footprint(size_t size) { return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1); }
+
+    size_t mark() { return _used; }
+    void release(size_t mark);
+
+    size_t getSize() { return _size; }
+    size_t getUsed() { return _used; }
+    size_t getFree() { return _size - _used; }
+    size_t getHighWater() { return _highWater; }
+    uint32_t getFailures() { return _failures; }
+
+  private:
+    uint8_t* _memory;
+    size_t _size;
+    size_t _used;
+    size_t _highWater;
+    uint32_t _failures;
+};
+
+// Everything allocated while a scope lives is released with it
+class ArenaScope {
+  public:
+    ArenaScope(Arena& arena) : _arena(arena), _mark(arena.mark()) {}
+    ~ArenaScope() { _arena.release(_mark); }
+
+  private:
+    Arena& _arena;
+    size_t _mark;
+};
+
+#endif
\ No newline at end of file
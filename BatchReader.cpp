@@ -0,0 +1,247 @@
+#include "BatchReader.h"
+#include "HexDecode.h"
+#include <string.h>
+
+// Fields seen in the current object
+#define FIELD_OP      0x01
+#define FIELD_BARCODE 0x02
+#define FIELD_REPEAT  0x04
+#define FIELD_PP4     0x08
+#define FIELD_TYPE    0x10
+#define FIELD_DATA    0x20
+#define FIELD_BITMAP  0x40
+
+static const char* OP_NAMES[BATCH_OP_COUNT] = {
+  "ping", "refresh", "raw", "segments"
+};
+
+// Fields each operation accepts, and those it needs
+static const uint8_t OP_ALLOWED[BATCH_OP_COUNT] = {
+  FIELD_OP | FIELD_BARCODE | FIELD_REPEAT | FIELD_PP4,
+  FIELD_OP | FIELD_BARCODE | FIELD_PP4,
+  FIELD_OP | FIELD_BARCODE | FIELD_REPEAT | FIELD_TYPE | FIELD_DATA,
+  FIELD_OP | FIELD_BARCODE | FIELD_BITMAP
+};
+static const uint8_t OP_REQUIRED[BATCH_OP_COUNT] = {
+  FIELD_OP | FIELD_BARCODE,
+  FIELD_OP | FIELD_BARCODE,
+  FIELD_OP | FIELD_BARCODE | FIELD_REPEAT | FIELD_TYPE | FIELD_DATA,
+  FIELD_OP | FIELD_BARCODE | FIELD_BITMAP
+};
+
+static bool matches(const char* value, size_t length, const char* literal) {
+  return strlen(literal) == length && memcmp(value, literal, length) == 0;
+}
+
+BatchReader::BatchReader(const char* text, size_t length) {
+  _text = text;
+  _end = text + length;
+  rewind();
+}
+
+void BatchReader::rewind() {
+  _pos = _text;
+  _error = NULL;
+  _index = 0;
+  _started = false;
+  _finished = false;
+}
+
+const char* BatchReader::opName(uint8_t type) {
+  return type < BATCH_OP_COUNT ? OP_NAMES[type] : "unknown";
+}
+
+bool BatchReader::fail(const char* error) {
+  _error = error;
+  _finished = true;
+  return false;
+}
+
+void BatchReader::skipSpace() {
+  while (_pos < _end && (*_pos == ' ' || *_pos == '\t' || *_pos == '\r' || *_pos == '\n')) {
+    _pos++;
+  }
+}
+
+bool BatchReader::expect(char c) {
+  skipSpace();
+  if (_pos >= _end || *_pos != c) {
+    return false;
+  }
+  _pos++;
+  return true;
+}
+
+bool BatchReader::readString(const char** value, size_t* length) {
+  if (!expect('"')) {
+    return false;
+  }
+
+  // Barcodes, names and hex never need escapes, so none are accepted
+  const char* start = _pos;
+  while (_pos < _end && *_pos != '"') {
+    if (*_pos == '\\' || (uint8_t)*_pos < 0x20) {
+      return false;
+    }
+    _pos++;
+  }
+  if (_pos >= _end) {
+    return false;
+  }
+
+  *value = start;
+  *length = _pos - start;
+  _pos++;
+  return true;
+}
+
+bool BatchReader::readNumber(uint32_t* value) {
+  skipSpace();
+  const char* start = _pos;
+  *value = 0;
+  while (_pos < _end && *_pos >= '0' && *_pos <= '9') {
+    if (*value > 100000) {
+      return false;
+    }
+    *value = *value * 10 + (*_pos - '0');
+    _pos++;
+  }
+  return _pos > start;
+}
+
+bool BatchReader::readBool(bool* value) {
+  skipSpace();
+  if (_end - _pos >= 4 && memcmp(_pos, "true", 4) == 0) {
+    *value = true;
+    _pos += 4;
+    return true;
+  }
+  if (_end - _pos >= 5 && memcmp(_pos, "false", 5) == 0) {
+    *value = false;
+    _pos += 5;
+    return true;
+  }
+  return false;
+}
+
+bool BatchReader::next(BatchOp* op) {
+  if (_finished) {
+    return false;
+  }
+
+  // Array brackets and the commas between operations
+  if (!_started) {
+    if (!expect('[')) {
+      return fail("Body must be a JSON array");
+    }
+    _started = true;
+    if (expect(']')) {
+      _finished = true;
+    }
+  } else if (expect(']')) {
+    _finished = true;
+  } else if (!expect(',')) {
+    return fail("Expected , or ] after an operation");
+  }
+
+  if (_finished) {
+    skipSpace();
+    return _pos == _end ? false : fail("Data after the array");
+  }
+
+  if (_index >= BATCH_MAX_OPS) {
+    return fail("Too many operations");
+  }
+
+  memset(op, 0, sizeof(*op));
+  op->type = BATCH_OP_COUNT;
+  uint8_t fields = 0;
+
+  if (!expect('{')) {
+    return fail("Operation must be an object");
+  }
+
+  if (!expect('}')) {
+    do {
+      const char* key;
+      size_t keyLength;
+      if (!readString(&key, &keyLength) || !expect(':')) {
+        return fail("Malformed field");
+      }
+
+      const char* value;
+      size_t length;
+      uint32_t number;
+      if (matches(key, keyLength, "op")) {
+        if (!readString(&value, &length)) {
+          return fail("op must be a string");
+        }
+        for (uint8_t t = 0; t < BATCH_OP_COUNT; t++) {
+          if (matches(value, length, OP_NAMES[t])) {
+            op->type = t;
+          }
+        }
+        if (op->type == BATCH_OP_COUNT) {
+          return fail("op must be ping, refresh, raw or segments");
+        }
+        fields |= FIELD_OP;
+      } else if (matches(key, keyLength, "barcode")) {
+        if (!readString(&value, &length) || length != BATCH_BARCODE_LENGTH) {
+          return fail("barcode must be 17 characters");
+        }
+        memcpy(op->barcode, value, length);
+        op->barcode[length] = '\0';
+        fields |= FIELD_BARCODE;
+      } else if (matches(key, keyLength, "repeat")) {
+        if (!readNumber(&number) || number == 0 || number > 0xFFFF) {
+          return fail("repeat must be between 1 and 65535");
+        }
+        op->repeats = number;
+        fields |= FIELD_REPEAT;
+      } else if (matches(key, keyLength, "pp4")) {
+        if (!readBool(&op->forcePP4)) {
+          return fail("pp4 must be true or false");
+        }
+        fields |= FIELD_PP4;
+      } else if (matches(key, keyLength, "type")) {
+        if (!readString(&value, &length) || !(matches(value, length, "DM") || matches(value, length, "SEG"))) {
+          return fail("type must be DM or SEG");
+        }
+        op->segmentType = value[0] == 'S';
+        fields |= FIELD_TYPE;
+      } else if (matches(key, keyLength, "data")) {
+        if (!readString(&value, &length) ||
+            !decodeHex(value, length, op->data, BATCH_MAX_DATA, &op->dataSize) || op->dataSize == 0) {
+          return fail("data must be 1 to 240 bytes of hex");
+        }
+        fields |= FIELD_DATA;
+      } else if (matches(key, keyLength, "bitmap")) {
+        if (!readString(&value, &length) ||
+            !decodeHex(value, length, op->data, BATCH_BITMAP_SIZE, &op->dataSize) ||
+            op->dataSize != BATCH_BITMAP_SIZE) {
+          return fail("bitmap must be exactly 46 hex digits");
+        }
+        fields |= FIELD_BITMAP;
+      } else {
+        return fail("Unknown field");
+      }
+    } while (expect(','));
+
+    if (!expect('}')) {
+      return fail("Expected , or } in an operation");
+    }
+  }
+
+  if (!(fields & FIELD_OP)) {
+    return fail("Missing op");
+  }
+  if ((fields & OP_REQUIRED[op->type]) != OP_REQUIRED[op->type]) {
+    return fail("Missing field for this op");
+  }
+  if (fields & ~OP_ALLOWED[op->type]) {
+    return fail("Field not valid for this op");
+  }
+
+  _index++;
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef BATCH_READER_H
+#define BATCH_READER_H
+
+// Pull parser for /batch request bodies, one operation at a time
+//
+// The body is a JSON array of flat objects, for example
+//   [{"op":"ping","barcode":"04123456789012345","repeat":400},
+//    {"op":"raw","barcode":"...","type":"DM","data":"85AB00","repeat":10},
+//    {"op":"segments","barcode":"...","bitmap":"<46 hex digits>"},
+//    {"op":"refresh","barcode":"...","pp4":true}]
+// next() scans the text in place and fills one BatchOp, no document tree is
+// built. Every operation is checked completely, so a first pass with the same
+// reader validates a whole batch before anything is queued.
+//
+// No Arduino dependencies, the parser can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BATCH_MAX_OPS 128
+#define BATCH_BARCODE_LENGTH 17
+#define BATCH_MAX_DATA 240
+#define BATCH_BITMAP_SIZE 23
+
+enum BatchOpType {
+  BATCH_OP_PING = 0,
+  BATCH_OP_REFRESH,
+  BATCH_OP_RAW,
+  BATCH_OP_SEGMENTS,
+  BATCH_OP_COUNT
+};
+
+struct BatchOp {
+  uint8_t type;                 // BatchOpType
+  char barcode[BATCH_BARCODE_LENGTH + 1];
+  uint16_t repeats;             // 0 = the operation's default
+  bool forcePP4;
+  bool segmentType;             // raw: "SEG" instead of "DM"
+  uint8_t data[BATCH_MAX_DATA]; // raw command bytes or segment bitmap
+  uint16_t dataSize;
+};
+
+class BatchReader {
+  public:
+    BatchReader(const char* text, size_t length);
+
+    // Start over at the first operation
+    void rewind();
+
+    // Read the next operation, false at the end of the array or on an error
+    bool next(BatchOp* op);
+
+    // Set once next() has returned false because of bad input
+    const char* getError() { return _error; }
+    // Operations read so far, on error the index of the bad one
+    uint16_t getIndex() { return _index; }
+
+    static const char* opName(uint8_t type);
+
+  private:
+    const char* _text;
+    const char* _end;
+    const char* _pos;
+    const char* _error;
+    uint16_t _index;
+    bool _started;
+    bool _finished;
+
+    void skipSpace();
+    bool expect(char c);
+    bool readString(const char** value, size_t* length);
+    bool readNumber(uint32_t* value);
+    bool readBool(bool* value);
+    bool fail(const char* error);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef CARRIER_KERNEL_H
+#define CARRIER_KERNEL_H
+
+#include <Arduino.h>
+
+// Emits exactly N nop instructions, unrolled at compile time
+template<uint32_t N>
+struct Nops {
+  static inline void emit() __attribute__((always_inline)) {
+    __asm__ __volatile__("nop");
+    Nops<N - 1>::emit();
+  }
+};
+
+template<>
+struct Nops<0> {
+  static inline void emit() __attribute__((always_inline)) {}
+};
+
+// Square-wave carrier generator specialized for one CPU clock and carrier frequency
+// Trim shifts both half periods by a few cycles; the boot calibration picks the
+// instantiation whose measured period is closest to nominal
+template<uint32_t CpuMHz, uint32_t CarrierKHz, int32_t Trim>
+struct CarrierKernel {
+  // Cycles spent per half period on the GPIO store and loop bookkeeping,
+  // as assumed by the original hand-written 160MHz loop (54 nops + 10)
+  static constexpr uint32_t OVERHEAD_CYCLES = 10;
+
+  static constexpr uint32_t PERIOD_CYCLES = CpuMHz * 1000 / CarrierKHz;
+  static constexpr uint32_t HALF_CYCLES = PERIOD_CYCLES / 2;
+  static constexpr uint32_t NOPS = HALF_CYCLES - OVERHEAD_CYCLES + Trim;
+
+  static_assert(PERIOD_CYCLES * CarrierKHz == CpuMHz * 1000, "Carrier period must be a whole number of cycles");
+  static_assert(HALF_CYCLES > OVERHEAD_CYCLES + 4, "CPU clock too slow for this carrier");
+
+  static constexpr uint32_t periodsFor(uint32_t durationUs) {
+    return durationUs * CarrierKHz / 1000;
+  }
+
+  // Caller masks interrupts; must be inlined into an ICACHE_RAM_ATTR function
+  static inline void run(uint32_t pinMask, uint32_t periods) __attribute__((always_inline)) {
+    for (uint32_t i = 0; i < periods; i++) {
+      GPOS = pinMask;
+      Nops<NOPS>::emit();
+      GPOC = pinMask;
+      Nops<NOPS>::emit();
+    }
+  }
+};
+
+typedef void (*CarrierKernelFn)(uint32_t pinMask, uint32_t periods);
+
+struct CarrierKernelInfo {
+  uint8_t cpuMHz;
+  int8_t trim;
+  CarrierKernelFn run;
+};
+
+#endif
\ No newline at end of file
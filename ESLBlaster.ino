@@ -13,7 +13,6 @@
 #include <ESP8266HTTPClient.h>
 #include <Wire.h>
 #include "SSD1306Wire.h"
-#include <ArduinoJson.h>
 #include <EEPROM.h>
 #include <user_interface.h> // For system_update_cpu_freq()
 #include <FS.h>         // For SPIFFS file system
@@ -22,11 +21,21 @@
 #include "WebInterface.h"
 #include "OLEDInterface.h"
 #include "ESLProtocol.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "JobSpool.h"
+#include "FlashJobs.h"
+#include "TagProfiles.h"
+#include "WiFiLink.h"
+#include "Arena.h"
+#include "TagRegistry.h"
+#include <time.h>
 
 // Wi-Fi settings (will be loaded from EEPROM)
-char ssid[32] = "YOUR_WIFI_SSID";
-char password[64] = "YOUR_WIFI_PASSWORD";
+char ssid[WIFI_SSID_LENGTH + 1] = "YOUR_WIFI_SSID";
+char password[WIFI_PASSWORD_LENGTH + 1] = "YOUR_WIFI_PASSWORD";
 bool apMode = false;
+bool reuseLease = false;  // Fast boot takes the last DHCP lease as a static address
 
 // Version information
 const char* FW_VERSION = "1.0.0";
@@ -34,24 +43,97 @@ const char* HW_VERSION = "A";
 
 // Objects initialization
 ESP8266WebServer server(80);
-SSD1306Wire display(0x3c, SDA, SCL, GEOMETRY_64_48); // 0x3c is the I2C address
+SSD1306Wire display(OLED_I2C_ADDRESS, SDA, SCL, GEOMETRY_64_48);
 IRTransmitter irTransmitter(4); // D2 (GPIO4)
 OLEDInterface oledInterface(&display);
+WiFiLink wifiLink;
 WebInterface webInterface(&server, &irTransmitter, &oledInterface);
 ESLProtocol eslProtocol(&irTransmitter);
+Metrics metrics;
+Profiler profiler;
+
+// Image buffers come from here instead of the heap, which they fragmented;
+// uploads are admitted against it before anything is staged
+#define IMAGE_ARENA_SIZE 24576
+static uint8_t imageArenaMemory[IMAGE_ARENA_SIZE] __attribute__((aligned(4)));
+Arena imageArena(imageArenaMemory, sizeof(imageArenaMemory));
+
+// Scheduled jobs survive reboots in /spool, timed by NTP
+uint32_t spoolClock();
+uint32_t spoolMillis();
+LittleFSSpoolStorage spoolStorage(LittleFS, "/spool");
+JobSpool jobSpool(spoolStorage, spoolClock, spoolMillis);
+
+// How long a tag keeps listening after its last frame; a preempted job
+// that resumes later than this sends its wake-up ping again
+#define TAG_AWAKE_MS 3000
+FlashJobArea flashJobs;
+
+// Encoding and timing per tag model, from /profiles.txt
+TagProfiles tagProfiles;
+
+// Models, groups and statistics per tag, hashed by PLID into /tags
+LittleFSSpoolStorage tagStorage(LittleFS, "/tags");
+TagRegistry tagRegistry(tagStorage, tagProfiles, spoolClock, spoolMillis);
 
 // Stats tracking
 unsigned long lastActivityTime = 0;
-unsigned long totalFramesSent = 0;
 unsigned long uptimeStart = 0;
 unsigned long lastIpCheck = 0;
+unsigned long lastDashboard = 0;
+
+// Boot timeline, milliseconds since reset at the end of each phase
+#define BOOT_MAX_PHASES 10
+#define SPLASH_MS 1500
+struct BootPhase {
+  const char* name;
+  uint32_t atMs;
+};
+BootPhase bootPhases[BOOT_MAX_PHASES];
+uint8_t bootPhaseCount = 0;
+uint32_t bootReadyMs = 0;  // Network up and serving, 0 until then
+
+// Association of the last link in EEPROM after the settings; flash rather than
+// RTC memory so it survives the power loss of a brownout
+#define LINK_CACHE_ADDRESS 100
+#define LINK_CACHE_MARKER 0xA5
+struct StoredLinkCache {
+  uint8_t marker;
+  uint32_t ssidHash;        // Cache belongs to this network
+  WiFiLinkCache cache;
+};
+
+// Frames come back to back while a job or a serial stream runs, the display
+// waits for a pause this long before drawing
+#define OLED_QUIET_MS 50
+uint32_t lastIrFrameMs = 0;
+
+// Tags of the spool job being sent, with the address bytes their frames carry
+struct JobTag {
+  char barcode[SPOOL_BARCODE_LENGTH + 1];
+  uint8_t address[4];
+};
+JobTag jobTags[SPOOL_MAX_BARCODES];
+uint8_t jobTagCount = 0;
+uint32_t jobTagsOf = SPOOL_NO_JOB;
 
 // Function prototypes
 void loadSettings();
 void saveSettings();
 void setupWiFi();
-void startAPMode();
+void showWiFiState();
+void commitWiFi(void* context, const char* newSsid, const char* newPassword, bool newApMode);
+void bootMark(const char* phase);
+bool loadLinkCache(WiFiLinkCache* cache);
+void saveLinkCache(const WiFiLinkCache& cache);
 void handleSerialCommands();
+bool sendSpooledFrame(void* context, const SpoolFrame& frame);
+void loadJobTags(const SpoolJobInfo& job);
+void useFrameProfile(const uint8_t* frameData, uint8_t frameSize);
+void serviceSpool();
+void spoolJobDone(void* context, const SpoolJobInfo& job, bool completed, uint32_t latencyMs);
+bool irActive(void* context);
+void updateDashboard();
 
 void setup() {
   // Initialize serial
@@ -66,70 +148,93 @@ void setup() {
   
   // Load settings
   loadSettings();
+  bootMark("settings");
+  
+  // Association runs in the background while the rest is set up
+  setupWiFi();
+  bootMark("wifi_begin");
   
   // Initialize IR transmitter
   irTransmitter.begin();
+  irTransmitter.addChannel(14); // D5 (GPIO14), second emitter for /ping-parallel
+  bootMark("ir");
   
-  // Initialize OLED
+  // Initialize OLED, the splash stays up until loop() replaces it
   oledInterface.begin();
+  oledInterface.setBusyCheck(irActive, NULL);
   oledInterface.showSplashScreen("ESLBlaster", FW_VERSION);
-  delay(1500);
+  bootMark("oled");
   
   // Initialize file system for image uploads
   if (!LittleFS.begin()) {
     Serial.println("Failed to initialize LittleFS");
     oledInterface.showError("FS Init Failed");
-    delay(2000);
   } else {
     Serial.println("File system initialized");
+    
+    if (tagProfiles.loadFile(LittleFS)) {
+      Serial.printf("Tag profiles: %u models, %u assignments\n",
+                    tagProfiles.getProfileCount(), tagProfiles.getAssignmentCount());
+    } else {
+      Serial.printf("Tag profiles not loaded, line %u: %s\n", tagProfiles.getErrorLine(),
+                    tagProfiles.getError() ? tagProfiles.getError() : "read failed");
+    }
+    
+    if (tagRegistry.begin()) {
+      Serial.printf("Tag registry: %u of %u tags\n", tagRegistry.getCount(), tagRegistry.getCapacity());
+    }
+    if (tagRegistry.getError()) {
+      Serial.printf("Tag registry: %s\n", tagRegistry.getError());
+    }
+    
+    jobSpool.setFrameRoles(FRAME_PING, FRAME_DATA, TAG_AWAKE_MS);
+    jobSpool.setDoneHandler(spoolJobDone, NULL);
+    if (jobSpool.begin()) {
+      Serial.printf("Job spool: %u jobs queued\n", jobSpool.getJobCount());
+    }
+    if (flashJobs.begin(jobSpool)) {
+      Serial.printf("Compiled jobs: %u in %lu of %lu bytes\n", flashJobs.getJobCount(),
+                    (unsigned long)flashJobs.getUsed(), (unsigned long)flashJobs.getSize());
+    }
   }
+  bootMark("fs");
   
-  // Set up WiFi
-  setupWiFi();
+  // UTC wall clock for the job spool, set in the background once online
+  configTime(0, 0, "pool.ntp.org", "time.nist.gov");
   
   // Initialize web server routes
   webInterface.setupRoutes();
   
-  // Start the server
+  // Start the server, it answers as soon as the link is up
   server.begin();
   Serial.println("HTTP server started");
+  bootMark("server");
   
   // Initialize stats
   uptimeStart = millis();
   
-  // Ready to use - verify we have a valid IP before showing ready
-  delay(1000); // Extra delay to ensure network is stable
-  
-  IPAddress currentIP;
-  String ipString;
-  
-  if (WiFi.getMode() == WIFI_STA) {
-    currentIP = WiFi.localIP();
-    ipString = currentIP.toString();
-    // Double-check that we have a valid IP
-    if (currentIP[0] == 0) {
-      ipString = "No IP - Check WiFi";
-    }
-  } else {
-    currentIP = WiFi.softAPIP();
-    ipString = "AP: " + currentIP.toString();
-  }
-  
-  oledInterface.showMainScreen("Ready", ipString);
-
   // Serial protocol indicator
   Serial.println("ESLBlaster" + String(HW_VERSION) + "1");
 }
 
 void loop() {
+  profiler.beginLoop();
+  
   // Handle incoming web requests
   server.handleClient();
+  profiler.mark(PROF_HANDLE_CLIENT);
   
   // Handle serial commands
   handleSerialCommands();
+  profiler.mark(PROF_SERIAL);
   
   // Update OLED display
+  if (millis() - lastDashboard >= 1000) {
+    lastDashboard = millis();
+    updateDashboard();
+  }
   oledInterface.update();
+  profiler.mark(PROF_OLED);
   
   // Periodically check and update IP address if it changes
   if (millis() - lastIpCheck > 10000) { // Check every 10 seconds
@@ -141,62 +246,173 @@ void loop() {
     if (WiFi.getMode() == WIFI_STA && WiFi.status() == WL_CONNECTED) {
       currentIP = WiFi.localIP();
       ipString = currentIP.toString();
-      // Only update if we have a valid IP and not already showing it
+      // Only update if we have a valid IP; the same screen again draws nothing
       if (currentIP[0] != 0) {
-        oledInterface.showMainScreen("Ready", ipString);
+        oledInterface.showMainScreen("Ready", ipString.c_str());
       }
     }
   }
   
-  // Reconnect WiFi if disconnected (only if in STA mode)
-  static unsigned long lastWifiCheck = 0;
-  if (WiFi.getMode() == WIFI_STA && millis() - lastWifiCheck > 30000) { // Every 30 seconds
-    lastWifiCheck = millis();
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi disconnected. Reconnecting...");
-      oledInterface.showStatus("WiFi", "Reconnecting...");
-      WiFi.reconnect();
-      
-      // Wait up to 10 seconds for reconnection
-      int attempts = 0;
-      while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        attempts++;
-      }
-      
-      if (WiFi.status() == WL_CONNECTED) {
-        oledInterface.showMainScreen("Ready", WiFi.localIP().toString());
-      } else {
-        oledInterface.showStatus("WiFi Failed", "Check Settings");
-      }
+  // Connect and reconnect without waiting, IR and serial work carry on meanwhile
+  static bool splashDone = false;
+  bool linkChanged = wifiLink.service();
+  if (linkChanged || (!splashDone && millis() >= SPLASH_MS)) {
+    splashDone = true;
+    showWiFiState();
+  }
+  if (linkChanged && wifiLink.isConnected()) {
+    saveLinkCache(wifiLink.getCache());
+  }
+  if (bootReadyMs == 0 && (wifiLink.isConnected() || wifiLink.getState() == WIFI_LINK_AP)) {
+    bootMark(wifiLink.isConnected() ? "link" : "ap");
+    bootReadyMs = millis();
+    Serial.print("Boot timeline (ms):");
+    for (uint8_t i = 0; i < bootPhaseCount; i++) {
+      Serial.printf(" %s %lu", bootPhases[i].name, (unsigned long)bootPhases[i].atMs);
     }
+    Serial.println();
   }
   
+  profiler.mark(PROF_WIFI);
+  
+  // Send the next frame of a due spooled job, one frame per iteration
+  serviceSpool();
+  tagRegistry.service();
+  profiler.mark(PROF_SPOOL);
+  
+  // Track worst-case loop iteration time for /metrics
+  metrics.recordLoop(profiler.endLoop());
+  
   // Perform any background tasks
-  yield();
+  profiler.yieldNow();
+}
+
+uint32_t spoolMillis() {
+  return millis();
+}
+
+uint32_t spoolClock() {
+  // Anything before 2020 means NTP has not answered yet
+  time_t now = time(nullptr);
+  return now > 1577836800 ? (uint32_t)now : 0;
+}
+
+void updateDashboard() {
+  OLEDDashboard dashboard;
+  MetricsRecent recent;
+  metrics.getRecent(&recent);
+
+  uint32_t windowMs = METRICS_HISTORY_SECONDS * 1000UL;
+  dashboard.queueDepth = jobSpool.getJobCount();
+  dashboard.framesPerSecond10 = recent.frames * 10 / METRICS_HISTORY_SECONDS;
+  dashboard.utilization = min(recent.airtimeMs, windowMs) * 100 / windowMs;
+  dashboard.wakeShare = recent.airtimeMs ? (uint64_t)recent.wakeAirtimeMs * 100 / recent.airtimeMs : 0;
+  dashboard.freeHeap = ESP.getFreeHeap();
+  dashboard.rssi = wifiLink.isConnected() ? WiFi.RSSI() : 0;
+  metrics.getUtilizationHistory(dashboard.history, OLED_SPARK_POINTS);
+  oledInterface.setDashboard(dashboard);
+}
+
+bool irActive(void* context) {
+  return irTransmitter.isBusy() || millis() - lastIrFrameMs < OLED_QUIET_MS;
+}
+
+bool sendSpooledFrame(void* context, const SpoolFrame& frame) {
+  useFrameProfile(frame.data, frame.size);
+  return eslProtocol.transmitEncodedFrame(frame.type, (uint8_t*)frame.data, frame.size, frame.repeats);
+}
+
+void loadJobTags(const SpoolJobInfo& job) {
+  jobTagCount = 0;
+  for (uint8_t i = 0; i < job.barcodeCount; i++) {
+    JobTag& tag = jobTags[jobTagCount];
+    if (jobSpool.getBarcode(job.id, i, tag.barcode)) {
+      uint8_t PLID[4];
+      eslProtocol.getPLIDFromBarcode(tag.barcode, PLID);
+      tag.address[0] = PLID[3];
+      tag.address[1] = PLID[2];
+      tag.address[2] = PLID[1];
+      tag.address[3] = PLID[0];
+      jobTagCount++;
+    }
+  }
+  jobTagsOf = job.id;
+}
+
+// Frames were encoded for their tag's model, its gap applies again on replay
+// and the airtime goes to that tag. Every frame names its tag in bytes 1-4,
+// so each frame of a group or batch job finds its own; frames of no listed
+// tag fall back to the job's first one. Set per frame since requests sent
+// in between may have changed the profile
+void useFrameProfile(const uint8_t* frameData, uint8_t frameSize) {
+  if (jobTagCount == 0) {
+    eslProtocol.useProfile("");
+    return;
+  }
+  uint8_t match = 0;
+  for (uint8_t i = 1; i < jobTagCount && frameSize >= 5; i++) {
+    if (memcmp(jobTags[i].address, frameData + 1, 4) == 0) {
+      match = i;
+      break;
+    }
+  }
+  eslProtocol.useProfile(jobTags[match].barcode);
+}
+
+void serviceSpool() {
+  SpoolJobInfo job;
+  uint16_t frameIndex;
+  if (!jobSpool.getDueJob(&job, &frameIndex)) {
+    return;
+  }
+  if (job.id != jobTagsOf) {
+    loadJobTags(job);
+  }
+  
+  // Compiled jobs are sent straight from the flash mapping, no copy into RAM
+  FlashFrame frame;
+  if (flashJobs.getFrame(job, frameIndex, &frame)) {
+    uint32_t head[2] = { frame.words[0], frame.size > 4 ? frame.words[1] : 0 };
+    useFrameProfile((const uint8_t*)head, frame.size);
+    eslProtocol.transmitMappedFrame(frame.type, frame.words, frame.size, frame.repeats);
+    jobSpool.frameSent(job.id, frameIndex, frame.size);
+  } else {
+    jobSpool.service(sendSpooledFrame, NULL);
+  }
+  lastIrFrameMs = millis();
+}
+
+// Spooled jobs count in /metrics like those sent right away, their latency
+// includes the wait in the queue
+void spoolJobDone(void* context, const SpoolJobInfo& job, bool completed, uint32_t latencyMs) {
+  metrics.recordJob(completed ? JOB_OK : JOB_FAILED, latencyMs);
 }
 
 void loadSettings() {
   // Read settings from EEPROM
   if (EEPROM.read(0) == 0xAA) {
-    // Valid settings marker found
+    // Valid settings marker found; values of the full length have no terminator
     int i = 0;
-    for (i = 0; i < 32; i++) {
+    for (i = 0; i < WIFI_SSID_LENGTH; i++) {
       ssid[i] = EEPROM.read(i + 1);
       if (ssid[i] == 0) break;
     }
+    ssid[i] = '\0';
     
-    for (i = 0; i < 64; i++) {
+    for (i = 0; i < WIFI_PASSWORD_LENGTH; i++) {
       password[i] = EEPROM.read(i + 33);
       if (password[i] == 0) break;
     }
+    password[i] = '\0';
     
     apMode = EEPROM.read(97) == 1;
+    reuseLease = EEPROM.read(98) == 1;
   } else {
     // No valid settings, use defaults
     strcpy(ssid, "YOUR_WIFI_SSID");
     strcpy(password, "YOUR_WIFI_PASSWORD");
     apMode = false;
+    reuseLease = false;
   }
 }
 
@@ -205,94 +421,119 @@ void saveSettings() {
   EEPROM.write(0, 0xAA);  // Valid settings marker
   
   // Write SSID
-  for (int i = 0; i < 32; i++) {
+  for (int i = 0; i < WIFI_SSID_LENGTH; i++) {
     EEPROM.write(i + 1, ssid[i]);
     if (ssid[i] == 0) break;
   }
   
   // Write password
-  for (int i = 0; i < 64; i++) {
+  for (int i = 0; i < WIFI_PASSWORD_LENGTH; i++) {
     EEPROM.write(i + 33, password[i]);
     if (password[i] == 0) break;
   }
   
   // Write AP mode flag
   EEPROM.write(97, apMode ? 1 : 0);
+  EEPROM.write(98, reuseLease ? 1 : 0);
   
   EEPROM.commit();
 }
 
 void setupWiFi() {
-  // Always start in station mode first (unless explicitly set to AP mode)
+  // Settings changed at runtime reach EEPROM only once they have worked
+  wifiLink.setCommitHandler(commitWiFi, NULL);
+  
+  // Station mode unless explicitly set to AP mode; returns before the link is up
   if (apMode) {
-    startAPMode();
+    wifiLink.startAccessPoint();
   } else {
-    // Try to connect to WiFi
-    oledInterface.showStatus("Connecting", "to WiFi...");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
-    
-    int wifiAttempts = 0;
-    bool connected = false;
-    
-    // Wait longer for connection (30 attempts * 500ms = 15 seconds max)
-    while (wifiAttempts < 30) {
-      if (WiFi.status() == WL_CONNECTED) {
-        connected = true;
-        break;
-      }
-      delay(500);
-      Serial.print(".");
-      wifiAttempts++;
-    }
-    
-    if (connected) {
-      // Successfully connected
-      Serial.println("\nWiFi connected");
-      Serial.print("IP address: ");
-      Serial.println(WiFi.localIP());
-      
-      // Make sure IP is valid before showing it
-      IPAddress ip = WiFi.localIP();
-      if (ip[0] != 0) {
-        oledInterface.showStatus("WiFi Connected", ip.toString());
-      } else {
-        oledInterface.showStatus("WiFi Connected", "IP Pending");
-        delay(2000); // Wait a bit more for DHCP
-        oledInterface.showStatus("WiFi Connected", WiFi.localIP().toString());
-      }
-    } else {
-      // Connection failed, switch to AP mode
-      Serial.println("\nWiFi connection failed");
-      startAPMode();
-    }
+    WiFiLinkCache cache;
+    bool cached = loadLinkCache(&cache);
+    wifiLink.begin(ssid, password, cached ? &cache : NULL, reuseLease);
   }
 }
 
-void startAPMode() {
-  oledInterface.showStatus("Starting", "AP Mode");
-  
-  // Disconnect from any existing connections first
-  WiFi.disconnect();
-  delay(100);
-  
-  // Set up access point mode
-  WiFi.mode(WIFI_AP);
-  WiFi.softAP("ESLBlaster", "password");
-  
-  // Wait a moment for AP to initialize
-  delay(500);
+void commitWiFi(void* context, const char* newSsid, const char* newPassword, bool newApMode) {
+  strncpy(ssid, newSsid, WIFI_SSID_LENGTH);
+  ssid[WIFI_SSID_LENGTH] = '\0';
+  strncpy(password, newPassword, WIFI_PASSWORD_LENGTH);
+  password[WIFI_PASSWORD_LENGTH] = '\0';
+  apMode = newApMode;
+  saveSettings();
+  Serial.println(apMode ? "WiFi settings saved: access point" : "WiFi settings saved");
+}
+
+void bootMark(const char* phase) {
+  if (bootPhaseCount < BOOT_MAX_PHASES) {
+    bootPhases[bootPhaseCount].name = phase;
+    bootPhases[bootPhaseCount].atMs = millis();
+    bootPhaseCount++;
+  }
+}
+
+static uint32_t ssidHash() {
+  // FNV-1a, only has to tell networks apart
+  uint32_t hash = 2166136261UL;
+  for (const char* c = ssid; *c; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619UL;
+  }
+  return hash;
+}
+
+bool loadLinkCache(WiFiLinkCache* cache) {
+  StoredLinkCache stored;
+  EEPROM.get(LINK_CACHE_ADDRESS, stored);
+  if (stored.marker != LINK_CACHE_MARKER || stored.ssidHash != ssidHash() || stored.cache.channel == 0) {
+    return false;
+  }
+  *cache = stored.cache;
+  return true;
+}
+
+void saveLinkCache(const WiFiLinkCache& cache) {
+  // Written only when the association changed, a steady network costs no flash wear
+  StoredLinkCache stored;
+  EEPROM.get(LINK_CACHE_ADDRESS, stored);
+  if (stored.marker == LINK_CACHE_MARKER && stored.ssidHash == ssidHash() &&
+      memcmp(&stored.cache, &cache, sizeof(cache)) == 0) {
+    return;
+  }
   
-  IPAddress apIP = WiFi.softAPIP();
-  Serial.print("AP IP address: ");
-  Serial.println(apIP);
-  oledInterface.showStatus("AP Active", apIP.toString());
+  memset(&stored, 0, sizeof(stored));
+  stored.marker = LINK_CACHE_MARKER;
+  stored.ssidHash = ssidHash();
+  stored.cache = cache;
+  EEPROM.put(LINK_CACHE_ADDRESS, stored);
+  EEPROM.commit();
+}
+
+void showWiFiState() {
+  switch (wifiLink.getState()) {
+    case WIFI_LINK_CONNECTED:
+      oledInterface.showMainScreen("Ready", WiFi.localIP().toString().c_str());
+      break;
+    case WIFI_LINK_AP:
+      oledInterface.showMainScreen("Ready", ("AP: " + WiFi.softAPIP().toString()).c_str());
+      break;
+    case WIFI_LINK_CONNECTING:
+      oledInterface.showStatus("Connecting", "to WiFi...");
+      break;
+    case WIFI_LINK_TRIAL:
+      oledInterface.showStatus("Trying", "New WiFi...");
+      break;
+    case WIFI_LINK_BACKOFF:
+      {
+        char retry[24];
+        snprintf(retry, sizeof(retry), "Retry in %lus", (unsigned long)((wifiLink.getRetryInMs() + 999) / 1000));
+        oledInterface.showStatus("WiFi Lost", retry);
+      }
+      break;
+  }
 }
 
 void handleSerialCommands() {
   if (Serial.available()) {
     char cmd = Serial.read();
-    String ipString; // Moved outside the switch to avoid initialization crossing
     
     switch (cmd) {
       case '?':
@@ -320,21 +561,25 @@ void handleSerialCommands() {
               buffer[bytesRead++] = Serial.read();
               startTime = millis();  // Reset timeout on successful read
             }
-            yield();  // Allow ESP8266 to handle background tasks
+            profiler.yieldNow();  // Allow ESP8266 to handle background tasks
           }
           
           if (bytesRead == dataSize) {
             // Data fully received
             oledInterface.showTransmitting(1, 1, dataSize, repeats);
-            irTransmitter.transmitFrame(buffer, dataSize, repeats);
+            unsigned long jobStart = millis();
+            // No tag behind a serial frame: default gap, airtime counted like every other frame
+            eslProtocol.useProfile("");
+            eslProtocol.transmitEncodedFrame(FRAME_SERIAL, buffer, dataSize, repeats);
+            metrics.recordJob(JOB_OK, millis() - jobStart);
+            lastIrFrameMs = millis();
             Serial.write('K');  // Acknowledge successful transmission
-            totalFramesSent++;
             
-            // Update status display
-            ipString = WiFi.getMode() == WIFI_STA ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
-            oledInterface.showMainScreen("Ready", ipString);
+            // Back to the screen underneath, nothing is drawn for a frame that came and went
+            oledInterface.endTransmitting();
           } else {
             // Timeout
+            metrics.recordJob(JOB_REJECTED, 0);
             Serial.write('E');  // Error
           }
         }
@@ -353,7 +598,7 @@ void handleSerialCommands() {
               serialData += c;
               startTime = millis();  // Reset timeout on successful read
             }
-            yield();
+            profiler.yieldNow();
           }
           
           if (serialData.length() > 0) {
@@ -362,17 +607,12 @@ void handleSerialCommands() {
               String newSSID = serialData.substring(0, separatorPos);
               String newPassword = serialData.substring(separatorPos + 1);
               
-              // Save to EEPROM
-              strncpy(ssid, newSSID.c_str(), 31);
-              ssid[31] = '\0';
-              strncpy(password, newPassword.c_str(), 63);
-              password[63] = '\0';
-              apMode = false;
-              saveSettings();
-              
-              Serial.write('K');  // Acknowledge
-              delay(500);
-              ESP.restart();  // Restart to apply new settings
+              // Tried in the background, saved to EEPROM once connected
+              if (wifiLink.requestStation(newSSID.c_str(), newPassword.c_str())) {
+                Serial.write('K');  // Acknowledge
+              } else {
+                Serial.write('E');  // Another change is still being tried
+              }
             } else {
               Serial.write('E');  // Error
             }
@@ -382,16 +622,17 @@ void handleSerialCommands() {
         }
         break;
         
-      case 'A':  // Toggle AP mode
-        apMode = !apMode;
-        saveSettings();
-        Serial.write('K');  // Acknowledge
-        delay(500);
-        ESP.restart();  // Restart to apply new settings
+      case 'A':  // Toggle AP mode, applied without a restart
+        if (apMode ? wifiLink.requestStation(ssid, password) : wifiLink.requestAccessPoint(ssid, password)) {
+          Serial.write('K');  // Acknowledge
+        } else {
+          Serial.write('E');
+        }
         break;
         
       case 'R':  // Restart device
         Serial.write('K');  // Acknowledge
+        tagRegistry.flush();
         delay(500);
         ESP.restart();
         break;
@@ -401,21 +642,40 @@ void handleSerialCommands() {
           String status = "Status:\n";
           status += "WiFi: " + String(WiFi.getMode() == WIFI_STA ? "Station" : "AP") + "\n";
           status += "Connected: " + String(WiFi.status() == WL_CONNECTED ? "Yes" : "No") + "\n";
+          status += "Link: " + String(WiFiLink::stateName(wifiLink.getState())) + ", down " +
+                    String((unsigned long)(wifiLink.getDisconnectedMs() / 1000)) + "s\n";
           status += "IP: " + (WiFi.getMode() == WIFI_STA ? WiFi.localIP().toString() : WiFi.softAPIP().toString()) + "\n";
           status += "Uptime: " + String(millis() / 1000) + "s\n";
-          status += "Frames sent: " + String(totalFramesSent) + "\n";
+          status += "Frames sent: " + String(metrics.getFramesSent()) + "\n";
           status += "Free heap: " + String(ESP.getFreeHeap()) + "\n";
           Serial.println(status);
         }
         break;
         
+      case 'P':  // Profiler report
+        {
+          Serial.printf("Max: irq-off %luus, yield gap %luus\n",
+                        (unsigned long)profiler.getIrqOffMaxUs(), (unsigned long)profiler.getYieldGapMaxUs());
+          Serial.println("t_ms loops loop_max irq_off yield_gap client serial oled wifi spool (max us)");
+          for (uint8_t i = 0; i < profiler.getWindowCount(); i++) {
+            const ProfileWindow& w = profiler.getWindow(i);
+            Serial.printf("%lu %lu %lu %lu %lu %lu %lu %lu %lu %lu\n",
+                          (unsigned long)w.startMs, (unsigned long)w.loops, (unsigned long)w.loopMaxUs,
+                          (unsigned long)w.irqOffMaxUs, (unsigned long)w.yieldGapMaxUs,
+                          (unsigned long)w.sectionMaxUs[PROF_HANDLE_CLIENT], (unsigned long)w.sectionMaxUs[PROF_SERIAL],
+                          (unsigned long)w.sectionMaxUs[PROF_OLED], (unsigned long)w.sectionMaxUs[PROF_WIFI],
+                          (unsigned long)w.sectionMaxUs[PROF_SPOOL]);
+          }
+        }
+        break;
+        
       case 'T':  // Test frequency
         oledInterface.showStatus("Testing", "1.25MHz signal");
+        oledInterface.update(true);
         irTransmitter.testFrequency();
         Serial.write('K');  // Acknowledge
         // Return to ready state
-        ipString = WiFi.getMode() == WIFI_STA ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
-        oledInterface.showMainScreen("Ready", ipString);
+        showWiFiState();
         break;
         
       default:
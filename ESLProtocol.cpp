@@ -1,7 +1,25 @@
 #include "ESLProtocol.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "Arena.h"
+#include "TagRegistry.h"
+#include "Redundancy.h"
+
+extern Metrics metrics;
+extern Profiler profiler;
+extern Arena imageArena;
+extern TagRegistry tagRegistry;
 
 ESLProtocol::ESLProtocol(IRTransmitter* irTransmitter) {
   _irTransmitter = irTransmitter;
+  _capture = NULL;
+  _captureContext = NULL;
+  _captureFailed = false;
+  _observer = NULL;
+  _observerContext = NULL;
+  memset(&_progress, 0, sizeof(_progress));
+  _jobSequence = 0;
+  _tag = 0;
 }
 
 uint16_t ESLProtocol::calculateCRC16(uint8_t* data, uint16_t length) {
@@ -56,6 +74,129 @@ void ESLProtocol::getPLIDFromBarcode(const char* barcode, uint8_t* PLID) {
   }
 }
 
+const TagProfile& ESLProtocol::useProfile(const char* barcodeStr) {
+  _tag = tagRegistry.useTag(barcodeStr);
+  const TagProfile& profile = tagRegistry.profileFor(barcodeStr);
+  _irTransmitter->setFrameGap(profile.frameGapUs);
+  return profile;
+}
+
+void ESLProtocol::sendFrame(uint8_t type, uint8_t* frameData, uint8_t frameSize, uint16_t repeats) {
+  if (_capture) {
+    if (!_capture(_captureContext, type, frameData, frameSize, repeats)) {
+      _captureFailed = true;
+    }
+    return;
+  }
+  
+  // Every transmission goes through here so telemetry sees all frames; the
+  // previous frame's gap ends first, it is not airtime of this one
+  _irTransmitter->waitGap();
+  uint32_t start = micros();
+  _irTransmitter->transmitFrame(frameData, frameSize, repeats);
+  uint32_t airtimeUs = micros() - start;
+  metrics.recordFrame(type, frameSize, repeats, airtimeUs);
+  if (_tag) {
+    tagRegistry.recordAirtime(_tag, airtimeUs);
+  }
+  if (_observer) {
+    reportFrame(type, airtimeUs);
+  }
+}
+
+void ESLProtocol::finishJob(JobOutcome outcome, unsigned long jobStart) {
+  if (_capture) {
+    return;
+  }
+  metrics.recordJob(outcome, millis() - jobStart);
+  
+  if (_observer && _progress.job != 0) {
+    _progress.type = PROGRESS_JOB_DONE;
+    _progress.outcome = outcome;
+    _observer(_observerContext, _progress);
+  }
+  _progress.job = 0;
+}
+
+void ESLProtocol::setObserver(ProgressFn observer, void* context) {
+  _observer = observer;
+  _observerContext = context;
+}
+
+void ESLProtocol::reportJobStart(const char* barcode, uint16_t frameCount) {
+  if (!_observer || _capture) {
+    return;
+  }
+  
+  memset(&_progress, 0, sizeof(_progress));
+  _progress.type = PROGRESS_JOB_START;
+  _progress.job = ++_jobSequence;
+  _progress.barcode = barcode;
+  _progress.frameCount = frameCount;
+  _observer(_observerContext, _progress);
+  _progress.barcode = NULL;
+}
+
+void ESLProtocol::reportFrame(uint8_t type, uint32_t airtimeUs) {
+  // Frames sent outside a job (e.g. from the spool) are reported one by one
+  if (_progress.job == 0) {
+    _progress.frame = 0;
+    _progress.frameCount = 0;
+    _progress.airtimeUs = 0;
+  }
+  
+  _progress.type = PROGRESS_FRAME;
+  _progress.frameType = type;
+  _progress.frame++;
+  _progress.airtimeUs += airtimeUs;
+  _observer(_observerContext, _progress);
+  
+  // The observer may have removed itself
+  if (_observer && type == FRAME_PING && _progress.frame == 1 && _progress.frameCount > 1) {
+    _progress.type = PROGRESS_WAKE_DONE;
+    _observer(_observerContext, _progress);
+  }
+}
+
+void ESLProtocol::beginCapture(FrameCaptureFn capture, void* context) {
+  _capture = capture;
+  _captureContext = context;
+  _captureFailed = false;
+}
+
+bool ESLProtocol::endCapture() {
+  _capture = NULL;
+  _captureContext = NULL;
+  return !_captureFailed;
+}
+
+bool ESLProtocol::transmitEncodedFrame(uint8_t type, uint8_t* frameData, uint8_t frameSize, uint16_t repeats) {
+  if (type >= FRAME_TYPE_COUNT) {
+    return false;
+  }
+  sendFrame(type, frameData, frameSize, repeats);
+  return true;
+}
+
+bool ESLProtocol::transmitMappedFrame(uint8_t type, const uint32_t* frameWords, uint8_t frameSize, uint16_t repeats) {
+  if (type >= FRAME_TYPE_COUNT) {
+    return false;
+  }
+  
+  _irTransmitter->waitGap();
+  uint32_t start = micros();
+  _irTransmitter->transmitMappedFrame(frameWords, frameSize, repeats);
+  uint32_t airtimeUs = micros() - start;
+  metrics.recordFrame(type, frameSize, repeats, airtimeUs);
+  if (_tag) {
+    tagRegistry.recordAirtime(_tag, airtimeUs);
+  }
+  if (_observer) {
+    reportFrame(type, airtimeUs);
+  }
+  return true;
+}
+
 void ESLProtocol::appendWord(uint8_t* buffer, uint16_t offset, uint16_t value) {
   buffer[offset] = (value >> 8) & 0xFF;
   buffer[offset + 1] = value & 0xFF;
@@ -237,15 +378,35 @@ void ESLProtocol::compressImage(uint8_t* inputData, uint16_t width, uint16_t hei
   *outputSize = outputIdx;
 }
 
+size_t ESLProtocol::imageScratchSize(uint16_t width, uint16_t height, bool colorMode) {
+  // Raw pixels and the worst case compressed copy, as allocated below
+  uint16_t pixelCount = width * height;
+  return Arena::footprint(pixelCount * (colorMode ? 2 : 1)) + Arena::footprint(pixelCount * 2);
+}
+
 bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData, 
                                uint16_t width, uint16_t height, uint8_t page, 
                                bool colorMode, uint16_t posX, uint16_t posY,
-                               bool forcePP4) {
+                               bool forcePP4, uint8_t copies) {
   // Implementation of img2dm.py functionality
+  unsigned long jobStart = millis();
   uint8_t PLID[4];
   getPLIDFromBarcode(barcodeStr, PLID);
+  const TagProfile& profile = useProfile(barcodeStr);
   
-  bool pp16 = !forcePP4;
+  // PP4 can be forced for a single request, otherwise the model decides
+  bool pp16 = profile.pp16 && !forcePP4;
+  
+  if (colorMode && profile.planes < 2) {
+    Serial.printf("Tag model %s has no color plane\n", profile.model);
+    finishJob(JOB_FAILED, jobStart);
+    return false;
+  }
+  if (profile.width && (posX + width > profile.width || posY + height > profile.height)) {
+    Serial.printf("Image does not fit the %ux%u display of %s\n", profile.width, profile.height, profile.model);
+    finishJob(JOB_FAILED, jobStart);
+    return false;
+  }
   
   // Prepare for image compression
   uint16_t pixelCount = width * height;
@@ -253,13 +414,16 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
   // ESLs only accept images with pixel counts multiple of 8
   if (pixelCount & 7) {
     Serial.println("Image pixel count must be a multiple of 8");
+    finishJob(JOB_FAILED, jobStart);
     return false;
   }
   
-  // Prepare raw and compressed data buffers
-  uint8_t* rawPixels = new uint8_t[pixelCount * (colorMode ? 2 : 1)];
+  // Prepare raw and compressed data buffers, both go back to the arena on return
+  ArenaScope scratch(imageArena);
+  uint8_t* rawPixels = (uint8_t*)imageArena.allocate(pixelCount * (colorMode ? 2 : 1));
   if (!rawPixels) {
     Serial.println("Memory allocation failed for raw pixels");
+    finishJob(JOB_FAILED, jobStart);
     return false;
   }
   
@@ -279,10 +443,10 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
   }
   
   // Compress the image data
-  uint8_t* compressedData = new uint8_t[pixelCount * 2]; // Worst case size
+  uint8_t* compressedData = (uint8_t*)imageArena.allocate(pixelCount * 2); // Worst case size
   if (!compressedData) {
-    delete[] rawPixels;
     Serial.println("Memory allocation failed for compressed data");
+    finishJob(JOB_FAILED, jobStart);
     return false;
   }
   
@@ -309,17 +473,23 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
   }
   
   // Calculate frames needed
-  const int bytesPerFrame = 20;
+  const int bytesPerFrame = profile.payload;
   int frameCount = (finalSize + bytesPerFrame - 1) / bytesPerFrame;
   
+  // Tags cannot acknowledge; on lossy paths extra copies of the data frames
+  // cost less airtime than sending the whole job again
+  FrameInterleaver order(frameCount, copies ? copies : profile.dataCopies, profile.interleaveSpan);
+  
   // Prepare to send frames
   uint8_t frameData[256];
   uint8_t frameSize;
   
+  // Ping, parameters, data frames and refresh
+  reportJobStart(barcodeStr, order.getLength() + 3);
+  
   // 1. Wake-up ping frame
-  createPingFrame(PLID, pp16, 400, frameData, &frameSize);
-  _irTransmitter->transmitFrame(frameData, frameSize, 400);
-  yield();
+  createPingFrame(PLID, pp16, profile.wakeRepeats, frameData, &frameSize);
+  sendFrame(FRAME_PING, frameData, frameSize, profile.wakeRepeats);
   
   // 2. Parameters frame
   uint8_t paramData[32] = {0};
@@ -342,12 +512,13 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
   paramData[21] = 0x00;
   
   createMCUFrame(PLID, 0x05, paramData, 22, pp16, 1, frameData, &frameSize);
-  _irTransmitter->transmitFrame(frameData, frameSize, 1);
-  yield();
+  sendFrame(FRAME_PARAMS, frameData, frameSize, 1);
   
-  // 3. Data frames
-  for (int fr = 0; fr < frameCount; fr++) {
-    uint8_t dataFrameData[24] = {0};
+  // 3. Data frames; each is built and CRCed in the gap after the one before,
+  // the transmitter returns as soon as a frame is out
+  uint16_t fr;
+  while (order.next(&fr)) {
+    uint8_t dataFrameData[2 + TAG_MAX_PAYLOAD] = {0};
     appendWord(dataFrameData, 0, fr); // Frame number
     
     // Calculate how many bytes to copy for this frame
@@ -357,8 +528,7 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
     memcpy(&dataFrameData[2], &finalData[fr * bytesPerFrame], bytesToCopy);
     
     createMCUFrame(PLID, 0x20, dataFrameData, 2 + bytesToCopy, pp16, 1, frameData, &frameSize);
-    _irTransmitter->transmitFrame(frameData, frameSize, 1);
-    yield();
+    sendFrame(FRAME_DATA, frameData, frameSize, 1);
   }
   
   // 4. Refresh frame
@@ -368,37 +538,50 @@ bool ESLProtocol::transmitImage(const char* barcodeStr, uint8_t* imageData,
   }
   
   createMCUFrame(PLID, 0x01, refreshData, 22, pp16, 1, frameData, &frameSize);
-  _irTransmitter->transmitFrame(frameData, frameSize, 1);
+  sendFrame(FRAME_REFRESH, frameData, frameSize, 1);
   
-  // Clean up
-  delete[] rawPixels;
-  delete[] compressedData;
+  // Spooled updates are only encoded here, their payload is not on the tag yet
+  if (_tag && !_capture) {
+    tagRegistry.recordPayload(_tag, page, finalData, finalSize);
+  }
   
+  finishJob(JOB_OK, jobStart);
   return true;
 }
 
 bool ESLProtocol::transmitRawCommand(const char* barcodeStr, const char* typeStr, 
                                    uint8_t* frameData, uint16_t dataSize, uint16_t repeatCount) {
   // Implementation of rawcmd.py functionality
+  uint8_t completeFrame[256];
+  uint8_t frameSize;
+  
+  // Header, command data and CRC have to fit the buffer and the uint8_t size
+  if (dataSize == 0 || 6 + (dataSize - 1) + 2 >= sizeof(completeFrame)) {
+    return false;
+  }
+  
+  unsigned long jobStart = millis();
   uint8_t PLID[4];
   getPLIDFromBarcode(barcodeStr, PLID);
+  useProfile(barcodeStr);
   
   uint8_t protocol = (strcmp(typeStr, "DM") == 0) ? 0x85 : 0x84;
   uint8_t cmd = frameData[0];
   
-  uint8_t completeFrame[256];
-  uint8_t frameSize;
-  
   createRawFrame(protocol, PLID, cmd, &frameData[1], dataSize - 1, false, repeatCount, completeFrame, &frameSize);
-  _irTransmitter->transmitFrame(completeFrame, frameSize, repeatCount);
+  reportJobStart(barcodeStr, 1);
+  sendFrame(FRAME_RAW, completeFrame, frameSize, repeatCount);
   
+  finishJob(JOB_OK, jobStart);
   return true;
 }
 
 bool ESLProtocol::setSegments(const char* barcodeStr, uint8_t* bitmap) {
   // Implementation of setsegs.py functionality
+  unsigned long jobStart = millis();
   uint8_t PLID[4];
   getPLIDFromBarcode(barcodeStr, PLID);
+  const TagProfile& profile = useProfile(barcodeStr);
   
   // Create payload for segment ESL
   uint8_t payload[40] = {0};
@@ -427,28 +610,98 @@ bool ESLProtocol::setSegments(const char* barcodeStr, uint8_t* bitmap) {
   uint8_t completeFrame[256];
   uint8_t frameSize;
   
-  createRawFrame(0x84, PLID, payload[0], &payload[1], 35, false, 100, completeFrame, &frameSize);
-  _irTransmitter->transmitFrame(completeFrame, frameSize, 100);
+  // Segment frames always go out with the short preamble
+  createRawFrame(0x84, PLID, payload[0], &payload[1], 35, false, profile.segmentRepeats, completeFrame, &frameSize);
+  reportJobStart(barcodeStr, 1);
+  sendFrame(FRAME_SEGMENTS, completeFrame, frameSize, profile.segmentRepeats);
   
+  finishJob(JOB_OK, jobStart);
   return true;
 }
 
 bool ESLProtocol::makePingFrame(const char* barcodeStr, bool pp16, uint16_t repeats) {
+  unsigned long jobStart = millis();
   uint8_t PLID[4];
   getPLIDFromBarcode(barcodeStr, PLID);
+  useProfile(barcodeStr);
   
   uint8_t frameData[256];
   uint8_t frameSize;
   
   createPingFrame(PLID, pp16, repeats, frameData, &frameSize);
-  _irTransmitter->transmitFrame(frameData, frameSize, repeats);
+  reportJobStart(barcodeStr, 1);
+  sendFrame(FRAME_PING, frameData, frameSize, repeats);
   
+  finishJob(JOB_OK, jobStart);
   return true;
 }
 
+bool ESLProtocol::makePingFrames(const char* const* barcodes, uint8_t count, bool pp16,
+                                 uint16_t repeats, uint32_t channelOffsetNs) {
+  unsigned long jobStart = millis();
+  // Parallel sends bypass sendFrame and cannot be captured
+  if (_capture || count == 0 || count > _irTransmitter->getChannelCount()) {
+    finishJob(JOB_FAILED, jobStart);
+    return false;
+  }
+  
+  ArenaScope scratch(imageArena);
+  uint8_t* frameData = (uint8_t*)imageArena.allocate(count * 256);
+  if (!frameData) {
+    finishJob(JOB_FAILED, jobStart);
+    return false;
+  }
+  
+  // All channels share the repeat timing, the slowest tag sets the gap
+  ChannelFrame frames[EDGE_MAX_CHANNELS];
+  uint32_t tags[EDGE_MAX_CHANNELS];
+  uint16_t frameGapUs = 0;
+  for (uint8_t c = 0; c < count; c++) {
+    uint8_t PLID[4];
+    getPLIDFromBarcode(barcodes[c], PLID);
+    tags[c] = tagRegistry.useTag(barcodes[c]);
+    frameGapUs = max(frameGapUs, tagRegistry.profileFor(barcodes[c]).frameGapUs);
+    
+    uint8_t frameSize;
+    createPingFrame(PLID, pp16, repeats, &frameData[c * 256], &frameSize);
+    frames[c].data = &frameData[c * 256];
+    frames[c].size = frameSize;
+    frames[c].offsetNs = c * channelOffsetNs;
+  }
+  
+  _irTransmitter->setFrameGap(frameGapUs);
+  
+  // Reported as one job with a frame per channel
+  reportJobStart(barcodes[0], count);
+  
+  _irTransmitter->waitGap();
+  uint32_t start = micros();
+  bool sent = _irTransmitter->transmitParallel(frames, count, repeats);
+  uint32_t airtimeUs = micros() - start;
+  
+  // Each channel carried its own frame for the whole transmission, but the
+  // air was only taken once
+  if (sent) {
+    for (uint8_t c = 0; c < count; c++) {
+      metrics.recordFrame(FRAME_PING, frames[c].size, repeats, c == 0 ? airtimeUs : 0);
+      if (tags[c]) {
+        tagRegistry.recordAirtime(tags[c], airtimeUs);
+      }
+      if (_observer) {
+        reportFrame(FRAME_PING, c == 0 ? airtimeUs : 0);
+      }
+    }
+  }
+  
+  finishJob(sent ? JOB_OK : JOB_FAILED, jobStart);
+  return sent;
+}
+
 bool ESLProtocol::makeRefreshFrame(const char* barcodeStr, bool pp16) {
+  unsigned long jobStart = millis();
   uint8_t PLID[4];
   getPLIDFromBarcode(barcodeStr, PLID);
+  useProfile(barcodeStr);
   
   uint8_t frameData[256];
   uint8_t frameSize;
@@ -459,7 +712,9 @@ bool ESLProtocol::makeRefreshFrame(const char* barcodeStr, bool pp16) {
   }
   
   createMCUFrame(PLID, 0x01, refreshData, 22, pp16, 1, frameData, &frameSize);
-  _irTransmitter->transmitFrame(frameData, frameSize, 1);
+  reportJobStart(barcodeStr, 1);
+  sendFrame(FRAME_REFRESH, frameData, frameSize, 1);
   
+  finishJob(JOB_OK, jobStart);
   return true;
 }
\ No newline at end of file
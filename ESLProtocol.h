@@ -3,16 +3,46 @@
 
 #include <Arduino.h>
 #include "IRTransmitter.h"
+#include "Metrics.h"
+#include "TagProfiles.h"
+
+// Receives encoded frames in place of the transmitter while capturing
+typedef bool (*FrameCaptureFn)(void* context, uint8_t type, const uint8_t* frameData,
+                               uint8_t frameSize, uint16_t repeats);
+
+// Progress of transmit jobs, for live status reports
+enum ProgressEventType {
+  PROGRESS_JOB_START = 0,
+  PROGRESS_WAKE_DONE,       // Wake-up ping sent, more frames follow
+  PROGRESS_FRAME,
+  PROGRESS_JOB_DONE
+};
+
+struct ProgressEvent {
+  uint8_t type;             // ProgressEventType
+  uint32_t job;             // Sequence number, 0 for frames sent outside a job
+  const char* barcode;      // Job start only
+  uint8_t frameType;        // FrameType of the last frame
+  uint16_t frame;           // Frames of the job sent so far
+  uint16_t frameCount;      // Frames the job sends, 0 if not known
+  uint32_t airtimeUs;       // Airtime of the job so far
+  uint8_t outcome;          // JobOutcome, job done only
+};
+
+typedef void (*ProgressFn)(void* context, const ProgressEvent& event);
 
 class ESLProtocol {
   public:
     ESLProtocol(IRTransmitter* irTransmitter);
     
-    // Main functions matching the Python scripts
+    // Main functions matching the Python scripts; transmitImage sends each data
+    // frame copies times, interleaved, 0 takes the count from the tag's profile
     bool transmitImage(const char* barcodeStr, uint8_t* imageData, 
                       uint16_t width, uint16_t height, uint8_t page = 0, 
                       bool colorMode = false, uint16_t posX = 0, uint16_t posY = 0,
-                      bool forcePP4 = false);
+                      bool forcePP4 = false, uint8_t copies = 0);
+    // Scratch transmitImage takes from the image arena for such an image
+    static size_t imageScratchSize(uint16_t width, uint16_t height, bool colorMode);
                       
     bool transmitRawCommand(const char* barcodeStr, const char* typeStr, 
                            uint8_t* frameData, uint16_t dataSize, uint16_t repeatCount);
@@ -23,6 +53,30 @@ class ESLProtocol {
     bool makePingFrame(const char* barcodeStr, bool pp16, uint16_t repeats);
     bool makeRefreshFrame(const char* barcodeStr, bool pp16);
     
+    // Ping a different tag on each IR channel at once, channel i+1 starts
+    // channelOffsetNs after channel i so their first bursts do not coincide
+    bool makePingFrames(const char* const* barcodes, uint8_t count, bool pp16,
+                        uint16_t repeats, uint32_t channelOffsetNs);
+    
+    // Send a frame that was encoded earlier, e.g. by a capture into the job spool
+    bool transmitEncodedFrame(uint8_t type, uint8_t* frameData, uint8_t frameSize, uint16_t repeats);
+    // Same for a frame read in place from the flash mapping
+    bool transmitMappedFrame(uint8_t type, const uint32_t* frameWords, uint8_t frameSize, uint16_t repeats);
+    
+    // Route every frame of the following calls to capture instead of the IR LED;
+    // endCapture() returns false if any frame was refused
+    void beginCapture(FrameCaptureFn capture, void* context);
+    bool endCapture();
+    
+    // Report job progress to observer, NULL stops the reports. Captured jobs
+    // are not reported, they are only encoded
+    void setObserver(ProgressFn observer, void* context);
+    
+    // Look up the tag's profile and set the transmitter's frame gap from it;
+    // every job does this itself, spooled frames are sent after calling it.
+    // Frames sent until the next call are counted in the tag's registry record
+    const TagProfile& useProfile(const char* barcodeStr);
+    
     // Helper functions
     uint16_t calculateCRC16(uint8_t* data, uint16_t length);
     void getPLIDFromBarcode(const char* barcode, uint8_t* PLID);
@@ -31,6 +85,14 @@ class ESLProtocol {
     
   private:
     IRTransmitter* _irTransmitter;
+    FrameCaptureFn _capture;
+    void* _captureContext;
+    bool _captureFailed;
+    ProgressFn _observer;
+    void* _observerContext;
+    ProgressEvent _progress;  // Job being transmitted
+    uint32_t _jobSequence;
+    uint32_t _tag;            // PLID of the tag being sent to, 0 if not registered
     
     // Frame creation functions
     void createPingFrame(uint8_t* PLID, bool pp16, uint16_t repeats, 
@@ -48,6 +110,14 @@ class ESLProtocol {
                        uint16_t repeats, uint8_t* frameSize);
                        
     void appendWord(uint8_t* buffer, uint16_t offset, uint16_t value);
+    
+    // Transmit a finished frame and record it in the telemetry counters
+    void sendFrame(uint8_t type, uint8_t* frameData, uint8_t frameSize, uint16_t repeats);
+    // Record the job outcome, captured jobs are not counted until they are sent
+    void finishJob(JobOutcome outcome, unsigned long jobStart);
+    // Progress reports, the frame path checks for an observer before calling
+    void reportJobStart(const char* barcode, uint16_t frameCount);
+    void reportFrame(uint8_t type, uint32_t airtimeUs);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "EdgeSchedule.h"
+
+void ChannelSchedule::begin(const ChannelFrame& frame) {
+  _data = frame.data;
+  _symbolCount = frame.size << 2;  // 1 byte = 4 symbols (2 bits per symbol)
+  _burst = 0;
+  _burstStartNs = frame.offsetNs;
+  _on = false;
+  _done = (frame.data == NULL);
+}
+
+bool ChannelSchedule::peek(uint32_t* timeNs) const {
+  if (_done) {
+    return false;
+  }
+
+  *timeNs = _on ? _burstStartNs + IR_BURST_ON_NS : _burstStartNs;
+  return true;
+}
+
+bool ChannelSchedule::next(uint32_t* timeNs, bool* on) {
+  if (!peek(timeNs)) {
+    return false;
+  }
+
+  if (!_on) {
+    _on = true;
+    *on = true;
+    return true;
+  }
+
+  _on = false;
+  *on = false;
+
+  // The frame ends with one extra burst after the last symbol
+  if (_burst == _symbolCount) {
+    _done = true;
+    return true;
+  }
+
+  // Same spacing as the single-channel transmitter: burst plus symbol pause
+  uint8_t byte = _data[_burst >> 2];
+  uint8_t symbol = (byte >> (6 - ((_burst & 3) << 1))) & 3;
+  _burstStartNs += IR_BURST_ON_NS + IR_PAUSE_US[symbol] * 1000;
+  _burst++;
+  return true;
+}
+
+void EdgeMerger::begin(const ChannelFrame* frames, uint8_t count) {
+  _count = count > EDGE_MAX_CHANNELS ? EDGE_MAX_CHANNELS : count;
+  _mask = 0;
+  for (uint8_t c = 0; c < _count; c++) {
+    _channels[c].begin(frames[c]);
+  }
+}
+
+bool EdgeMerger::next(ScheduleEdge* edge) {
+  // Find the earliest pending transition
+  bool found = false;
+  uint32_t earliest = 0;
+  for (uint8_t c = 0; c < _count; c++) {
+    uint32_t t;
+    if (_channels[c].peek(&t) && (!found || t < earliest)) {
+      earliest = t;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  // Apply every channel transition at that instant as one edge
+  for (uint8_t c = 0; c < _count; c++) {
+    uint32_t t;
+    bool on;
+    if (_channels[c].peek(&t) && t == earliest) {
+      _channels[c].next(&t, &on);
+      if (on) {
+        _mask |= (1 << c);
+      } else {
+        _mask &= ~(1 << c);
+      }
+    }
+  }
+
+  edge->timeNs = earliest;
+  edge->mask = _mask;
+  return true;
+}
+
+void SegmentStream::begin(const ChannelFrame* frames, uint8_t count) {
+  _merger.begin(frames, count);
+  _edge.timeNs = 0;
+  _edge.mask = 0;
+  _haveEdge = _merger.next(&_edge);
+}
+
+uint32_t SegmentStream::toPeriod(uint32_t timeNs) {
+  const uint32_t periodNs = 1000000 / IR_CARRIER_KHZ;
+  return (timeNs + periodNs / 2) / periodNs;
+}
+
+bool SegmentStream::next(CarrierSegment* segment) {
+  while (_haveEdge) {
+    ScheduleEdge following;
+    bool haveFollowing = _merger.next(&following);
+    if (!haveFollowing) {
+      _haveEdge = false;
+      return false;
+    }
+
+    ScheduleEdge edge = _edge;
+    _edge = following;
+
+    // Edges closer than half a period round to the same point and drop out
+    uint32_t start = toPeriod(edge.timeNs);
+    uint32_t end = toPeriod(following.timeNs);
+    if (edge.mask != 0 && end > start) {
+      segment->startNs = start * (1000000 / IR_CARRIER_KHZ);
+      segment->periods = end - start;
+      segment->mask = edge.mask;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool verifyMergedSchedule(const ChannelFrame* frames, uint8_t count) {
+  if (count > EDGE_MAX_CHANNELS) {
+    return false;
+  }
+
+  // The expected edges are worked out here from the symbol timings rather
+  // than with ChannelSchedule, which the merger itself is built on
+  for (uint8_t c = 0; c < count; c++) {
+    const ChannelFrame& frame = frames[c];
+    uint16_t symbolCount = frame.data ? frame.size * 4 : 0;
+    uint16_t symbol = 0;
+    uint32_t burstStartNs = frame.offsetNs;
+    bool done = (frame.data == NULL);
+
+    EdgeMerger merger;
+    merger.begin(frames, count);
+
+    bool wasOn = false;
+    ScheduleEdge edge;
+    while (merger.next(&edge)) {
+      bool isOn = (edge.mask >> c) & 1;
+      if (isOn == wasOn) {
+        continue;
+      }
+      if (done) {
+        return false;
+      }
+
+      // Bursts of IR_BURST_US rounded to whole carrier periods, each followed
+      // by the pause of its symbol, most significant bits first
+      uint32_t expectedNs = isOn ? burstStartNs : burstStartNs + IR_BURST_ON_NS;
+      if (edge.timeNs != expectedNs) {
+        return false;
+      }
+      if (!isOn) {
+        if (symbol == symbolCount) {
+          done = true;
+        } else {
+          uint8_t value = (frame.data[symbol / 4] >> (6 - 2 * (symbol % 4))) & 3;
+          burstStartNs += IR_BURST_ON_NS + IR_PAUSE_US[value] * 1000;
+          symbol++;
+        }
+      }
+      wasOn = isOn;
+    }
+
+    // Every burst of the frame, the final one included, must have been sent
+    if (!done) {
+      return false;
+    }
+  }
+
+  return true;
+}
\ No newline at end of file
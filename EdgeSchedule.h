@@ -0,0 +1,86 @@
+#ifndef EDGE_SCHEDULE_H
+#define EDGE_SCHEDULE_H
+
+// Combined carrier edge schedule for several IR channels sending different frames
+// No Arduino dependencies, so merged schedules can be checked on the host
+// against the nominal symbol timings
+
+#include <stdint.h>
+#include <stddef.h>
+#include "IRTiming.h"
+
+#define EDGE_MAX_CHANNELS 4
+
+// One channel's frame and where it starts on the shared timeline
+struct ChannelFrame {
+  const uint8_t* data;
+  uint8_t size;
+  uint32_t offsetNs;
+};
+
+// From timeNs until the next edge, the carrier is on for the channels in mask
+struct ScheduleEdge {
+  uint32_t timeNs;
+  uint8_t mask;
+};
+
+// Burst on/off transitions of a single channel, generated lazily from the frame bytes
+class ChannelSchedule {
+  public:
+    void begin(const ChannelFrame& frame);
+    // Time of the next transition, false once the final burst has ended
+    bool peek(uint32_t* timeNs) const;
+    // Consume the next transition, on tells whether the carrier switches on
+    bool next(uint32_t* timeNs, bool* on);
+
+  private:
+    const uint8_t* _data;
+    uint16_t _symbolCount;
+    uint16_t _burst;        // Index of the current burst, symbolCount + 1 bursts per frame
+    uint32_t _burstStartNs;
+    bool _on;
+    bool _done;
+};
+
+// Merges the channel schedules into one time-ordered edge stream
+class EdgeMerger {
+  public:
+    void begin(const ChannelFrame* frames, uint8_t count);
+    bool next(ScheduleEdge* edge);
+
+  private:
+    ChannelSchedule _channels[EDGE_MAX_CHANNELS];
+    uint8_t _count;
+    uint8_t _mask;
+};
+
+// Carrier on between two merged edges, in whole periods of the shared
+// timeline. Edge times are rounded to the period grid rather than each
+// segment's length, so a burst split by other channels' edges still adds up
+// to IR_BURST_PERIODS
+struct CarrierSegment {
+  uint32_t startNs;       // On the period grid
+  uint32_t periods;
+  uint8_t mask;
+};
+
+class SegmentStream {
+  public:
+    void begin(const ChannelFrame* frames, uint8_t count);
+    bool next(CarrierSegment* segment);
+    // Time of the last edge so far, the end of the frames once next() is false
+    uint32_t getLastEdgeNs() { return _edge.timeNs; }
+
+  private:
+    EdgeMerger _merger;
+    ScheduleEdge _edge;
+    bool _haveEdge;
+
+    static uint32_t toPeriod(uint32_t timeNs);
+};
+
+// Checks every channel's edges in the merged stream against the nominal
+// burst and pause timings of its frame
+bool verifyMergedSchedule(const ChannelFrame* frames, uint8_t count);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "FlashJobs.h"
+#include "Profiler.h"
+
+extern Profiler profiler;
+
+// Job header, 8 words: magic, spool id, spool created-at, frame count,
+// length in bytes including the header, 3 reserved
+// Frame record: one word (type | size << 8 | repeats << 16), then the frame
+// bytes padded to a whole word
+#define FLASH_JOBS_MAGIC 0x434C5345  // "ESLC"
+#define FLASH_JOBS_HEADER_WORDS 8
+#define FLASH_JOBS_HEADER_BYTES (FLASH_JOBS_HEADER_WORDS * 4)
+
+static uint32_t sectorAlign(uint32_t offset) {
+  return (offset + FLASH_JOBS_SECTOR - 1) & ~(FLASH_JOBS_SECTOR - 1);
+}
+
+static uint32_t recordLength(uint8_t frameSize) {
+  return 4 + ((frameSize + 3) & ~3);
+}
+
+FlashJobArea::FlashJobArea() {
+  _start = 0;
+  _end = 0;
+  _writeOffset = 0;
+  _erasedEnd = 0;
+  _jobCount = 0;
+  _cursorId = SPOOL_NO_JOB;
+  _cursorFrame = 0;
+  _cursorOffset = 0;
+}
+
+bool FlashJobArea::begin(JobSpool& spool) {
+  _start = sectorAlign(ESP.getSketchSize());
+  _end = _start + ESP.getFreeSketchSpace();
+  if (_end > FLASH_JOBS_MAP_SIZE) {
+    _end = FLASH_JOBS_MAP_SIZE;
+  }
+  if (_end <= _start) {
+    _end = _start;
+    _writeOffset = _start;
+    return false;
+  }
+
+  // Compiled jobs follow each other on sector boundaries until the first empty header
+  _jobCount = 0;
+  uint32_t offset = _start;
+  while (offset + FLASH_JOBS_HEADER_BYTES <= _end && _jobCount < FLASH_JOBS_MAX) {
+    const uint32_t* header = map(offset);
+    if (header[0] != FLASH_JOBS_MAGIC || header[4] < FLASH_JOBS_HEADER_BYTES ||
+        offset + header[4] > _end) {
+      break;
+    }
+
+    // A copy whose job is gone can never be sent again; left in the index it
+    // could be taken for a new job with the same identity if the ids restart
+    const SpoolJobInfo* queued = spool.findJobInfo(header[1]);
+    if (queued && queued->createdAt == header[2] && queued->frameCount == header[3]) {
+      CompiledJob& job = _jobs[_jobCount++];
+      job.spoolId = header[1];
+      job.createdAt = header[2];
+      job.frameCount = header[3];
+      job.offset = offset;
+    }
+    offset = sectorAlign(offset + header[4]);
+  }
+
+  _writeOffset = offset;
+  _erasedEnd = offset;
+  return true;
+}
+
+int8_t FlashJobArea::findCompiled(const SpoolJobInfo& job) {
+  // Spool ids never repeat, but restart if the file system is wiped, so match
+  // the whole identity
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    if (_jobs[i].spoolId == job.id && _jobs[i].createdAt == job.createdAt &&
+        _jobs[i].frameCount == job.frameCount) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool FlashJobArea::isCompiled(const SpoolJobInfo& job) {
+  return findCompiled(job) >= 0;
+}
+
+void FlashJobArea::reclaim(JobSpool& spool) {
+  // The area is a log, it can only start over once none of its jobs is queued
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    const SpoolJobInfo* queued = spool.findJobInfo(_jobs[i].spoolId);
+    if (queued && queued->createdAt == _jobs[i].createdAt) {
+      return;
+    }
+  }
+
+  // Erasing each header sector is enough for begin() to see an empty area
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    ESP.flashEraseSector(_jobs[i].offset / FLASH_JOBS_SECTOR);
+    profiler.yieldNow();
+  }
+
+  _jobCount = 0;
+  _writeOffset = _start;
+  _erasedEnd = _start;
+  _cursorId = SPOOL_NO_JOB;
+}
+
+bool FlashJobArea::writeWords(uint32_t offset, const uint32_t* words, uint32_t length) {
+  // Sectors are erased as the write position enters them
+  while (_erasedEnd < offset + length) {
+    if (!ESP.flashEraseSector(_erasedEnd / FLASH_JOBS_SECTOR)) {
+      return false;
+    }
+    _erasedEnd += FLASH_JOBS_SECTOR;
+    profiler.yieldNow();
+  }
+  return ESP.flashWrite(offset, words, length);
+}
+
+bool FlashJobArea::compile(JobSpool& spool, uint32_t id) {
+  const SpoolJobInfo* queued = spool.findJobInfo(id);
+  if (!queued || queued->nextFrame != 0 || _end == _start) {
+    return false;
+  }
+  SpoolJobInfo job = *queued;
+
+  // Word padding adds at most 3 bytes per frame to the spool file size
+  uint32_t needed = FLASH_JOBS_HEADER_BYTES + job.bytes + 3 * job.frameCount;
+  if (_jobCount >= FLASH_JOBS_MAX || _writeOffset + needed > _end) {
+    reclaim(spool);
+  }
+  if (_jobCount >= FLASH_JOBS_MAX || _writeOffset + needed > _end) {
+    return false;
+  }
+
+  uint32_t jobOffset = _writeOffset;
+  uint32_t offset = jobOffset + FLASH_JOBS_HEADER_BYTES;
+  uint32_t spoolOffset = job.nextOffset;
+  _erasedEnd = jobOffset;
+
+  SpoolFrame frame;
+  for (uint16_t f = 0; f < job.frameCount; f++) {
+    if (!spool.readFrame(id, &spoolOffset, &frame)) {
+      return false;
+    }
+
+    uint32_t length = recordLength(frame.size);
+    _record[length / 4 - 1] = 0xFFFFFFFF;  // Padding of the last word
+    _record[0] = frame.type | (frame.size << 8) | ((uint32_t)frame.repeats << 16);
+    memcpy(&_record[1], frame.data, frame.size);
+
+    if (!writeWords(offset, _record, length)) {
+      return false;
+    }
+    offset += length;
+  }
+
+  // Header last: until it is written the job does not exist for begin()
+  uint32_t header[FLASH_JOBS_HEADER_WORDS] = {
+    FLASH_JOBS_MAGIC, job.id, job.createdAt, job.frameCount, offset - jobOffset,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF
+  };
+  if (!ESP.flashWrite(jobOffset, header, sizeof(header))) {
+    return false;
+  }
+
+  CompiledJob& compiled = _jobs[_jobCount++];
+  compiled.spoolId = job.id;
+  compiled.createdAt = job.createdAt;
+  compiled.frameCount = job.frameCount;
+  compiled.offset = jobOffset;
+
+  _writeOffset = sectorAlign(offset);
+  return true;
+}
+
+bool FlashJobArea::getFrame(const SpoolJobInfo& job, uint16_t frameIndex, FlashFrame* frame) {
+  int8_t index = findCompiled(job);
+  if (index < 0 || frameIndex >= _jobs[index].frameCount) {
+    return false;
+  }
+
+  // Continue from the previous lookup when possible, otherwise walk from the start
+  uint32_t offset = _jobs[index].offset + FLASH_JOBS_HEADER_BYTES;
+  uint16_t f = 0;
+  if (_cursorId == job.id && _cursorFrame <= frameIndex) {
+    offset = _cursorOffset;
+    f = _cursorFrame;
+  }
+
+  while (f < frameIndex) {
+    offset += recordLength((*map(offset) >> 8) & 0xFF);
+    f++;
+  }
+
+  uint32_t record = *map(offset);
+  frame->type = record & 0xFF;
+  frame->size = (record >> 8) & 0xFF;
+  frame->repeats = record >> 16;
+  frame->words = map(offset + 4);
+
+  _cursorId = job.id;
+  _cursorFrame = f + 1;
+  _cursorOffset = offset + recordLength(frame->size);
+  return true;
+}
\ No newline at end of file
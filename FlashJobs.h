@@ -0,0 +1,80 @@
+#ifndef FLASH_JOBS_H
+#define FLASH_JOBS_H
+
+#include <Arduino.h>
+#include "JobSpool.h"
+
+// Compiled copies of spool jobs in raw flash, sent without any RAM buffer
+//
+// The area is the unused sketch space after the running sketch, limited to
+// the first megabyte that the ESP8266 maps at 0x40200000 through the flash
+// cache. Frames are stored word aligned so IRTransmitter can read them in
+// place. Each job starts on a sector and its header is written last, so a
+// job cut short by a reset is simply not there after reboot.
+// Note: this is the space an OTA update would use for the new image.
+
+#define FLASH_JOBS_MAX 64
+#define FLASH_JOBS_SECTOR 4096
+#define FLASH_JOBS_MAP_BASE 0x40200000
+#define FLASH_JOBS_MAP_SIZE 0x100000
+
+// One frame of a compiled job, words points into the flash mapping
+struct FlashFrame {
+  uint8_t type;
+  uint8_t size;
+  uint16_t repeats;
+  const uint32_t* words;
+};
+
+class FlashJobArea {
+  public:
+    FlashJobArea();
+
+    // Find the area and the jobs already compiled into it; copies of jobs
+    // that are no longer queued in spool are forgotten
+    bool begin(JobSpool& spool);
+
+    // Copy a queued spool job into flash, false if it does not fit
+    bool compile(JobSpool& spool, uint32_t id);
+    bool isCompiled(const SpoolJobInfo& job);
+
+    // Frame frameIndex of a spool job, if a compiled copy of that job exists
+    bool getFrame(const SpoolJobInfo& job, uint16_t frameIndex, FlashFrame* frame);
+
+    uint32_t getSize() { return _end - _start; }
+    uint32_t getUsed() { return _writeOffset - _start; }
+    uint8_t getJobCount() { return _jobCount; }
+
+  private:
+    struct CompiledJob {
+      uint32_t spoolId;
+      uint32_t createdAt;
+      uint16_t frameCount;
+      uint32_t offset;      // Flash offset of the job header
+    };
+
+    uint32_t _start;        // Flash offsets, sector aligned
+    uint32_t _end;
+    uint32_t _writeOffset;
+    uint32_t _erasedEnd;
+    CompiledJob _jobs[FLASH_JOBS_MAX];
+    uint8_t _jobCount;
+
+    // Jobs are read front to back, remember where the last lookup ended
+    uint32_t _cursorId;
+    uint16_t _cursorFrame;
+    uint32_t _cursorOffset;
+
+    // Staging for one record, flash writes need word-aligned RAM
+    uint32_t _record[1 + (SPOOL_MAX_FRAME + 3) / 4];
+
+    int8_t findCompiled(const SpoolJobInfo& job);
+    void reclaim(JobSpool& spool);
+    bool writeWords(uint32_t offset, const uint32_t* words, uint32_t length);
+
+    static inline const uint32_t* map(uint32_t offset) {
+      return (const uint32_t*)(uintptr_t)(FLASH_JOBS_MAP_BASE + offset);
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "HexDecode.h"
+
+static int8_t nibbleValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+bool decodeHex(const char* text, size_t length, uint8_t* out, uint16_t maxLength, uint16_t* actualLength) {
+  const char* end = text + length;
+  uint16_t count = 0;
+  int8_t high = -1;  // First nibble of the byte in progress
+
+  while (text < end) {
+    char c = *text++;
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',') {
+      continue;
+    }
+
+    // 0x prefix, only at the start of a byte so "A0x" stays an error
+    if (c == '0' && high < 0 && text < end && (*text == 'x' || *text == 'X')) {
+      text++;
+      continue;
+    }
+
+    int8_t value = nibbleValue(c);
+    if (value < 0) {
+      return false;
+    }
+    if (high < 0) {
+      high = value;
+      continue;
+    }
+
+    if (count >= maxLength) {
+      return false;
+    }
+    out[count++] = (high << 4) | value;
+    high = -1;
+  }
+
+  if (high >= 0) {
+    return false;
+  }
+  *actualLength = count;
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef HEX_DECODE_H
+#define HEX_DECODE_H
+
+// Hex text to bytes in one pass, without copies or allocation
+//
+// Separators are skipped where they stand: spaces, tabs, line breaks, commas
+// and a 0x or 0X prefix in front of a byte. Bytes are written straight into
+// out. Fails on any other character, a dangling nibble or more than maxLength
+// bytes, out may then hold a partial result.
+//
+// No Arduino dependencies, the decoder can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+bool decodeHex(const char* text, size_t length, uint8_t* out, uint16_t maxLength, uint16_t* actualLength);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef IR_TIMING_H
+#define IR_TIMING_H
+
+// Nominal timings of the ESL IR symbol encoding
+// Plain constants only, so host-side tools can include this header too
+
+#include <stdint.h>
+
+#define IR_CARRIER_KHZ 1250      // Carrier frequency of every burst
+#define IR_BURST_US 39           // Length of each burst
+#define IR_FRAME_GAP_US 2000     // Silence between frame repeats, tag profiles may shorten it
+
+// Bursts are generated as whole carrier periods (48 x 800ns for 39us),
+// pauses are timed from the end of the burst as actually sent
+#define IR_BURST_PERIODS (IR_BURST_US * IR_CARRIER_KHZ / 1000)
+#define IR_BURST_ON_NS (IR_BURST_PERIODS * (1000000 / IR_CARRIER_KHZ))
+
+// Pause after a burst encodes two bits, indexed by symbol value
+static const uint16_t IR_PAUSE_US[4] = { 56, 237, 117, 178 };
+
+#endif
\ No newline at end of file
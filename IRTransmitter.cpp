@@ -1,134 +1,301 @@
 #include "IRTransmitter.h"
+#include "Profiler.h"
+#include "IRTiming.h"
+#include "CarrierKernel.h"
 #include <user_interface.h>  // For system_update_cpu_freq()
 
+extern Profiler profiler;
+
+// Every burst kernel instantiation the boot calibration can choose from
+#define CARRIER_KERNEL(name, mhz, trim) \
+  static void ICACHE_RAM_ATTR name(uint32_t pinMask, uint32_t periods) { \
+    CarrierKernel<mhz, IR_CARRIER_KHZ, trim>::run(pinMask, periods); \
+  }
+
+CARRIER_KERNEL(carrier160m4, 160, -4)
+CARRIER_KERNEL(carrier160m2, 160, -2)
+CARRIER_KERNEL(carrier160, 160, 0)
+CARRIER_KERNEL(carrier160p2, 160, 2)
+CARRIER_KERNEL(carrier160p4, 160, 4)
+CARRIER_KERNEL(carrier80m2, 80, -2)
+CARRIER_KERNEL(carrier80, 80, 0)
+CARRIER_KERNEL(carrier80p2, 80, 2)
+
+static const CarrierKernelInfo CARRIER_KERNELS[] = {
+  { 160, -4, carrier160m4 },
+  { 160, -2, carrier160m2 },
+  { 160, 0, carrier160 },
+  { 160, 2, carrier160p2 },
+  { 160, 4, carrier160p4 },
+  { 80, -2, carrier80m2 },
+  { 80, 0, carrier80 },
+  { 80, 2, carrier80p2 }
+};
+
+#define CARRIER_KERNEL_COUNT (sizeof(CARRIER_KERNELS) / sizeof(CARRIER_KERNELS[0]))
+
+// Every burst has the same length, so its carrier period count is fixed at compile time
+static constexpr uint32_t BURST_PERIODS = CarrierKernel<160, IR_CARRIER_KHZ, 0>::periodsFor(IR_BURST_US);
+static_assert(BURST_PERIODS == IR_BURST_PERIODS, "Burst length must match the nominal timing");
+
 IRTransmitter::IRTransmitter(int pin) {
   _irPin = pin;
   _busy = false;
   _pinMask = (1 << pin); // Prepare pin mask for direct port manipulation
+  _channelMasks[0] = _pinMask;
+  _channelCount = 1;
+  _burstLeadCycles = 0;
+  _lastBurstStart = 0;
+  _kernel = &CARRIER_KERNELS[2]; // Untrimmed 160MHz until calibrated
+  _savedCpuFreq = 160;
+  _frameGapUs = IR_FRAME_GAP_US;
+  _gapPending = false;
+  _gapDeadline = 0;
+  _gapCycles = 0;
+  _gapMHz = 160;
+  _gapsDeferred = 0;
+  _gapSpinUs = 0;
 }
 
 void IRTransmitter::begin() {
   pinMode(_irPin, OUTPUT);
   digitalWrite(_irPin, LOW);
+  
+  calibrate();
 }
 
-// Optimized high-precision burst generation for 1.25MHz signal
-// Using ICACHE_RAM_ATTR to ensure code runs from RAM for consistent timing
-void ICACHE_RAM_ATTR IRTransmitter::sendBurst(int durationUs) {
-  // Calculate cycle count for duration
-  // At 1.25MHz, each full cycle takes 0.8μs
-  uint32_t cycles = (durationUs * 1250) / 1000;
+// Pick the kernel whose measured carrier period is closest to nominal, then
+// measure the fixed cost between calling sendBurst and the carrier switching on
+void IRTransmitter::calibrate() {
+  const uint32_t periods = 1000;
+  const uint32_t nominalNs = 1000000 / IR_CARRIER_KHZ;
+  uint32_t bestError = UINT32_MAX;
   
-  // Save current CPU frequency and set to maximum
+  // All kernels run with an empty pin mask, the LEDs stay dark while calibrating
   uint32_t oldCPUFreq = system_get_cpu_freq();
-  system_update_cpu_freq(160); // Set CPU to 160MHz for most precise timing
-  
-  // Save interrupt state and disable interrupts
-  uint32_t savedInterruptState = xt_rsil(15); // Disable all interrupts
   
-  // Each cycle is 0.8μs (1/1.25MHz)
-  // At 160MHz, each machine cycle is 6.25ns
-  // So we need 128 cycles per IR cycle (0.8μs / 6.25ns)
-  // With 50% duty cycle, that's 64 cycles each for HIGH and LOW
-  
-  for (uint32_t i = 0; i < cycles; i++) {
-    // Set pin HIGH
-    GPOS = _pinMask;
+  for (uint8_t k = 0; k < CARRIER_KERNEL_COUNT; k++) {
+    const CarrierKernelInfo& kernel = CARRIER_KERNELS[k];
+    system_update_cpu_freq(kernel.cpuMHz);
     
-    // Delay for exactly 0.4μs (half of 1.25MHz cycle) = 64 cycles at 160MHz
-    // Use inline assembly for precise timing
-    __asm__ __volatile__(
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop" // 54 nops + overhead ≈ 64 cycles
-    );
+    uint32_t savedInterruptState = xt_rsil(15);
+    uint32_t start = ESP.getCycleCount();
+    kernel.run(0, periods);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    xt_wsr_ps(savedInterruptState);
     
-    // Set pin LOW
-    GPOC = _pinMask;
+    // Cycle counter runs at the CPU clock, convert to nanoseconds per carrier period
+    uint32_t periodNs = (uint32_t)((uint64_t)cycles * 1000 / kernel.cpuMHz / periods);
+    uint32_t error = periodNs > nominalNs ? periodNs - nominalNs : nominalNs - periodNs;
     
-    // Delay for exactly 0.4μs again
-    __asm__ __volatile__(
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop" // 54 nops + overhead ≈ 64 cycles
-    );
-  }
-  
-  // Restore interrupt state and CPU frequency
-  xt_wsr_ps(savedInterruptState);
+    Serial.printf("Carrier kernel %uMHz trim %d: %luns\n", kernel.cpuMHz, kernel.trim, (unsigned long)periodNs);
+    
+    // Ties go to the earlier, faster-clocked entry
+    if (error < bestError) {
+      bestError = error;
+      _kernel = &kernel;
+    }
+  }
+  
+  // Entry overhead is measured at the clock the chosen kernel runs at
+  system_update_cpu_freq(_kernel->cpuMHz);
+  
+  const uint8_t runs = 16;
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < runs; i++) {
+    uint32_t called = ESP.getCycleCount();
+    sendCarrier(0, BURST_PERIODS);
+    total += _lastBurstStart - called;
+  }
+  _burstLeadCycles = total / runs;
+  
   system_update_cpu_freq(oldCPUFreq);
+  
+  Serial.printf("IR kernel %uMHz trim %d, burst lead %lu cycles\n",
+                _kernel->cpuMHz, _kernel->trim, (unsigned long)_burstLeadCycles);
 }
 
-// Send pause with different durations based on symbol value
+// Switch to the kernel's CPU clock once for a whole frame instead of per burst
+void IRTransmitter::beginFrameClock() {
+  _savedCpuFreq = system_get_cpu_freq();
+  if (_savedCpuFreq != _kernel->cpuMHz) {
+    system_update_cpu_freq(_kernel->cpuMHz);
+  }
+}
+
+void IRTransmitter::endFrameClock() {
+  if (_savedCpuFreq != _kernel->cpuMHz) {
+    rebaseGap(_savedCpuFreq);
+    system_update_cpu_freq(_savedCpuFreq);
+  }
+}
+
+// 1.25MHz carrier on the given pins using the calibrated kernel
 // Using ICACHE_RAM_ATTR to ensure code runs from RAM for consistent timing
-void ICACHE_RAM_ATTR IRTransmitter::sendPause(uint8_t symbol) {
-  uint32_t pauseTime;
-  
-  switch(symbol & 3) {
-    case 0:
-      pauseTime = 56;
-      break;
-    case 1:
-      pauseTime = 237;
-      break;
-    case 2:
-      pauseTime = 117;
-      break;
-    case 3:
-      pauseTime = 178;
-      break;
+void ICACHE_RAM_ATTR IRTransmitter::sendCarrier(uint32_t pinMask, uint32_t periods) {
+  // Save interrupt state and disable interrupts
+  uint32_t savedInterruptState = xt_rsil(15); // Disable all interrupts
+  uint32_t maskedSince = ESP.getCycleCount();
+  _lastBurstStart = maskedSince;
+  if (_trace.isRecording()) {
+    _trace.record(TRACE_BURST_START, 0, maskedSince);
   }
   
-  // More precise delay than delayMicroseconds for critical timing
-  uint32_t start = ESP.getCycleCount();
-  uint32_t target = start + (pauseTime * 160); // Convert μs to cycles at 160MHz
+  _kernel->run(pinMask, periods);
   
-  while (ESP.getCycleCount() < target) {
-    // Wait precisely
+  // Restore interrupt state
+  uint32_t maskedUntil = ESP.getCycleCount();
+  if (_trace.isRecording()) {
+    _trace.record(TRACE_BURST_END, 0, maskedUntil);
+  }
+  xt_wsr_ps(savedInterruptState);
+  profiler.recordIrqOff(maskedUntil - maskedSince, _kernel->cpuMHz);
+}
+
+// Busy-wait until an absolute cycle deadline
+// The signed difference keeps the comparison correct across counter wrap-around
+void ICACHE_RAM_ATTR IRTransmitter::waitUntil(uint32_t deadline) {
+  while ((int32_t)(ESP.getCycleCount() - deadline) < 0) {
     __asm__ __volatile__("nop"); // Prevent optimization from removing the loop
   }
 }
 
+// Leave the gap ending at deadline, in cycles of the kernel clock, to the caller
+void IRTransmitter::deferGap(uint32_t deadline, uint32_t cycles) {
+  _gapPending = true;
+  _gapDeadline = deadline;
+  _gapCycles = cycles;
+  _gapMHz = _kernel->cpuMHz;
+  _gapsDeferred++;
+}
+
+// Count the rest of the pending gap in cycles of the clock about to run, so
+// the cycle counter keeps measuring it across a change of CPU clock
+void IRTransmitter::rebaseGap(uint8_t cpuMHz) {
+  if (!_gapPending || cpuMHz == _gapMHz) {
+    return;
+  }
+  uint32_t now = ESP.getCycleCount();
+  uint32_t remaining = _gapDeadline - now;
+  if (remaining > _gapCycles) {
+    remaining = 0;
+  }
+  // Rounded up, the gap never comes out shorter
+  _gapDeadline = now + (uint32_t)(((uint64_t)remaining * cpuMHz + _gapMHz - 1) / _gapMHz);
+  _gapCycles = (uint32_t)(((uint64_t)_gapCycles * cpuMHz + _gapMHz - 1) / _gapMHz);
+  _gapMHz = cpuMHz;
+}
+
+void IRTransmitter::waitGap() {
+  if (!_gapPending) {
+    return;
+  }
+  _gapPending = false;
+  
+  // Background tasks get their turn between frames, as they always did
+  profiler.yieldNow();
+  rebaseGap(system_get_cpu_freq());
+  
+  // More than the whole gap left means the deadline has passed, possibly so
+  // long ago that the counter wrapped around
+  uint32_t remaining = _gapDeadline - ESP.getCycleCount();
+  if (remaining <= _gapCycles) {
+    _gapSpinUs += remaining / _gapMHz;
+    waitUntil(_gapDeadline);
+  }
+}
+
+// Frame bytes in RAM
+struct RamFrameBytes {
+  const uint8_t* data;
+  
+  inline uint8_t operator[](uint16_t index) const {
+    return data[index];
+  }
+};
+
+// Frame bytes in the flash mapping, which only allows aligned 32-bit loads
+// Flash is little endian, byte i is the i-th octet of word i / 4
+struct MappedFrameBytes {
+  const uint32_t* words;
+  
+  inline uint8_t operator[](uint16_t index) const {
+    return words[index >> 2] >> ((index & 3) << 3);
+  }
+};
+
 // Transmit a single frame with the specified repeat count
 void IRTransmitter::transmitFrame(uint8_t* buffer, uint8_t dataSize, uint16_t repeat) {
+  RamFrameBytes bytes = { buffer };
+  transmitSymbols(bytes, dataSize, repeat);
+}
+
+void IRTransmitter::transmitMappedFrame(const uint32_t* words, uint8_t dataSize, uint16_t repeat) {
+  MappedFrameBytes bytes = { words };
+  transmitSymbols(bytes, dataSize, repeat);
+}
+
+// Symbol timing shared by every frame source; a byte is fetched right after the
+// burst that precedes its first symbol, well inside the shortest pause
+template <typename FrameBytes>
+void IRTransmitter::transmitSymbols(const FrameBytes& bytes, uint8_t dataSize, uint16_t repeat) {
   _busy = true;
+  waitGap();
+  beginFrameClock();
   
   uint16_t sym_count = dataSize << 2;  // 1 byte = 4 symbols (2 bits per symbol)
+  uint32_t cyclesPerUs = _kernel->cpuMHz;
+  uint32_t burstCycles = BURST_PERIODS * (cyclesPerUs * 1000 / IR_CARRIER_KHZ);
   
   for (uint16_t r = 0; r < repeat; r++) {
-    for (uint16_t s = 0; s < sym_count; s++) {
-      uint8_t byte = buffer[s >> 2];  // Load new byte every 4 symbols
-      uint8_t symbol = (byte >> (6 - ((s & 3) << 1))) & 3;  // Extract 2-bit symbol
+    // Every symbol of this repeat is scheduled against this origin, so time
+    // spent inside sendBurst never accumulates from one symbol to the next
+    uint32_t deadline = ESP.getCycleCount() + _burstLeadCycles;
+    
+    if (_trace.isRecording()) {
+      _trace.record(TRACE_FRAME_START, 0, ESP.getCycleCount());
+    }
+    
+    // No yield inside a frame: any delay here would stretch a pause and corrupt the symbol
+    uint8_t lastSymbol = 0;
+    for (uint16_t s = 0; s <= sym_count; s++) {
+      // Burst starts on its deadline, minus the calibrated entry overhead
+      waitUntil(deadline - _burstLeadCycles);
       
-      // Send burst
-      sendBurst(39);
+      if (s > 0 && _trace.isRecording()) {
+        _trace.record(TRACE_PAUSE_END, lastSymbol, ESP.getCycleCount());
+      }
       
-      // Send symbol pause
-      sendPause(symbol);
+      sendCarrier(_pinMask, BURST_PERIODS);
       
-      // Allow the ESP8266 to perform background tasks every 32 symbols
-      // This helps maintain WiFi connection during long transmissions
-      if ((s & 0x1F) == 0) {
-        yield();
+      // The frame ends with one extra burst after the last symbol
+      if (s == sym_count) {
+        break;
       }
+      
+      uint8_t byte = bytes[s >> 2];  // Load new byte every 4 symbols
+      lastSymbol = (byte >> (6 - ((s & 3) << 1))) & 3;  // Extract 2-bit symbol
+      
+      // Next burst starts one burst plus one symbol pause later
+      deadline += burstCycles + IR_PAUSE_US[lastSymbol] * cyclesPerUs;
     }
     
-    // Final burst
-    sendBurst(39);
+    deadline += burstCycles + _frameGapUs * cyclesPerUs;
     
-    // Inter-frame delay
-    delayMicroseconds(2000);
+    // The caller spends the gap after the last repeat
+    if (r + 1 == repeat) {
+      deferGap(deadline, burstCycles + _frameGapUs * cyclesPerUs);
+      break;
+    }
     
     // Allow ESP8266 to handle background tasks between frames
-    yield();
+    profiler.yieldNow();
+    
+    // Inter-frame gap is at least _frameGapUs even if the yield was short
+    waitUntil(deadline);
   }
   
+  endFrameClock();
   _busy = false;
 }
 
@@ -136,14 +303,110 @@ void IRTransmitter::transmitFrame(uint8_t* buffer, uint8_t dataSize, uint16_t re
 void IRTransmitter::transmitFrames(uint8_t** frames, uint8_t* sizes, uint16_t* repeats, uint8_t frameCount) {
   for (uint8_t i = 0; i < frameCount; i++) {
     transmitFrame(frames[i], sizes[i], repeats[i]);
-    yield();  // Allow ESP8266 to handle background tasks
+    profiler.yieldNow();  // Allow ESP8266 to handle background tasks
+  }
+}
+
+uint8_t IRTransmitter::addChannel(int pin) {
+  if (_channelCount >= EDGE_MAX_CHANNELS) {
+    return 0xFF;
+  }
+  
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  
+  _channelMasks[_channelCount] = (1 << pin);
+  return _channelCount++;
+}
+
+uint8_t IRTransmitter::getChannelCount() {
+  return _channelCount;
+}
+
+// Cycle offset of a schedule time, split to stay within 32 bits for long frames
+static inline uint32_t nsToCycles(uint32_t ns, uint32_t cpuMHz) {
+  return (ns / 1000) * cpuMHz + (ns % 1000) * cpuMHz / 1000;
+}
+
+// Transmit one frame per channel concurrently from a merged edge schedule
+// Whenever one channel pauses, the others can burst; overlapping bursts
+// simply drive both LEDs from the same carrier loop
+bool IRTransmitter::transmitParallel(const ChannelFrame* frames, uint8_t count, uint16_t repeat) {
+  if (count == 0 || count > _channelCount) {
+    return false;
+  }
+  
+  _busy = true;
+  waitGap();
+  beginFrameClock();
+  
+  // The symbol trace describes a single channel, do not mix merged carrier segments into it
+  _trace.setPaused(true);
+  
+  uint32_t cpuMHz = _kernel->cpuMHz;
+  
+  for (uint16_t r = 0; r < repeat; r++) {
+    SegmentStream segments;
+    segments.begin(frames, count);
+    
+    uint32_t origin = ESP.getCycleCount() + _burstLeadCycles;
+    
+    // Carrier runs for each segment on the channels in its mask
+    CarrierSegment segment;
+    while (segments.next(&segment)) {
+      uint32_t pins = 0;
+      for (uint8_t c = 0; c < count; c++) {
+        if (segment.mask & (1 << c)) {
+          pins |= _channelMasks[c];
+        }
+      }
+      
+      waitUntil(origin + nsToCycles(segment.startNs, cpuMHz) - _burstLeadCycles);
+      sendCarrier(pins, segment.periods);
+    }
+    
+    uint32_t deadline = origin + nsToCycles(segments.getLastEdgeNs(), cpuMHz) + _frameGapUs * cpuMHz;
+    if (r + 1 == repeat) {
+      deferGap(deadline, _frameGapUs * cpuMHz);
+      break;
+    }
+    
+    // Allow ESP8266 to handle background tasks between frames
+    profiler.yieldNow();
+    waitUntil(deadline);
   }
+  
+  _trace.setPaused(false);
+  endFrameClock();
+  _busy = false;
+  return true;
+}
+
+bool IRTransmitter::enableTrace(uint16_t capacity) {
+  // Timestamps are taken at the clock of the calibrated kernel
+  return _trace.begin(capacity, _kernel->cpuMHz);
+}
+
+void IRTransmitter::disableTrace() {
+  _trace.end();
+}
+
+SymbolTrace* IRTransmitter::getTrace() {
+  return &_trace;
 }
 
 bool IRTransmitter::isBusy() {
   return _busy;
 }
 
+void IRTransmitter::setFrameGap(uint16_t gapUs) {
+  _frameGapUs = gapUs;
+}
+
+uint16_t IRTransmitter::getFrameGap() {
+  return _frameGapUs;
+}
+
 // Test function for verifying 1.25MHz frequency
 void IRTransmitter::testFrequency() {
   Serial.println("Generating 1.25MHz test signal for 5 seconds");
@@ -151,40 +414,26 @@ void IRTransmitter::testFrequency() {
   // Set pin directly
   pinMode(_irPin, OUTPUT);
   
-  // Set to maximum CPU frequency
-  uint32_t oldCPUFreq = system_get_cpu_freq();
-  system_update_cpu_freq(160);
+  waitGap();
+  beginFrameClock();
   
-  // Disable interrupts for clean signal
-  uint32_t savedInterruptState = xt_rsil(15);
+  // Same kernel as real bursts, masked in 10ms slices instead of for the whole
+  // 5 seconds so the watchdog and WiFi stack keep running between slices
+  const uint32_t slicePeriods = CarrierKernel<160, IR_CARRIER_KHZ, 0>::periodsFor(10000);
   
   unsigned long startTime = millis();
   while (millis() - startTime < 5000) {
-    // Direct port manipulation
-    GPOS = _pinMask;
-    __asm__ __volatile__(
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop"
-    );
+    uint32_t savedInterruptState = xt_rsil(15);
+    uint32_t maskedSince = ESP.getCycleCount();
+    _kernel->run(_pinMask, slicePeriods);
+    uint32_t maskedCycles = ESP.getCycleCount() - maskedSince;
+    xt_wsr_ps(savedInterruptState);
+    profiler.recordIrqOff(maskedCycles, _kernel->cpuMHz);
     
-    GPOC = _pinMask;
-    __asm__ __volatile__(
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\nnop\n"
-      "nop\nnop\nnop\nnop"
-    );
-  }
-  
-  // Restore interrupts
-  xt_wsr_ps(savedInterruptState);
-  system_update_cpu_freq(oldCPUFreq);
+    profiler.yieldNow();
+  }
+  
+  endFrameClock();
   
   Serial.println("Test complete");
 }
\ No newline at end of file
@@ -2,23 +2,74 @@
 #define IR_TRANSMITTER_H
 
 #include <Arduino.h>
+#include "SymbolTrace.h"
+#include "CarrierKernel.h"
+#include "EdgeSchedule.h"
+
+// The silence after a frame is not waited out before returning: the caller
+// gets it to encode the next frame or serve the network, and the next
+// transmission spins on the cycle counter for whatever is left of it. Work
+// longer than the gap stretches it, it never shortens it. Gaps between the
+// repeats of one frame are still kept inside the transmission.
 
 class IRTransmitter {
   public:
     IRTransmitter(int pin);
     void begin();
     void transmitFrame(uint8_t* buffer, uint8_t dataSize, uint16_t repeat);
+    // Same, reading the frame in place from memory-mapped flash (32-bit aligned)
+    void transmitMappedFrame(const uint32_t* words, uint8_t dataSize, uint16_t repeat);
     void transmitFrames(uint8_t** frames, uint8_t* sizes, uint16_t* repeats, uint8_t frameCount);
+    
+    // Extra IR LEDs on their own GPIOs; channel 0 is the pin given to the constructor
+    uint8_t addChannel(int pin);
+    uint8_t getChannelCount();
+    // Send a different frame on each channel at once, channel i carries frames[i]
+    bool transmitParallel(const ChannelFrame* frames, uint8_t count, uint16_t repeat);
     bool isBusy();
+    // Wait out the gap after the last frame; every transmission does this first
+    void waitGap();
+    // Gaps handed to the caller, and the part of them still spent spinning
+    uint32_t getGapsDeferred() { return _gapsDeferred; }
+    uint64_t getGapSpinUs() { return _gapSpinUs; }
+    // Silence after each frame and repeat, IR_FRAME_GAP_US until set
+    void setFrameGap(uint16_t gapUs);
+    uint16_t getFrameGap();
     void testFrequency();
     
+    // Optional symbol timing capture, buffer is allocated only while enabled
+    bool enableTrace(uint16_t capacity);
+    void disableTrace();
+    SymbolTrace* getTrace();
+    
   private:
     int _irPin;
     bool _busy;
     uint32_t _pinMask;
+    uint32_t _channelMasks[EDGE_MAX_CHANNELS];
+    uint8_t _channelCount;
+    SymbolTrace _trace;
+    uint32_t _burstLeadCycles;   // Calibrated cycles from sendBurst() call to carrier on
+    uint32_t _lastBurstStart;    // Cycle count when the last burst switched the carrier on
+    const CarrierKernelInfo* _kernel;  // Burst kernel picked by the boot calibration
+    uint8_t _savedCpuFreq;
+    uint16_t _frameGapUs;
+    bool _gapPending;
+    uint32_t _gapDeadline;       // Cycle count when the next frame may start
+    uint32_t _gapCycles;         // Longest the gap can still run, for wrap-around
+    uint8_t _gapMHz;             // Clock the gap deadline is counted in
+    uint32_t _gapsDeferred;
+    uint64_t _gapSpinUs;
     
-    void ICACHE_RAM_ATTR sendBurst(int durationUs);
-    void ICACHE_RAM_ATTR sendPause(uint8_t symbol);
+    void calibrate();
+    void deferGap(uint32_t deadline, uint32_t cycles);
+    void rebaseGap(uint8_t cpuMHz);
+    template <typename FrameBytes>
+    void transmitSymbols(const FrameBytes& bytes, uint8_t dataSize, uint16_t repeat);
+    void beginFrameClock();
+    void endFrameClock();
+    void ICACHE_RAM_ATTR sendCarrier(uint32_t pinMask, uint32_t periods);
+    void ICACHE_RAM_ATTR waitUntil(uint32_t deadline);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,757 @@
+#include "JobSpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File layout, all integers little endian:
+//   header   "ESLJ", version, priority, barcode count, reserved,
+//            not-before (u32), created-at (u32), deadline (u32, version 2),
+//            tag (u32), kind, page, reserved (u16) (version 3)
+//   barcodes barcode count x 17 bytes
+//   frames   type, size, repeats (u16), size bytes of encoded frame
+// Progress file: next frame (u16), reserved (u16), next frame offset (u32)
+// Sequence file: the next job id (u32), so ids never repeat once the queue
+// has drained; compiled copies in flash are matched by id
+#define SPOOL_MAGIC "ESLJ"
+#define SPOOL_VERSION 3
+#define SPOOL_HEADER_SIZE 28
+#define SPOOL_HEADER_SIZE_V1 16
+#define SPOOL_HEADER_SIZE_V2 20
+#define SPOOL_RECORD_HEADER 4
+#define SPOOL_PROGRESS_SIZE 8
+#define SPOOL_NAME_SIZE 16
+#define SPOOL_MAX_STALE 8
+#define SPOOL_SEQUENCE_NAME "next.seq"
+
+static const char* CLASS_NAMES[SPOOL_CLASS_COUNT] = {
+  "bulk", "normal", "urgent"
+};
+
+static void putLE16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+  putLE16(out, value & 0xFFFF);
+  putLE16(out + 2, value >> 16);
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+  return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+  return getLE16(in) | ((uint32_t)getLE16(in + 2) << 16);
+}
+
+// Collects the spool directory listing for begin()
+struct SpoolScan {
+  JobSpool* spool;
+  char stale[SPOOL_MAX_STALE][SPOOL_NAME_SIZE];
+  uint8_t staleCount;
+  uint32_t maxId;
+};
+
+JobSpool::JobSpool(SpoolStorage& storage, SpoolClockFn clock, SpoolMillisFn millisClock) : _storage(storage) {
+  _clock = clock;
+  _millis = millisClock;
+  _jobCount = 0;
+  _nextId = 1;
+  _active = SPOOL_NO_JOB;
+  _building = SPOOL_NO_JOB;
+  _wakeType = SPOOL_NO_TYPE;
+  _dataType = SPOOL_NO_TYPE;
+  _wakeWindowMs = 0;
+  memset(_stats, 0, sizeof(_stats));
+  _replaced = 0;
+  _merged = 0;
+  _done = NULL;
+  _doneContext = NULL;
+}
+
+void JobSpool::setFrameRoles(uint8_t wakeType, uint8_t dataType, uint32_t wakeWindowMs) {
+  _wakeType = wakeType;
+  _dataType = dataType;
+  _wakeWindowMs = wakeWindowMs;
+}
+
+void JobSpool::setDoneHandler(SpoolDoneFn done, void* context) {
+  _done = done;
+  _doneContext = context;
+}
+
+const char* JobSpool::className(uint8_t spoolClass) {
+  return spoolClass < SPOOL_CLASS_COUNT ? CLASS_NAMES[spoolClass] : "unknown";
+}
+
+void JobSpool::makeName(char* out, uint32_t id, const char* extension) {
+  snprintf(out, SPOOL_NAME_SIZE, "%08lx.%s", (unsigned long)id, extension);
+}
+
+bool JobSpool::begin() {
+  _jobCount = 0;
+  _active = SPOOL_NO_JOB;
+  _building = SPOOL_NO_JOB;
+
+  if (!_storage.begin()) {
+    return false;
+  }
+
+  SpoolScan scan;
+  scan.spool = this;
+  scan.staleCount = 0;
+  scan.maxId = 0;
+  _storage.list(listEntry, &scan);
+
+  // Temp files are jobs that were still being queued when the power went
+  for (uint8_t i = 0; i < scan.staleCount; i++) {
+    _storage.remove(scan.stale[i]);
+  }
+
+  // Ids carry on after the last one handed out, even if its job is gone
+  _nextId = scan.maxId + 1;
+  uint8_t sequence[4];
+  if (_storage.read(SPOOL_SEQUENCE_NAME, 0, sequence, sizeof(sequence)) == sizeof(sequence) &&
+      getLE32(sequence) > _nextId) {
+    _nextId = getLE32(sequence);
+  }
+
+  // A job with progress was interrupted mid-transmission, finish it first
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    if (_jobs[i].nextFrame > 0) {
+      _active = _jobs[i].id;
+      break;
+    }
+  }
+
+  return true;
+}
+
+void JobSpool::listEntry(void* context, const char* name, uint32_t size) {
+  SpoolScan* scan = (SpoolScan*)context;
+
+  if (strlen(name) != 12 || name[8] != '.') {
+    return;
+  }
+
+  uint32_t id = strtoul(name, NULL, 16);
+  if (id > scan->maxId) {
+    scan->maxId = id;
+  }
+
+  const char* extension = name + 9;
+  if (strcmp(extension, "job") == 0) {
+    if (!scan->spool->loadJob(id, size) && scan->staleCount < SPOOL_MAX_STALE) {
+      strcpy(scan->stale[scan->staleCount++], name);
+    }
+  } else if (strcmp(extension, "tmp") == 0 && scan->staleCount < SPOOL_MAX_STALE) {
+    strcpy(scan->stale[scan->staleCount++], name);
+  }
+}
+
+bool JobSpool::loadJob(uint32_t id, uint32_t size) {
+  if (_jobCount >= SPOOL_MAX_JOBS) {
+    return true;  // Keep the file, it gets picked up once the queue drains and we reboot
+  }
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, id, "job");
+
+  // Files from before deadlines (version 1) and targets (version 2) have shorter headers
+  uint8_t header[SPOOL_HEADER_SIZE];
+  if (_storage.read(name, 0, header, SPOOL_HEADER_SIZE_V1) != SPOOL_HEADER_SIZE_V1 ||
+      memcmp(header, SPOOL_MAGIC, 4) != 0 || header[4] < 1 || header[4] > SPOOL_VERSION ||
+      header[6] > SPOOL_MAX_BARCODES) {
+    return false;
+  }
+
+  uint32_t headerSize = header[4] == 1 ? SPOOL_HEADER_SIZE_V1 :
+                        header[4] == 2 ? SPOOL_HEADER_SIZE_V2 : SPOOL_HEADER_SIZE;
+  if (headerSize > SPOOL_HEADER_SIZE_V1 &&
+      _storage.read(name, SPOOL_HEADER_SIZE_V1, &header[SPOOL_HEADER_SIZE_V1],
+                    headerSize - SPOOL_HEADER_SIZE_V1) != (int32_t)(headerSize - SPOOL_HEADER_SIZE_V1)) {
+    return false;
+  }
+
+  SpoolJobInfo job;
+  memset(&job, 0, sizeof(job));
+  job.id = id;
+  job.priority = header[5] < SPOOL_CLASS_COUNT ? header[5] : (uint8_t)SPOOL_CLASS_URGENT;
+  job.barcodeCount = header[6];
+  job.notBefore = getLE32(&header[8]);
+  job.createdAt = getLE32(&header[12]);
+  job.deadline = headerSize > SPOOL_HEADER_SIZE_V1 ? getLE32(&header[16]) : 0;
+  if (headerSize > SPOOL_HEADER_SIZE_V2) {
+    job.tag = getLE32(&header[20]);
+    job.kind = header[24];
+    job.page = header[25];
+  }
+  job.bytes = size;
+  job.firstOffset = headerSize + job.barcodeCount * SPOOL_BARCODE_LENGTH;
+
+  // Count the frames, only their record headers need reading
+  uint32_t offset = job.firstOffset;
+  while (offset + SPOOL_RECORD_HEADER <= size) {
+    uint8_t record[SPOOL_RECORD_HEADER];
+    if (_storage.read(name, offset, record, sizeof(record)) != sizeof(record)) {
+      break;
+    }
+    if (job.frameCount == 0) {
+      job.firstType = record[0];
+    }
+    offset += SPOOL_RECORD_HEADER + record[1];
+    if (offset > size) {
+      break;
+    }
+    job.frameCount++;
+  }
+
+  if (job.frameCount == 0) {
+    return false;
+  }
+
+  job.nextFrame = 0;
+  job.nextOffset = job.firstOffset;
+  job.nextType = job.firstType;
+
+  char posName[SPOOL_NAME_SIZE];
+  makeName(posName, id, "pos");
+  uint8_t progress[SPOOL_PROGRESS_SIZE];
+  if (_storage.read(posName, 0, progress, sizeof(progress)) == sizeof(progress)) {
+    uint16_t nextFrame = getLE16(&progress[0]);
+    uint32_t nextOffset = getLE32(&progress[4]);
+    if (nextFrame < job.frameCount && nextOffset >= job.firstOffset && nextOffset < size) {
+      job.nextFrame = nextFrame;
+      job.nextOffset = nextOffset;
+      job.nextType = readType(id, nextOffset);
+    }
+  }
+
+  // Keep the index ordered by id, which is also the order of queueing
+  uint8_t index = _jobCount;
+  while (index > 0 && _jobs[index - 1].id > id) {
+    _jobs[index] = _jobs[index - 1];
+    index--;
+  }
+  _jobs[index] = job;
+  _jobCount++;
+  return true;
+}
+
+uint32_t JobSpool::beginJob(uint32_t notBefore, uint32_t deadline, uint8_t priority,
+                            const char* const* barcodes, uint8_t barcodeCount,
+                            const SpoolJobTarget* target) {
+  abortJob();
+
+  if (_jobCount >= SPOOL_MAX_JOBS || barcodeCount > SPOOL_MAX_BARCODES ||
+      priority >= SPOOL_CLASS_COUNT) {
+    return SPOOL_NO_JOB;
+  }
+
+  uint8_t header[SPOOL_HEADER_SIZE];
+  memcpy(header, SPOOL_MAGIC, 4);
+  header[4] = SPOOL_VERSION;
+  header[5] = priority;
+  header[6] = barcodeCount;
+  header[7] = 0;
+  putLE32(&header[8], notBefore);
+  putLE32(&header[12], _clock());
+  putLE32(&header[16], deadline);
+  putLE32(&header[20], target ? target->tag : 0);
+  header[24] = target ? target->kind : (uint8_t)SPOOL_KIND_OTHER;
+  header[25] = target ? target->page : 0;
+  putLE16(&header[26], 0);
+
+  uint32_t id = _nextId++;
+  uint8_t sequence[4];
+  putLE32(sequence, _nextId);
+  if (!_storage.write(SPOOL_SEQUENCE_NAME, sequence, sizeof(sequence))) {
+    return SPOOL_NO_JOB;
+  }
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, id, "tmp");
+  if (!_storage.write(name, header, sizeof(header))) {
+    return SPOOL_NO_JOB;
+  }
+
+  for (uint8_t i = 0; i < barcodeCount; i++) {
+    char barcode[SPOOL_BARCODE_LENGTH];
+    memset(barcode, 0, sizeof(barcode));
+    strncpy(barcode, barcodes[i], SPOOL_BARCODE_LENGTH);
+    if (!_storage.append(name, barcode, sizeof(barcode))) {
+      _storage.remove(name);
+      return SPOOL_NO_JOB;
+    }
+  }
+
+  _building = id;
+  memset(&_pending, 0, sizeof(_pending));
+  _pending.id = id;
+  _pending.notBefore = notBefore;
+  _pending.deadline = deadline;
+  _pending.createdAt = getLE32(&header[12]);
+  _pending.priority = priority;
+  _pending.kind = header[24];
+  _pending.page = header[25];
+  _pending.tag = getLE32(&header[20]);
+  _pending.barcodeCount = barcodeCount;
+  _pending.firstOffset = SPOOL_HEADER_SIZE + barcodeCount * SPOOL_BARCODE_LENGTH;
+  _pending.nextOffset = _pending.firstOffset;
+  _pending.bytes = _pending.firstOffset;
+  return id;
+}
+
+bool JobSpool::appendFrame(uint8_t type, const uint8_t* data, uint8_t size, uint16_t repeats) {
+  if (_building == SPOOL_NO_JOB || _pending.frameCount == 0xFFFF) {
+    return false;
+  }
+
+  uint8_t record[SPOOL_RECORD_HEADER + SPOOL_MAX_FRAME];
+  record[0] = type;
+  record[1] = size;
+  putLE16(&record[2], repeats);
+  memcpy(&record[SPOOL_RECORD_HEADER], data, size);
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, _building, "tmp");
+  if (!_storage.append(name, record, SPOOL_RECORD_HEADER + size)) {
+    return false;
+  }
+
+  if (_pending.frameCount == 0) {
+    _pending.firstType = type;
+    _pending.nextType = type;
+  }
+  _pending.frameCount++;
+  _pending.bytes += SPOOL_RECORD_HEADER + size;
+  return true;
+}
+
+bool JobSpool::commitJob() {
+  if (_building == SPOOL_NO_JOB) {
+    return false;
+  }
+
+  if (_pending.frameCount == 0 || _jobCount >= SPOOL_MAX_JOBS) {
+    abortJob();
+    return false;
+  }
+
+  char tmpName[SPOOL_NAME_SIZE];
+  char jobName[SPOOL_NAME_SIZE];
+  makeName(tmpName, _building, "tmp");
+  makeName(jobName, _building, "job");
+  if (!_storage.rename(tmpName, jobName)) {
+    abortJob();
+    return false;
+  }
+
+  // The new job is not in the index yet, so it cannot drop itself; it takes
+  // over the class and deadline of the pings and refreshes it covers
+  _building = SPOOL_NO_JOB;
+  if (_pending.kind == SPOOL_KIND_UPDATE) {
+    uint8_t priority = _pending.priority;
+    uint32_t deadline = _pending.deadline;
+    dropCovered(_pending.tag, _pending.page, _pending.notBefore, &priority, &deadline);
+    tighten(_pending, priority, deadline);
+  }
+
+  // New ids are always the largest, append keeps the index ordered
+  _jobs[_jobCount++] = _pending;
+  return true;
+}
+
+void JobSpool::abortJob() {
+  if (_building == SPOOL_NO_JOB) {
+    return;
+  }
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, _building, "tmp");
+  _storage.remove(name);
+  _building = SPOOL_NO_JOB;
+}
+
+int8_t JobSpool::findJob(uint32_t id) {
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    if (_jobs[i].id == id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void JobSpool::removeJob(uint8_t index) {
+  char name[SPOOL_NAME_SIZE];
+  uint32_t id = _jobs[index].id;
+
+  makeName(name, id, "job");
+  _storage.remove(name);
+  makeName(name, id, "pos");
+  _storage.remove(name);
+
+  if (_active == id) {
+    _active = SPOOL_NO_JOB;
+  }
+
+  for (uint8_t i = index; i + 1 < _jobCount; i++) {
+    _jobs[i] = _jobs[i + 1];
+  }
+  _jobCount--;
+}
+
+void JobSpool::finishJob(uint8_t index, bool completed) {
+  const SpoolJobInfo& job = _jobs[index];
+  if (_done) {
+    uint32_t latencyMs = job.dueSinceMs ? _millis() - job.dueSinceMs : 0;
+    _done(_doneContext, job, completed, latencyMs);
+  }
+  removeJob(index);
+}
+
+bool JobSpool::cancelJob(uint32_t id) {
+  int8_t index = findJob(id);
+  if (index < 0) {
+    return false;
+  }
+  removeJob(index);
+  return true;
+}
+
+uint32_t JobSpool::dueAt(uint32_t notBefore) {
+  // Jobs already due, or without a time, are all due now
+  uint32_t time = _clock();
+  return notBefore > time ? notBefore : time;
+}
+
+uint32_t JobSpool::findCoveringUpdate(uint32_t tag, uint32_t notBefore) {
+  uint32_t due = dueAt(notBefore);
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    const SpoolJobInfo& job = _jobs[i];
+    if (job.kind == SPOOL_KIND_UPDATE && job.tag == tag && job.nextFrame == 0 &&
+        dueAt(job.notBefore) <= due) {
+      return job.id;
+    }
+  }
+  return SPOOL_NO_JOB;
+}
+
+bool JobSpool::mergeInto(uint32_t id, uint8_t priority, uint32_t deadline) {
+  int8_t index = findJob(id);
+  if (index < 0) {
+    return false;
+  }
+  _merged++;
+  return tighten(_jobs[index], priority, deadline);
+}
+
+bool JobSpool::tighten(SpoolJobInfo& job, uint8_t priority, uint32_t deadline) {
+  bool earlier = deadline != 0 && (job.deadline == 0 || deadline < job.deadline);
+  if (priority <= job.priority && !earlier) {
+    return true;
+  }
+
+  // Version 1 headers end before the deadline, such jobs are never targeted
+  uint32_t headerSize = job.firstOffset - job.barcodeCount * SPOOL_BARCODE_LENGTH;
+  if (earlier && headerSize <= SPOOL_HEADER_SIZE_V1) {
+    return false;
+  }
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, job.id, "job");
+  if (priority > job.priority) {
+    uint8_t value = priority;
+    if (!_storage.writeAt(name, 5, &value, 1)) {
+      return false;
+    }
+    job.priority = priority;
+  }
+  if (earlier) {
+    uint8_t value[4];
+    putLE32(value, deadline);
+    if (!_storage.writeAt(name, 16, value, sizeof(value))) {
+      return false;
+    }
+    job.deadline = deadline;
+  }
+  return true;
+}
+
+uint8_t JobSpool::dropSuperseded(uint32_t tag, uint8_t page, uint32_t notBefore) {
+  uint8_t priority = 0;
+  uint32_t deadline = 0;
+  return dropCovered(tag, page, notBefore, &priority, &deadline);
+}
+
+uint8_t JobSpool::dropCovered(uint32_t tag, uint8_t page, uint32_t notBefore,
+                              uint8_t* priority, uint32_t* deadline) {
+  uint32_t due = dueAt(notBefore);
+  uint8_t dropped = 0;
+
+  // A job that has sent a frame is left alone, the tag may be mid-transfer;
+  // one due after the update is meant to follow it, e.g. tomorrow's price
+  uint8_t i = 0;
+  while (i < _jobCount) {
+    const SpoolJobInfo& job = _jobs[i];
+    bool covered = job.tag == tag && job.nextFrame == 0 && dueAt(job.notBefore) <= due &&
+                   ((job.kind == SPOOL_KIND_UPDATE && job.page == page) ||
+                    job.kind == SPOOL_KIND_PING || job.kind == SPOOL_KIND_REFRESH);
+    if (!covered) {
+      i++;
+      continue;
+    }
+
+    if (job.kind == SPOOL_KIND_UPDATE) {
+      _replaced++;
+    } else {
+      _merged++;
+      if (job.priority > *priority) {
+        *priority = job.priority;
+      }
+      if (job.deadline != 0 && (*deadline == 0 || job.deadline < *deadline)) {
+        *deadline = job.deadline;
+      }
+    }
+    removeJob(i);
+    dropped++;
+  }
+  return dropped;
+}
+
+const SpoolJobInfo& JobSpool::getJob(uint8_t index) {
+  return _jobs[index];
+}
+
+const SpoolJobInfo* JobSpool::findJobInfo(uint32_t id) {
+  int8_t index = findJob(id);
+  return index < 0 ? NULL : &_jobs[index];
+}
+
+bool JobSpool::getBarcode(uint32_t id, uint8_t index, char* out) {
+  int8_t job = findJob(id);
+  if (job < 0 || index >= _jobs[job].barcodeCount) {
+    return false;
+  }
+
+  // Barcodes sit right in front of the first frame
+  uint32_t offset = _jobs[job].firstOffset - (_jobs[job].barcodeCount - index) * SPOOL_BARCODE_LENGTH;
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, id, "job");
+  if (_storage.read(name, offset, out, SPOOL_BARCODE_LENGTH) != SPOOL_BARCODE_LENGTH) {
+    return false;
+  }
+  out[SPOOL_BARCODE_LENGTH] = '\0';
+  return true;
+}
+
+bool JobSpool::ranksBefore(const SpoolJobInfo& a, const SpoolJobInfo& b) {
+  if (a.priority != b.priority) {
+    return a.priority > b.priority;
+  }
+
+  // Within a class, finish what was started before opening another tag
+  if ((a.nextFrame > 0) != (b.nextFrame > 0)) {
+    return a.nextFrame > 0;
+  }
+
+  // Earliest deadline first, jobs without one after all that have one
+  if (a.deadline != b.deadline) {
+    if (a.deadline == 0 || b.deadline == 0) {
+      return b.deadline == 0;
+    }
+    return a.deadline < b.deadline;
+  }
+
+  if (a.notBefore != b.notBefore) {
+    return a.notBefore < b.notBefore;
+  }
+  return a.id < b.id;
+}
+
+int8_t JobSpool::pickDue() {
+  uint32_t time = _clock();
+  uint32_t nowMs = _millis();
+  int8_t best = -1;
+
+  for (uint8_t i = 0; i < _jobCount; i++) {
+    SpoolJobInfo& job = _jobs[i];
+
+    // Timed jobs wait until the clock has been set
+    if (job.notBefore != 0 && (time == 0 || time < job.notBefore)) {
+      continue;
+    }
+
+    // Waiting time is counted from the first service that saw the job due
+    if (job.dueSinceMs == 0) {
+      job.dueSinceMs = nowMs ? nowMs : 1;
+    }
+
+    if (best < 0 || ranksBefore(job, _jobs[best])) {
+      best = i;
+    }
+  }
+
+  int8_t active = _active != SPOOL_NO_JOB ? findJob(_active) : -1;
+  if (active < 0 || best < 0 || best == active) {
+    return best;
+  }
+
+  // The running job only yields to a higher class, and only in front of a data frame
+  const SpoolJobInfo& running = _jobs[active];
+  if (_jobs[best].priority > running.priority && running.nextType == _dataType) {
+    return best;
+  }
+  return active;
+}
+
+uint16_t JobSpool::frameToSend(const SpoolJobInfo& job) {
+  // A tag left alone longer than its wake window needs its wake frame again;
+  // after a reboot nothing is known about it, so it is woken as well
+  if (job.nextFrame > 0 && job.firstType == _wakeType && job.nextType != _wakeType &&
+      (job.lastSentMs == 0 || (uint32_t)(_millis() - job.lastSentMs) > _wakeWindowMs)) {
+    return 0;
+  }
+  return job.nextFrame;
+}
+
+void JobSpool::noteSending(uint8_t index, uint16_t frameIndex) {
+  SpoolJobInfo& job = _jobs[index];
+
+  if (_active != SPOOL_NO_JOB && _active != job.id) {
+    int8_t previous = findJob(_active);
+    if (previous >= 0 && _jobs[previous].nextFrame > 0) {
+      _stats[_jobs[previous].priority].preemptions++;
+      saveProgress(_jobs[previous]);
+    }
+  }
+  _active = job.id;
+
+  SpoolClassStats& stats = _stats[job.priority];
+  if (frameIndex != job.nextFrame) {
+    stats.rewakes++;
+  } else if (job.nextFrame == 0 && job.dueSinceMs != 0) {
+    uint32_t waitMs = _millis() - job.dueSinceMs;
+    stats.started++;
+    stats.waitTotalMs += waitMs;
+    if (waitMs > stats.waitMaxMs) {
+      stats.waitMaxMs = waitMs;
+    }
+  }
+}
+
+bool JobSpool::saveProgress(const SpoolJobInfo& job) {
+  uint8_t progress[SPOOL_PROGRESS_SIZE];
+  putLE16(&progress[0], job.nextFrame);
+  putLE16(&progress[2], 0);
+  putLE32(&progress[4], job.nextOffset);
+
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, job.id, "pos");
+  return _storage.write(name, progress, sizeof(progress));
+}
+
+bool JobSpool::readFrame(uint32_t id, uint32_t* offset, SpoolFrame* frame) {
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, id, "job");
+
+  uint8_t record[SPOOL_RECORD_HEADER];
+  if (_storage.read(name, *offset, record, sizeof(record)) != sizeof(record) ||
+      _storage.read(name, *offset + SPOOL_RECORD_HEADER, frame->data, record[1]) != record[1]) {
+    return false;
+  }
+
+  frame->type = record[0];
+  frame->size = record[1];
+  frame->repeats = getLE16(&record[2]);
+  *offset += SPOOL_RECORD_HEADER + frame->size;
+  return true;
+}
+
+uint8_t JobSpool::readType(uint32_t id, uint32_t offset) {
+  char name[SPOOL_NAME_SIZE];
+  makeName(name, id, "job");
+
+  uint8_t type;
+  if (_storage.read(name, offset, &type, 1) != 1) {
+    return SPOOL_NO_TYPE;
+  }
+  return type;
+}
+
+void JobSpool::advanceJob(uint8_t index, uint16_t frameIndex, uint8_t frameSize) {
+  SpoolJobInfo& job = _jobs[index];
+  job.lastSentMs = _millis();
+  if (job.lastSentMs == 0) {
+    job.lastSentMs = 1;
+  }
+
+  // A repeated wake frame does not move the job forward
+  if (frameIndex != job.nextFrame) {
+    return;
+  }
+
+  job.nextFrame++;
+  job.nextOffset += SPOOL_RECORD_HEADER + frameSize;
+
+  if (job.nextFrame >= job.frameCount) {
+    uint32_t time = _clock();
+    if (job.deadline != 0 && time != 0 && time > job.deadline) {
+      _stats[job.priority].deadlineMisses++;
+    }
+    finishJob(index, true);
+  } else {
+    job.nextType = readType(job.id, job.nextOffset);
+    if (job.nextFrame % SPOOL_PROGRESS_FRAMES == 0) {
+      saveProgress(job);
+    }
+  }
+}
+
+bool JobSpool::service(SpoolSendFn send, void* context) {
+  int8_t index = pickDue();
+  if (index < 0) {
+    return false;
+  }
+
+  SpoolJobInfo& job = _jobs[index];
+  uint16_t frameIndex = frameToSend(job);
+
+  SpoolFrame frame;
+  uint32_t offset = frameIndex == job.nextFrame ? job.nextOffset : job.firstOffset;
+  if (!readFrame(job.id, &offset, &frame)) {
+    // Unreadable job, drop it rather than retrying forever
+    finishJob(index, false);
+    return false;
+  }
+
+  noteSending(index, frameIndex);
+  if (!send(context, frame)) {
+    return false;
+  }
+
+  advanceJob(index, frameIndex, frame.size);
+  return true;
+}
+
+bool JobSpool::getDueJob(SpoolJobInfo* job, uint16_t* frameIndex) {
+  int8_t index = pickDue();
+  if (index < 0) {
+    return false;
+  }
+  *job = _jobs[index];
+  *frameIndex = frameToSend(_jobs[index]);
+  return true;
+}
+
+bool JobSpool::frameSent(uint32_t id, uint16_t frameIndex, uint8_t frameSize) {
+  int8_t index = findJob(id);
+  if (index < 0) {
+    return false;
+  }
+  noteSending(index, frameIndex);
+  advanceJob(index, frameIndex, frameSize);
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#ifndef JOB_SPOOL_H
+#define JOB_SPOOL_H
+
+// Persistent queue of fully encoded jobs that go out at a scheduled time
+//
+// Each job is one append-only file "<id>.job" holding a header, the target
+// barcodes and the encoded frames as they would be handed to the transmitter.
+// Jobs are written as "<id>.tmp" and renamed once complete, so a reboot while
+// queueing never leaves half a job behind. Progress lives in "<id>.pos"; to
+// spare the flash it is rewritten every SPOOL_PROGRESS_FRAMES frames and when
+// the job is preempted, so an interrupted job resumes at most that many
+// frames before where it stopped.
+// Ids are never reused: the next one is kept in "next.seq" across reboots.
+//
+// Scheduling: due jobs are served by priority class, then earliest deadline.
+// A job of a higher class preempts the running one, but only in front of a
+// data frame, never inside a wake-up or parameter sequence. When a preempted
+// job continues after its tag's wake window has run out, its wake frame is
+// sent again first; the remaining frames still carry their own frame numbers.
+//
+// Coalescing: a job may name its target tag, the page it writes and what it
+// does. A committed update replaces queued but unstarted updates of the same
+// page, and unstarted pings or refreshes of the tag, that would have become
+// due no later than it; revisions scheduled after it still follow. Merged
+// pings and refreshes pass their class and deadline on when they are stricter.
+//
+// No Arduino dependencies: storage and clocks are injected, host builds can
+// run the spool on a directory with a fake clock
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpoolStorage.h"
+
+#define SPOOL_MAX_JOBS 32
+#define SPOOL_MAX_BARCODES 8
+#define SPOOL_BARCODE_LENGTH 17
+#define SPOOL_MAX_FRAME 255
+#define SPOOL_NO_JOB 0
+#define SPOOL_NO_TYPE 0xFF
+#define SPOOL_PROGRESS_FRAMES 16
+
+// Priority classes, a job's priority is its class
+enum SpoolClass {
+  SPOOL_CLASS_BULK = 0,
+  SPOOL_CLASS_NORMAL,
+  SPOOL_CLASS_URGENT,
+  SPOOL_CLASS_COUNT
+};
+
+// What a job does to its tag, only targeted jobs are coalesced
+enum SpoolJobKind {
+  SPOOL_KIND_OTHER = 0,
+  SPOOL_KIND_UPDATE,      // Rewrites one page of the tag
+  SPOOL_KIND_PING,
+  SPOOL_KIND_REFRESH
+};
+
+struct SpoolJobTarget {
+  uint8_t kind;           // SpoolJobKind
+  uint32_t tag;           // Any stable id of the tag, e.g. its PLID
+  uint8_t page;
+};
+
+// Unix time in seconds, 0 while the clock is not set
+typedef uint32_t (*SpoolClockFn)();
+// Monotonic milliseconds, for wait times and wake windows
+typedef uint32_t (*SpoolMillisFn)();
+
+// One encoded frame, as stored and as handed back for transmission
+struct SpoolFrame {
+  uint8_t type;
+  uint8_t size;
+  uint16_t repeats;
+  uint8_t data[SPOOL_MAX_FRAME];
+};
+
+// Transmits a frame, false leaves the job where it is to retry on the next service
+typedef bool (*SpoolSendFn)(void* context, const SpoolFrame& frame);
+
+struct SpoolJobInfo {
+  uint32_t id;
+  uint32_t notBefore;     // 0 = as soon as possible
+  uint32_t deadline;      // 0 = none, otherwise finish by this unix time
+  uint32_t createdAt;
+  uint8_t priority;       // SpoolClass
+  uint8_t kind;           // SpoolJobKind, target of the job for coalescing
+  uint8_t page;
+  uint32_t tag;
+  uint8_t barcodeCount;
+  uint16_t frameCount;
+  uint16_t nextFrame;     // Frames before this one have been sent
+  uint32_t firstOffset;   // File offset of the first frame record
+  uint32_t nextOffset;    // File offset of the next frame record
+  uint32_t bytes;
+  uint8_t firstType;      // Frame types, to find wake frames and preemption points
+  uint8_t nextType;
+  uint32_t dueSinceMs;    // When the job was first seen due, 0 = not yet
+  uint32_t lastSentMs;    // When its last frame went out, 0 = not since boot
+};
+
+// Called when a job has sent its last frame, or with completed false when
+// it was dropped unreadable; latencyMs runs from the job becoming due
+typedef void (*SpoolDoneFn)(void* context, const SpoolJobInfo& job, bool completed, uint32_t latencyMs);
+
+// Waiting and preemption statistics of one priority class
+struct SpoolClassStats {
+  uint32_t started;       // Jobs whose first frame went out
+  uint32_t waitTotalMs;   // Due to first frame, summed over started jobs
+  uint32_t waitMaxMs;
+  uint32_t preemptions;   // Times a job of this class was interrupted
+  uint32_t rewakes;       // Wake frames sent again on resume
+  uint32_t deadlineMisses;
+};
+
+class JobSpool {
+  public:
+    JobSpool(SpoolStorage& storage, SpoolClockFn clock, SpoolMillisFn millisClock);
+
+    // Frame types are opaque to the spool: wakeType frames re-wake a tag,
+    // jobs may be preempted in front of dataType frames. A tag is assumed
+    // asleep again wakeWindowMs after the last frame it was sent
+    void setFrameRoles(uint8_t wakeType, uint8_t dataType, uint32_t wakeWindowMs);
+
+    void setDoneHandler(SpoolDoneFn done, void* context);
+
+    // Rebuild the index from storage, drops unfinished temp files
+    bool begin();
+
+    // Queue a new job: beginJob, appendFrame for every frame, then commitJob
+    uint32_t beginJob(uint32_t notBefore, uint32_t deadline, uint8_t priority,
+                      const char* const* barcodes, uint8_t barcodeCount,
+                      const SpoolJobTarget* target = NULL);
+    bool appendFrame(uint8_t type, const uint8_t* data, uint8_t size, uint16_t repeats);
+    bool commitJob();
+    void abortJob();
+    bool isBuilding() { return _building != SPOOL_NO_JOB; }
+
+    bool cancelJob(uint32_t id);
+
+    // Unstarted update of tag that is due no later than notBefore; a ping or
+    // refresh wanted then is covered by it and need not be queued
+    uint32_t findCoveringUpdate(uint32_t tag, uint32_t notBefore);
+    // Count a request merged into job id, which keeps the higher of the two
+    // classes and the earlier deadline
+    bool mergeInto(uint32_t id, uint8_t priority, uint32_t deadline);
+    // Drop the unstarted work an update of tag and page due at notBefore makes
+    // redundant: older revisions of the page and pings or refreshes due no
+    // later than it. commitJob does this for targeted updates. Returns the count
+    uint8_t dropSuperseded(uint32_t tag, uint8_t page, uint32_t notBefore);
+
+    // Send the next frame of the most urgent due job, false if nothing was sent
+    bool service(SpoolSendFn send, void* context);
+
+    // For frames sent from elsewhere (e.g. a compiled copy in flash): getDueJob
+    // returns the job service() would pick and the index of the frame to send,
+    // frameSent records that frame as sent
+    bool getDueJob(SpoolJobInfo* job, uint16_t* frameIndex);
+    bool frameSent(uint32_t id, uint16_t frameIndex, uint8_t frameSize);
+
+    // Read the frame record at offset and move offset past it
+    bool readFrame(uint32_t id, uint32_t* offset, SpoolFrame* frame);
+
+    uint8_t getJobCount() { return _jobCount; }
+    // Jobs in queue order, index < getJobCount()
+    const SpoolJobInfo& getJob(uint8_t index);
+    const SpoolJobInfo* findJobInfo(uint32_t id);
+    // Reads the n-th barcode of a job into out (SPOOL_BARCODE_LENGTH + 1 bytes)
+    bool getBarcode(uint32_t id, uint8_t index, char* out);
+    uint32_t getActiveJob() { return _active; }
+    uint32_t now() { return _clock(); }
+
+    const SpoolClassStats& getClassStats(uint8_t spoolClass) { return _stats[spoolClass]; }
+    static const char* className(uint8_t spoolClass);
+    // Jobs dropped for a newer update, and requests merged into a queued job
+    uint32_t getReplacedCount() { return _replaced; }
+    uint32_t getMergedCount() { return _merged; }
+
+  private:
+    SpoolStorage& _storage;
+    SpoolClockFn _clock;
+    SpoolMillisFn _millis;
+    SpoolJobInfo _jobs[SPOOL_MAX_JOBS];
+    uint8_t _jobCount;
+    uint32_t _nextId;
+    uint32_t _active;      // Job that sent the last frame
+
+    uint8_t _wakeType;
+    uint8_t _dataType;
+    uint32_t _wakeWindowMs;
+    SpoolClassStats _stats[SPOOL_CLASS_COUNT];
+    uint32_t _replaced;
+    uint32_t _merged;
+    SpoolDoneFn _done;
+    void* _doneContext;
+
+    // Job being queued
+    uint32_t _building;
+    SpoolJobInfo _pending;
+
+    static void listEntry(void* context, const char* name, uint32_t size);
+    bool loadJob(uint32_t id, uint32_t size);
+    int8_t findJob(uint32_t id);
+    int8_t pickDue();
+    bool ranksBefore(const SpoolJobInfo& a, const SpoolJobInfo& b);
+    uint8_t dropCovered(uint32_t tag, uint8_t page, uint32_t notBefore,
+                        uint8_t* priority, uint32_t* deadline);
+    bool tighten(SpoolJobInfo& job, uint8_t priority, uint32_t deadline);
+    uint16_t frameToSend(const SpoolJobInfo& job);
+    void noteSending(uint8_t index, uint16_t frameIndex);
+    void removeJob(uint8_t index);
+    void finishJob(uint8_t index, bool completed);
+    void advanceJob(uint8_t index, uint16_t frameIndex, uint8_t frameSize);
+    uint8_t readType(uint32_t id, uint32_t offset);
+    uint32_t dueAt(uint32_t notBefore);
+    bool saveProgress(const SpoolJobInfo& job);
+    static void makeName(char* out, uint32_t id, const char* extension);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "JsonWriter.h"
+#include <stdio.h>
+
+JsonWriter::JsonWriter(char* buffer, size_t size, JsonSinkFn sink, void* context) {
+  _buffer = buffer;
+  _size = size;
+  _length = 0;
+  _sink = sink;
+  _context = context;
+  _overflowed = false;
+  _depth = 0;
+  _hasItems = 0;
+  if (_size > 0) {
+    _buffer[0] = '\0';
+  }
+}
+
+void JsonWriter::flush() {
+  if (_sink && _length > 0) {
+    _sink(_context, _buffer, _length);
+    _length = 0;
+  }
+}
+
+void JsonWriter::put(char c) {
+  // One byte stays free for the terminator
+  if (_length + 1 >= _size) {
+    if (!_sink) {
+      _overflowed = true;
+      return;
+    }
+    flush();
+  }
+  _buffer[_length++] = c;
+  _buffer[_length] = '\0';
+}
+
+void JsonWriter::put(const char* text) {
+  while (*text) {
+    put(*text++);
+  }
+}
+
+void JsonWriter::putEscaped(const char* text) {
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+
+  put('"');
+  for (; *text; text++) {
+    uint8_t c = *text;
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if (c == '\n') {
+      put("\\n");
+    } else if (c == '\r') {
+      put("\\r");
+    } else if (c == '\t') {
+      put("\\t");
+    } else if (c < 0x20) {
+      put("\\u00");
+      put(HEX_DIGITS[c >> 4]);
+      put(HEX_DIGITS[c & 0x0F]);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+}
+
+void JsonWriter::beginValue(const char* key) {
+  uint16_t bit = 1 << _depth;
+  if (_hasItems & bit) {
+    put(',');
+  }
+  _hasItems |= bit;
+
+  if (key) {
+    putEscaped(key);
+    put(':');
+  }
+}
+
+void JsonWriter::beginObject(const char* key) {
+  beginValue(key);
+  put('{');
+  if (_depth + 1 < JSON_MAX_DEPTH) {
+    _depth++;
+  }
+  _hasItems &= ~(1 << _depth);
+}
+
+void JsonWriter::endObject() {
+  put('}');
+  if (_depth > 0) {
+    _depth--;
+  }
+}
+
+void JsonWriter::beginArray(const char* key) {
+  beginValue(key);
+  put('[');
+  if (_depth + 1 < JSON_MAX_DEPTH) {
+    _depth++;
+  }
+  _hasItems &= ~(1 << _depth);
+}
+
+void JsonWriter::endArray() {
+  put(']');
+  if (_depth > 0) {
+    _depth--;
+  }
+}
+
+void JsonWriter::addString(const char* key, const char* value) {
+  beginValue(key);
+  putEscaped(value ? value : "");
+}
+
+void JsonWriter::addNumber(const char* key, uint32_t value) {
+  char number[12];
+  snprintf(number, sizeof(number), "%lu", (unsigned long)value);
+  beginValue(key);
+  put(number);
+}
+
+void JsonWriter::addSigned(const char* key, int32_t value) {
+  char number[12];
+  snprintf(number, sizeof(number), "%ld", (long)value);
+  beginValue(key);
+  put(number);
+}
+
+void JsonWriter::addBool(const char* key, bool value) {
+  beginValue(key);
+  put(value ? "true" : "false");
+}
+
+void JsonWriter::addRaw(const char* key, const char* json) {
+  beginValue(key);
+  put(json);
+}
+
+void JsonWriter::finish() {
+  flush();
+}
\ No newline at end of file
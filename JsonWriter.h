@@ -0,0 +1,62 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+// JSON text written through a fixed buffer, without allocation
+//
+// Keys, commas and quotes are placed by the writer and string values are
+// escaped, callers only say what goes where. With a sink the buffer is
+// handed over whenever it fills up and at finish(), so output of any length
+// streams through it. Without one the text must fit: it is cut short and
+// overflowed() is set instead.
+//
+// No Arduino dependencies, the writer can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JSON_MAX_DEPTH 16
+
+typedef void (*JsonSinkFn)(void* context, const char* data, size_t length);
+
+class JsonWriter {
+  public:
+    JsonWriter(char* buffer, size_t size, JsonSinkFn sink = NULL, void* context = NULL);
+
+    // key is NULL for array elements and the outermost value
+    void beginObject(const char* key = NULL);
+    void endObject();
+    void beginArray(const char* key = NULL);
+    void endArray();
+
+    void addString(const char* key, const char* value);
+    void addNumber(const char* key, uint32_t value);
+    void addSigned(const char* key, int32_t value);
+    void addBool(const char* key, bool value);
+    // Text that already is valid JSON, e.g. a preformatted decimal
+    void addRaw(const char* key, const char* json);
+
+    // Hand the rest to the sink; without one, the text stays NUL terminated in the buffer
+    void finish();
+
+    const char* c_str() { return _buffer; }
+    size_t length() { return _length; }
+    bool overflowed() { return _overflowed; }
+
+  private:
+    char* _buffer;
+    size_t _size;
+    size_t _length;
+    JsonSinkFn _sink;
+    void* _context;
+    bool _overflowed;
+    uint8_t _depth;
+    uint16_t _hasItems;  // Bit per nesting level: a value was written there
+
+    void put(char c);
+    void put(const char* text);
+    void flush();
+    void beginValue(const char* key);
+    void putEscaped(const char* text);
+};
+
+#endif
\ No newline at end of file
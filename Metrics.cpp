@@ -0,0 +1,180 @@
+#include "Metrics.h"
+
+// Job latency bucket bounds in milliseconds
+static const uint32_t JOB_LATENCY_BOUNDS_MS[] = {
+  10, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000, 30000, 60000
+};
+
+// Per-frame airtime bucket bounds in microseconds
+// A frame here is one transmitFrame call including all of its repeats,
+// so wake pings with 400 repeats land in the multi-second buckets
+static const uint32_t FRAME_AIRTIME_BOUNDS_US[] = {
+  1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000, 5000000, 10000000, 30000000
+};
+
+static const char* FRAME_TYPE_NAMES[FRAME_TYPE_COUNT] = {
+  "ping", "params", "data", "refresh", "raw", "segments", "serial"
+};
+
+static const char* JOB_OUTCOME_NAMES[JOB_OUTCOME_COUNT] = {
+  "ok", "failed", "rejected"
+};
+
+Metrics::Metrics() {
+  memset(_frames, 0, sizeof(_frames));
+  memset(_bytes, 0, sizeof(_bytes));
+  memset(_airtimeUs, 0, sizeof(_airtimeUs));
+  memset(_jobs, 0, sizeof(_jobs));
+  _worstLoopUs = 0;
+
+  memset(&_jobLatencyMs, 0, sizeof(_jobLatencyMs));
+  _jobLatencyMs.bounds = JOB_LATENCY_BOUNDS_MS;
+  _jobLatencyMs.boundCount = sizeof(JOB_LATENCY_BOUNDS_MS) / sizeof(JOB_LATENCY_BOUNDS_MS[0]);
+
+  memset(&_frameAirtimeUs, 0, sizeof(_frameAirtimeUs));
+  _frameAirtimeUs.bounds = FRAME_AIRTIME_BOUNDS_US;
+  _frameAirtimeUs.boundCount = sizeof(FRAME_AIRTIME_BOUNDS_US) / sizeof(FRAME_AIRTIME_BOUNDS_US[0]);
+
+  memset(_seconds, 0, sizeof(_seconds));
+  _secondIndex = 0;
+  _secondStartMs = 0;
+}
+
+#define METRICS_SLOTS (METRICS_HISTORY_SECONDS + 1)
+
+void Metrics::rollSeconds() {
+  uint32_t elapsed = (millis() - _secondStartMs) / 1000;
+  if (elapsed == 0) {
+    return;
+  }
+
+  if (elapsed >= METRICS_SLOTS) {
+    memset(_seconds, 0, sizeof(_seconds));
+  } else {
+    for (uint32_t i = 0; i < elapsed; i++) {
+      _secondIndex = (_secondIndex + 1) % METRICS_SLOTS;
+      memset(&_seconds[_secondIndex], 0, sizeof(MetricsSecond));
+    }
+  }
+  _secondStartMs += elapsed * 1000;
+}
+
+void Metrics::observe(MetricsHistogram& histogram, uint32_t value) {
+  uint8_t bucket = 0;
+  while (bucket < histogram.boundCount && value > histogram.bounds[bucket]) {
+    bucket++;
+  }
+
+  histogram.counts[bucket]++;
+  histogram.count++;
+  histogram.sum += value;
+}
+
+void Metrics::recordFrame(uint8_t type, uint8_t frameSize, uint16_t repeats, uint32_t airtimeUs) {
+  if (type >= FRAME_TYPE_COUNT) {
+    type = FRAME_RAW;
+  }
+
+  _frames[type]++;
+  _bytes[type] += (uint32_t)frameSize * repeats; // Bytes on air, including repeats
+  _airtimeUs[type] += airtimeUs;
+  // Frames sent alongside another on a parallel channel come with no airtime
+  // of their own, the transmission is observed once
+  if (airtimeUs > 0) {
+    observe(_frameAirtimeUs, airtimeUs);
+  }
+
+  // The frame just ended; its airtime is spread back over the seconds it
+  // covered, a multi-second wake ping must not read as 400% in one of them
+  rollSeconds();
+  _seconds[_secondIndex].frames++;
+  uint32_t slotUs = (millis() - _secondStartMs) * 1000;
+  uint8_t index = _secondIndex;
+  for (uint8_t n = 0; n < METRICS_SLOTS && airtimeUs > 0; n++) {
+    uint32_t part = min(airtimeUs, slotUs);
+    _seconds[index].airtimeUs += part;
+    if (type == FRAME_PING) {
+      _seconds[index].wakeAirtimeUs += part;
+    }
+    airtimeUs -= part;
+    slotUs = 1000000;
+    index = (index + METRICS_SLOTS - 1) % METRICS_SLOTS;
+  }
+}
+
+void Metrics::recordJob(uint8_t outcome, uint32_t latencyMs) {
+  if (outcome >= JOB_OUTCOME_COUNT) {
+    outcome = JOB_FAILED;
+  }
+
+  _jobs[outcome]++;
+
+  // Rejected requests never reached the transmitter, keep them out of the latency histogram
+  if (outcome != JOB_REJECTED) {
+    observe(_jobLatencyMs, latencyMs);
+  }
+}
+
+void Metrics::recordLoop(uint32_t durationUs) {
+  if (durationUs > _worstLoopUs) {
+    _worstLoopUs = durationUs;
+  }
+}
+
+uint32_t Metrics::getFramesSent() {
+  uint32_t total = 0;
+  for (uint8_t t = 0; t < FRAME_TYPE_COUNT; t++) {
+    total += _frames[t];
+  }
+  return total;
+}
+
+uint64_t Metrics::getTotalAirtimeUs() {
+  uint64_t total = 0;
+  for (uint8_t t = 0; t < FRAME_TYPE_COUNT; t++) {
+    total += _airtimeUs[t];
+  }
+  return total;
+}
+
+void Metrics::getRecent(MetricsRecent* recent) {
+  rollSeconds();
+  memset(recent, 0, sizeof(*recent));
+
+  uint64_t airtimeUs = 0;
+  uint64_t wakeAirtimeUs = 0;
+  for (uint8_t i = 0; i < METRICS_SLOTS; i++) {
+    if (i == _secondIndex) {
+      continue;  // Still filling
+    }
+    recent->frames += _seconds[i].frames;
+    airtimeUs += _seconds[i].airtimeUs;
+    wakeAirtimeUs += _seconds[i].wakeAirtimeUs;
+  }
+  recent->airtimeMs = airtimeUs / 1000;
+  recent->wakeAirtimeMs = wakeAirtimeUs / 1000;
+}
+
+uint8_t Metrics::getUtilizationHistory(uint8_t* percent, uint8_t count) {
+  rollSeconds();
+  if (count > METRICS_HISTORY_SECONDS) {
+    count = METRICS_HISTORY_SECONDS;
+  }
+
+  // Newest completed second last
+  uint8_t index = (_secondIndex + METRICS_SLOTS - count) % METRICS_SLOTS;
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t airtimeUs = _seconds[index].airtimeUs;
+    percent[i] = airtimeUs >= 1000000 ? 100 : airtimeUs / 10000;
+    index = (index + 1) % METRICS_SLOTS;
+  }
+  return count;
+}
+
+const char* Metrics::frameTypeName(uint8_t type) {
+  return type < FRAME_TYPE_COUNT ? FRAME_TYPE_NAMES[type] : "unknown";
+}
+
+const char* Metrics::jobOutcomeName(uint8_t outcome) {
+  return outcome < JOB_OUTCOME_COUNT ? JOB_OUTCOME_NAMES[outcome] : "unknown";
+}
\ No newline at end of file
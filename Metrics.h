@@ -0,0 +1,98 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+// Frame categories tracked by the transmit counters
+enum FrameType {
+  FRAME_PING = 0,     // Wake-up ping (counted as wake airtime)
+  FRAME_PARAMS,       // Image parameters frame
+  FRAME_DATA,         // Image data frame
+  FRAME_REFRESH,      // Display refresh frame
+  FRAME_RAW,          // Raw command frame
+  FRAME_SEGMENTS,     // Segment bitmap frame
+  FRAME_SERIAL,       // Frame loaded over the serial 'L' command
+  FRAME_TYPE_COUNT
+};
+
+// Outcome of a complete transmit request
+enum JobOutcome {
+  JOB_OK = 0,
+  JOB_FAILED,
+  JOB_REJECTED,
+  JOB_OUTCOME_COUNT
+};
+
+#define METRICS_MAX_BUCKETS 12
+#define METRICS_HISTORY_SECONDS 60
+
+// Fixed-bucket histogram, buckets are stored non-cumulative
+struct MetricsHistogram {
+  const uint32_t* bounds;
+  uint8_t boundCount;
+  uint32_t counts[METRICS_MAX_BUCKETS + 1]; // Last bucket is +Inf
+  uint32_t count;
+  uint64_t sum;
+};
+
+// One second of transmit activity in the recent history ring
+struct MetricsSecond {
+  uint16_t frames;
+  uint32_t airtimeUs;
+  uint32_t wakeAirtimeUs;
+};
+
+// Totals over the last METRICS_HISTORY_SECONDS completed seconds
+struct MetricsRecent {
+  uint32_t frames;
+  uint32_t airtimeMs;
+  uint32_t wakeAirtimeMs;
+};
+
+class Metrics {
+  public:
+    Metrics();
+
+    // Hot path recorders - fixed arrays only, no allocation
+    void recordFrame(uint8_t type, uint8_t frameSize, uint16_t repeats, uint32_t airtimeUs);
+    void recordJob(uint8_t outcome, uint32_t latencyMs);
+    void recordLoop(uint32_t durationUs);
+
+    // Accessors used by the /metrics, /status and serial 'S' reports
+    uint32_t getFramesSent();
+    uint32_t getFrames(uint8_t type) { return _frames[type]; }
+    uint32_t getBytes(uint8_t type) { return _bytes[type]; }
+    uint64_t getAirtimeUs(uint8_t type) { return _airtimeUs[type]; }
+    uint64_t getTotalAirtimeUs();
+    uint32_t getJobs(uint8_t outcome) { return _jobs[outcome]; }
+    uint32_t getWorstLoopUs() { return _worstLoopUs; }
+    const MetricsHistogram& getJobLatency() { return _jobLatencyMs; }
+    const MetricsHistogram& getFrameAirtime() { return _frameAirtimeUs; }
+
+    // Recent history for the on-device dashboard; percent receives the airtime
+    // share of each completed second, oldest first, and the count written
+    void getRecent(MetricsRecent* recent);
+    uint8_t getUtilizationHistory(uint8_t* percent, uint8_t count);
+
+    static const char* frameTypeName(uint8_t type);
+    static const char* jobOutcomeName(uint8_t outcome);
+
+  private:
+    uint32_t _frames[FRAME_TYPE_COUNT];
+    uint32_t _bytes[FRAME_TYPE_COUNT];
+    uint64_t _airtimeUs[FRAME_TYPE_COUNT];
+    uint32_t _jobs[JOB_OUTCOME_COUNT];
+    uint32_t _worstLoopUs;
+    MetricsHistogram _jobLatencyMs;
+    MetricsHistogram _frameAirtimeUs;
+
+    // Ring of the completed seconds plus the current one at _secondIndex
+    MetricsSecond _seconds[METRICS_HISTORY_SECONDS + 1];
+    uint8_t _secondIndex;
+    uint32_t _secondStartMs;
+
+    void observe(MetricsHistogram& histogram, uint32_t value);
+    void rollSeconds();
+};
+
+#endif
\ No newline at end of file
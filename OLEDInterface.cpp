@@ -1,199 +1,350 @@
 #include "OLEDInterface.h"
+#include <Wire.h>
+
+// SSD1306 control bytes and addressing commands
+#define SSD1306_COMMANDS 0x00
+#define SSD1306_DATA 0x40
+#define SSD1306_COLUMN_ADDRESS 0x21
+#define SSD1306_PAGE_ADDRESS 0x22
+#define SSD1306_DATA_CHUNK 16
+
+static void copyLine(char* out, const char* text) {
+  // strncpy pads with zeros, equal lines compare equal byte for byte
+  strncpy(out, text ? text : "", OLED_LINE_LENGTH);
+  out[OLED_LINE_LENGTH] = '\0';
+}
 
 OLEDInterface::OLEDInterface(SSD1306Wire* display) {
   _display = display;
-  _lastUpdate = 0;
-  _animationFrame = 0;
-  _isTransmitting = false;
-  _isScrolling = false;
-  _scrollPosition = 0;
+  memset(&_model, 0, sizeof(_model));
+  memset(&_drawn, 0, sizeof(_drawn));
+  memset(_panel, 0, sizeof(_panel));
+  _lastRender = 0;
+  _animationTimer = 0;
   _scrollTimer = 0;
+  _pageTimer = 0;
+  memset(&_dashboard, 0, sizeof(_dashboard));
+  _dashboardChanged = false;
+  _deferring = false;
+  _deferredSince = 0;
+  _busy = NULL;
+  _busyContext = NULL;
 }
 
 void OLEDInterface::begin() {
+  // init() leaves the panel cleared, which is what _panel starts with
   _display->init();
   _display->flipScreenVertically();
   _display->setFont(ArialMT_Plain_10);
   _display->setTextAlignment(TEXT_ALIGN_CENTER);
 }
 
-void OLEDInterface::showSplashScreen(String title, String version) {
-  _display->clear();
-  _display->setFont(ArialMT_Plain_16);
-  _display->drawString(32, 8, title);
-  _display->setFont(ArialMT_Plain_10);
-  _display->drawString(32, 30, version);
-  _display->display();
+void OLEDInterface::setBusyCheck(OLEDBusyFn busy, void* context) {
+  _busy = busy;
+  _busyContext = context;
 }
 
-void OLEDInterface::showStatus(String line1, String line2) {
-  _statusLine1 = line1;
-  _statusLine2 = line2;
-  _isTransmitting = false;
-  _isScrolling = (line2.length() > 10);
-  _scrollPosition = 0;
-  _scrollTimer = millis();
-  
-  _display->clear();
-  _display->setFont(ArialMT_Plain_10);
-  _display->drawString(32, 10, line1);
-  
-  if (_isScrolling) {
-    _display->drawString(32, 30, line2.substring(0, 10) + "...");
-  } else {
-    _display->drawString(32, 30, line2);
-  }
-  
-  _display->display();
+void OLEDInterface::setDashboard(const OLEDDashboard& dashboard) {
+  _dashboard = dashboard;
+  _dashboardChanged = true;
 }
 
-void OLEDInterface::showMainScreen(String status, String details) {
-  _isTransmitting = false;
-  _statusLine1 = status;
-  _statusLine2 = details;
-  _isScrolling = (details.length() > 10);
-  _scrollPosition = 0;
+void OLEDInterface::setScreen(uint8_t screen, const char* line1, const char* line2) {
+  char newLine1[OLED_LINE_LENGTH + 1];
+  char newLine2[OLED_LINE_LENGTH + 1];
+  copyLine(newLine1, line1);
+  copyLine(newLine2, line2);
+
+  // Showing what is already there keeps the scroll position and draws nothing
+  if (_model.screen == screen && !_model.transmitting &&
+      memcmp(newLine1, _model.line1, sizeof(newLine1)) == 0 &&
+      memcmp(newLine2, _model.line2, sizeof(newLine2)) == 0) {
+    return;
+  }
+
+  _model.screen = screen;
+  _model.page = OLED_PAGE_MAIN;
+  _model.transmitting = false;
+  _model.animationFrame = 0;
+  _model.txCurrent = 0;
+  _model.txTotal = 0;
+  _model.scrollPosition = 0;
+  memcpy(_model.line1, newLine1, sizeof(newLine1));
+  memcpy(_model.line2, newLine2, sizeof(newLine2));
   _scrollTimer = millis();
-  
-  _display->clear();
-  
-  // Draw header
-  _display->setFont(ArialMT_Plain_10);
-  _display->setTextAlignment(TEXT_ALIGN_LEFT);
-  _display->drawString(0, 0, "ESLBlaster");
-  
-  // Draw horizontal line
-  _display->drawHorizontalLine(0, 12, 64);
-  
-  // Draw status
-  _display->setTextAlignment(TEXT_ALIGN_CENTER);
-  _display->drawString(32, 16, status);
-  
+  _pageTimer = _scrollTimer;
+}
+
+void OLEDInterface::showSplashScreen(const char* title, const char* version) {
+  setScreen(OLED_SCREEN_SPLASH, title, version);
+}
+
+void OLEDInterface::showStatus(const char* line1, const char* line2) {
+  setScreen(OLED_SCREEN_STATUS, line1, line2);
+}
+
+void OLEDInterface::showMainScreen(const char* status, const char* details) {
   // Ensure details is not empty
-  if (details.length() == 0) {
-    details = "No IP Available";
-    _statusLine2 = details;
+  setScreen(OLED_SCREEN_MAIN, status, details && *details ? details : "No IP Available");
+}
+
+void OLEDInterface::showTransmitting(int current, int total, int size, int repeats) {
+  // The 64x48 panel only has room for the progress bar
+  (void)size;
+  (void)repeats;
+  if (!_model.transmitting) {
+    _model.transmitting = true;
+    _animationTimer = millis();
+  }
+  _model.txCurrent = current;
+  _model.txTotal = total > 0 ? total : 1;
+}
+
+void OLEDInterface::endTransmitting() {
+  _model.transmitting = false;
+  _model.animationFrame = 0;
+  _model.txCurrent = 0;
+  _model.txTotal = 0;
+}
+
+void OLEDInterface::showError(const char* errorMsg) {
+  setScreen(OLED_SCREEN_ERROR, "Error", errorMsg);
+}
+
+void OLEDInterface::drawScrolled(int16_t y) {
+  const char* text = _model.line2;
+  size_t length = strlen(text);
+  char window[OLED_VISIBLE_CHARS + 4];
+
+  if (length <= OLED_VISIBLE_CHARS) {
+    _display->drawString(32, y, text);
+    return;
   }
-  
-  // For long IP addresses or text, prepare for scrolling
-  if (_isScrolling) {
-    _display->drawString(32, 30, details.substring(0, 10) + "...");
+
+  if (_model.scrollPosition == 0) {
+    memcpy(window, text, OLED_VISIBLE_CHARS);
+    strcpy(window + OLED_VISIBLE_CHARS, "...");
   } else {
-    _display->drawString(32, 30, details);
+    // Wrap around through a space for smooth scrolling
+    for (uint8_t i = 0; i < OLED_VISIBLE_CHARS; i++) {
+      size_t pos = (_model.scrollPosition + i) % (length + 1);
+      window[i] = pos == length ? ' ' : text[pos];
+    }
+    window[OLED_VISIBLE_CHARS] = '\0';
   }
-  
-  _display->display();
+  _display->drawString(32, y, window);
 }
 
-void OLEDInterface::showTransmitting(int current, int total, int size, int repeats) {
-  _isTransmitting = true;
-  _isScrolling = false;
-  _txCurrent = current;
-  _txTotal = total;
-  
-  _display->clear();
-  
-  // Draw header
-  _display->setFont(ArialMT_Plain_10);
+void OLEDInterface::drawThroughput() {
+  char text[16];
+
   _display->setTextAlignment(TEXT_ALIGN_LEFT);
-  _display->drawString(0, 0, "Transmitting");
-  
-  // Draw horizontal line
-  _display->drawHorizontalLine(0, 12, 64);
-  
-  // Draw progress
-  _display->setTextAlignment(TEXT_ALIGN_CENTER);
-  _display->drawString(32, 16, String(current) + "/" + String(total));
-  
-  // Progress bar
-  int progressWidth = (current * 60) / total;
-  _display->drawProgressBar(2, 32, 60, 10, (progressWidth * 100) / 60);
-  
-  _display->display();
-}
-
-void OLEDInterface::showError(String errorMsg) {
-  _isTransmitting = false;
-  _isScrolling = (errorMsg.length() > 10);
-  _scrollPosition = 0;
-  _scrollTimer = millis();
-  
-  _display->clear();
-  
-  // Draw header
-  _display->setFont(ArialMT_Plain_10);
+  snprintf(text, sizeof(text), "%u.%u f/s", _dashboard.framesPerSecond10 / 10, _dashboard.framesPerSecond10 % 10);
+  _display->drawString(0, 0, text);
+  _display->setTextAlignment(TEXT_ALIGN_RIGHT);
+  snprintf(text, sizeof(text), "%u%%", _dashboard.utilization);
+  _display->drawString(64, 0, text);
+
+  // Airtime use of the last minute, one column per second
+  int16_t left = (OLED_WIDTH - OLED_SPARK_POINTS) / 2;
+  _display->drawHorizontalLine(0, OLED_HEIGHT - 1, OLED_WIDTH);
+  for (uint8_t i = 0; i < OLED_SPARK_POINTS; i++) {
+    int16_t height = (_dashboard.history[i] * OLED_SPARK_HEIGHT) / 100;
+    if (height == 0 && _dashboard.history[i] > 0) {
+      height = 1;
+    }
+    if (height > 0) {
+      _display->drawVerticalLine(left + i, OLED_HEIGHT - 1 - height, height);
+    }
+  }
+}
+
+void OLEDInterface::drawHealth() {
+  char text[16];
+
   _display->setTextAlignment(TEXT_ALIGN_LEFT);
-  _display->drawString(0, 0, "Error");
-  
-  // Draw horizontal line
-  _display->drawHorizontalLine(0, 12, 64);
-  
-  // Draw error message
-  _display->setTextAlignment(TEXT_ALIGN_CENTER);
-  
-  if (_isScrolling) {
-    _display->drawString(32, 24, errorMsg.substring(0, 10) + "...");
-    _statusLine2 = errorMsg;
+  snprintf(text, sizeof(text), "Queue %u", _dashboard.queueDepth);
+  _display->drawString(0, 0, text);
+  snprintf(text, sizeof(text), "Wake %u%%", _dashboard.wakeShare);
+  _display->drawString(0, 12, text);
+  snprintf(text, sizeof(text), "Heap %luk", (unsigned long)(_dashboard.freeHeap / 1024));
+  _display->drawString(0, 24, text);
+  if (_dashboard.rssi != 0) {
+    snprintf(text, sizeof(text), "RSSI %d", _dashboard.rssi);
   } else {
-    _display->drawString(32, 24, errorMsg);
+    strcpy(text, "RSSI --");
   }
-  
-  _display->display();
+  _display->drawString(0, 36, text);
 }
 
-void OLEDInterface::update() {
-  unsigned long currentTime = millis();
-  
-  // Update animations for transmitting state
-  if (_isTransmitting && currentTime - _lastUpdate > 200) {
-    _lastUpdate = currentTime;
-    _animationFrame = (_animationFrame + 1) % 4;
-    
-    // Update animation part of display without clearing everything
+void OLEDInterface::render() {
+  _display->clear();
+  _display->setColor(WHITE);
+  _display->setFont(ArialMT_Plain_10);
+
+  if (_model.transmitting) {
+    // Draw header
+    _display->setTextAlignment(TEXT_ALIGN_LEFT);
+    _display->drawString(0, 0, "Transmitting");
     _display->setColor(BLACK);
     _display->fillRect(59, 0, 5, 10); // Clear dot area
     _display->setColor(WHITE);
-    
     _display->setTextAlignment(TEXT_ALIGN_RIGHT);
-    String dots = "";
-    for (int i = 0; i < _animationFrame + 1; i++) {
-      dots += ".";
+    const char* dots = "....";
+    _display->drawString(64, 0, dots + 3 - _model.animationFrame);
+
+    // Draw horizontal line
+    _display->drawHorizontalLine(0, 12, 64);
+
+    // Draw progress
+    char progress[24];
+    snprintf(progress, sizeof(progress), "%d/%d", _model.txCurrent, _model.txTotal);
+    _display->setTextAlignment(TEXT_ALIGN_CENTER);
+    _display->drawString(32, 16, progress);
+
+    // Progress bar
+    int progressWidth = (_model.txCurrent * 60) / _model.txTotal;
+    _display->drawProgressBar(2, 32, 60, 10, (progressWidth * 100) / 60);
+    return;
+  }
+
+  switch (_model.screen) {
+    case OLED_SCREEN_SPLASH:
+      _display->setTextAlignment(TEXT_ALIGN_CENTER);
+      _display->setFont(ArialMT_Plain_16);
+      _display->drawString(32, 8, _model.line1);
+      _display->setFont(ArialMT_Plain_10);
+      _display->drawString(32, 30, _model.line2);
+      break;
+
+    case OLED_SCREEN_STATUS:
+      _display->setTextAlignment(TEXT_ALIGN_CENTER);
+      _display->drawString(32, 10, _model.line1);
+      drawScrolled(30);
+      break;
+
+    case OLED_SCREEN_MAIN:
+      if (_model.page == OLED_PAGE_THROUGHPUT) {
+        drawThroughput();
+        break;
+      }
+      if (_model.page == OLED_PAGE_HEALTH) {
+        drawHealth();
+        break;
+      }
+      // The main page is drawn like the error screen
+      // fall through
+    case OLED_SCREEN_ERROR:
+      // Draw header
+      _display->setTextAlignment(TEXT_ALIGN_LEFT);
+      _display->drawString(0, 0, _model.screen == OLED_SCREEN_MAIN ? "ESLBlaster" : "Error");
+
+      // Draw horizontal line
+      _display->drawHorizontalLine(0, 12, 64);
+
+      _display->setTextAlignment(TEXT_ALIGN_CENTER);
+      if (_model.screen == OLED_SCREEN_MAIN) {
+        _display->drawString(32, 16, _model.line1);
+        drawScrolled(30);
+      } else {
+        drawScrolled(24);
+      }
+      break;
+  }
+}
+
+void OLEDInterface::pushChangedPages() {
+  const uint8_t* frame = _display->buffer;
+
+  for (uint8_t page = 0; page < OLED_PAGES; page++) {
+    const uint8_t* row = frame + page * OLED_WIDTH;
+    uint8_t* shown = _panel + page * OLED_WIDTH;
+
+    // Only the columns between the first and last difference go out
+    int16_t first = 0;
+    while (first < OLED_WIDTH && row[first] == shown[first]) {
+      first++;
     }
-    _display->drawString(64, 0, dots);
-    _display->display();
+    if (first == OLED_WIDTH) {
+      continue;
+    }
+    int16_t last = OLED_WIDTH - 1;
+    while (row[last] == shown[last]) {
+      last--;
+    }
+
+    Wire.beginTransmission(OLED_I2C_ADDRESS);
+    Wire.write(SSD1306_COMMANDS);
+    Wire.write(SSD1306_COLUMN_ADDRESS);
+    Wire.write(OLED_COLUMN_OFFSET + first);
+    Wire.write(OLED_COLUMN_OFFSET + last);
+    Wire.write(SSD1306_PAGE_ADDRESS);
+    Wire.write(page);
+    Wire.write(page);
+    Wire.endTransmission();
+
+    for (int16_t column = first; column <= last; column += SSD1306_DATA_CHUNK) {
+      uint8_t count = min(SSD1306_DATA_CHUNK, last + 1 - column);
+      Wire.beginTransmission(OLED_I2C_ADDRESS);
+      Wire.write(SSD1306_DATA);
+      Wire.write(row + column, count);
+      Wire.endTransmission();
+    }
+
+    memcpy(shown + first, row + first, last + 1 - first);
+  }
+}
+
+void OLEDInterface::update(bool force) {
+  unsigned long currentTime = millis();
+
+  // Update animations for transmitting state
+  if (_model.transmitting && currentTime - _animationTimer >= OLED_ANIMATION_MS) {
+    _animationTimer = currentTime;
+    _model.animationFrame = (_model.animationFrame + 1) % 4;
   }
-  
+
+  // Rotate the dashboard while idle on the main screen
+  if (!_model.transmitting && _model.screen == OLED_SCREEN_MAIN &&
+      currentTime - _pageTimer >= OLED_PAGE_MS) {
+    _pageTimer = currentTime;
+    _model.page = (_model.page + 1) % OLED_PAGE_COUNT;
+    _model.scrollPosition = 0;
+    _scrollTimer = currentTime;
+  }
+
   // Handle scrolling for long text
-  if (_isScrolling && !_isTransmitting && currentTime - _scrollTimer > 500) {
+  size_t length = strlen(_model.line2);
+  if (!_model.transmitting && _model.screen != OLED_SCREEN_SPLASH && _model.page == OLED_PAGE_MAIN &&
+      length > OLED_VISIBLE_CHARS && currentTime - _scrollTimer >= OLED_SCROLL_MS) {
     _scrollTimer = currentTime;
-    
-    _scrollPosition = (_scrollPosition + 1) % _statusLine2.length();
-    
-    int endPos = _scrollPosition + 10;
-    if (endPos > _statusLine2.length()) {
-      // Handle wrap-around for smooth scrolling
-      String scrollText = _statusLine2.substring(_scrollPosition) + " " + _statusLine2.substring(0, endPos - _statusLine2.length());
-      
-      // Update just the scrolling part without clearing everything
-      _display->setColor(BLACK);
-      _display->fillRect(0, 30, 64, 10); // Clear text area
-      _display->setColor(WHITE);
-      
-      _display->setTextAlignment(TEXT_ALIGN_CENTER);
-      _display->drawString(32, 30, scrollText);
-      _display->display();
-    } else {
-      // Normal case - no wrap-around needed
-      String scrollText = _statusLine2.substring(_scrollPosition, endPos);
-      
-      // Update just the scrolling part without clearing everything
-      _display->setColor(BLACK);
-      _display->fillRect(0, 30, 64, 10); // Clear text area
-      _display->setColor(WHITE);
-      
-      _display->setTextAlignment(TEXT_ALIGN_CENTER);
-      _display->drawString(32, 30, scrollText);
-      _display->display();
+    _model.scrollPosition = (_model.scrollPosition + 1) % (length + 1);
+  }
+
+  // Dashboard figures only matter while one of their pages is up
+  bool dashboardShown = !_model.transmitting && _model.screen == OLED_SCREEN_MAIN &&
+                        _model.page != OLED_PAGE_MAIN;
+  if (memcmp(&_model, &_drawn, sizeof(_model)) == 0 && !(dashboardShown && _dashboardChanged)) {
+    return;
+  }
+  if (!force && currentTime - _lastRender < OLED_MIN_FRAME_MS) {
+    return;
+  }
+  // A frame in flight or about to go out has the bus and the CPU first
+  if (!force && _busy && _busy(_busyContext)) {
+    if (!_deferring) {
+      _deferring = true;
+      _deferredSince = currentTime;
+    }
+    if (currentTime - _deferredSince < OLED_MAX_DEFER_MS) {
+      return;
     }
   }
+
+  _deferring = false;
+  _dashboardChanged = false;
+  _lastRender = currentTime;
+  render();
+  memcpy(&_drawn, &_model, sizeof(_drawn));
+  pushChangedPages();
 }
\ No newline at end of file
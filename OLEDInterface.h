@@ -4,29 +4,113 @@
 #include <Arduino.h>
 #include "SSD1306Wire.h"
 
+// The show* calls only change the screen model; update() draws it from loop(),
+// at most every OLED_MIN_FRAME_MS and not while the busy check reports IR
+// activity, unless that has held a change back for OLED_MAX_DEFER_MS (a
+// saturated spool would otherwise freeze the dashboard). Only the 8-pixel
+// pages that differ from the panel are sent over I2C, a screen that did not
+// change costs no bus time at all.
+//
+// While idle on the main screen the display rotates through dashboard pages
+// showing the figures last handed to setDashboard().
+
+#define OLED_I2C_ADDRESS 0x3c
+#define OLED_WIDTH 64
+#define OLED_HEIGHT 48
+#define OLED_PAGES (OLED_HEIGHT / 8)
+#define OLED_COLUMN_OFFSET 32     // 64 pixel panel in the middle of the 128 column controller
+#define OLED_MIN_FRAME_MS 100
+#define OLED_LINE_LENGTH 24
+#define OLED_VISIBLE_CHARS 10     // Longer second lines scroll
+#define OLED_SCROLL_MS 500
+#define OLED_ANIMATION_MS 200
+#define OLED_MAX_DEFER_MS 2000
+#define OLED_PAGE_MS 4000
+#define OLED_SPARK_POINTS 60
+#define OLED_SPARK_HEIGHT 32
+
+enum OLEDScreen {
+  OLED_SCREEN_NONE = 0,
+  OLED_SCREEN_SPLASH,
+  OLED_SCREEN_STATUS,
+  OLED_SCREEN_MAIN,
+  OLED_SCREEN_ERROR
+};
+
+// Pages shown in turn on the main screen
+enum OLEDPage {
+  OLED_PAGE_MAIN = 0,         // Status and address
+  OLED_PAGE_THROUGHPUT,       // Frames/s, airtime use and its sparkline
+  OLED_PAGE_HEALTH,           // Queue, wake share, heap and RSSI
+  OLED_PAGE_COUNT
+};
+
+// Dashboard figures over the last minute, refreshed by the caller
+struct OLEDDashboard {
+  uint8_t queueDepth;
+  uint16_t framesPerSecond10;        // Tenths of a frame per second
+  uint8_t utilization;               // Percent of the time on air
+  uint8_t wakeShare;                 // Percent of the airtime spent on wake-up pings
+  uint32_t freeHeap;
+  int8_t rssi;                       // 0 without a station link
+  uint8_t history[OLED_SPARK_POINTS];  // Utilization per second, oldest first
+};
+
+// True while rendering would delay a transmission
+typedef bool (*OLEDBusyFn)(void* context);
+
+// Everything that decides the pixels, compared against the last drawn copy
+struct OLEDModel {
+  uint8_t screen;
+  uint8_t page;
+  bool transmitting;          // Progress overlay on top of the screen
+  uint8_t scrollPosition;
+  uint8_t animationFrame;
+  int txCurrent;
+  int txTotal;
+  char line1[OLED_LINE_LENGTH + 1];
+  char line2[OLED_LINE_LENGTH + 1];
+};
+
 class OLEDInterface {
   public:
     OLEDInterface(SSD1306Wire* display);
     void begin();
-    void showSplashScreen(String title, String version);
-    void showStatus(String line1, String line2);
-    void showMainScreen(String status, String details);
+    void showSplashScreen(const char* title, const char* version);
+    void showStatus(const char* line1, const char* line2);
+    void showMainScreen(const char* status, const char* details);
     void showTransmitting(int current, int total, int size, int repeats);
-    void showError(String errorMsg);
-    void update();
-    
+    // Back to the screen shown before showTransmitting
+    void endTransmitting();
+    void showError(const char* errorMsg);
+    void setDashboard(const OLEDDashboard& dashboard);
+    void setBusyCheck(OLEDBusyFn busy, void* context);
+    // force draws a changed model at once, without the frame rate limit and
+    // the busy check; for a status shown before a call that blocks loop()
+    void update(bool force = false);
+
   private:
     SSD1306Wire* _display;
-    unsigned long _lastUpdate;
-    int _animationFrame;
-    String _statusLine1;
-    String _statusLine2;
-    bool _isTransmitting;
-    bool _isScrolling;
-    int _txCurrent;
-    int _txTotal;
-    int _scrollPosition;
+    OLEDModel _model;
+    OLEDModel _drawn;
+    uint8_t _panel[OLED_WIDTH * OLED_PAGES];   // What the controller holds
+    unsigned long _lastRender;
+    unsigned long _animationTimer;
     unsigned long _scrollTimer;
+    unsigned long _pageTimer;
+    OLEDDashboard _dashboard;
+    bool _dashboardChanged;
+    bool _deferring;
+    unsigned long _deferredSince;
+    OLEDBusyFn _busy;
+    void* _busyContext;
+
+    void setScreen(uint8_t screen, const char* line1, const char* line2);
+    void render();
+    void drawScrolled(int16_t y);
+    void drawThroughput();
+    void drawHealth();
+    void pushChangedPages();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "Profiler.h"
+
+static const char* SECTION_NAMES[PROF_SECTION_COUNT] = {
+  "handle_client", "serial", "oled", "wifi", "spool"
+};
+
+Profiler::Profiler() {
+  memset(_windows, 0, sizeof(_windows));
+  memset(_sectionMaxUs, 0, sizeof(_sectionMaxUs));
+  _head = 0;
+  _count = 1;
+  _loopStartUs = 0;
+  _markUs = 0;
+  _lastYieldUs = 0;
+  _irqOffMaxUs = 0;
+  _yieldGapMaxUs = 0;
+}
+
+void Profiler::startWindow(uint32_t now) {
+  _head = (_head + 1) % PROFILER_WINDOWS;
+  if (_count < PROFILER_WINDOWS) {
+    _count++;
+  }
+
+  memset(&_windows[_head], 0, sizeof(ProfileWindow));
+  _windows[_head].startMs = now;
+}
+
+void Profiler::noteYieldGap(uint32_t now) {
+  // The very first yield point has nothing to measure against
+  if (_lastYieldUs != 0) {
+    uint32_t gap = now - _lastYieldUs;
+    if (gap > _windows[_head].yieldGapMaxUs) {
+      _windows[_head].yieldGapMaxUs = gap;
+    }
+    if (gap > _yieldGapMaxUs) {
+      _yieldGapMaxUs = gap;
+    }
+  }
+}
+
+void Profiler::beginLoop() {
+  uint32_t now = micros();
+
+  // Returning from loop() lets the system run, so loop entry is a yield point
+  noteYieldGap(now);
+  _lastYieldUs = now;
+
+  _loopStartUs = now;
+  _markUs = now;
+}
+
+void Profiler::mark(uint8_t section) {
+  uint32_t now = micros();
+  uint32_t elapsed = now - _markUs;
+  _markUs = now;
+
+  ProfileWindow& window = _windows[_head];
+  window.sectionTotalUs[section] += elapsed;
+  if (elapsed > window.sectionMaxUs[section]) {
+    window.sectionMaxUs[section] = elapsed;
+  }
+  if (elapsed > _sectionMaxUs[section]) {
+    _sectionMaxUs[section] = elapsed;
+  }
+}
+
+uint32_t Profiler::endLoop() {
+  uint32_t elapsed = micros() - _loopStartUs;
+
+  ProfileWindow& window = _windows[_head];
+  window.loops++;
+  if (elapsed > window.loopMaxUs) {
+    window.loopMaxUs = elapsed;
+  }
+
+  // Roll over to a new window once the current one is full
+  unsigned long nowMs = millis();
+  if (nowMs - window.startMs >= PROFILER_WINDOW_MS) {
+    startWindow(nowMs);
+  }
+
+  return elapsed;
+}
+
+void Profiler::yieldNow() {
+  noteYieldGap(micros());
+  yield();
+  _lastYieldUs = micros();
+}
+
+uint8_t Profiler::getWindowCount() {
+  return _count;
+}
+
+const ProfileWindow& Profiler::getWindow(uint8_t index) {
+  // Oldest window sits just after the head once the ring has wrapped
+  uint8_t oldest = (_head + PROFILER_WINDOWS + 1 - _count) % PROFILER_WINDOWS;
+  return _windows[(oldest + index) % PROFILER_WINDOWS];
+}
+
+const char* Profiler::sectionName(uint8_t section) {
+  return section < PROF_SECTION_COUNT ? SECTION_NAMES[section] : "unknown";
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+// Instrumented sections of loop()
+enum ProfileSection {
+  PROF_HANDLE_CLIENT = 0,
+  PROF_SERIAL,
+  PROF_OLED,
+  PROF_WIFI,
+  PROF_SPOOL,
+  PROF_SECTION_COUNT
+};
+
+#define PROFILER_WINDOWS 32        // Ring buffer depth
+#define PROFILER_WINDOW_MS 1000    // Length of one aggregation window
+
+// Aggregated timings for one window
+struct ProfileWindow {
+  uint32_t startMs;
+  uint32_t loops;
+  uint32_t loopMaxUs;
+  uint32_t sectionMaxUs[PROF_SECTION_COUNT];
+  uint32_t sectionTotalUs[PROF_SECTION_COUNT];
+  uint32_t irqOffMaxUs;      // Longest continuous interrupt-masked stretch
+  uint32_t yieldGapMaxUs;    // Longest time between instrumented yield points
+};
+
+class Profiler {
+  public:
+    Profiler();
+
+    // Called at the top of loop(); loop entry counts as a yield point
+    void beginLoop();
+    // Close the section that started at the previous mark
+    void mark(uint8_t section);
+    // Returns the duration of the iteration in microseconds
+    uint32_t endLoop();
+
+    // Yield to the system and record the gap since the previous yield point
+    void yieldNow();
+
+    // Called by code that masks interrupts, with the masked stretch in CPU cycles
+    inline void recordIrqOff(uint32_t cycles, uint32_t cpuMHz) {
+      uint32_t us = cycles / cpuMHz;
+      if (us > _windows[_head].irqOffMaxUs) {
+        _windows[_head].irqOffMaxUs = us;
+      }
+      if (us > _irqOffMaxUs) {
+        _irqOffMaxUs = us;
+      }
+    }
+
+    // Windows are returned oldest first, index < getWindowCount()
+    uint8_t getWindowCount();
+    const ProfileWindow& getWindow(uint8_t index);
+
+    // All-time maxima since boot
+    uint32_t getIrqOffMaxUs() { return _irqOffMaxUs; }
+    uint32_t getYieldGapMaxUs() { return _yieldGapMaxUs; }
+    uint32_t getSectionMaxUs(uint8_t section) { return _sectionMaxUs[section]; }
+
+    static const char* sectionName(uint8_t section);
+
+  private:
+    ProfileWindow _windows[PROFILER_WINDOWS];
+    uint8_t _head;
+    uint8_t _count;
+    uint32_t _loopStartUs;
+    uint32_t _markUs;
+    uint32_t _lastYieldUs;
+    uint32_t _irqOffMaxUs;
+    uint32_t _yieldGapMaxUs;
+    uint32_t _sectionMaxUs[PROF_SECTION_COUNT];
+
+    void noteYieldGap(uint32_t now);
+    void startWindow(uint32_t now);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "Redundancy.h"
+#include "IRTiming.h"
+#include <string.h>
+
+// Data frames the loss model keeps track of, longer jobs are cut to this
+#define LOSS_MAX_FRAMES 1024
+
+FrameInterleaver::FrameInterleaver(uint16_t frameCount, uint8_t copies, uint8_t span) {
+  _frameCount = frameCount;
+  _copies = copies ? copies : 1;
+  if (span == 0) {
+    span = 1;
+  }
+  // Blocks of equal size rather than full ones and a short rest, which
+  // would bring the copies of the last frames close together
+  _blocks = frameCount ? (frameCount + span - 1) / span : 1;
+  _block = 0;
+  _copy = 0;
+  _frame = 0;
+}
+
+bool FrameInterleaver::next(uint16_t* frame) {
+  if (_block >= _blocks || _frameCount == 0) {
+    return false;
+  }
+
+  *frame = _frame;
+  if (++_frame == blockStart(_block + 1)) {
+    if (++_copy < _copies) {
+      _frame = blockStart(_block);
+    } else {
+      _copy = 0;
+      _block++;
+    }
+  }
+  return true;
+}
+
+LossSimulator::LossSimulator(const LossModel& model, uint32_t seed) {
+  _state = seed ? seed : 1;
+  _bad = false;
+
+  // Two-state channel with the asked for loss share and mean burst length:
+  // a burst ends with 1/burst per frame, and starts often enough that
+  // loss/(1 - loss) of the time is spent in bursts
+  uint16_t burst = model.burstFrames ? model.burstFrames : 1;
+  uint16_t loss = model.lossPermille < 1000 ? model.lossPermille : 1000;
+  _leaveBad = burst == 1 ? 0xFFFFFFFFUL : (uint32_t)(0x100000000ULL / burst);
+  _stationaryBad = loss == 1000 ? 0xFFFFFFFFUL : (uint32_t)(0x100000000ULL * loss / 1000);
+  if (loss == 1000) {
+    _enterBad = 0xFFFFFFFFUL;
+    _leaveBad = 0;
+  } else {
+    uint64_t enter = 0x100000000ULL * loss / ((uint64_t)burst * (1000 - loss));
+    _enterBad = enter > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)enter;
+  }
+}
+
+uint32_t LossSimulator::random() {
+  // xorshift32, plenty for a few thousand trials
+  _state ^= _state << 13;
+  _state ^= _state >> 17;
+  _state ^= _state << 5;
+  return _state;
+}
+
+void LossSimulator::restart() {
+  _bad = random() < _stationaryBad;
+}
+
+bool LossSimulator::lost() {
+  bool wasLost = _bad;
+  uint32_t r = random();
+  _bad = _bad ? r >= _leaveBad : r < _enterBad;
+  return wasLost;
+}
+
+uint32_t LossSimulator::frameAirtimeUs(uint16_t size, uint16_t repeats, uint16_t gapUs) {
+  // Symbols carry 2 bits each, at the mean pause of the four symbol values
+  uint32_t pauseSum = IR_PAUSE_US[0] + IR_PAUSE_US[1] + IR_PAUSE_US[2] + IR_PAUSE_US[3];
+  uint32_t symbolsUs = (uint32_t)size * 4 * IR_BURST_US + (uint32_t)size * pauseSum;
+  return (symbolsUs + IR_BURST_US + gapUs) * repeats;
+}
+
+void LossSimulator::finish(uint32_t airtimeUs, uint16_t successes, uint16_t trials, LossResult* result) {
+  result->successPermille = trials ? (uint32_t)successes * 1000 / trials : 0;
+  result->airtimeMs = airtimeUs / 1000;
+  result->perImageMs = successes ? (uint64_t)airtimeUs * trials / successes / 1000 : 0;
+}
+
+void LossSimulator::simulateCopies(const LossJob& job, uint8_t copies, uint8_t span,
+                                   uint16_t trials, LossResult* result) {
+  uint16_t frames = job.dataFrames < LOSS_MAX_FRAMES ? job.dataFrames : LOSS_MAX_FRAMES;
+  uint8_t received[LOSS_MAX_FRAMES / 8];
+  uint16_t successes = 0;
+
+  for (uint16_t t = 0; t < trials; t++) {
+    restart();
+    bool complete = !lost();          // Parameters
+
+    memset(received, 0, sizeof(received));
+    uint16_t missing = frames;
+    FrameInterleaver order(frames, copies, span);
+    uint16_t frame;
+    while (order.next(&frame)) {
+      uint8_t bit = 1 << (frame & 7);
+      if (!lost() && !(received[frame >> 3] & bit)) {
+        received[frame >> 3] |= bit;
+        missing--;
+      }
+    }
+
+    complete = !lost() && complete && missing == 0;   // Refresh
+    if (complete) {
+      successes++;
+    }
+  }
+
+  uint32_t airtimeUs = job.wakeUs + job.controlUs + (uint32_t)job.dataFrames * (copies ? copies : 1) * job.dataUs;
+  finish(airtimeUs, successes, trials, result);
+}
+
+void LossSimulator::simulateRetries(const LossJob& job, uint8_t attempts, uint16_t trials, LossResult* result) {
+  if (attempts == 0) {
+    attempts = 1;
+  }
+  uint16_t successes = 0;
+
+  for (uint16_t t = 0; t < trials; t++) {
+    bool updated = false;
+    for (uint8_t a = 0; a < attempts; a++) {
+      // Every attempt starts with its own long wake-up ping
+      restart();
+      bool complete = !lost();
+      for (uint16_t frame = 0; frame < job.dataFrames; frame++) {
+        if (lost()) {
+          complete = false;
+        }
+      }
+      if (lost()) {
+        complete = false;
+      }
+      updated = updated || complete;
+    }
+    if (updated) {
+      successes++;
+    }
+  }
+
+  uint32_t airtimeUs = (job.wakeUs + job.controlUs + (uint32_t)job.dataFrames * job.dataUs) * attempts;
+  finish(airtimeUs, successes, trials, result);
+}
\ No newline at end of file
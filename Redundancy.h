@@ -0,0 +1,95 @@
+#ifndef REDUNDANCY_H
+#define REDUNDANCY_H
+
+// Redundant image transfers for tags that cannot acknowledge
+//
+// FrameInterleaver gives the order of the data frames when each is sent
+// several times. The frames are split into blocks of at most span frames and
+// every block goes out copies times in a row, so the copies of a frame are a
+// block apart: interference shorter than a block costs at most one copy of
+// each frame, and tags never see frame numbers more than a block out of order.
+//
+// The loss model compares that against re-running the whole job. Losses
+// follow a two-state (Gilbert-Elliott) channel: lossPermille of all frames
+// are lost, in bursts of burstFrames frames on average. Each trial runs the
+// channel over the job frame by frame; the wake-up ping is taken to always
+// arrive, its own repeats are its redundancy. A job succeeds when the
+// parameters, the refresh and at least one copy of every data frame arrived,
+// a retried job when one of its attempts had every frame.
+//
+// No Arduino dependencies, the planner and the loss model can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define REDUNDANCY_MAX_ATTEMPTS 4
+// Most frames times trials the device simulates in one call: at up to 4 copies
+// or attempts of every frame that is some 80000 channel steps, tens of
+// milliseconds between two yields. The host has no such limit
+#define REDUNDANCY_MAX_FRAME_TRIALS 20000UL
+
+class FrameInterleaver {
+  public:
+    FrameInterleaver(uint16_t frameCount, uint8_t copies, uint8_t span);
+
+    // Next data frame to send, false once every copy has been sent
+    bool next(uint16_t* frame);
+    uint32_t getLength() { return (uint32_t)_frameCount * _copies; }
+
+  private:
+    uint16_t _frameCount;
+    uint8_t _copies;
+    uint16_t _blocks;
+    uint16_t _block;
+    uint8_t _copy;
+    uint16_t _frame;
+
+    uint16_t blockStart(uint16_t block) { return (uint32_t)block * _frameCount / _blocks; }
+};
+
+// Airtime of the parts of an image job, in microseconds including frame gaps
+struct LossJob {
+  uint16_t dataFrames;
+  uint32_t wakeUs;
+  uint32_t controlUs;       // Parameters and refresh frame together
+  uint32_t dataUs;          // One data frame
+};
+
+struct LossModel {
+  uint16_t lossPermille;
+  uint16_t burstFrames;     // Mean length of a loss burst, at least 1
+};
+
+struct LossResult {
+  uint16_t successPermille;   // Share of the trials that updated the tag
+  uint32_t airtimeMs;         // Of one job, sent in full either way
+  uint32_t perImageMs;        // Airtime per successful update, 0 if none succeeded
+};
+
+class LossSimulator {
+  public:
+    LossSimulator(const LossModel& model, uint32_t seed = 1);
+
+    // Estimated airtime of a frame of size bytes, sent repeats times
+    static uint32_t frameAirtimeUs(uint16_t size, uint16_t repeats, uint16_t gapUs);
+
+    // One job with every data frame sent copies times, interleaved as above
+    void simulateCopies(const LossJob& job, uint8_t copies, uint8_t span,
+                        uint16_t trials, LossResult* result);
+    // The whole job, wake-up included, sent attempts times
+    void simulateRetries(const LossJob& job, uint8_t attempts, uint16_t trials, LossResult* result);
+
+  private:
+    uint32_t _state;          // Random generator
+    uint32_t _enterBad;       // Chance per frame of a burst starting, in 1/2^32
+    uint32_t _leaveBad;       // Chance per frame of a burst ending
+    uint32_t _stationaryBad;  // Chance of being in a burst at a random time
+    bool _bad;
+
+    uint32_t random();
+    void restart();           // Channel state after a long gap, e.g. a wake-up ping
+    bool lost();              // Advance by one frame, true if it was lost
+    static void finish(uint32_t airtimeUs, uint16_t successes, uint16_t trials, LossResult* result);
+};
+
+#endif
\ No newline at end of file
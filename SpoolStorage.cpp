@@ -0,0 +1,233 @@
+#include "SpoolStorage.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+
+LittleFSSpoolStorage::LittleFSSpoolStorage(fs::FS& fs, const char* directory) : _fs(fs) {
+  _directory = directory;
+}
+
+void LittleFSSpoolStorage::makePath(char* path, size_t size, const char* name) {
+  // A path cut short could name another file, an empty one fails to open
+  if (snprintf(path, size, "%s/%s", _directory, name) >= (int)size) {
+    path[0] = '\0';
+  }
+}
+
+bool LittleFSSpoolStorage::begin() {
+  return _fs.exists(_directory) || _fs.mkdir(_directory);
+}
+
+bool LittleFSSpoolStorage::write(const char* name, const void* data, size_t length) {
+  char path[48];
+  makePath(path, sizeof(path), name);
+
+  File file = _fs.open(path, "w");
+  if (!file) {
+    return false;
+  }
+  size_t written = file.write((const uint8_t*)data, length);
+  file.close();
+  return written == length;
+}
+
+bool LittleFSSpoolStorage::append(const char* name, const void* data, size_t length) {
+  char path[48];
+  makePath(path, sizeof(path), name);
+
+  File file = _fs.open(path, "a");
+  if (!file) {
+    return false;
+  }
+  size_t written = file.write((const uint8_t*)data, length);
+  file.close();
+  return written == length;
+}
+
+bool LittleFSSpoolStorage::writeAt(const char* name, uint32_t offset, const void* data, size_t length) {
+  char path[48];
+  makePath(path, sizeof(path), name);
+
+  File file = _fs.open(path, _fs.exists(path) ? "r+" : "w");
+  if (!file) {
+    return false;
+  }
+
+  // Seeking past the end is refused, the gap is written out instead
+  if (file.size() < offset) {
+    static const uint8_t zeros[64] = {0};
+    file.seek(0, SeekEnd);
+    for (uint32_t size = file.size(); size < offset; ) {
+      size_t part = offset - size < sizeof(zeros) ? offset - size : sizeof(zeros);
+      if (file.write(zeros, part) != part) {
+        file.close();
+        return false;
+      }
+      size += part;
+    }
+  }
+  if (!file.seek(offset, SeekSet)) {
+    file.close();
+    return false;
+  }
+  size_t written = file.write((const uint8_t*)data, length);
+  file.close();
+  return written == length;
+}
+
+int32_t LittleFSSpoolStorage::read(const char* name, uint32_t offset, void* data, size_t length) {
+  char path[48];
+  makePath(path, sizeof(path), name);
+
+  File file = _fs.open(path, "r");
+  if (!file) {
+    return -1;
+  }
+  if (!file.seek(offset, SeekSet)) {
+    file.close();
+    return 0;
+  }
+  int32_t count = file.read((uint8_t*)data, length);
+  file.close();
+  return count;
+}
+
+bool LittleFSSpoolStorage::rename(const char* from, const char* to) {
+  char fromPath[48];
+  char toPath[48];
+  makePath(fromPath, sizeof(fromPath), from);
+  makePath(toPath, sizeof(toPath), to);
+  return _fs.rename(fromPath, toPath);
+}
+
+bool LittleFSSpoolStorage::remove(const char* name) {
+  char path[48];
+  makePath(path, sizeof(path), name);
+  return _fs.remove(path);
+}
+
+void LittleFSSpoolStorage::list(SpoolListFn fn, void* context) {
+  Dir dir = _fs.openDir(_directory);
+  while (dir.next()) {
+    fn(context, dir.fileName().c_str(), dir.fileSize());
+  }
+}
+
+#else
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+DirSpoolStorage::DirSpoolStorage(const char* directory) {
+  _directory = directory;
+}
+
+void DirSpoolStorage::makePath(char* path, size_t size, const char* name) {
+  // A path cut short could name another file, an empty one fails to open
+  if (snprintf(path, size, "%s/%s", _directory, name) >= (int)size) {
+    path[0] = '\0';
+  }
+}
+
+bool DirSpoolStorage::begin() {
+  struct stat info;
+  return stat(_directory, &info) == 0 || mkdir(_directory, 0755) == 0;
+}
+
+bool DirSpoolStorage::write(const char* name, const void* data, size_t length) {
+  char path[256];
+  makePath(path, sizeof(path), name);
+
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  size_t written = fwrite(data, 1, length, file);
+  fclose(file);
+  return written == length;
+}
+
+bool DirSpoolStorage::append(const char* name, const void* data, size_t length) {
+  char path[256];
+  makePath(path, sizeof(path), name);
+
+  FILE* file = fopen(path, "ab");
+  if (!file) {
+    return false;
+  }
+  size_t written = fwrite(data, 1, length, file);
+  fclose(file);
+  return written == length;
+}
+
+bool DirSpoolStorage::writeAt(const char* name, uint32_t offset, const void* data, size_t length) {
+  char path[256];
+  makePath(path, sizeof(path), name);
+
+  FILE* file = fopen(path, "r+b");
+  if (!file) {
+    file = fopen(path, "w+b");
+  }
+  if (!file) {
+    return false;
+  }
+  if (fseek(file, offset, SEEK_SET) != 0) {
+    fclose(file);
+    return false;
+  }
+  size_t written = fwrite(data, 1, length, file);
+  fclose(file);
+  return written == length;
+}
+
+int32_t DirSpoolStorage::read(const char* name, uint32_t offset, void* data, size_t length) {
+  char path[256];
+  makePath(path, sizeof(path), name);
+
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return -1;
+  }
+  if (fseek(file, offset, SEEK_SET) != 0) {
+    fclose(file);
+    return 0;
+  }
+  int32_t count = fread(data, 1, length, file);
+  fclose(file);
+  return count;
+}
+
+bool DirSpoolStorage::rename(const char* from, const char* to) {
+  char fromPath[256];
+  char toPath[256];
+  makePath(fromPath, sizeof(fromPath), from);
+  makePath(toPath, sizeof(toPath), to);
+  return ::rename(fromPath, toPath) == 0;
+}
+
+bool DirSpoolStorage::remove(const char* name) {
+  char path[256];
+  makePath(path, sizeof(path), name);
+  return ::remove(path) == 0;
+}
+
+void DirSpoolStorage::list(SpoolListFn fn, void* context) {
+  DIR* dir = opendir(_directory);
+  if (!dir) {
+    return;
+  }
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    char path[256];
+    struct stat info;
+    makePath(path, sizeof(path), entry->d_name);
+    if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+      fn(context, entry->d_name, info.st_size);
+    }
+  }
+  closedir(dir);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef SPOOL_STORAGE_H
+#define SPOOL_STORAGE_H
+
+// Flat file store behind the job spool
+// The device uses a LittleFS directory; host builds get a plain POSIX
+// directory so the spool can be exercised without flash
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Called once per file in the store, name has no directory part
+typedef void (*SpoolListFn)(void* context, const char* name, uint32_t size);
+
+class SpoolStorage {
+  public:
+    virtual ~SpoolStorage() {}
+
+    virtual bool begin() = 0;
+    // Replace the file contents
+    virtual bool write(const char* name, const void* data, size_t length) = 0;
+    // Add to the end of the file, creating it if needed
+    virtual bool append(const char* name, const void* data, size_t length) = 0;
+    // Overwrite part of the file in place, creating it if needed; a gap
+    // before offset reads back as zeros
+    virtual bool writeAt(const char* name, uint32_t offset, const void* data, size_t length) = 0;
+    // Returns the bytes read, -1 if the file does not exist
+    virtual int32_t read(const char* name, uint32_t offset, void* data, size_t length) = 0;
+    virtual bool rename(const char* from, const char* to) = 0;
+    virtual bool remove(const char* name) = 0;
+    virtual void list(SpoolListFn fn, void* context) = 0;
+};
+
+#ifdef ARDUINO
+
+#include <FS.h>
+
+class LittleFSSpoolStorage : public SpoolStorage {
+  public:
+    LittleFSSpoolStorage(fs::FS& fs, const char* directory);
+
+    bool begin();
+    bool write(const char* name, const void* data, size_t length);
+    bool append(const char* name, const void* data, size_t length);
+    bool writeAt(const char* name, uint32_t offset, const void* data, size_t length);
+    int32_t read(const char* name, uint32_t offset, void* data, size_t length);
+    bool rename(const char* from, const char* to);
+    bool remove(const char* name);
+    void list(SpoolListFn fn, void* context);
+
+  private:
+    fs::FS& _fs;
+    const char* _directory;
+
+    void makePath(char* path, size_t size, const char* name);
+};
+
+#else
+
+class DirSpoolStorage : public SpoolStorage {
+  public:
+    DirSpoolStorage(const char* directory);
+
+    bool begin();
+    bool write(const char* name, const void* data, size_t length);
+    bool append(const char* name, const void* data, size_t length);
+    bool writeAt(const char* name, uint32_t offset, const void* data, size_t length);
+    int32_t read(const char* name, uint32_t offset, void* data, size_t length);
+    bool rename(const char* from, const char* to);
+    bool remove(const char* name);
+    void list(SpoolListFn fn, void* context);
+
+  private:
+    const char* _directory;
+
+    void makePath(char* path, size_t size, const char* name);
+};
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,362 @@
+#include "SymbolTrace.h"
+#include <stdio.h>
+#include <string.h>
+
+// Follows the wrapping 32-bit cycle counter during a forward walk over the events
+struct TraceClock {
+  bool started;
+  uint32_t lastCycle;
+  uint64_t cycles;
+
+  uint64_t advance(uint32_t cycle) {
+    if (started) {
+      cycles += (uint32_t)(cycle - lastCycle);
+    } else {
+      started = true;
+    }
+    lastCycle = cycle;
+    return cycles;
+  }
+};
+
+static uint64_t cyclesToNs(uint64_t cycles, uint32_t cpuMHz) {
+  return cycles * 1000 / cpuMHz;
+}
+
+static void resetStats(TraceGapStats& stats) {
+  stats.count = 0;
+  stats.minErrorNs = INT32_MAX;
+  stats.maxErrorNs = INT32_MIN;
+  stats.sumErrorNs = 0;
+}
+
+static void addSample(TraceGapStats& stats, int64_t errorNs) {
+  int32_t error = (int32_t)errorNs;
+  stats.count++;
+  stats.sumErrorNs += error;
+  if (error < stats.minErrorNs) {
+    stats.minErrorNs = error;
+  }
+  if (error > stats.maxErrorNs) {
+    stats.maxErrorNs = error;
+  }
+}
+
+static void finishFrame(TraceReport* report, int32_t driftNs) {
+  report->frames++;
+  report->sumDriftNs += driftNs;
+  if ((driftNs < 0 ? -driftNs : driftNs) > (report->maxDriftNs < 0 ? -report->maxDriftNs : report->maxDriftNs)) {
+    report->maxDriftNs = driftNs;
+  }
+}
+
+// VCD needs plain decimal 64-bit timestamps, avoid relying on %llu support
+static int formatU64(char* out, uint64_t value) {
+  char digits[21];
+  int length = 0;
+  do {
+    digits[length++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+
+  for (int i = 0; i < length; i++) {
+    out[i] = digits[length - 1 - i];
+  }
+  out[length] = '\0';
+  return length;
+}
+
+SymbolTrace::SymbolTrace() {
+  _events = NULL;
+  _capacity = 0;
+  _head = 0;
+  _count = 0;
+  _cpuMHz = 160;
+  _paused = false;
+}
+
+SymbolTrace::~SymbolTrace() {
+  end();
+}
+
+bool SymbolTrace::begin(uint16_t capacity, uint32_t cpuMHz) {
+  end();
+
+  _events = new TraceEvent[capacity];
+  if (!_events) {
+    return false;
+  }
+
+  _capacity = capacity;
+  _cpuMHz = cpuMHz;
+  _paused = false;
+  clear();
+  return true;
+}
+
+void SymbolTrace::end() {
+  delete[] _events;
+  _events = NULL;
+  _capacity = 0;
+  _head = 0;
+  _count = 0;
+}
+
+void SymbolTrace::clear() {
+  _head = 0;
+  _count = 0;
+}
+
+const TraceEvent& SymbolTrace::getEvent(uint16_t index) const {
+  uint16_t oldest = (_head + _capacity - _count) % _capacity;
+  return _events[(oldest + index) % _capacity];
+}
+
+uint16_t SymbolTrace::firstFrameStart() const {
+  // After wrapping the oldest events belong to a partial frame, skip them
+  for (uint16_t i = 0; i < _count; i++) {
+    if (getEvent(i).kind == TRACE_FRAME_START) {
+      return i;
+    }
+  }
+  return _count;
+}
+
+void SymbolTrace::analyze(TraceReport* report) const {
+  memset(report, 0, sizeof(TraceReport));
+  for (uint8_t s = 0; s < 4; s++) {
+    resetStats(report->pause[s]);
+  }
+  resetStats(report->burst);
+
+  if (!isActive()) {
+    return;
+  }
+
+  TraceClock clock = { false, 0, 0 };
+  bool inFrame = false;
+  bool anchored = false;
+  bool havePause = false;
+  uint8_t pendingSymbol = 0;
+  uint64_t anchorNs = 0;
+  uint64_t intendedNs = 0;
+  uint64_t burstStartNs = 0;
+  uint64_t burstEndNs = 0;
+  int32_t frameDriftNs = 0;
+
+  for (uint16_t i = firstFrameStart(); i < _count; i++) {
+    const TraceEvent& event = getEvent(i);
+    uint64_t nowNs = cyclesToNs(clock.advance(event.cycle), _cpuMHz);
+
+    switch (event.kind) {
+      case TRACE_FRAME_START:
+        if (anchored) {
+          finishFrame(report, frameDriftNs);
+        }
+        inFrame = true;
+        anchored = false;
+        havePause = false;
+        break;
+
+      case TRACE_BURST_START:
+        if (!inFrame) {
+          break;
+        }
+        if (!anchored) {
+          // The intended waveform of each frame starts at its first burst
+          anchored = true;
+          anchorNs = nowNs;
+          intendedNs = 0;
+        } else if (havePause) {
+          // The gap seen by the tag runs from burst end to the next burst start
+          addSample(report->pause[pendingSymbol],
+                    (int64_t)(nowNs - burstEndNs) - (int64_t)IR_PAUSE_US[pendingSymbol] * 1000);
+          havePause = false;
+        }
+        frameDriftNs = (int32_t)((int64_t)(nowNs - anchorNs) - (int64_t)intendedNs);
+        burstStartNs = nowNs;
+        break;
+
+      case TRACE_BURST_END:
+        if (!anchored) {
+          break;
+        }
+        addSample(report->burst, (int64_t)(nowNs - burstStartNs) - (int64_t)IR_BURST_ON_NS);
+        burstEndNs = nowNs;
+        intendedNs += IR_BURST_ON_NS;
+        break;
+
+      case TRACE_PAUSE_END:
+        if (!anchored) {
+          break;
+        }
+        pendingSymbol = event.symbol & 3;
+        havePause = true;
+        intendedNs += IR_PAUSE_US[pendingSymbol] * 1000;
+        break;
+    }
+  }
+
+  if (anchored) {
+    finishFrame(report, frameDriftNs);
+  }
+}
+
+// One pending value change of a VCD signal
+struct VcdChange {
+  bool valid;
+  uint64_t timeNs;
+  uint8_t value;
+};
+
+// Produces the measured LED and symbol changes straight from the events
+struct ActualCursor {
+  const SymbolTrace* trace;
+  uint16_t index;
+  TraceClock clock;
+  VcdChange change;
+  char id;
+
+  void next() {
+    change.valid = false;
+    while (index < trace->getCount()) {
+      const TraceEvent& event = trace->getEvent(index++);
+      uint64_t nowNs = cyclesToNs(clock.advance(event.cycle), trace->getCpuMHz());
+
+      if (event.kind == TRACE_BURST_START || event.kind == TRACE_BURST_END) {
+        id = 'a';
+        change.value = event.kind == TRACE_BURST_START ? 1 : 0;
+      } else if (event.kind == TRACE_PAUSE_END) {
+        id = 's';
+        change.value = event.symbol & 3;
+      } else {
+        continue;
+      }
+
+      change.valid = true;
+      change.timeNs = nowNs;
+      return;
+    }
+  }
+};
+
+// Rebuilds the ideal waveform: every frame starts at its first measured burst,
+// then follows the nominal burst and pause lengths for the captured symbols
+struct IntendedCursor {
+  const SymbolTrace* trace;
+  uint16_t index;
+  TraceClock clock;
+  VcdChange change;
+
+  void anchorFrame() {
+    // Next rising edge is the first burst after a frame start
+    bool sawFrameStart = false;
+    change.valid = false;
+    while (index < trace->getCount()) {
+      const TraceEvent& event = trace->getEvent(index++);
+      uint64_t nowNs = cyclesToNs(clock.advance(event.cycle), trace->getCpuMHz());
+
+      if (event.kind == TRACE_FRAME_START) {
+        sawFrameStart = true;
+      } else if (event.kind == TRACE_BURST_START && sawFrameStart) {
+        change.valid = true;
+        change.timeNs = nowNs;
+        change.value = 1;
+        return;
+      }
+    }
+  }
+
+  void next() {
+    if (change.value == 1) {
+      change.timeNs += IR_BURST_ON_NS;
+      change.value = 0;
+      return;
+    }
+
+    // After a falling edge, the next pause symbol decides the next rise
+    while (index < trace->getCount()) {
+      const TraceEvent& event = trace->getEvent(index);
+      if (event.kind == TRACE_FRAME_START) {
+        anchorFrame();
+        return;
+      }
+
+      clock.advance(event.cycle);
+      index++;
+
+      if (event.kind == TRACE_PAUSE_END) {
+        change.timeNs += IR_PAUSE_US[event.symbol & 3] * 1000;
+        change.value = 1;
+        return;
+      }
+    }
+
+    change.valid = false;
+  }
+};
+
+void SymbolTrace::writeVCD(TraceWriteFn write, void* context) const {
+  char line[64];
+  int length;
+
+  length = snprintf(line, sizeof(line), "$comment ESLBlaster symbol trace, %u events at %lu MHz $end\n",
+                    (unsigned)_count, (unsigned long)_cpuMHz);
+  write(context, line, length);
+
+  static const char* HEADER =
+    "$timescale 1ns $end\n"
+    "$scope module ir $end\n"
+    "$var wire 1 a actual $end\n"
+    "$var wire 1 i intended $end\n"
+    "$var wire 2 s symbol $end\n"
+    "$upscope $end\n"
+    "$enddefinitions $end\n"
+    "#0\n"
+    "$dumpvars\n0a\n0i\nb00 s\n$end\n";
+  write(context, HEADER, strlen(HEADER));
+
+  if (!isActive()) {
+    return;
+  }
+
+  uint16_t start = firstFrameStart();
+
+  ActualCursor actual = { this, start, { false, 0, 0 }, { false, 0, 0 }, 'a' };
+  actual.next();
+
+  IntendedCursor intended = { this, start, { false, 0, 0 }, { false, 0, 0 } };
+  intended.anchorFrame();
+
+  bool haveTime = false;
+  uint64_t lastTimeNs = 0;
+
+  while (actual.change.valid || intended.change.valid) {
+    // Merge both streams in time order, measured changes first on ties
+    bool takeActual = actual.change.valid &&
+                      (!intended.change.valid || actual.change.timeNs <= intended.change.timeNs);
+    const VcdChange& change = takeActual ? actual.change : intended.change;
+
+    if (!haveTime || change.timeNs != lastTimeNs) {
+      line[0] = '#';
+      length = 1 + formatU64(line + 1, change.timeNs);
+      line[length++] = '\n';
+      write(context, line, length);
+      haveTime = true;
+      lastTimeNs = change.timeNs;
+    }
+
+    if (takeActual && actual.id == 's') {
+      length = snprintf(line, sizeof(line), "b%u%u s\n", (change.value >> 1) & 1, change.value & 1);
+    } else {
+      length = snprintf(line, sizeof(line), "%u%c\n", change.value, takeActual ? 'a' : 'i');
+    }
+    write(context, line, length);
+
+    if (takeActual) {
+      actual.next();
+    } else {
+      intended.next();
+    }
+  }
+}
\ No newline at end of file
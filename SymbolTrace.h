@@ -0,0 +1,91 @@
+#ifndef SYMBOL_TRACE_H
+#define SYMBOL_TRACE_H
+
+// Symbol-level timing capture for IRTransmitter
+// No Arduino dependencies, so the VCD writer and the jitter analysis
+// also build and run on the host against a captured event list
+
+#include <stdint.h>
+#include <stddef.h>
+#include "IRTiming.h"
+
+enum TraceEventKind {
+  TRACE_FRAME_START = 0,  // Start of one frame repeat
+  TRACE_BURST_START,      // Carrier switched on
+  TRACE_BURST_END,        // Carrier switched off
+  TRACE_PAUSE_END         // Pause wait finished, symbol holds the encoded value
+};
+
+struct TraceEvent {
+  uint32_t cycle;   // ESP.getCycleCount() at the event
+  uint8_t kind;
+  uint8_t symbol;
+};
+
+// Error statistics against a nominal duration
+struct TraceGapStats {
+  uint32_t count;
+  int32_t minErrorNs;
+  int32_t maxErrorNs;
+  int64_t sumErrorNs;
+};
+
+struct TraceReport {
+  TraceGapStats pause[4];   // Burst end to next burst start, by symbol value
+  TraceGapStats burst;      // Burst length against IR_BURST_ON_NS
+  uint32_t frames;
+  int32_t maxDriftNs;       // Worst deviation of a frame's last burst from its intended start
+  int64_t sumDriftNs;
+};
+
+typedef void (*TraceWriteFn)(void* context, const char* data, size_t length);
+
+class SymbolTrace {
+  public:
+    SymbolTrace();
+    ~SymbolTrace();
+
+    // Allocates the ring buffer up front so recording never allocates
+    bool begin(uint16_t capacity, uint32_t cpuMHz);
+    void end();
+    void clear();
+    bool isActive() const { return _events != NULL; }
+    // Recording can be suspended without dropping the captured events
+    void setPaused(bool paused) { _paused = paused; }
+    bool isRecording() const { return _events != NULL && !_paused; }
+
+    // Called from the transmit loop, must stay cheap
+    inline void record(uint8_t kind, uint8_t symbol, uint32_t cycle) {
+      TraceEvent& event = _events[_head];
+      event.cycle = cycle;
+      event.kind = kind;
+      event.symbol = symbol;
+      _head = (_head + 1) % _capacity;
+      if (_count < _capacity) {
+        _count++;
+      }
+    }
+
+    uint16_t getCount() const { return _count; }
+    uint16_t getCapacity() const { return _capacity; }
+    uint32_t getCpuMHz() const { return _cpuMHz; }
+    // Events are returned oldest first
+    const TraceEvent& getEvent(uint16_t index) const;
+
+    // Compare captured timings against the nominal symbol timings
+    void analyze(TraceReport* report) const;
+    // Write a Value Change Dump with actual and intended waveforms
+    void writeVCD(TraceWriteFn write, void* context) const;
+
+  private:
+    TraceEvent* _events;
+    uint16_t _capacity;
+    uint16_t _head;
+    uint16_t _count;
+    uint32_t _cpuMHz;
+    bool _paused;
+
+    uint16_t firstFrameStart() const;
+};
+
+#endif
\ No newline at end of file
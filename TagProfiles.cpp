@@ -0,0 +1,410 @@
+#include "TagProfiles.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool matches(const char* value, size_t length, const char* literal) {
+  return strlen(literal) == length && memcmp(value, literal, length) == 0;
+}
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Next whitespace separated word of the line, false at its end
+static bool nextWord(const char** pos, const char* end, const char** word, size_t* length) {
+  while (*pos < end && isSpace(**pos)) {
+    (*pos)++;
+  }
+  *word = *pos;
+  while (*pos < end && !isSpace(**pos)) {
+    (*pos)++;
+  }
+  *length = *pos - *word;
+  return *length > 0;
+}
+
+static bool parseNumber(const char* text, size_t length, uint32_t minimum, uint32_t maximum, uint32_t* value) {
+  if (length == 0 || length > 5) {
+    return false;
+  }
+  *value = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] < '0' || text[i] > '9') {
+      return false;
+    }
+    *value = *value * 10 + (text[i] - '0');
+  }
+  return *value >= minimum && *value <= maximum;
+}
+
+TagProfiles::TagProfiles() {
+  reset();
+}
+
+void TagProfiles::setDefaults(TagProfile* profile) {
+  // The timings every tag was sent before there were profiles
+  memset(profile, 0, sizeof(*profile));
+  strcpy(profile->model, TAG_DEFAULT_MODEL);
+  profile->width = 0;
+  profile->height = 0;
+  profile->planes = 2;
+  profile->payload = 20;
+  profile->wakeRepeats = 400;
+  profile->frameGapUs = 2000;
+  profile->pp16 = true;
+  profile->segmentRepeats = 100;
+  profile->dataCopies = 1;
+  profile->interleaveSpan = 8;
+}
+
+void TagProfiles::reset() {
+  setDefaults(&_profiles[0]);
+  _profileCount = 1;
+  _assignmentCount = 0;
+  _error = NULL;
+  _errorLine = 0;
+}
+
+int16_t TagProfiles::indexOf(const char* model, size_t length) {
+  for (uint8_t i = 0; i < _profileCount; i++) {
+    if (matches(model, length, _profiles[i].model)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const TagProfile* TagProfiles::find(const char* model) {
+  int16_t index = indexOf(model, strlen(model));
+  return index < 0 ? NULL : &_profiles[index];
+}
+
+const TagProfile& TagProfiles::forBarcode(const char* barcode) {
+  uint8_t best = 0;
+  size_t bestLength = 0;
+  for (uint8_t i = 0; i < _assignmentCount; i++) {
+    size_t length = strlen(_assignments[i].prefix);
+    if (length > bestLength && strncmp(barcode, _assignments[i].prefix, length) == 0) {
+      best = _assignments[i].profile;
+      bestLength = length;
+    }
+  }
+  return _profiles[best];
+}
+
+bool TagProfiles::assign(const char* prefix, const char* model) {
+  size_t prefixLength = strlen(prefix);
+  if (prefixLength == 0 || prefixLength > TAG_PREFIX_LENGTH) {
+    return false;
+  }
+
+  int16_t profile = -1;
+  if (model && *model) {
+    profile = indexOf(model, strlen(model));
+    if (profile < 0) {
+      return false;
+    }
+  }
+
+  for (uint8_t i = 0; i < _assignmentCount; i++) {
+    if (strcmp(_assignments[i].prefix, prefix) != 0) {
+      continue;
+    }
+    if (profile < 0) {
+      _assignments[i] = _assignments[--_assignmentCount];
+    } else {
+      _assignments[i].profile = profile;
+    }
+    return true;
+  }
+
+  if (profile < 0) {
+    return true;
+  }
+  if (_assignmentCount >= TAG_ASSIGNMENTS_MAX) {
+    return false;
+  }
+  TagAssignment& assignment = _assignments[_assignmentCount++];
+  strcpy(assignment.prefix, prefix);
+  assignment.profile = profile;
+  return true;
+}
+
+bool TagProfiles::parseField(TagProfile* profile, const char* key, size_t keyLength,
+                             const char* value, size_t valueLength) {
+  uint32_t number;
+  if (matches(key, keyLength, "size")) {
+    const char* x = (const char*)memchr(value, 'x', valueLength);
+    uint32_t height;
+    if (!x || !parseNumber(value, x - value, 0, 4096, &number) ||
+        !parseNumber(x + 1, valueLength - (x + 1 - value), 0, 4096, &height) ||
+        (number == 0) != (height == 0)) {
+      _error = "size must be <width>x<height>";
+      return false;
+    }
+    profile->width = number;
+    profile->height = height;
+  } else if (matches(key, keyLength, "planes")) {
+    if (!parseNumber(value, valueLength, 1, 2, &number)) {
+      _error = "planes must be 1 or 2";
+      return false;
+    }
+    profile->planes = number;
+  } else if (matches(key, keyLength, "payload")) {
+    if (!parseNumber(value, valueLength, 1, TAG_MAX_PAYLOAD, &number)) {
+      _error = "payload must be between 1 and 200";
+      return false;
+    }
+    profile->payload = number;
+  } else if (matches(key, keyLength, "wake")) {
+    if (!parseNumber(value, valueLength, 1, 0xFFFF, &number)) {
+      _error = "wake must be between 1 and 65535";
+      return false;
+    }
+    profile->wakeRepeats = number;
+  } else if (matches(key, keyLength, "gap")) {
+    if (!parseNumber(value, valueLength, TAG_MIN_GAP_US, 0xFFFF, &number)) {
+      _error = "gap must be between 200 and 65535";
+      return false;
+    }
+    profile->frameGapUs = number;
+  } else if (matches(key, keyLength, "preamble")) {
+    if (matches(value, valueLength, "pp16")) {
+      profile->pp16 = true;
+    } else if (matches(value, valueLength, "pp4")) {
+      profile->pp16 = false;
+    } else {
+      _error = "preamble must be pp16 or pp4";
+      return false;
+    }
+  } else if (matches(key, keyLength, "segrepeat")) {
+    if (!parseNumber(value, valueLength, 1, 0xFFFF, &number)) {
+      _error = "segrepeat must be between 1 and 65535";
+      return false;
+    }
+    profile->segmentRepeats = number;
+  } else if (matches(key, keyLength, "copies")) {
+    if (!parseNumber(value, valueLength, 1, TAG_MAX_COPIES, &number)) {
+      _error = "copies must be between 1 and 4";
+      return false;
+    }
+    profile->dataCopies = number;
+  } else if (matches(key, keyLength, "span")) {
+    if (!parseNumber(value, valueLength, 1, TAG_MAX_SPAN, &number)) {
+      _error = "span must be between 1 and 64";
+      return false;
+    }
+    profile->interleaveSpan = number;
+  } else {
+    _error = "Unknown profile field";
+    return false;
+  }
+  return true;
+}
+
+bool TagProfiles::parseLine(const char* line, size_t length) {
+  const char* pos = line;
+  const char* end = line + length;
+  const char* word;
+  size_t wordLength;
+
+  if (!nextWord(&pos, end, &word, &wordLength) || word[0] == '#') {
+    return true;
+  }
+
+  if (matches(word, wordLength, "profile")) {
+    const char* model;
+    size_t modelLength;
+    if (!nextWord(&pos, end, &model, &modelLength) || modelLength > TAG_MODEL_LENGTH) {
+      _error = "Model name must be 1 to 15 characters";
+      return false;
+    }
+
+    // Unset fields come from the default profile as defined so far
+    TagProfile profile = _profiles[0];
+    memcpy(profile.model, model, modelLength);
+    profile.model[modelLength] = '\0';
+
+    while (nextWord(&pos, end, &word, &wordLength)) {
+      const char* equals = (const char*)memchr(word, '=', wordLength);
+      if (!equals) {
+        _error = "Profile fields must be key=value";
+        return false;
+      }
+      if (!parseField(&profile, word, equals - word, equals + 1, wordLength - (equals + 1 - word))) {
+        return false;
+      }
+    }
+
+    int16_t index = indexOf(profile.model, modelLength);
+    if (index < 0) {
+      if (_profileCount >= TAG_PROFILES_MAX) {
+        _error = "Too many profiles";
+        return false;
+      }
+      index = _profileCount++;
+    }
+    _profiles[index] = profile;
+    return true;
+  }
+
+  if (matches(word, wordLength, "assign")) {
+    char prefix[TAG_PREFIX_LENGTH + 1];
+    char model[TAG_MODEL_LENGTH + 1];
+    const char* value;
+    size_t valueLength;
+
+    if (!nextWord(&pos, end, &value, &valueLength) || valueLength > TAG_PREFIX_LENGTH) {
+      _error = "Barcode prefix must be 1 to 17 characters";
+      return false;
+    }
+    memcpy(prefix, value, valueLength);
+    prefix[valueLength] = '\0';
+
+    if (!nextWord(&pos, end, &value, &valueLength) || valueLength > TAG_MODEL_LENGTH) {
+      _error = "Missing model";
+      return false;
+    }
+    memcpy(model, value, valueLength);
+    model[valueLength] = '\0';
+
+    if (nextWord(&pos, end, &value, &valueLength)) {
+      _error = "Data after the model";
+      return false;
+    }
+    if (indexOf(model, strlen(model)) < 0) {
+      _error = "Model is not defined above";
+      return false;
+    }
+    if (!assign(prefix, model)) {
+      _error = "Too many assignments";
+      return false;
+    }
+    return true;
+  }
+
+  _error = "Lines must start with profile or assign";
+  return false;
+}
+
+bool TagProfiles::parse(const char* text, size_t length) {
+  reset();
+
+  const char* end = text + length;
+  const char* line = text;
+  for (uint16_t number = 1; line < end; number++) {
+    const char* newline = (const char*)memchr(line, '\n', end - line);
+    const char* lineEnd = newline ? newline : end;
+    if (!parseLine(line, lineEnd - line)) {
+      _errorLine = number;
+      return false;
+    }
+    line = lineEnd + 1;
+  }
+  return true;
+}
+
+bool TagProfiles::load(const char* text, size_t length) {
+  // The live table keeps working until the new one has been parsed completely
+  TagProfiles* parsed = new TagProfiles();
+  if (!parsed) {
+    _error = "Out of memory";
+    _errorLine = 0;
+    return false;
+  }
+
+  bool ok = parsed->parse(text, length);
+  if (ok) {
+    memcpy(_profiles, parsed->_profiles, sizeof(_profiles));
+    _profileCount = parsed->_profileCount;
+    memcpy(_assignments, parsed->_assignments, sizeof(_assignments));
+    _assignmentCount = parsed->_assignmentCount;
+    _error = NULL;
+    _errorLine = 0;
+  } else {
+    _error = parsed->_error;
+    _errorLine = parsed->_errorLine;
+  }
+  delete parsed;
+  return ok;
+}
+
+size_t TagProfiles::format(char* out, size_t size) {
+  size_t length = 0;
+
+  // Keep counting once the buffer is full, the caller learns the size it needs
+  #define FORMAT_APPEND(...) \
+    length += snprintf(out && length < size ? out + length : NULL, \
+                       out && length < size ? size - length : 0, __VA_ARGS__)
+
+  FORMAT_APPEND("# profile <model> size=WxH planes=N payload=N wake=N gap=us preamble=pp16|pp4 segrepeat=N copies=N span=N\n");
+  for (uint8_t i = 0; i < _profileCount; i++) {
+    const TagProfile& profile = _profiles[i];
+    FORMAT_APPEND("profile %s size=%ux%u planes=%u payload=%u wake=%u gap=%u preamble=%s segrepeat=%u copies=%u span=%u\n",
+                  profile.model, profile.width, profile.height, profile.planes, profile.payload,
+                  profile.wakeRepeats, profile.frameGapUs, profile.pp16 ? "pp16" : "pp4",
+                  profile.segmentRepeats, profile.dataCopies, profile.interleaveSpan);
+  }
+  for (uint8_t i = 0; i < _assignmentCount; i++) {
+    FORMAT_APPEND("assign %s %s\n", _assignments[i].prefix, _profiles[_assignments[i].profile].model);
+  }
+
+  #undef FORMAT_APPEND
+  return length;
+}
+
+#ifdef ARDUINO
+
+bool TagProfiles::loadFile(fs::FS& fs, const char* path) {
+  if (!fs.exists(path)) {
+    reset();
+    return true;
+  }
+
+  File file = fs.open(path, "r");
+  if (!file) {
+    return false;
+  }
+  size_t length = file.size();
+  char* text = new char[length + 1];
+  if (!text) {
+    file.close();
+    return false;
+  }
+  length = file.read((uint8_t*)text, length);
+  file.close();
+
+  bool ok = load(text, length);
+  delete[] text;
+  return ok;
+}
+
+bool TagProfiles::saveFile(fs::FS& fs, const char* path) {
+  size_t length = format(NULL, 0);
+  char* text = new char[length + 1];
+  if (!text) {
+    return false;
+  }
+  format(text, length + 1);
+
+  // Written beside the old table first, a power cut leaves one of them whole
+  char tempPath[40];
+  snprintf(tempPath, sizeof(tempPath), "%s.new", path);
+  File file = fs.open(tempPath, "w");
+  if (!file) {
+    delete[] text;
+    return false;
+  }
+  size_t written = file.write((const uint8_t*)text, length);
+  file.close();
+  delete[] text;
+
+  if (written != length) {
+    fs.remove(tempPath);
+    return false;
+  }
+  fs.remove(path);
+  return fs.rename(tempPath, path);
+}
+
+#endif
\ No newline at end of file
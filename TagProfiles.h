@@ -0,0 +1,112 @@
+#ifndef TAG_PROFILES_H
+#define TAG_PROFILES_H
+
+// Encoding and timing parameters per tag model, and which tags use which model
+//
+// The table is kept as a text file, one entry per line:
+//   # comment
+//   profile dm-hd size=296x128 planes=2 payload=40 wake=200 gap=1200 preamble=pp16
+//   profile dm-edge copies=2 span=8
+//   assign 0412345 dm-hd
+// copies sends every image data frame that many times, for tags at the edge
+// of coverage; the copies of a frame are span frames apart (see Redundancy.h).
+// Fields left out of a profile line keep the value of the default profile.
+// assign maps every barcode starting with the prefix to a model, the longest
+// matching prefix wins; unassigned barcodes use the profile named "default",
+// which is built in and can be redefined by the file.
+//
+// The parser and lookups have no Arduino dependencies and can be run on the host
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef ARDUINO
+#include <FS.h>
+#endif
+
+#define TAG_PROFILES_MAX 16
+#define TAG_ASSIGNMENTS_MAX 32
+#define TAG_MODEL_LENGTH 15
+#define TAG_PREFIX_LENGTH 17
+// Data frames carry the payload after a 2 byte frame number and must stay
+// within one 255 byte frame together with header, preamble and CRC
+#define TAG_MAX_PAYLOAD 200
+#define TAG_MIN_GAP_US 200
+#define TAG_MAX_COPIES 4
+#define TAG_MAX_SPAN 64
+#define TAG_PROFILES_FILE "/profiles.txt"
+#define TAG_DEFAULT_MODEL "default"
+
+struct TagProfile {
+  char model[TAG_MODEL_LENGTH + 1];
+  uint16_t width;           // Native resolution, 0 = not checked
+  uint16_t height;
+  uint8_t planes;           // 1 = black only, 2 = with a color plane
+  uint8_t payload;          // Image bytes per data frame
+  uint16_t wakeRepeats;     // Repeats of the wake-up ping
+  uint16_t frameGapUs;      // Silence between frames and repeats
+  bool pp16;                // Preamble type, false = PP4
+  uint16_t segmentRepeats;  // Repeats of a segment update
+  uint8_t dataCopies;       // Times each image data frame is sent
+  uint8_t interleaveSpan;   // Data frames between two copies of one frame
+};
+
+struct TagAssignment {
+  char prefix[TAG_PREFIX_LENGTH + 1];
+  uint8_t profile;          // Index into the profile table
+};
+
+class TagProfiles {
+  public:
+    TagProfiles();
+
+    // Only the built-in default profile, no assignments
+    void reset();
+
+    // Replace the table with the parsed text; on bad input the table is left
+    // unchanged and getError()/getErrorLine() say what was wrong
+    bool load(const char* text, size_t length);
+    const char* getError() { return _error; }
+    uint16_t getErrorLine() { return _errorLine; }
+
+    // Write the table back as text, returns the length needed (excluding the
+    // terminator) so a short buffer can be detected like with snprintf
+    size_t format(char* out, size_t size);
+
+    const TagProfile* find(const char* model);
+    // Profile for a tag, the default profile if no prefix matches
+    const TagProfile& forBarcode(const char* barcode);
+
+    // Point barcodes with this prefix at a model, model NULL or "" removes the
+    // assignment; false if the model is unknown or the table is full
+    bool assign(const char* prefix, const char* model);
+
+    uint8_t getProfileCount() { return _profileCount; }
+    const TagProfile& getProfile(uint8_t index) { return _profiles[index]; }
+    uint8_t getAssignmentCount() { return _assignmentCount; }
+    const TagAssignment& getAssignment(uint8_t index) { return _assignments[index]; }
+
+#ifdef ARDUINO
+    // The table as stored on the file system, a missing file is not an error
+    bool loadFile(fs::FS& fs, const char* path = TAG_PROFILES_FILE);
+    bool saveFile(fs::FS& fs, const char* path = TAG_PROFILES_FILE);
+#endif
+
+  private:
+    TagProfile _profiles[TAG_PROFILES_MAX];
+    uint8_t _profileCount;
+    TagAssignment _assignments[TAG_ASSIGNMENTS_MAX];
+    uint8_t _assignmentCount;
+    const char* _error;
+    uint16_t _errorLine;
+
+    static void setDefaults(TagProfile* profile);
+    // Parse into this table, load() runs it on a scratch copy
+    bool parse(const char* text, size_t length);
+    bool parseLine(const char* line, size_t length);
+    bool parseField(TagProfile* profile, const char* key, size_t keyLength,
+                    const char* value, size_t valueLength);
+    int16_t indexOf(const char* model, size_t length);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,605 @@
+#include "TagRegistry.h"
+#include <stdio.h>
+#include <string.h>
+
+// Page files "p000".."p127" hold TAG_REGISTRY_PAGE_RECORDS records each,
+// slot s is record s % TAG_REGISTRY_PAGE_RECORDS of page s / TAG_REGISTRY_PAGE_RECORDS.
+// Record layout, all integers little endian:
+//   barcode (u64, 0 = free slot, all ones = removed), PLID (u32),
+//   last sent (u32), airtime ms (u32), groups (u16), model, reserved,
+//   page hashes (8 x u16)
+// Meta file "meta": "ESLT", version, reserved, tag count (u16),
+//   group names (16 x 16 bytes), model names (16 x 16 bytes)
+#define TAG_REGISTRY_MAGIC "ESLT"
+#define TAG_REGISTRY_VERSION 1
+#define TAG_META_NAME "meta"
+#define TAG_META_TEMP "meta.tmp"
+#define TAG_META_SIZE (8 + TAG_GROUPS_MAX * (TAG_GROUP_LENGTH + 1) + TAG_PROFILES_MAX * (TAG_MODEL_LENGTH + 1))
+#define TAG_BARCODE_REMOVED 0xFFFFFFFFFFFFFFFFULL
+
+static void putLE16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+  putLE16(out, value & 0xFFFF);
+  putLE16(out + 2, value >> 16);
+}
+
+static uint16_t getLE16(const uint8_t* in) {
+  return in[0] | (in[1] << 8);
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+  return getLE16(in) | ((uint32_t)getLE16(in + 2) << 16);
+}
+
+static bool isGroupChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         c == '-' || c == '_' || c == '.';
+}
+
+TagRegistry::TagRegistry(SpoolStorage& storage, TagProfiles& profiles, TagClockFn clock, TagClockFn millisClock)
+    : _storage(storage), _profiles(profiles) {
+  _clock = clock;
+  _millis = millisClock;
+  _lookups = 0;
+  _cacheMisses = 0;
+  _error = NULL;
+  clear();
+}
+
+void TagRegistry::clear() {
+  memset(&_meta, 0, sizeof(_meta));
+  for (uint8_t i = 0; i < TAG_REGISTRY_CACHE; i++) {
+    _cache[i].slot = TAG_NO_SLOT;
+    _cache[i].dirty = false;
+    _cache[i].used = 0;
+  }
+  _useCounter = 0;
+  _lastFlush = 0;
+}
+
+bool TagRegistry::begin() {
+  clear();
+  if (!_storage.begin()) {
+    _error = "Storage not available";
+    return false;
+  }
+  _lastFlush = _millis();
+
+  uint8_t data[TAG_META_SIZE];
+  int32_t length = _storage.read(TAG_META_NAME, 0, data, sizeof(data));
+  if (length < 0) {
+    return true;
+  }
+
+  // Without its count and names the table cannot be trusted, start over
+  if (length != TAG_META_SIZE || memcmp(data, TAG_REGISTRY_MAGIC, 4) != 0 ||
+      data[4] != TAG_REGISTRY_VERSION) {
+    for (uint16_t page = 0; page < TAG_REGISTRY_PAGES; page++) {
+      char name[8];
+      pageName(page, name);
+      _storage.remove(name);
+    }
+    _error = "Registry was not readable and has been reset";
+    return saveMeta();
+  }
+
+  _meta.count = getLE16(data + 6);
+  const uint8_t* names = data + 8;
+  for (uint8_t i = 0; i < TAG_GROUPS_MAX; i++) {
+    memcpy(_meta.groups[i], names, TAG_GROUP_LENGTH);
+    names += TAG_GROUP_LENGTH + 1;
+  }
+  for (uint8_t i = 0; i < TAG_PROFILES_MAX; i++) {
+    memcpy(_meta.models[i], names, TAG_MODEL_LENGTH);
+    names += TAG_MODEL_LENGTH + 1;
+  }
+  return true;
+}
+
+bool TagRegistry::saveMeta() {
+  uint8_t data[TAG_META_SIZE];
+  memset(data, 0, sizeof(data));
+  memcpy(data, TAG_REGISTRY_MAGIC, 4);
+  data[4] = TAG_REGISTRY_VERSION;
+  putLE16(data + 6, _meta.count);
+  uint8_t* names = data + 8;
+  for (uint8_t i = 0; i < TAG_GROUPS_MAX; i++) {
+    memcpy(names, _meta.groups[i], TAG_GROUP_LENGTH);
+    names += TAG_GROUP_LENGTH + 1;
+  }
+  for (uint8_t i = 0; i < TAG_PROFILES_MAX; i++) {
+    memcpy(names, _meta.models[i], TAG_MODEL_LENGTH);
+    names += TAG_MODEL_LENGTH + 1;
+  }
+
+  // Renamed into place so a reset while saving keeps the previous copy
+  return _storage.write(TAG_META_TEMP, data, sizeof(data)) &&
+         _storage.rename(TAG_META_TEMP, TAG_META_NAME);
+}
+
+bool TagRegistry::parseBarcode(const char* barcode, uint64_t* value, uint32_t* plid) {
+  uint64_t number = 0;
+  uint32_t part1 = 0;
+  uint32_t part2 = 0;
+  for (uint8_t i = 0; i < TAG_BARCODE_LENGTH; i++) {
+    char c = barcode[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    uint8_t digit = c - '0';
+    number = number * 10 + digit;
+    if (i >= 2 && i < 7) {
+      part1 = part1 * 10 + digit;
+    } else if (i >= 7 && i < 12) {
+      part2 = part2 * 10 + digit;
+    }
+  }
+  if (barcode[TAG_BARCODE_LENGTH] != '\0' || number == 0) {
+    return false;
+  }
+
+  *value = number;
+  *plid = part1 + (part2 << 16);
+  return true;
+}
+
+void TagRegistry::formatBarcode(uint64_t value, char* out) {
+  for (int8_t i = TAG_BARCODE_LENGTH - 1; i >= 0; i--) {
+    out[i] = '0' + value % 10;
+    value /= 10;
+  }
+  out[TAG_BARCODE_LENGTH] = '\0';
+}
+
+uint16_t TagRegistry::homeSlot(uint32_t plid) {
+  // Multiplicative hash, its high bits scaled onto the table
+  uint32_t hash = plid * 2654435761UL;
+  return ((uint64_t)hash * TAG_REGISTRY_CAPACITY) >> 32;
+}
+
+void TagRegistry::pageName(uint16_t page, char* out) {
+  snprintf(out, 8, "p%03u", page);
+}
+
+void TagRegistry::encode(const TagRecord& record, uint8_t* out) {
+  putLE32(out, (uint32_t)record.barcode);
+  putLE32(out + 4, (uint32_t)(record.barcode >> 32));
+  putLE32(out + 8, record.plid);
+  putLE32(out + 12, record.lastSent);
+  putLE32(out + 16, record.airtimeMs);
+  putLE16(out + 20, record.groups);
+  out[22] = record.model;
+  out[23] = 0;
+  for (uint8_t i = 0; i < TAG_PAGE_HASHES; i++) {
+    putLE16(out + 24 + i * 2, record.pageHash[i]);
+  }
+}
+
+void TagRegistry::decode(const uint8_t* in, TagRecord* record) {
+  record->barcode = getLE32(in) | ((uint64_t)getLE32(in + 4) << 32);
+  record->plid = getLE32(in + 8);
+  record->lastSent = getLE32(in + 12);
+  record->airtimeMs = getLE32(in + 16);
+  record->groups = getLE16(in + 20);
+  record->model = in[22];
+  for (uint8_t i = 0; i < TAG_PAGE_HASHES; i++) {
+    record->pageHash[i] = getLE16(in + 24 + i * 2);
+  }
+}
+
+uint16_t TagRegistry::readRecords(uint16_t slot, uint16_t count) {
+  char name[8];
+  pageName(slot / TAG_REGISTRY_PAGE_RECORDS, name);
+  uint32_t offset = (uint32_t)(slot % TAG_REGISTRY_PAGE_RECORDS) * TAG_RECORD_SIZE;
+
+  // Pages only extend to their last written slot, the rest is free
+  int32_t length = _storage.read(name, offset, _scan, count * TAG_RECORD_SIZE);
+  if (length < 0) {
+    length = 0;
+  }
+  memset(_scan + length, 0, count * TAG_RECORD_SIZE - length);
+  return length / TAG_RECORD_SIZE;
+}
+
+bool TagRegistry::writeRecord(uint16_t slot, const TagRecord& record) {
+  char name[8];
+  pageName(slot / TAG_REGISTRY_PAGE_RECORDS, name);
+  uint8_t data[TAG_RECORD_SIZE];
+  encode(record, data);
+  return _storage.writeAt(name, (uint32_t)(slot % TAG_REGISTRY_PAGE_RECORDS) * TAG_RECORD_SIZE,
+                          data, sizeof(data));
+}
+
+uint16_t TagRegistry::probe(uint32_t plid, TagRecord* record, uint16_t* freeSlot) {
+  *freeSlot = TAG_NO_SLOT;
+  uint16_t slot = homeSlot(plid);
+
+  // Runs never cross a page end; the capacity is whole pages, so the wrap
+  // back to slot 0 falls on a run boundary as well
+  uint16_t probed = 0;
+  while (probed < TAG_REGISTRY_CAPACITY) {
+    uint16_t run = TAG_REGISTRY_PAGE_RECORDS - slot % TAG_REGISTRY_PAGE_RECORDS;
+    if (run > TAG_REGISTRY_SCAN) {
+      run = TAG_REGISTRY_SCAN;
+    }
+    readRecords(slot, run);
+
+    for (uint16_t i = 0; i < run; i++) {
+      decode(_scan + i * TAG_RECORD_SIZE, record);
+      if (record->barcode == 0) {
+        // A free slot ends every probe sequence that passed here
+        if (*freeSlot == TAG_NO_SLOT) {
+          *freeSlot = slot + i;
+        }
+        return TAG_NO_SLOT;
+      }
+      if (record->barcode == TAG_BARCODE_REMOVED) {
+        if (*freeSlot == TAG_NO_SLOT) {
+          *freeSlot = slot + i;
+        }
+      } else if (record->plid == plid) {
+        return slot + i;
+      }
+    }
+
+    probed += run;
+    slot = (slot + run) % TAG_REGISTRY_CAPACITY;
+  }
+  return TAG_NO_SLOT;
+}
+
+TagRegistry::CacheEntry* TagRegistry::cached(uint32_t plid) {
+  for (uint8_t i = 0; i < TAG_REGISTRY_CACHE; i++) {
+    if (_cache[i].slot != TAG_NO_SLOT && _cache[i].record.plid == plid) {
+      return &_cache[i];
+    }
+  }
+  return NULL;
+}
+
+TagRegistry::CacheEntry* TagRegistry::cacheRecord(uint16_t slot, const TagRecord& record) {
+  CacheEntry* entry = &_cache[0];
+  for (uint8_t i = 0; i < TAG_REGISTRY_CACHE; i++) {
+    if (_cache[i].slot == TAG_NO_SLOT) {
+      entry = &_cache[i];
+      break;
+    }
+    if (_cache[i].used < entry->used) {
+      entry = &_cache[i];
+    }
+  }
+
+  if (entry->slot != TAG_NO_SLOT && entry->dirty) {
+    writeRecord(entry->slot, entry->record);
+  }
+  entry->record = record;
+  entry->slot = slot;
+  entry->dirty = false;
+  entry->used = ++_useCounter;
+  return entry;
+}
+
+TagRegistry::CacheEntry* TagRegistry::lookup(uint32_t plid, uint16_t* freeSlot) {
+  _lookups++;
+  *freeSlot = TAG_NO_SLOT;
+  CacheEntry* entry = cached(plid);
+  if (entry) {
+    entry->used = ++_useCounter;
+    return entry;
+  }
+
+  _cacheMisses++;
+  TagRecord record;
+  uint16_t slot = probe(plid, &record, freeSlot);
+  return slot == TAG_NO_SLOT ? NULL : cacheRecord(slot, record);
+}
+
+const TagRecord* TagRegistry::find(const char* barcode) {
+  uint64_t value;
+  uint32_t plid;
+  if (!parseBarcode(barcode, &value, &plid)) {
+    return NULL;
+  }
+  uint16_t freeSlot;
+  CacheEntry* entry = lookup(plid, &freeSlot);
+  return entry ? &entry->record : NULL;
+}
+
+const TagProfile& TagRegistry::profileFor(const char* barcode) {
+  const TagRecord* record = find(barcode);
+  const char* model = record ? modelName(*record) : NULL;
+  // A model removed from the profiles since falls back to the prefix rules
+  const TagProfile* profile = model ? _profiles.find(model) : NULL;
+  return profile ? *profile : _profiles.forBarcode(barcode);
+}
+
+const char* TagRegistry::modelName(const TagRecord& record) {
+  if (record.model >= TAG_PROFILES_MAX || _meta.models[record.model][0] == '\0') {
+    return NULL;
+  }
+  return _meta.models[record.model];
+}
+
+uint8_t TagRegistry::modelIndex(const char* model) {
+  uint8_t unused = TAG_NO_MODEL;
+  for (uint8_t i = 0; i < TAG_PROFILES_MAX; i++) {
+    if (strcmp(_meta.models[i], model) == 0) {
+      return i;
+    }
+    if (unused == TAG_NO_MODEL && _meta.models[i][0] == '\0') {
+      unused = i;
+    }
+  }
+  if (unused != TAG_NO_MODEL) {
+    strncpy(_meta.models[unused], model, TAG_MODEL_LENGTH);
+    _meta.models[unused][TAG_MODEL_LENGTH] = '\0';
+  }
+  return unused;
+}
+
+bool TagRegistry::put(const char* barcode, const char* model, uint16_t groups) {
+  uint64_t value;
+  uint32_t plid;
+  if (!parseBarcode(barcode, &value, &plid)) {
+    _error = "Barcode must be 17 digits";
+    return false;
+  }
+
+  uint8_t modelNumber = TAG_NO_MODEL;
+  if (model && *model) {
+    if (!_profiles.find(model)) {
+      _error = "Unknown model";
+      return false;
+    }
+    modelNumber = modelIndex(model);
+    if (modelNumber == TAG_NO_MODEL) {
+      _error = "Too many models";
+      return false;
+    }
+  }
+
+  uint16_t freeSlot;
+  CacheEntry* entry = lookup(plid, &freeSlot);
+  bool added = false;
+  if (!entry) {
+    if (_meta.count >= TAG_REGISTRY_MAX_TAGS || freeSlot == TAG_NO_SLOT) {
+      _error = "Tag registry is full";
+      return false;
+    }
+    TagRecord record;
+    memset(&record, 0, sizeof(record));
+    record.plid = plid;
+    entry = cacheRecord(freeSlot, record);
+    added = true;
+  }
+
+  // Written with the statistics collected so far
+  entry->record.barcode = value;
+  entry->record.model = modelNumber;
+  entry->record.groups = groups;
+  if (!writeRecord(entry->slot, entry->record)) {
+    if (added) {
+      entry->slot = TAG_NO_SLOT;
+    }
+    _error = "Tag not saved";
+    return false;
+  }
+  entry->dirty = false;
+
+  // The meta file also holds new group and model names
+  if (added) {
+    _meta.count++;
+  }
+  if (!saveMeta()) {
+    _error = "Tag saved, names not saved";
+    return false;
+  }
+  return true;
+}
+
+bool TagRegistry::remove(const char* barcode) {
+  uint64_t value;
+  uint32_t plid;
+  uint16_t freeSlot;
+  CacheEntry* entry = parseBarcode(barcode, &value, &plid) ? lookup(plid, &freeSlot) : NULL;
+  if (!entry) {
+    _error = "Tag not registered";
+    return false;
+  }
+
+  // Later tags of the probe sequence stay reachable past the removed mark
+  TagRecord removed;
+  memset(&removed, 0, sizeof(removed));
+  removed.barcode = TAG_BARCODE_REMOVED;
+  if (!writeRecord(entry->slot, removed)) {
+    _error = "Tag not removed";
+    return false;
+  }
+  entry->slot = TAG_NO_SLOT;
+  entry->dirty = false;
+  _meta.count--;
+  saveMeta();
+  return true;
+}
+
+uint32_t TagRegistry::useTag(const char* barcode) {
+  uint64_t value;
+  uint32_t plid;
+  if (!parseBarcode(barcode, &value, &plid)) {
+    return 0;
+  }
+
+  uint16_t freeSlot;
+  if (lookup(plid, &freeSlot)) {
+    return plid;
+  }
+  if (_meta.count >= TAG_REGISTRY_MAX_TAGS || freeSlot == TAG_NO_SLOT) {
+    return 0;
+  }
+
+  TagRecord record;
+  memset(&record, 0, sizeof(record));
+  record.barcode = value;
+  record.plid = plid;
+  record.model = TAG_NO_MODEL;
+  if (!writeRecord(freeSlot, record)) {
+    return 0;
+  }
+  cacheRecord(freeSlot, record);
+  _meta.count++;
+  saveMeta();
+  return plid;
+}
+
+void TagRegistry::recordAirtime(uint32_t plid, uint32_t airtimeUs) {
+  uint16_t freeSlot;
+  CacheEntry* entry = lookup(plid, &freeSlot);
+  if (!entry) {
+    return;
+  }
+  entry->record.airtimeMs += (airtimeUs + 500) / 1000;
+  uint32_t now = _clock();
+  if (now) {
+    entry->record.lastSent = now;
+  }
+  entry->dirty = true;
+}
+
+void TagRegistry::recordPayload(uint32_t plid, uint8_t page, const uint8_t* data, size_t length) {
+  uint16_t freeSlot;
+  CacheEntry* entry = page < TAG_PAGE_HASHES ? lookup(plid, &freeSlot) : NULL;
+  if (!entry) {
+    return;
+  }
+
+  // FNV-1a folded to 16 bits, 0 is kept for pages never sent
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+  uint16_t folded = (hash >> 16) ^ (hash & 0xFFFF);
+  entry->record.pageHash[page] = folded ? folded : 1;
+  entry->dirty = true;
+}
+
+bool TagRegistry::next(uint16_t* position, TagRecord* record, int8_t group) {
+  while (*position < TAG_REGISTRY_CAPACITY) {
+    uint16_t run = TAG_REGISTRY_PAGE_RECORDS - *position % TAG_REGISTRY_PAGE_RECORDS;
+    if (run > TAG_REGISTRY_SCAN) {
+      run = TAG_REGISTRY_SCAN;
+    }
+    uint16_t present = readRecords(*position, run);
+
+    for (uint16_t i = 0; i < present; i++) {
+      uint16_t slot = (*position)++;
+      decode(_scan + i * TAG_RECORD_SIZE, record);
+      if (record->barcode == 0 || record->barcode == TAG_BARCODE_REMOVED) {
+        continue;
+      }
+      // Statistics not written back yet are in the cache
+      for (uint8_t c = 0; c < TAG_REGISTRY_CACHE; c++) {
+        if (_cache[c].slot == slot) {
+          *record = _cache[c].record;
+        }
+      }
+      if (group < 0 || (record->groups & (1 << group))) {
+        return true;
+      }
+    }
+
+    // Nothing stored past the end of the page file
+    if (present < run) {
+      *position = (*position / TAG_REGISTRY_PAGE_RECORDS + 1) * TAG_REGISTRY_PAGE_RECORDS;
+    }
+  }
+  return false;
+}
+
+bool TagRegistry::parseGroups(const char* list, uint16_t* groups) {
+  *groups = 0;
+  while (*list) {
+    const char* end = strchr(list, ',');
+    size_t length = end ? (size_t)(end - list) : strlen(list);
+    while (length > 0 && *list == ' ') {
+      list++;
+      length--;
+    }
+    while (length > 0 && list[length - 1] == ' ') {
+      length--;
+    }
+
+    if (length > 0) {
+      if (length > TAG_GROUP_LENGTH) {
+        _error = "Group names are at most 15 characters";
+        return false;
+      }
+      for (size_t i = 0; i < length; i++) {
+        if (!isGroupChar(list[i])) {
+          _error = "Group names use letters, digits, '-', '_' and '.'";
+          return false;
+        }
+      }
+
+      int8_t group = -1;
+      int8_t unused = -1;
+      for (uint8_t i = 0; i < TAG_GROUPS_MAX; i++) {
+        if (strncmp(_meta.groups[i], list, length) == 0 && _meta.groups[i][length] == '\0') {
+          group = i;
+          break;
+        }
+        if (unused < 0 && _meta.groups[i][0] == '\0') {
+          unused = i;
+        }
+      }
+      if (group < 0) {
+        if (unused < 0) {
+          _error = "Too many groups";
+          return false;
+        }
+        group = unused;
+        memcpy(_meta.groups[group], list, length);
+        _meta.groups[group][length] = '\0';
+      }
+      *groups |= 1 << group;
+    }
+
+    if (!end) {
+      break;
+    }
+    list = end + 1;
+  }
+  return true;
+}
+
+int8_t TagRegistry::findGroup(const char* name) {
+  if (!*name) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < TAG_GROUPS_MAX; i++) {
+    if (strcmp(_meta.groups[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void TagRegistry::service() {
+  if (_millis() - _lastFlush >= TAG_REGISTRY_FLUSH_MS) {
+    flush();
+  }
+}
+
+void TagRegistry::flush() {
+  for (uint8_t i = 0; i < TAG_REGISTRY_CACHE; i++) {
+    if (_cache[i].slot != TAG_NO_SLOT && _cache[i].dirty) {
+      if (writeRecord(_cache[i].slot, _cache[i].record)) {
+        _cache[i].dirty = false;
+      }
+    }
+  }
+  _lastFlush = _millis();
+}
\ No newline at end of file
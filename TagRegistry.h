@@ -0,0 +1,160 @@
+#ifndef TAG_REGISTRY_H
+#define TAG_REGISTRY_H
+
+// Persistent registry of the tags in the store, keyed by PLID
+//
+// One open-addressing hash table with linear probing, stored as
+// TAG_REGISTRY_PAGES files of TAG_REGISTRY_PAGE_RECORDS fixed size records.
+// A file stays within one 4 KB flash block, so changing a record rewrites a
+// single block instead of the tail of one large file, and files only grow as
+// far as their last used slot. A lookup reads TAG_REGISTRY_SCAN records at a
+// time from the tag's home slot on; below TAG_REGISTRY_MAX_TAGS that is one
+// read on average, independent of how many tags are registered. Recently used
+// records stay in a small RAM cache, jobs for the same tag do not touch flash.
+//
+// Each record holds the tag's model (by name, NULL for the prefix rules of
+// TagProfiles), the groups it belongs to (e.g. "aisle-5", "dairy"), when it was
+// last sent to, the airtime it took and a hash of the last payload per page.
+// Registration and removal are written at once; the statistics collect in
+// the cache and are written back every TAG_REGISTRY_FLUSH_MS and on eviction.
+// Tags that are transmitted to are registered on first contact.
+//
+// No Arduino dependencies: storage and clocks are injected, host builds can
+// run the registry on a directory
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SpoolStorage.h"
+#include "TagProfiles.h"
+
+#define TAG_REGISTRY_PAGES 128
+#define TAG_REGISTRY_PAGE_RECORDS 100
+#define TAG_REGISTRY_CAPACITY (TAG_REGISTRY_PAGES * TAG_REGISTRY_PAGE_RECORDS)
+// Probe sequences grow quickly past this load, registration stops there
+#define TAG_REGISTRY_MAX_TAGS (TAG_REGISTRY_CAPACITY * 9 / 10)
+#define TAG_RECORD_SIZE 40         // On flash, see TagRegistry.cpp
+#define TAG_REGISTRY_CACHE 16
+#define TAG_REGISTRY_SCAN 10
+#define TAG_REGISTRY_FLUSH_MS 60000
+#define TAG_BARCODE_LENGTH 17
+#define TAG_GROUPS_MAX 16
+#define TAG_GROUP_LENGTH 15
+#define TAG_PAGE_HASHES 8
+#define TAG_NO_MODEL 0xFF
+#define TAG_NO_SLOT 0xFFFF
+
+struct TagRecord {
+  uint64_t barcode;         // The 17 digits as a number
+  uint32_t plid;
+  uint32_t lastSent;        // Unix seconds, 0 = never or clock not set
+  uint32_t airtimeMs;
+  uint16_t groups;          // Bit per group name
+  uint8_t model;            // Index into the registry's model names, TAG_NO_MODEL = by prefix
+  uint16_t pageHash[TAG_PAGE_HASHES];  // 0 = nothing sent to the page yet
+};
+
+// Unix time in seconds (0 while not set), or milliseconds since boot
+typedef uint32_t (*TagClockFn)();
+
+class TagRegistry {
+  public:
+    TagRegistry(SpoolStorage& storage, TagProfiles& profiles, TagClockFn clock, TagClockFn millisClock);
+
+    bool begin();
+
+    // Barcodes are exactly 17 digits, not all zero; the PLID comes from
+    // digits 2-6 and 7-11
+    static bool parseBarcode(const char* barcode, uint64_t* value, uint32_t* plid);
+    // out holds TAG_BARCODE_LENGTH + 1 characters
+    static void formatBarcode(uint64_t value, char* out);
+
+    // The record is valid until the next call into the registry, NULL if the
+    // tag is not registered
+    const TagRecord* find(const char* barcode);
+    // Registered model, else the prefix rules
+    const TagProfile& profileFor(const char* barcode);
+
+    // Register a tag or change it; model NULL or "" leaves the choice to the
+    // prefix rules. false with getError() set if the table is full or the
+    // barcode or model is not valid
+    bool put(const char* barcode, const char* model, uint16_t groups);
+    bool remove(const char* barcode);
+    const char* getError() { return _error; }
+
+    // Called at the start of every job: registers the tag if needed and
+    // returns its PLID, 0 for barcodes that cannot be registered
+    uint32_t useTag(const char* barcode);
+    // Statistics of a tag returned by useTag()
+    void recordAirtime(uint32_t plid, uint32_t airtimeUs);
+    void recordPayload(uint32_t plid, uint8_t page, const uint8_t* data, size_t length);
+
+    // Walk the table, position starts at 0; group -1 returns every tag
+    bool next(uint16_t* position, TagRecord* record, int8_t group = -1);
+
+    // Groups from a comma separated list of names, new names are added;
+    // false with getError() set on a bad name or when all groups are taken
+    bool parseGroups(const char* list, uint16_t* groups);
+    int8_t findGroup(const char* name);
+    // "" for unused groups
+    const char* groupName(uint8_t group) { return _meta.groups[group]; }
+    // Model name of a record, NULL if it follows the prefix rules
+    const char* modelName(const TagRecord& record);
+
+    // Write back the statistics when due, call from loop()
+    void service();
+    // Write back all pending statistics, e.g. before a restart
+    void flush();
+
+    uint16_t getCount() { return _meta.count; }
+    uint16_t getCapacity() { return TAG_REGISTRY_CAPACITY; }
+    uint32_t getLookups() { return _lookups; }
+    uint32_t getCacheMisses() { return _cacheMisses; }
+
+  private:
+    struct Meta {
+      uint16_t count;
+      char groups[TAG_GROUPS_MAX][TAG_GROUP_LENGTH + 1];
+      char models[TAG_PROFILES_MAX][TAG_MODEL_LENGTH + 1];
+    };
+
+    struct CacheEntry {
+      TagRecord record;
+      uint16_t slot;          // TAG_NO_SLOT = entry unused
+      bool dirty;             // Statistics not written yet
+      uint32_t used;          // For least recently used eviction
+    };
+
+    SpoolStorage& _storage;
+    TagProfiles& _profiles;
+    TagClockFn _clock;
+    TagClockFn _millis;
+    Meta _meta;
+    CacheEntry _cache[TAG_REGISTRY_CACHE];
+    uint32_t _useCounter;
+    uint8_t _scan[TAG_REGISTRY_SCAN * TAG_RECORD_SIZE];   // Raw records read by a probe
+    uint32_t _lastFlush;
+    uint32_t _lookups;
+    uint32_t _cacheMisses;
+    const char* _error;
+
+    static uint16_t homeSlot(uint32_t plid);
+    static void pageName(uint16_t page, char* out);
+    static void encode(const TagRecord& record, uint8_t* out);
+    static void decode(const uint8_t* in, TagRecord* record);
+
+    // Records read into _scan, missing ones read as free
+    uint16_t readRecords(uint16_t slot, uint16_t count);
+    bool writeRecord(uint16_t slot, const TagRecord& record);
+    bool saveMeta();
+    void clear();
+
+    // Slot of the tag or TAG_NO_SLOT; freeSlot gets the first slot on the way
+    // a new record could take
+    uint16_t probe(uint32_t plid, TagRecord* record, uint16_t* freeSlot);
+    CacheEntry* lookup(uint32_t plid, uint16_t* freeSlot);
+    CacheEntry* cacheRecord(uint16_t slot, const TagRecord& record);
+    CacheEntry* cached(uint32_t plid);
+    uint8_t modelIndex(const char* model);
+};
+
+#endif
\ No newline at end of file
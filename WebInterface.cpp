@@ -1,376 +1,199 @@
 #include "WebInterface.h"
 #include "ESLProtocol.h"
-#include <ArduinoJson.h>
+#include "Metrics.h"
+#include "Profiler.h"
+#include "JobSpool.h"
+#include "BatchReader.h"
+#include "HexDecode.h"
+#include "WebUI.h"
+#include "JsonWriter.h"
+#include "FlashJobs.h"
+#include "TagProfiles.h"
+#include "WiFiLink.h"
+#include "Arena.h"
+#include "TagRegistry.h"
+#include "Redundancy.h"
+#include <stdarg.h>
 
-extern char ssid[32];
-extern char password[64];
+extern char ssid[WIFI_SSID_LENGTH + 1];
+extern char password[WIFI_PASSWORD_LENGTH + 1];
 extern bool apMode;
+extern bool reuseLease;
 extern void saveSettings();
 extern const char* FW_VERSION;
 extern const char* HW_VERSION;
 extern unsigned long uptimeStart;
-extern unsigned long totalFramesSent;
+extern uint32_t bootReadyMs;
+extern Metrics metrics;
+extern Arena imageArena;
+extern Profiler profiler;
+extern JobSpool jobSpool;
+extern FlashJobArea flashJobs;
+extern TagProfiles tagProfiles;
+extern TagRegistry tagRegistry;
+extern WiFiLink wifiLink;
+
+// Collects formatted text into a fixed buffer and sends it as large chunks,
+// so streamed text reports need neither String building nor one write per line
+class ChunkedText {
+  public:
+    ChunkedText(ESP8266WebServer* server) : _server(server), _length(0) {}
+    
+    void printf(const char* format, ...) {
+      va_list args;
+      va_start(args, format);
+      int written = vsnprintf(_buffer + _length, sizeof(_buffer) - _length, format, args);
+      va_end(args);
+      
+      if (written < 0) {
+        return;
+      }
+      
+      // Line did not fit - send what we have and format it again at the start
+      if (_length + written >= sizeof(_buffer)) {
+        flush();
+        va_start(args, format);
+        written = vsnprintf(_buffer, sizeof(_buffer), format, args);
+        va_end(args);
+        if (written < 0) {
+          return;
+        }
+        if ((size_t)written >= sizeof(_buffer)) {
+          written = sizeof(_buffer) - 1; // Truncate oversized lines
+        }
+      }
+      
+      _length += written;
+    }
+    
+    void write(const char* data, size_t length) {
+      while (length > 0) {
+        if (_length == sizeof(_buffer)) {
+          flush();
+        }
+        size_t room = sizeof(_buffer) - _length;
+        size_t part = length < room ? length : room;
+        memcpy(_buffer + _length, data, part);
+        _length += part;
+        data += part;
+        length -= part;
+      }
+    }
+    
+    void flush() {
+      if (_length > 0) {
+        _server->sendContent(_buffer, _length);
+        _length = 0;
+      }
+    }
+    
+  private:
+    ESP8266WebServer* _server;
+    char _buffer[512];
+    size_t _length;
+};
+
+// Print a value stored in 1/scale units as a decimal number of whole units
+// (e.g. microseconds with scale 1000000 as seconds)
+static void formatScaled(char* out, size_t outSize, uint64_t value, uint32_t scale) {
+  uint8_t digits = 0;
+  for (uint32_t s = scale; s > 1; s /= 10) {
+    digits++;
+  }
+  snprintf(out, outSize, "%lu.%0*lu", (unsigned long)(value / scale), digits,
+           (unsigned long)(value % scale));
+}
+
+static void writeHistogram(ChunkedText& out, const char* name, const char* help,
+                           const MetricsHistogram& histogram, uint32_t scale) {
+  char number[24];
+  
+  out.printf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+  
+  uint32_t cumulative = 0;
+  for (uint8_t b = 0; b < histogram.boundCount; b++) {
+    cumulative += histogram.counts[b];
+    formatScaled(number, sizeof(number), histogram.bounds[b], scale);
+    out.printf("%s_bucket{le=\"%s\"} %lu\n", name, number, (unsigned long)cumulative);
+  }
+  
+  out.printf("%s_bucket{le=\"+Inf\"} %lu\n", name, (unsigned long)histogram.count);
+  formatScaled(number, sizeof(number), histogram.sum, scale);
+  out.printf("%s_sum %s\n%s_count %lu\n", name, number, name, (unsigned long)histogram.count);
+}
 
 WebInterface::WebInterface(ESP8266WebServer* server, IRTransmitter* irTransmitter, OLEDInterface* oledInterface) {
   _server = server;
   _irTransmitter = irTransmitter;
   _oledInterface = oledInterface;
+  _uploadStatus = 0;
+  _uploadError[0] = '\0';
+  _uploadChecked = false;
   _eslProtocol = new ESLProtocol(irTransmitter);
 }
 
 void WebInterface::setupRoutes() {
+  // Content-Type tells binary bodies from form posts,
+  // If-None-Match lets cached copies of the UI be revalidated
+  static const char* headers[] = { "Content-Type", "If-None-Match" };
+  _server->collectHeaders(headers, 2);
+  
   _server->on("/", HTTP_GET, [this]() { this->handleRoot(); });
   
   // File upload handling requires special configuration
   _server->on("/transmit-image", HTTP_POST, 
-    [this](){ this->sendSuccessResponse("Image upload complete"); },
-    [this](){ this->handleTransmitImage(); }
+    [this](){ this->handleTransmitImage(); },
+    [this](){ this->handleFileUpload(); }
   );
   
   _server->on("/raw-command", HTTP_POST, [this]() { this->handleRawCommand(); });
   _server->on("/set-segments", HTTP_POST, [this]() { this->handleSetSegments(); });
   _server->on("/ping", HTTP_POST, [this]() { this->handlePing(); });
+  _server->on("/ping-parallel", HTTP_POST, [this]() { this->handlePingParallel(); });
   _server->on("/refresh", HTTP_POST, [this]() { this->handleRefresh(); });
+  _server->on("/batch", HTTP_POST, [this]() { this->handleBatch(); });
+  _server->on("/events", HTTP_GET, [this]() { this->handleEvents(); });
   _server->on("/wifi-config", HTTP_POST, [this]() { this->handleWifiConfig(); });
   _server->on("/restart", HTTP_POST, [this]() { this->handleRestart(); });
   _server->on("/status", HTTP_GET, [this]() { this->handleStatus(); });
   _server->on("/test-frequency", HTTP_GET, [this]() { this->handleTestFrequency(); });
+  _server->on("/metrics", HTTP_GET, [this]() { this->handleMetrics(); });
+  _server->on("/profile", HTTP_GET, [this]() { this->handleProfile(); });
+  _server->on("/trace", HTTP_GET, [this]() { this->handleTrace(); });
+  _server->on("/trace", HTTP_POST, [this]() { this->handleTraceConfig(); });
+  _server->on("/trace.vcd", HTTP_GET, [this]() { this->handleTraceVCD(); });
+  _server->on("/spool", HTTP_GET, [this]() { this->handleSpoolList(); });
+  _server->on("/spool", HTTP_DELETE, [this]() { this->handleSpoolCancel(); });
+  _server->on("/profiles", HTTP_GET, [this]() { this->handleProfileList(); });
+  _server->on("/profiles", HTTP_POST, [this]() { this->handleProfileUpload(); });
+  _server->on("/profiles/assign", HTTP_POST, [this]() { this->handleProfileAssign(); });
+  _server->on("/redundancy", HTTP_GET, [this]() { this->handleRedundancy(); });
+  _server->on("/tags", HTTP_GET, [this]() { this->handleTagList(); });
+  _server->on("/tags", HTTP_POST, [this]() { this->handleTagPut(); });
+  _server->on("/tags", HTTP_DELETE, [this]() { this->handleTagRemove(); });
+  _server->on("/groups/ping", HTTP_POST, [this]() { this->handleGroupSend(true); });
+  _server->on("/groups/refresh", HTTP_POST, [this]() { this->handleGroupSend(false); });
   
   _server->onNotFound([this]() { this->handleNotFound(); });
 }
 
 void WebInterface::handleRoot() {
-  // Set cache control headers to prevent caching
-  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
-  _server->sendHeader("Pragma", "no-cache");
-  _server->sendHeader("Expires", "0");
+  // The page only changes with the firmware, a browser that has it gets a 304
+  _server->sendHeader("ETag", WEB_UI_INDEX_ETAG);
+  _server->sendHeader("Cache-Control", "public, max-age=86400");
+  if (_server->header("If-None-Match") == WEB_UI_INDEX_ETAG) {
+    _server->send(304);
+    return;
+  }
   
-  // More efficient way to serve HTML - build it in chunks to avoid memory issues
-  _server->setContentLength(CONTENT_LENGTH_UNKNOWN); // We don't know the size in advance
-  _server->send(200, "text/html", ""); // Start the response
-
-  // Send HTML in chunks to avoid memory issues
-  _server->sendContent("<!DOCTYPE html><html lang=\"en\"><head>");
-  _server->sendContent("<meta charset=\"UTF-8\"><title>ESL Blaster</title>");
-  _server->sendContent("<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">");
-  _server->sendContent("<meta http-equiv=\"Cache-Control\" content=\"no-cache, no-store, must-revalidate\" />");
-  _server->sendContent("<meta http-equiv=\"Pragma\" content=\"no-cache\" /><meta http-equiv=\"Expires\" content=\"0\" />");
-  
-  // Send CSS
-  _server->sendContent("<style>");
-  _server->sendContent("* { box-sizing: border-box; }");
-  _server->sendContent("body { font-family: Arial, sans-serif; max-width: 800px; margin: 0 auto; padding: 20px; color: #333; line-height: 1.6; }");
-  _server->sendContent("h1, h2 { color: #2c3e50; margin-top: 0; }");
-  _server->sendContent("h1 { text-align: center; margin-bottom: 20px; }");
-  _server->sendContent(".tab-container { margin-bottom: 20px; }");
-  _server->sendContent(".tabs { display: flex; flex-wrap: wrap; border-bottom: 1px solid #ccc; margin-bottom: 0; }");
-  _server->sendContent(".tab-button { background-color: #f1f1f1; border: 1px solid #ccc; border-bottom: none; border-radius: 4px 4px 0 0; padding: 10px 15px; margin-right: 5px; margin-bottom: -1px; cursor: pointer; transition: 0.3s; position: relative; top: 1px; }");
-  _server->sendContent(".tab-button:hover { background-color: #ddd; }");
-  _server->sendContent(".tab-button.active { background-color: #3498db; color: white; border-bottom: 1px solid #3498db; }");
-  _server->sendContent(".tab-content { display: none; padding: 20px; border: 1px solid #ccc; border-top: none; border-radius: 0 0 4px 4px; background-color: #fff; }");
-  _server->sendContent(".tab-content.active { display: block; }");
-  _server->sendContent(".form-group { margin-bottom: 15px; }");
-  _server->sendContent("label { display: block; margin-bottom: 5px; font-weight: bold; }");
-  _server->sendContent("input[type=text], input[type=number], input[type=password], select, textarea { width: 100%; padding: 10px; border: 1px solid #ddd; border-radius: 4px; font-size: 16px; }");
-  _server->sendContent("button[type=submit], button[type=button] { background-color: #3498db; color: white; padding: 10px 15px; border: none; border-radius: 4px; cursor: pointer; font-size: 16px; margin-top: 10px; }");
-  _server->sendContent("button[type=submit]:hover, button[type=button]:hover { background-color: #2980b9; }");
-  _server->sendContent("#status-message { margin-top: 20px; padding: 15px; border-radius: 4px; display: none; }");
-  _server->sendContent(".success { background-color: #d4edda; color: #155724; border: 1px solid #c3e6cb; }");
-  _server->sendContent(".error { background-color: #f8d7da; color: #721c24; border: 1px solid #f5c6cb; }");
-  _server->sendContent(".quick-actions { display: flex; flex-wrap: wrap; gap: 10px; margin-bottom: 20px; }");
-  _server->sendContent(".quick-actions button { flex: 1; min-width: 150px; }");
-  _server->sendContent("</style></head><body>");
-  
-  // Send body content
-  _server->sendContent("<h1>ESL Blaster Control Panel</h1>");
-  
-  // Quick actions
-  _server->sendContent("<div class=\"quick-actions\">");
-  _server->sendContent("<button id=\"statusBtn\" type=\"button\">Device Status</button>");
-  _server->sendContent("<button id=\"restartBtn\" type=\"button\">Restart Device</button>");
-  _server->sendContent("<button id=\"testFreqBtn\" type=\"button\">Test 1.25MHz</button>");
-  _server->sendContent("</div>");
-  
-  // Tab container
-  _server->sendContent("<div class=\"tab-container\"><div class=\"tabs\">");
-  _server->sendContent("<button class=\"tab-button active\" data-target=\"ImageTab\">Image</button>");
-  _server->sendContent("<button class=\"tab-button\" data-target=\"RawTab\">Raw Command</button>");
-  _server->sendContent("<button class=\"tab-button\" data-target=\"SegmentTab\">Segments</button>");
-  _server->sendContent("<button class=\"tab-button\" data-target=\"PingTab\">Ping/Refresh</button>");
-  _server->sendContent("<button class=\"tab-button\" data-target=\"SettingsTab\">WiFi Settings</button>");
-  _server->sendContent("<button class=\"tab-button\" data-target=\"AboutTab\">About</button>");
-  _server->sendContent("</div>");
-  
-  // Image tab
-  _server->sendContent("<div id=\"ImageTab\" class=\"tab-content active\">");
-  _server->sendContent("<h2>Transmit Image to ESL</h2>");
-  _server->sendContent("<form id=\"imageForm\" enctype=\"multipart/form-data\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"barcode\">ESL Barcode (17 digits):</label>");
-  _server->sendContent("<input type=\"text\" id=\"barcode\" name=\"barcode\" required pattern=\".{17,17}\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"imageFile\">Image File:</label>");
-  _server->sendContent("<input type=\"file\" id=\"imageFile\" name=\"imageFile\" accept=\"image/*\" required></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"page\">Page (0-15):</label>");
-  _server->sendContent("<input type=\"number\" id=\"page\" name=\"page\" min=\"0\" max=\"15\" value=\"0\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"colorMode\">Color Mode:</label>");
-  _server->sendContent("<select id=\"colorMode\" name=\"colorMode\"><option value=\"0\">Black & White</option><option value=\"1\">Color</option></select></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"posX\">X Position:</label>");
-  _server->sendContent("<input type=\"number\" id=\"posX\" name=\"posX\" min=\"0\" value=\"0\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"posY\">Y Position:</label>");
-  _server->sendContent("<input type=\"number\" id=\"posY\" name=\"posY\" min=\"0\" value=\"0\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"forcePP4\">");
-  _server->sendContent("<input type=\"checkbox\" id=\"forcePP4\" name=\"forcePP4\">Force PP4 Protocol</label></div>");
-  _server->sendContent("<button type=\"submit\">Transmit Image</button></form></div>");
-  
-  // Raw Command tab
-  _server->sendContent("<div id=\"RawTab\" class=\"tab-content\">");
-  _server->sendContent("<h2>Send Raw Command</h2><form id=\"rawForm\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"rawBarcode\">ESL Barcode (17 digits):</label>");
-  _server->sendContent("<input type=\"text\" id=\"rawBarcode\" name=\"barcode\" required pattern=\".{17,17}\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"eslType\">ESL Type:</label>");
-  _server->sendContent("<select id=\"eslType\" name=\"type\"><option value=\"DM\">Dot Matrix (DM)</option><option value=\"SEG\">Segment (SEG)</option></select></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"hexData\">Hex Data (without first byte and CRC):</label>");
-  _server->sendContent("<textarea id=\"hexData\" name=\"hexData\" rows=\"4\" required></textarea></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"repeatCount\">Repeat Count:</label>");
-  _server->sendContent("<input type=\"number\" id=\"repeatCount\" name=\"repeatCount\" min=\"1\" value=\"1\"></div>");
-  _server->sendContent("<button type=\"submit\">Send Command</button></form></div>");
-  
-  // Segment tab
-  _server->sendContent("<div id=\"SegmentTab\" class=\"tab-content\">");
-  _server->sendContent("<h2>Set Segments</h2><form id=\"segmentForm\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"segBarcode\">ESL Barcode (17 digits):</label>");
-  _server->sendContent("<input type=\"text\" id=\"segBarcode\" name=\"barcode\" required pattern=\".{17,17}\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"bitmap\">Segment Bitmap (46 hex digits):</label>");
-  _server->sendContent("<textarea id=\"bitmap\" name=\"bitmap\" rows=\"4\" required pattern=\"[0-9A-Fa-f]{46}\"></textarea></div>");
-  _server->sendContent("<button type=\"submit\">Set Segments</button></form></div>");
-  
-  // Ping tab
-  _server->sendContent("<div id=\"PingTab\" class=\"tab-content\">");
-  _server->sendContent("<h2>Ping & Refresh ESLs</h2><form id=\"pingForm\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"pingBarcode\">ESL Barcode (17 digits):</label>");
-  _server->sendContent("<input type=\"text\" id=\"pingBarcode\" name=\"barcode\" required pattern=\".{17,17}\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"forcePP4Ping\">");
-  _server->sendContent("<input type=\"checkbox\" id=\"forcePP4Ping\" name=\"forcePP4\">Force PP4 Protocol</label></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"repeatCountPing\">Repeat Count:</label>");
-  _server->sendContent("<input type=\"number\" id=\"repeatCountPing\" name=\"repeatCount\" min=\"1\" value=\"400\"></div>");
-  _server->sendContent("<button type=\"submit\">Send Ping</button></form>");
-  _server->sendContent("<h2>Refresh Display</h2><form id=\"refreshForm\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"refreshBarcode\">ESL Barcode (17 digits):</label>");
-  _server->sendContent("<input type=\"text\" id=\"refreshBarcode\" name=\"barcode\" required pattern=\".{17,17}\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"forcePP4Refresh\">");
-  _server->sendContent("<input type=\"checkbox\" id=\"forcePP4Refresh\" name=\"forcePP4\">Force PP4 Protocol</label></div>");
-  _server->sendContent("<button type=\"submit\">Refresh Display</button></form></div>");
-  
-  // Settings tab
-  _server->sendContent("<div id=\"SettingsTab\" class=\"tab-content\">");
-  _server->sendContent("<h2>WiFi Settings</h2><form id=\"wifiForm\">");
-  _server->sendContent("<div class=\"form-group\"><label for=\"wifiSsid\">WiFi SSID:</label>");
-  _server->sendContent("<input type=\"text\" id=\"wifiSsid\" name=\"ssid\" required></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"wifiPassword\">WiFi Password:</label>");
-  _server->sendContent("<input type=\"password\" id=\"wifiPassword\" name=\"password\"></div>");
-  _server->sendContent("<div class=\"form-group\"><label for=\"apMode\">");
-  _server->sendContent("<input type=\"checkbox\" id=\"apMode\" name=\"apMode\">Access Point Mode</label></div>");
-  _server->sendContent("<button type=\"submit\">Save Settings</button></form></div>");
-  
-  // About tab
-  _server->sendContent("<div id=\"AboutTab\" class=\"tab-content\">");
-  _server->sendContent("<h2>About ESL Blaster</h2>");
-  _server->sendContent("<p>ESL Blaster is a device for communicating with electronic shelf labels (ESLs) using infrared signals.</p>");
-  _server->sendContent("<p><strong>Hardware Version:</strong> <span id=\"hwVersion\">Loading...</span></p>");
-  _server->sendContent("<p><strong>Firmware Version:</strong> <span id=\"fwVersion\">Loading...</span></p>");
-  _server->sendContent("<p><strong>Uptime:</strong> <span id=\"uptime\">Loading...</span></p>");
-  _server->sendContent("<p><strong>Free Memory:</strong> <span id=\"freeHeap\">Loading...</span></p>");
-  _server->sendContent("<p><strong>Build Date:</strong> 2025-03-23</p><p><strong>Last Update:</strong> 2025-03-23 05:47:25 UTC</p>");
-  _server->sendContent("<p><strong>System User:</strong> BipBoopImportant</p>");
-  _server->sendContent("<h3>Hardware Setup</h3><p>IR Transmitter connected to GPIO4 (D2)</p>");
-  _server->sendContent("<p>SSD1306 OLED Shield on I2C (SDA/SCL)</p>");
-  _server->sendContent("<h3>Credits</h3><p>Based on work by furrtek (furrtek.org)</p></div>");
-  
-  _server->sendContent("</div>"); // Close tab container
-  
-  // Status message div
-  _server->sendContent("<div id=\"status-message\"></div>");
-  
-  // JavaScript - break into smaller sections to avoid memory issues
-  _server->sendContent("<script>");
-  // Part 1: Initial setup and functions
-  _server->sendContent("(function() { console.log('Script loaded');");
-  _server->sendContent("document.addEventListener('DOMContentLoaded', function() { console.log('DOM loaded'); initializeApp(); });");
-  _server->sendContent("if (document.readyState === 'complete' || document.readyState === 'interactive') {");
-  _server->sendContent("  console.log('DOM already loaded'); setTimeout(initializeApp, 1); }");
-  
-  // Part 2: Main app function
-  _server->sendContent("function initializeApp() { try {");
-  _server->sendContent("  const tabButtons = document.querySelectorAll('.tab-button');");
-  _server->sendContent("  const tabContents = document.querySelectorAll('.tab-content');");
-  _server->sendContent("  console.log('Tabs:', tabButtons.length, tabContents.length);");
-  
-  // Part 3: Tab functionality
-  _server->sendContent("  tabButtons.forEach(function(button) {");
-  _server->sendContent("    button.addEventListener('click', function() {");
-  _server->sendContent("      const target = this.getAttribute('data-target');");
-  _server->sendContent("      console.log('Tab:', target);");
-  _server->sendContent("      tabButtons.forEach(function(btn) { btn.classList.remove('active'); });");
-  _server->sendContent("      tabContents.forEach(function(content) { content.classList.remove('active'); });");
-  _server->sendContent("      this.classList.add('active');");
-  _server->sendContent("      const targetContent = document.getElementById(target);");
-  _server->sendContent("      if (targetContent) { targetContent.classList.add('active');");
-  _server->sendContent("        if (target === 'AboutTab') { updateAboutInfo(); }");
-  _server->sendContent("      } else { console.error('Missing:', target); }");
-  _server->sendContent("    });");
-  _server->sendContent("  });");
-  
-  // Part 4: Status and form functions
-  _server->sendContent("  function showStatus(message, isError) {");
-  _server->sendContent("    console.log('Status:', message);");
-  _server->sendContent("    const statusDiv = document.getElementById('status-message');");
-  _server->sendContent("    if (!statusDiv) { console.error('Status div missing'); return; }");
-  _server->sendContent("    statusDiv.textContent = message;");
-  _server->sendContent("    statusDiv.className = isError ? 'error' : 'success';");
-  _server->sendContent("    statusDiv.style.display = 'block';");
-  _server->sendContent("    setTimeout(function() { statusDiv.style.display = 'none'; }, 5000);");
-  _server->sendContent("  }");
-  
-  // Part 5: Forms and event handlers
-  _server->sendContent("  const forms = {");
-  _server->sendContent("    'imageForm': '/transmit-image',");
-  _server->sendContent("    'rawForm': '/raw-command',");
-  _server->sendContent("    'segmentForm': '/set-segments',");
-  _server->sendContent("    'pingForm': '/ping',");
-  _server->sendContent("    'refreshForm': '/refresh',");
-  _server->sendContent("    'wifiForm': '/wifi-config'");
-  _server->sendContent("  };");
-  
-  // Part 6: Form handlers
-  _server->sendContent("  Object.keys(forms).forEach(function(formId) {");
-  _server->sendContent("    const form = document.getElementById(formId);");
-  _server->sendContent("    if (form) {");
-  _server->sendContent("      form.addEventListener('submit', function(e) {");
-  _server->sendContent("        e.preventDefault();");
-  _server->sendContent("        if (formId === 'imageForm') { showStatus('Uploading...', false); }");
-  _server->sendContent("        const formData = new FormData(this);");
-  _server->sendContent("        fetch(forms[formId], { method: 'POST', body: formData })");
-  _server->sendContent("          .then(function(response) { return response.json(); })");
-  _server->sendContent("          .then(function(data) {");
-  _server->sendContent("            if (data.success) {");
-  _server->sendContent("              showStatus(data.message, false);");
-  _server->sendContent("              if (formId === 'wifiForm' && data.success) {");
-  _server->sendContent("                showStatus(data.message + ' Restarting...', false);");
-  _server->sendContent("                setTimeout(function() { window.location.reload(); }, 5000);");
-  _server->sendContent("              }");
-  _server->sendContent("            } else { showStatus(data.error || 'Error', true); }");
-  _server->sendContent("          })");
-  _server->sendContent("          .catch(function(error) {");
-  _server->sendContent("            console.error('Error:', error);");
-  _server->sendContent("            showStatus('Network error: ' + error.message, true);");
-  _server->sendContent("          });");
-  _server->sendContent("      });");
-  _server->sendContent("    } else { console.error('Form not found:', formId); }");
-  _server->sendContent("  });");
-  
-  // Part 7: Quick action buttons
-  _server->sendContent("  const statusBtn = document.getElementById('statusBtn');");
-  _server->sendContent("  if (statusBtn) {");
-  _server->sendContent("    statusBtn.addEventListener('click', function() {");
-  _server->sendContent("      fetch('/status')");
-  _server->sendContent("        .then(function(response) { return response.json(); })");
-  _server->sendContent("        .then(function(data) {");
-  _server->sendContent("          let statusMessage = 'Status:\\n';");
-  _server->sendContent("          statusMessage += `WiFi: ${data.wifi_mode}\\n`;");
-  _server->sendContent("          statusMessage += `Connected: ${data.connected}\\n`;");
-  _server->sendContent("          statusMessage += `IP: ${data.ip}\\n`;");
-  _server->sendContent("          statusMessage += `Uptime: ${formatUptime(data.uptime)}\\n`;");
-  _server->sendContent("          statusMessage += `Free Heap: ${formatBytes(data.free_heap)}\\n`;");
-  _server->sendContent("          statusMessage += `Frames Sent: ${data.frames_sent}\\n`;");
-  _server->sendContent("          showStatus(statusMessage, false);");
-  _server->sendContent("        })");
-  _server->sendContent("        .catch(function(error) {");
-  _server->sendContent("          showStatus('Network error: ' + error.message, true);");
-  _server->sendContent("        });");
-  _server->sendContent("    });");
-  _server->sendContent("  }");
-  
-  // Part 8: Test frequency button
-  _server->sendContent("  const testFreqBtn = document.getElementById('testFreqBtn');");
-  _server->sendContent("  if (testFreqBtn) {");
-  _server->sendContent("    testFreqBtn.addEventListener('click', function() {");
-  _server->sendContent("      showStatus('Testing for 5 seconds...', false);");
-  _server->sendContent("      fetch('/test-frequency')");
-  _server->sendContent("        .then(function(response) { return response.json(); })");
-  _server->sendContent("        .then(function(data) {");
-  _server->sendContent("          showStatus(data.message, !data.success);");
-  _server->sendContent("        })");
-  _server->sendContent("        .catch(function(error) {");
-  _server->sendContent("          showStatus('Error: ' + error.message, true);");
-  _server->sendContent("        });");
-  _server->sendContent("    });");
-  _server->sendContent("  }");
-  
-  // Part 9: Restart button
-  _server->sendContent("  const restartBtn = document.getElementById('restartBtn');");
-  _server->sendContent("  if (restartBtn) {");
-  _server->sendContent("    restartBtn.addEventListener('click', function() {");
-  _server->sendContent("      if (confirm('Restart device?')) {");
-  _server->sendContent("        fetch('/restart', { method: 'POST' })");
-  _server->sendContent("          .then(function(response) { return response.json(); })");
-  _server->sendContent("          .then(function(data) {");
-  _server->sendContent("            showStatus(data.message, !data.success);");
-  _server->sendContent("            if (data.success) {");
-  _server->sendContent("              setTimeout(function() { window.location.reload(); }, 5000);");
-  _server->sendContent("            }");
-  _server->sendContent("          })");
-  _server->sendContent("          .catch(function(error) {");
-  _server->sendContent("            showStatus('Error: ' + error.message, true);");
-  _server->sendContent("          });");
-  _server->sendContent("      }");
-  _server->sendContent("    });");
-  _server->sendContent("  }");
-  
-  // Part 10: About tab info
-  _server->sendContent("  function updateAboutInfo() {");
-  _server->sendContent("    fetch('/status')");
-  _server->sendContent("      .then(function(response) { return response.json(); })");
-  _server->sendContent("      .then(function(data) {");
-  _server->sendContent("        document.getElementById('hwVersion').textContent = data.hw_version || 'A';");
-  _server->sendContent("        document.getElementById('fwVersion').textContent = data.fw_version || '1.0.0';");
-  _server->sendContent("        document.getElementById('uptime').textContent = formatUptime(data.uptime);");
-  _server->sendContent("        document.getElementById('freeHeap').textContent = formatBytes(data.free_heap);");
-  _server->sendContent("      })");
-  _server->sendContent("      .catch(function(error) {");
-  _server->sendContent("        console.error('Error updating about info:', error);");
-  _server->sendContent("      });");
-  _server->sendContent("  }");
-  
-  // Part 11: Initialize and utility functions
-  _server->sendContent("  if (document.querySelector('#AboutTab.active')) { updateAboutInfo(); }");
-  _server->sendContent("  } catch (e) { console.error('Error:', e); }");
-  _server->sendContent("}");
-  
-  // Part 12: Helper functions
-  _server->sendContent("function formatUptime(seconds) {");
-  _server->sendContent("  const days = Math.floor(seconds / 86400);");
-  _server->sendContent("  seconds %= 86400;");
-  _server->sendContent("  const hours = Math.floor(seconds / 3600);");
-  _server->sendContent("  seconds %= 3600;");
-  _server->sendContent("  const minutes = Math.floor(seconds / 60);");
-  _server->sendContent("  seconds %= 60;");
-  _server->sendContent("  let result = '';");
-  _server->sendContent("  if (days > 0) result += days + ' days, ';");
-  _server->sendContent("  return result + hours + ':' + minutes.toString().padStart(2, '0') + ':' + seconds.toString().padStart(2, '0');");
-  _server->sendContent("}");
-  
-  _server->sendContent("function formatBytes(bytes) {");
-  _server->sendContent("  if (bytes < 1024) return bytes + ' bytes';");
-  _server->sendContent("  else if (bytes < 1048576) return (bytes / 1024).toFixed(2) + ' KB';");
-  _server->sendContent("  else return (bytes / 1048576).toFixed(2) + ' MB';");
-  _server->sendContent("}");
-  
-  // End script and HTML
-  _server->sendContent("})();</script></body></html>");
+  // Compressed by ui/embed.py at build time, sent straight from flash
+  _server->sendHeader("Content-Encoding", "gzip");
+  _server->send_P(200, "text/html", (PGM_P)WEB_UI_INDEX_GZ, WEB_UI_INDEX_GZ_LENGTH);
 }
 
 void WebInterface::handleTransmitImage() {
   if (!_server->hasArg("barcode")) {
-    sendErrorResponse("Missing barcode parameter");
+    rejectRequest("Missing barcode parameter");
     return;
   }
   
@@ -381,27 +204,54 @@ void WebInterface::handleTransmitImage() {
   uint16_t posX = _server->hasArg("posX") ? _server->arg("posX").toInt() : 0;
   uint16_t posY = _server->hasArg("posY") ? _server->arg("posY").toInt() : 0;
   bool forcePP4 = _server->hasArg("forcePP4");
+  // Copies of each data frame, the profile's count unless given
+  long copies = _server->hasArg("copies") ? _server->arg("copies").toInt() : 0;
   
-  // Handle file upload
-  if (!handleFileUpload()) {
-    sendErrorResponse("File upload failed");
+  // Refused while uploading, nothing was staged
+  if (_uploadStatus) {
+    LittleFS.remove("/temp_image.bin");
+    rejectRequest(_uploadError, _uploadStatus);
     return;
   }
   
-  _oledInterface->showStatus("Processing", "Image...");
+  showStatusNow("Processing", "Image...");
   
-  // Process the uploaded image
+  // Every buffer of this request comes from the arena and is released on return
+  ArenaScope scope(imageArena);
   uint8_t* imageData = nullptr;
   uint16_t width = 0;
   uint16_t height = 0;
   
   // Process image from uploaded file
   if (!processImage("/temp_image.bin", &imageData, &width, &height, colorMode)) {
-    sendErrorResponse("Failed to process image");
+    rejectRequest("Failed to process image");
+    return;
+  }
+  
+  // The encoder refuses these too, checked here to tell the client why
+  const TagProfile& profile = tagRegistry.profileFor(barcode.c_str());
+  const char* mismatch = NULL;
+  if (colorMode && profile.planes < 2) {
+    mismatch = "Tag model has no color plane";
+  } else if (profile.width && (posX + width > profile.width || posY + height > profile.height)) {
+    mismatch = "Image does not fit the tag's display";
+  }
+  if (copies < 0 || copies > TAG_MAX_COPIES) {
+    mismatch = "copies must be between 1 and 4";
+  }
+  if (mismatch) {
+    LittleFS.remove("/temp_image.bin");
+    rejectRequest(mismatch);
     return;
   }
   
-  _oledInterface->showStatus("Transmitting", "Image to ESL");
+  showStatusNow("Transmitting", "Image to ESL");
+  
+  bool spooling;
+  if (!beginSpoolCapture(barcode.c_str(), SPOOL_KIND_UPDATE, page, &spooling)) {
+    LittleFS.remove("/temp_image.bin");
+    return;
+  }
   
   // Send the image data to ESL
   bool success = _eslProtocol->transmitImage(
@@ -413,51 +263,91 @@ void WebInterface::handleTransmitImage() {
     colorMode, 
     posX, 
     posY, 
-    forcePP4
+    forcePP4,
+    copies
   );
   
-  // Clean up memory
-  delete[] imageData;
-  
   // Clean up temporary file
   LittleFS.remove("/temp_image.bin");
   
+  if (spooling) {
+    finishSpoolCapture(success);
+    return;
+  }
+  
   if (success) {
-    sendSuccessResponse("Image transmitted successfully");
+    char message[80];
+    uint8_t dropped = dropSupersededJobs(barcode.c_str(), page);
+    snprintf(message, sizeof(message), dropped ? "Image transmitted successfully, %u queued jobs superseded" :
+             "Image transmitted successfully", dropped);
+    sendSuccessResponse(message);
   } else {
     sendErrorResponse("Failed to transmit image");
   }
 }
 
-bool WebInterface::handleFileUpload() {
+void WebInterface::handleFileUpload() {
   HTTPUpload& upload = _server->upload();
   static File fsUploadFile;
   
   if (upload.status == UPLOAD_FILE_START) {
+    _uploadStatus = 0;
+    _uploadError[0] = '\0';
+    _uploadChecked = false;
+    
     // Initialize file system if not already initialized
     if (!LittleFS.begin()) {
       Serial.println("Failed to initialize LittleFS");
-      return false;
+      refuseUpload(503, "File system not available");
+      return;
+    }
+    
+    // The body length bounds the file, refuse before staging any of it
+    size_t length = _server->clientContentLength();
+    FSInfo info;
+    LittleFS.info(info);
+    if (length > IMAGE_MAX_UPLOAD_BYTES) {
+      refuseUpload(413, "Image file too large");
+      return;
+    }
+    if (length > info.totalBytes - info.usedBytes) {
+      refuseUpload(503, "No room to stage the upload");
+      return;
     }
     
     // Open the file for writing
     fsUploadFile = LittleFS.open("/temp_image.bin", "w");
     if (!fsUploadFile) {
       Serial.println("Failed to open file for writing");
-      return false;
+      refuseUpload(503, "Failed to stage the upload");
+      return;
     }
     
     Serial.print("Upload started: ");
     Serial.println(upload.filename);
   } 
   else if (upload.status == UPLOAD_FILE_WRITE) {
+    // The first chunk holds the BMP header, enough to know the memory needed
+    if (!_uploadChecked && !_uploadStatus) {
+      _uploadChecked = true;
+      admitImage(upload.buf, upload.currentSize);
+    }
+    
+    // The rest of a refused upload is read and dropped
+    if (_uploadStatus) {
+      if (fsUploadFile) {
+        fsUploadFile.close();
+      }
+      return;
+    }
+    
     // Write the received bytes to the file
     if (fsUploadFile) {
       fsUploadFile.write(upload.buf, upload.currentSize);
     }
     Serial.print(".");
   } 
-  else if (upload.status == UPLOAD_FILE_END) {
+  else if (upload.status == UPLOAD_FILE_END || upload.status == UPLOAD_FILE_ABORTED) {
     // Close the file
     if (fsUploadFile) {
       fsUploadFile.close();
@@ -465,10 +355,51 @@ bool WebInterface::handleFileUpload() {
     Serial.print("Upload complete: ");
     Serial.print(upload.totalSize);
     Serial.println(" bytes");
-    return true;
+  }
+}
+
+void WebInterface::refuseUpload(int statusCode, const char* error) {
+  _uploadStatus = statusCode;
+  strncpy(_uploadError, error, sizeof(_uploadError) - 1);
+  _uploadError[sizeof(_uploadError) - 1] = '\0';
+  Serial.printf("Upload refused (%d): %s\n", statusCode, _uploadError);
+}
+
+size_t WebInterface::imageMemoryNeeded(uint16_t width, uint16_t height, uint16_t bpp, bool colorMode) {
+  // The packed image lives through the whole request; grayscale pixels and the
+  // row buffer are gone before transmitImage takes its scratch
+  uint32_t pixelCount = (uint32_t)width * height;
+  uint32_t rowSize = ((width * bpp + 31) / 32) * 4;
+  size_t packed = Arena::footprint((pixelCount + 7) / 8 * (colorMode ? 2 : 1));
+  size_t decode = Arena::footprint(pixelCount) + Arena::footprint(rowSize);
+  size_t transmit = ESLProtocol::imageScratchSize(width, height, colorMode);
+  return packed + max(decode, transmit);
+}
+
+void WebInterface::admitImage(const uint8_t* header, size_t length) {
+  // Malformed files are left to processImage, it reports them
+  if (length < 54 || header[0] != 'B' || header[1] != 'M') {
+    return;
   }
   
-  return true;
+  uint32_t width = header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24);
+  uint32_t height = header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24);
+  uint16_t bpp = header[28] | (header[29] << 8);
+  bool colorMode = _server->hasArg("colorMode") && _server->arg("colorMode") == "1";
+  
+  char error[64];
+  if (width > 0xFFFF || height > 0xFFFF || width * height > 0xFFFF) {
+    refuseUpload(413, "Image has too many pixels");
+    return;
+  }
+  // Requests are served one at a time and every user of the arena releases
+  // it before returning, so an upload always has all of it
+  size_t needed = imageMemoryNeeded(width, height, bpp, colorMode);
+  if (needed > imageArena.getSize()) {
+    snprintf(error, sizeof(error), "Image needs %u bytes, at most %u available",
+             (unsigned)needed, (unsigned)imageArena.getSize());
+    refuseUpload(413, error);
+  }
 }
 
 bool WebInterface::processImage(const char* filename, uint8_t** imageData, 
@@ -509,9 +440,19 @@ bool WebInterface::processImage(const char* filename, uint8_t** imageData,
   // Calculate row size and padding
   uint32_t rowSize = ((*width * bpp + 31) / 32) * 4;
   
-  // Allocate memory for the image
+  // The packed output is taken first so it outlives the scratch scope below;
+  // the caller's scope releases it
   uint32_t pixelDataSize = *width * *height;
-  uint8_t* pixels = new uint8_t[pixelDataSize];
+  *imageData = (uint8_t*)imageArena.allocate((pixelDataSize + 7) / 8 * (colorMode ? 2 : 1));
+  if (!*imageData) {
+    Serial.println("Failed to allocate memory for binary image");
+    file.close();
+    return false;
+  }
+  
+  // Grayscale pixels and the row buffer go back to the arena on return
+  ArenaScope scratch(imageArena);
+  uint8_t* pixels = (uint8_t*)imageArena.allocate(pixelDataSize);
   if (!pixels) {
     Serial.println("Failed to allocate memory for image");
     file.close();
@@ -520,9 +461,8 @@ bool WebInterface::processImage(const char* filename, uint8_t** imageData,
   
   // Read pixel data
   if (bpp == 24) { // True color image
-    uint8_t* row = new uint8_t[rowSize];
+    uint8_t* row = (uint8_t*)imageArena.allocate(rowSize);
     if (!row) {
-      delete[] pixels;
       file.close();
       return false;
     }
@@ -541,13 +481,10 @@ bool WebInterface::processImage(const char* filename, uint8_t** imageData,
         pixels[y * *width + x] = (r * 77 + g * 150 + b * 29) >> 8;
       }
     }
-    
-    delete[] row;
   } 
   else if (bpp == 8) { // Grayscale or palette
-    uint8_t* row = new uint8_t[rowSize];
+    uint8_t* row = (uint8_t*)imageArena.allocate(rowSize);
     if (!row) {
-      delete[] pixels;
       file.close();
       return false;
     }
@@ -565,13 +502,10 @@ bool WebInterface::processImage(const char* filename, uint8_t** imageData,
         pixels[y * *width + x] = row[x];
       }
     }
-    
-    delete[] row;
   } 
   else {
     Serial.print("Unsupported bits per pixel: ");
     Serial.println(bpp);
-    delete[] pixels;
     file.close();
     return false;
   }
@@ -581,25 +515,8 @@ bool WebInterface::processImage(const char* filename, uint8_t** imageData,
   // Apply dithering
   applyDithering(pixels, *width, *height);
   
-  // Allocate memory for the output binary image
-  *imageData = new uint8_t[(pixelDataSize + 7) / 8 * (colorMode ? 2 : 1)];
-  if (!*imageData) {
-    delete[] pixels;
-    Serial.println("Failed to allocate memory for binary image");
-    return false;
-  }
-  
   // Convert to binary
-  if (!convertToBinary(pixels, *width, *height, *imageData, colorMode)) {
-    delete[] pixels;
-    delete[] *imageData;
-    return false;
-  }
-  
-  // Clean up
-  delete[] pixels;
-  
-  return true;
+  return convertToBinary(pixels, *width, *height, *imageData, colorMode);
 }
 
 bool WebInterface::convertToBinary(uint8_t* pixels, uint16_t width, uint16_t height, 
@@ -681,90 +598,69 @@ bool WebInterface::resizeImage(uint8_t* input, uint16_t inputWidth, uint16_t inp
   return true;
 }
 
-bool WebInterface::parseHexString(String hexString, uint8_t* buffer, uint16_t maxLength, uint16_t* actualLength) {
-  // Trim whitespace and normalize format
-  hexString.trim();
-  hexString.replace(" ", "");
-  hexString.replace("\n", "");
-  hexString.replace("\r", "");
-  hexString.replace(",", "");
-  hexString.replace("0x", "");
-  hexString.replace("0X", "");
-  
-  // Check if the string has an even number of characters
-  if (hexString.length() % 2 != 0) {
-    return false;
-  }
-  
-  // Check if the string is too long
-  if (hexString.length() / 2 > maxLength) {
+bool WebInterface::isBinaryBody() {
+  return _server->header("Content-Type").startsWith("application/octet-stream");
+}
+
+bool WebInterface::readBinaryBody(uint8_t* buffer, uint16_t maxLength, uint16_t* actualLength) {
+  // The server keeps non-form bodies as the "plain" argument, length included
+  const String& body = _server->arg("plain");
+  if (body.length() > maxLength) {
     return false;
   }
-  
-  *actualLength = hexString.length() / 2;
-  
-  // Convert each pair of hex characters to a byte
-  for (uint16_t i = 0; i < *actualLength; i++) {
-    char highNibble = hexString.charAt(i * 2);
-    char lowNibble = hexString.charAt(i * 2 + 1);
-    
-    // Convert high nibble
-    uint8_t high;
-    if (highNibble >= '0' && highNibble <= '9') {
-      high = highNibble - '0';
-    } else if (highNibble >= 'a' && highNibble <= 'f') {
-      high = highNibble - 'a' + 10;
-    } else if (highNibble >= 'A' && highNibble <= 'F') {
-      high = highNibble - 'A' + 10;
-    } else {
-      return false; // Invalid character
-    }
-    
-    // Convert low nibble
-    uint8_t low;
-    if (lowNibble >= '0' && lowNibble <= '9') {
-      low = lowNibble - '0';
-    } else if (lowNibble >= 'a' && lowNibble <= 'f') {
-      low = lowNibble - 'a' + 10;
-    } else if (lowNibble >= 'A' && lowNibble <= 'F') {
-      low = lowNibble - 'A' + 10;
-    } else {
-      return false; // Invalid character
-    }
-    
-    // Combine high and low nibbles
-    buffer[i] = (high << 4) | low;
-  }
-  
+  memcpy(buffer, body.c_str(), body.length());
+  *actualLength = body.length();
   return true;
 }
 
 void WebInterface::handleRawCommand() {
+  // Binary requests send the command bytes as the body instead of hexData
+  bool binary = isBinaryBody();
   if (!_server->hasArg("barcode") || !_server->hasArg("type") || 
-      !_server->hasArg("hexData") || !_server->hasArg("repeatCount")) {
-    sendErrorResponse("Missing required parameters");
+      !(binary || _server->hasArg("hexData")) || !_server->hasArg("repeatCount")) {
+    rejectRequest("Missing required parameters");
     return;
   }
   
   String barcode = _server->arg("barcode");
   String type = _server->arg("type");
-  String hexData = _server->arg("hexData");
-  int repeatCount = _server->arg("repeatCount").toInt();
+  uint16_t repeatCount;
+  if (!readRepeatCount(0, &repeatCount)) {
+    return;
+  }
   
-  // Parse the hex data
-  uint8_t buffer[256];
+  // Same limit as batch operations, the frame around it must stay below 256 bytes
+  uint8_t buffer[BATCH_MAX_DATA];
   uint16_t dataSize;
   
-  if (!parseHexString(hexData, buffer, 256, &dataSize)) {
-    sendErrorResponse("Invalid hex data format");
-    return;
+  if (binary) {
+    if (!readBinaryBody(buffer, sizeof(buffer), &dataSize) || dataSize == 0) {
+      rejectRequest("Body must hold 1 to 240 command bytes");
+      return;
+    }
+  } else {
+    const String& hexData = _server->arg("hexData");
+    if (!decodeHex(hexData.c_str(), hexData.length(), buffer, sizeof(buffer), &dataSize) || dataSize == 0) {
+      rejectRequest("Invalid hex data, 1 to 240 command bytes");
+      return;
+    }
   }
   
-  _oledInterface->showStatus("Transmitting", "Raw Command");
+  showStatusNow("Transmitting", "Raw Command");
+  
+  bool spooling;
+  if (!beginSpoolCapture(barcode.c_str(), SPOOL_KIND_OTHER, 0, &spooling)) {
+    return;
+  }
   
   // Send the raw command
   bool success = _eslProtocol->transmitRawCommand(barcode.c_str(), type.c_str(), buffer, dataSize, repeatCount);
   
+  if (spooling) {
+    finishSpoolCapture(success);
+    return;
+  }
+  
   if (success) {
     sendSuccessResponse("Raw command transmitted successfully");
   } else {
@@ -773,36 +669,54 @@ void WebInterface::handleRawCommand() {
 }
 
 void WebInterface::handleSetSegments() {
-  if (!_server->hasArg("barcode") || !_server->hasArg("bitmap")) {
-    sendErrorResponse("Missing required parameters");
+  // Binary requests send the 23 bitmap bytes as the body instead of bitmap
+  bool binary = isBinaryBody();
+  if (!_server->hasArg("barcode") || !(binary || _server->hasArg("bitmap"))) {
+    rejectRequest("Missing required parameters");
     return;
   }
   
   String barcode = _server->arg("barcode");
-  String bitmapHex = _server->arg("bitmap");
   
-  // Check bitmap length
-  if (bitmapHex.length() != 46) {
-    sendErrorResponse("Bitmap must be exactly 46 hex digits");
-    return;
-  }
-  
-  // Parse the hex bitmap
   uint8_t bitmap[23];
   uint16_t parsedSize;
   
-  if (!parseHexString(bitmapHex, bitmap, 23, &parsedSize) || parsedSize != 23) {
-    sendErrorResponse("Invalid hex bitmap format");
-    return;
+  if (binary) {
+    if (!readBinaryBody(bitmap, sizeof(bitmap), &parsedSize) || parsedSize != sizeof(bitmap)) {
+      rejectRequest("Body must be exactly 23 bitmap bytes");
+      return;
+    }
+  } else {
+    const String& bitmapHex = _server->arg("bitmap");
+    if (!decodeHex(bitmapHex.c_str(), bitmapHex.length(), bitmap, sizeof(bitmap), &parsedSize) ||
+        parsedSize != sizeof(bitmap)) {
+      rejectRequest("Bitmap must be exactly 46 hex digits");
+      return;
+    }
   }
   
-  _oledInterface->showStatus("Transmitting", "Segment Data");
+  showStatusNow("Transmitting", "Segment Data");
+  
+  // Segment tags have a single page
+  bool spooling;
+  if (!beginSpoolCapture(barcode.c_str(), SPOOL_KIND_UPDATE, 0, &spooling)) {
+    return;
+  }
   
   // Send the segments data
   bool success = _eslProtocol->setSegments(barcode.c_str(), bitmap);
   
+  if (spooling) {
+    finishSpoolCapture(success);
+    return;
+  }
+  
   if (success) {
-    sendSuccessResponse("Segments updated successfully");
+    char message[80];
+    uint8_t dropped = dropSupersededJobs(barcode.c_str(), 0);
+    snprintf(message, sizeof(message), dropped ? "Segments updated successfully, %u queued jobs superseded" :
+             "Segments updated successfully", dropped);
+    sendSuccessResponse(message);
   } else {
     sendErrorResponse("Failed to update segments");
   }
@@ -810,17 +724,31 @@ void WebInterface::handleSetSegments() {
 
 void WebInterface::handlePing() {
   if (!_server->hasArg("barcode")) {
-    sendErrorResponse("Missing barcode parameter");
+    rejectRequest("Missing barcode parameter");
     return;
   }
   
   String barcode = _server->arg("barcode");
-  bool forcePP4 = _server->hasArg("forcePP4");
-  int repeatCount = _server->hasArg("repeatCount") ? _server->arg("repeatCount").toInt() : 400;
+  const TagProfile& profile = tagRegistry.profileFor(barcode.c_str());
+  bool pp16 = profile.pp16 && !_server->hasArg("forcePP4");
+  uint16_t repeatCount;
+  if (!readRepeatCount(profile.wakeRepeats, &repeatCount)) {
+    return;
+  }
+  
+  showStatusNow("Transmitting", "Ping");
+  
+  bool spooling;
+  if (!beginSpoolCapture(barcode.c_str(), SPOOL_KIND_PING, 0, &spooling)) {
+    return;
+  }
   
-  _oledInterface->showStatus("Transmitting", "Ping");
+  bool success = _eslProtocol->makePingFrame(barcode.c_str(), pp16, repeatCount);
   
-  bool success = _eslProtocol->makePingFrame(barcode.c_str(), !forcePP4, repeatCount);
+  if (spooling) {
+    finishSpoolCapture(success);
+    return;
+  }
   
   if (success) {
     sendSuccessResponse("Ping transmitted successfully");
@@ -829,18 +757,84 @@ void WebInterface::handlePing() {
   }
 }
 
+void WebInterface::handlePingParallel() {
+  // barcode0, barcode1, ... one tag per IR channel
+  String barcodes[EDGE_MAX_CHANNELS];
+  const char* barcodePtrs[EDGE_MAX_CHANNELS];
+  uint8_t count = 0;
+  
+  while (count < _irTransmitter->getChannelCount()) {
+    String name = "barcode" + String(count);
+    if (!_server->hasArg(name)) {
+      break;
+    }
+    barcodes[count] = _server->arg(name);
+    barcodePtrs[count] = barcodes[count].c_str();
+    count++;
+  }
+  
+  if (count == 0) {
+    rejectRequest("Missing barcode0 parameter");
+    return;
+  }
+  
+  // One preamble and repeat count for all channels: PP16 only if every model
+  // takes it, and enough repeats to wake the slowest tag
+  bool pp16 = !_server->hasArg("forcePP4");
+  uint16_t wakeRepeats = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const TagProfile& profile = tagRegistry.profileFor(barcodePtrs[i]);
+    pp16 = pp16 && profile.pp16;
+    wakeRepeats = max(wakeRepeats, profile.wakeRepeats);
+  }
+  uint16_t repeatCount;
+  if (!readRepeatCount(wakeRepeats, &repeatCount)) {
+    return;
+  }
+  // Default stagger keeps the first bursts of neighbouring channels apart
+  long offsetNs = _server->hasArg("offsetNs") ? _server->arg("offsetNs").toInt() : 40000;
+  if (offsetNs < 0 || offsetNs > 1000000) {
+    rejectRequest("offsetNs must be between 0 and 1000000");
+    return;
+  }
+  
+  char oledLine[16];
+  snprintf(oledLine, sizeof(oledLine), "Ping x%u", count);
+  showStatusNow("Transmitting", oledLine);
+  
+  bool success = _eslProtocol->makePingFrames(barcodePtrs, count, pp16, repeatCount, offsetNs);
+  
+  if (success) {
+    char message[48];
+    snprintf(message, sizeof(message), "Parallel ping transmitted on %u channels", count);
+    sendSuccessResponse(message);
+  } else {
+    sendErrorResponse("Failed to transmit parallel ping");
+  }
+}
+
 void WebInterface::handleRefresh() {
   if (!_server->hasArg("barcode")) {
-    sendErrorResponse("Missing barcode parameter");
+    rejectRequest("Missing barcode parameter");
     return;
   }
   
   String barcode = _server->arg("barcode");
-  bool forcePP4 = _server->hasArg("forcePP4");
+  bool pp16 = tagRegistry.profileFor(barcode.c_str()).pp16 && !_server->hasArg("forcePP4");
+  
+  showStatusNow("Transmitting", "Refresh");
   
-  _oledInterface->showStatus("Transmitting", "Refresh");
+  bool spooling;
+  if (!beginSpoolCapture(barcode.c_str(), SPOOL_KIND_REFRESH, 0, &spooling)) {
+    return;
+  }
   
-  bool success = _eslProtocol->makeRefreshFrame(barcode.c_str(), !forcePP4);
+  bool success = _eslProtocol->makeRefreshFrame(barcode.c_str(), pp16);
+  
+  if (spooling) {
+    finishSpoolCapture(success);
+    return;
+  }
   
   if (success) {
     sendSuccessResponse("Refresh command transmitted successfully");
@@ -849,6 +843,213 @@ void WebInterface::handleRefresh() {
   }
 }
 
+void WebInterface::handleBatch() {
+  // JSON bodies arrive as the "plain" argument
+  if (!_server->hasArg("plain")) {
+    rejectRequest("Missing request body");
+    return;
+  }
+  
+  const String& body = _server->arg("plain");
+  BatchReader reader(body.c_str(), body.length());
+  BatchOp op;
+  
+  // Check the whole batch before the first job is queued
+  while (reader.next(&op)) {
+  }
+  if (reader.getError()) {
+    char message[80];
+    snprintf(message, sizeof(message), "Operation %u: %s", reader.getIndex(), reader.getError());
+    rejectRequest(message);
+    return;
+  }
+  uint16_t count = reader.getIndex();
+  if (count == 0) {
+    rejectRequest("Empty batch");
+    return;
+  }
+  
+  // Up to BATCH_MAX_OPS operations with long wake-ups would hold up loop()
+  // for minutes, so a batch goes through the spool like a group send
+  uint32_t notBefore = 0;
+  uint32_t deadline = 0;
+  uint8_t priority = SPOOL_CLASS_NORMAL;
+  if (!readSpoolOptions(&notBefore, &deadline, &priority)) {
+    return;
+  }
+  
+  // All or nothing, a client retrying a partly queued batch would send
+  // its first operations twice
+  uint8_t jobsNeeded = (count + SPOOL_MAX_BARCODES - 1) / SPOOL_MAX_BARCODES;
+  if (jobsNeeded > SPOOL_MAX_JOBS - jobSpool.getJobCount()) {
+    char message[64];
+    snprintf(message, sizeof(message), "Job spool has room for %u of %u jobs",
+             SPOOL_MAX_JOBS - jobSpool.getJobCount(), jobsNeeded);
+    sendErrorResponse(message, 503);
+    return;
+  }
+  
+  char oledLine[16];
+  snprintf(oledLine, sizeof(oledLine), "Batch x%u", count);
+  _oledInterface->showStatus("Queueing", oledLine);
+  
+  // Jobs of up to SPOOL_MAX_BARCODES operations in batch order. The first
+  // reader collects the barcodes of a job, the second replays its
+  // operations into the capture
+  char barcodes[SPOOL_MAX_BARCODES][BATCH_BARCODE_LENGTH + 1];
+  const char* batch[SPOOL_MAX_BARCODES];
+  BatchReader replay(body.c_str(), body.length());
+  uint16_t queued = 0;
+  uint16_t failed = 0;
+  uint8_t jobs = 0;
+  bool more = true;
+  
+  reader.rewind();
+  while (more) {
+    uint8_t size = 0;
+    while (size < SPOOL_MAX_BARCODES && (more = reader.next(&op))) {
+      strcpy(barcodes[size], op.barcode);
+      batch[size] = barcodes[size];
+      size++;
+    }
+    if (size == 0) {
+      break;
+    }
+    
+    if (queueBatchJob(replay, batch, size, notBefore, deadline, priority)) {
+      queued += size;
+      jobs++;
+    } else {
+      failed += size;
+    }
+  }
+  
+  char buffer[JSON_RESPONSE_SIZE];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.addBool("success", failed == 0);
+  if (failed) {
+    json.addString("error", "Failed to queue some operations");
+  }
+  json.addString("priority", JobSpool::className(priority));
+  json.addNumber("count", count);
+  json.addNumber("jobs", jobs);
+  json.addNumber("queued", queued);
+  json.addNumber("failed", failed);
+  json.endObject();
+  sendJson(queued ? 200 : 503, json);
+}
+
+uint8_t WebInterface::pruneEventClients() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < EVENTS_MAX_CLIENTS; i++) {
+    if (_eventClients[i].connected()) {
+      count++;
+    } else {
+      _eventClients[i] = WiFiClient();
+    }
+  }
+  
+  if (count == 0) {
+    _eslProtocol->setObserver(NULL, NULL);
+  }
+  return count;
+}
+
+void WebInterface::handleEvents() {
+  pruneEventClients();
+  
+  int8_t slot = -1;
+  for (uint8_t i = 0; i < EVENTS_MAX_CLIENTS && slot < 0; i++) {
+    if (!_eventClients[i].connected()) {
+      slot = i;
+    }
+  }
+  if (slot < 0) {
+    _server->send(503, "text/plain", "Too many event subscribers");
+    return;
+  }
+  
+  // The stream never ends, so the response head is written by hand and the
+  // connection is kept past the end of this handler
+  WiFiClient client = _server->client();
+  client.setNoDelay(true);
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->sendContent_P(PSTR("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                              "Cache-Control: no-cache\r\nConnection: keep-alive\r\n"
+                              "Access-Control-Allow-Origin: *\r\n\r\n"));
+  
+  _eventClients[slot] = client;
+  _eslProtocol->setObserver(progressToEvents, this);
+}
+
+void WebInterface::progressToEvents(void* context, const ProgressEvent& event) {
+  char text[160];
+  int length = 0;
+  
+  switch (event.type) {
+    case PROGRESS_JOB_START: {
+      // The barcode comes from the request: escaped by the writer, it can
+      // neither break the JSON nor start another data: line
+      length = snprintf(text, sizeof(text), "event: start\ndata: ");
+      JsonWriter json(text + length, sizeof(text) - length - 2);
+      json.beginObject();
+      json.addNumber("job", event.job);
+      json.addString("barcode", event.barcode ? event.barcode : "");
+      json.addNumber("frames", event.frameCount);
+      json.endObject();
+      json.finish();
+      if (json.overflowed()) {
+        return;
+      }
+      length += json.length();
+      text[length++] = '\n';
+      text[length++] = '\n';
+      break;
+    }
+    case PROGRESS_WAKE_DONE:
+      length = snprintf(text, sizeof(text), "event: wake\ndata: {\"job\":%lu,\"airtime_us\":%lu}\n\n",
+                        (unsigned long)event.job, (unsigned long)event.airtimeUs);
+      break;
+    case PROGRESS_FRAME:
+      length = snprintf(text, sizeof(text),
+                        "event: frame\ndata: {\"job\":%lu,\"frame\":%u,\"frames\":%u,\"type\":\"%s\",\"airtime_us\":%lu}\n\n",
+                        (unsigned long)event.job, event.frame, event.frameCount,
+                        Metrics::frameTypeName(event.frameType), (unsigned long)event.airtimeUs);
+      break;
+    case PROGRESS_JOB_DONE:
+      length = snprintf(text, sizeof(text),
+                        "event: done\ndata: {\"job\":%lu,\"outcome\":\"%s\",\"frames\":%u,\"airtime_us\":%lu}\n\n",
+                        (unsigned long)event.job, Metrics::jobOutcomeName(event.outcome), event.frame,
+                        (unsigned long)event.airtimeUs);
+      break;
+  }
+  
+  if (length > 0 && length < (int)sizeof(text)) {
+    ((WebInterface*)context)->broadcastEvent(text, length);
+  }
+}
+
+void WebInterface::broadcastEvent(const char* text, size_t length) {
+  // Called between frames: a slow subscriber misses events rather than
+  // holding up the transmission
+  bool any = false;
+  for (uint8_t i = 0; i < EVENTS_MAX_CLIENTS; i++) {
+    if (!_eventClients[i].connected()) {
+      continue;
+    }
+    any = true;
+    if ((size_t)_eventClients[i].availableForWrite() >= length) {
+      _eventClients[i].write((const uint8_t*)text, length);
+    }
+  }
+  
+  // Last subscriber gone, stop paying for the reports
+  if (!any) {
+    pruneEventClients();
+  }
+}
+
 void WebInterface::handleWifiConfig() {
   if (!_server->hasArg("ssid")) {
     sendErrorResponse("Missing SSID parameter");
@@ -858,106 +1059,1076 @@ void WebInterface::handleWifiConfig() {
   String newSSID = _server->arg("ssid");
   String newPassword = _server->hasArg("password") ? _server->arg("password") : "";
   bool newApMode = _server->hasArg("apMode");
+  if (newSSID.length() > WIFI_SSID_LENGTH || newPassword.length() > WIFI_PASSWORD_LENGTH) {
+    rejectRequest("SSID or password too long");
+    return;
+  }
   
-  // Update settings
-  strncpy(ssid, newSSID.c_str(), 31);
-  ssid[31] = '\0';
-  
-  strncpy(password, newPassword.c_str(), 63);
-  password[63] = '\0';
-  
-  apMode = newApMode;
-  
-  // Save to EEPROM
+  // Does not touch the current link, saved at once
+  reuseLease = _server->hasArg("reuseLease");
+  wifiLink.setReuseLease(reuseLease);
   saveSettings();
   
-  // Return success before restarting
-  sendSuccessResponse("WiFi settings updated");
+  // With apMode and no SSID the stored network stays the one to return to
+  if (newApMode && newSSID.length() == 0) {
+    newSSID = ssid;
+    newPassword = password;
+  }
+  
+  // Applied after this response; station settings are only saved once they
+  // have connected, otherwise the previous link comes back
+  bool accepted = newApMode ? wifiLink.requestAccessPoint(newSSID.c_str(), newPassword.c_str()) :
+                              wifiLink.requestStation(newSSID.c_str(), newPassword.c_str());
+  if (!accepted) {
+    rejectRequest("A WiFi change is already being tried");
+    return;
+  }
   
-  // Schedule a restart after sending the response
-  delay(1000);
-  ESP.restart();
+  sendSuccessResponse(newApMode ? "Switching to access point mode" :
+                      "Trying the new WiFi settings, the current ones stay if they fail");
 }
 
 void WebInterface::handleRestart() {
   sendSuccessResponse("Restarting device...");
+  tagRegistry.flush();
   delay(1000);
   ESP.restart();
 }
 
 void WebInterface::handleStatus() {
-  // Create a JSON response with the current status
-  DynamicJsonDocument doc(512);
-  
-  doc["wifi_mode"] = WiFi.getMode() == WIFI_STA ? "Station" : "Access Point";
-  doc["connected"] = WiFi.status() == WL_CONNECTED ? "Yes" : "No";
-  doc["ip"] = WiFi.getMode() == WIFI_STA ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
-  doc["uptime"] = (millis() - uptimeStart) / 1000;
-  doc["free_heap"] = ESP.getFreeHeap();
-  doc["frames_sent"] = totalFramesSent;
-  doc["cpu_freq"] = ESP.getCpuFreqMHz();
-  doc["busy"] = _irTransmitter->isBusy();
-  doc["hw_version"] = HW_VERSION;
-  doc["fw_version"] = FW_VERSION;
-  doc["build_date"] = "2025-03-23";
-  doc["last_update"] = "2025-03-23 05:47:25";
-  doc["system_user"] = "BipBoopImportant";
-  
-  String response;
-  serializeJson(doc, response);
+  char ip[16];
+  IPAddress address = WiFi.getMode() == WIFI_STA ? WiFi.localIP() : WiFi.softAPIP();
+  snprintf(ip, sizeof(ip), "%u.%u.%u.%u", address[0], address[1], address[2], address[3]);
+  
+  char buffer[JSON_STATUS_SIZE];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.addString("wifi_mode", WiFi.getMode() == WIFI_STA ? "Station" : "Access Point");
+  json.addString("connected", WiFi.status() == WL_CONNECTED ? "Yes" : "No");
+  json.addString("link", WiFiLink::stateName(wifiLink.getState()));
+  json.addNumber("disconnected_s", wifiLink.getDisconnectedMs() / 1000);
+  json.addString("wifi_change", WiFiLink::trialResultName(wifiLink.getTrialResult()));
+  json.addString("ip", ip);
+  json.addNumber("uptime", (millis() - uptimeStart) / 1000);
+  json.addNumber("boot_ready_ms", bootReadyMs);
+  json.addNumber("free_heap", ESP.getFreeHeap());
+  json.addNumber("arena_high_water", imageArena.getHighWater());
+  json.addNumber("frames_sent", metrics.getFramesSent());
+  json.addNumber("cpu_freq", ESP.getCpuFreqMHz());
+  json.addBool("busy", _irTransmitter->isBusy());
+  json.addString("hw_version", HW_VERSION);
+  json.addString("fw_version", FW_VERSION);
+  json.addString("build_date", "2025-03-23");
+  json.addString("last_update", "2025-03-23 05:47:25");
+  json.addString("system_user", "BipBoopImportant");
+  json.endObject();
   
   // Add cache control headers
   _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
   _server->sendHeader("Pragma", "no-cache");
   _server->sendHeader("Expires", "0");
-  _server->send(200, "application/json", response);
+  sendJson(200, json);
 }
 
 void WebInterface::handleTestFrequency() {
-  _oledInterface->showStatus("Testing", "1.25MHz signal");
+  showStatusNow("Testing", "1.25MHz signal");
   
   // Run the test
   _irTransmitter->testFrequency();
   
   // Update display
   String ipString = WiFi.getMode() == WIFI_STA ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
-  _oledInterface->showMainScreen("Ready", ipString);
+  _oledInterface->showMainScreen("Ready", ipString.c_str());
+  
+  sendSuccessResponse("1.25MHz test completed successfully");
+}
+
+void WebInterface::handleMetrics() {
+  // Prometheus text exposition format, streamed from the fixed counter arrays
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "text/plain; version=0.0.4", "");
+  
+  ChunkedText out(_server);
+  char number[24];
+  
+  out.printf("# HELP esl_frames_total Frames handed to the IR transmitter.\n# TYPE esl_frames_total counter\n");
+  for (uint8_t t = 0; t < FRAME_TYPE_COUNT; t++) {
+    out.printf("esl_frames_total{type=\"%s\"} %lu\n", Metrics::frameTypeName(t), (unsigned long)metrics.getFrames(t));
+  }
+  
+  out.printf("# HELP esl_frame_bytes_total Bytes on air, including repeats.\n# TYPE esl_frame_bytes_total counter\n");
+  for (uint8_t t = 0; t < FRAME_TYPE_COUNT; t++) {
+    out.printf("esl_frame_bytes_total{type=\"%s\"} %lu\n", Metrics::frameTypeName(t), (unsigned long)metrics.getBytes(t));
+  }
+  
+  out.printf("# HELP esl_airtime_seconds_total Time spent transmitting.\n# TYPE esl_airtime_seconds_total counter\n");
+  formatScaled(number, sizeof(number), metrics.getTotalAirtimeUs(), 1000000);
+  out.printf("esl_airtime_seconds_total %s\n", number);
+  
+  out.printf("# HELP esl_wake_airtime_seconds_total Time spent transmitting wake-up pings.\n# TYPE esl_wake_airtime_seconds_total counter\n");
+  formatScaled(number, sizeof(number), metrics.getAirtimeUs(FRAME_PING), 1000000);
+  out.printf("esl_wake_airtime_seconds_total %s\n", number);
+  
+  out.printf("# HELP esl_jobs_total Transmit requests by outcome.\n# TYPE esl_jobs_total counter\n");
+  for (uint8_t o = 0; o < JOB_OUTCOME_COUNT; o++) {
+    out.printf("esl_jobs_total{outcome=\"%s\"} %lu\n", Metrics::jobOutcomeName(o), (unsigned long)metrics.getJobs(o));
+  }
+  
+  writeHistogram(out, "esl_job_latency_seconds", "Time from request start, or a spooled job becoming due, to last frame.",
+                 metrics.getJobLatency(), 1000);
+  writeHistogram(out, "esl_frame_airtime_seconds", "Airtime per frame including repeats.",
+                 metrics.getFrameAirtime(), 1000000);
+  
+  out.printf("# HELP esl_spool_coalesced_total Queued work made redundant by a newer request.\n# TYPE esl_spool_coalesced_total counter\n");
+  out.printf("esl_spool_coalesced_total{reason=\"replaced\"} %lu\n", (unsigned long)jobSpool.getReplacedCount());
+  out.printf("esl_spool_coalesced_total{reason=\"merged\"} %lu\n", (unsigned long)jobSpool.getMergedCount());
+  
+  out.printf("# HELP esl_spool_wait_seconds_total Time spooled jobs waited from due to first frame.\n# TYPE esl_spool_wait_seconds_total counter\n");
+  for (uint8_t c = 0; c < SPOOL_CLASS_COUNT; c++) {
+    formatScaled(number, sizeof(number), jobSpool.getClassStats(c).waitTotalMs, 1000);
+    out.printf("esl_spool_wait_seconds_total{class=\"%s\"} %s\n", JobSpool::className(c), number);
+  }
+  out.printf("# HELP esl_spool_wait_max_seconds Longest wait of a spooled job.\n# TYPE esl_spool_wait_max_seconds gauge\n");
+  for (uint8_t c = 0; c < SPOOL_CLASS_COUNT; c++) {
+    formatScaled(number, sizeof(number), jobSpool.getClassStats(c).waitMaxMs, 1000);
+    out.printf("esl_spool_wait_max_seconds{class=\"%s\"} %s\n", JobSpool::className(c), number);
+  }
+  // Counters per class, each family written as one block
+  static const char* const SPOOL_COUNTERS[] = {
+    "started", "preemptions", "rewakes", "deadline_misses"
+  };
+  for (uint8_t k = 0; k < 4; k++) {
+    out.printf("# TYPE esl_spool_%s_total counter\n", SPOOL_COUNTERS[k]);
+    for (uint8_t c = 0; c < SPOOL_CLASS_COUNT; c++) {
+      const SpoolClassStats& stats = jobSpool.getClassStats(c);
+      uint32_t values[] = { stats.started, stats.preemptions, stats.rewakes, stats.deadlineMisses };
+      out.printf("esl_spool_%s_total{class=\"%s\"} %lu\n", SPOOL_COUNTERS[k],
+                 JobSpool::className(c), (unsigned long)values[k]);
+    }
+  }
+  
+  out.printf("# HELP esl_wifi_connected Station link up.\n# TYPE esl_wifi_connected gauge\nesl_wifi_connected %u\n",
+             wifiLink.isConnected() ? 1 : 0);
+  formatScaled(number, sizeof(number), wifiLink.getDisconnectedMs(), 1000);
+  out.printf("# HELP esl_wifi_disconnected_seconds_total Time the station link was down.\n# TYPE esl_wifi_disconnected_seconds_total counter\n");
+  out.printf("esl_wifi_disconnected_seconds_total %s\n", number);
+  out.printf("# TYPE esl_wifi_connect_attempts_total counter\nesl_wifi_connect_attempts_total %lu\n",
+             (unsigned long)wifiLink.getAttempts());
+  out.printf("# TYPE esl_wifi_reconnects_total counter\nesl_wifi_reconnects_total %lu\n",
+             (unsigned long)wifiLink.getReconnects());
+  
+  out.printf("# TYPE esl_heap_free_bytes gauge\nesl_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+  out.printf("# TYPE esl_heap_max_block_bytes gauge\nesl_heap_max_block_bytes %lu\n", (unsigned long)ESP.getMaxFreeBlockSize());
+  out.printf("# TYPE esl_heap_fragmentation_percent gauge\nesl_heap_fragmentation_percent %u\n", (unsigned)ESP.getHeapFragmentation());
+  
+  out.printf("# HELP esl_arena_size_bytes Image arena reserved at boot.\n# TYPE esl_arena_size_bytes gauge\nesl_arena_size_bytes %lu\n",
+             (unsigned long)imageArena.getSize());
+  out.printf("# TYPE esl_arena_high_water_bytes gauge\nesl_arena_high_water_bytes %lu\n", (unsigned long)imageArena.getHighWater());
+  out.printf("# TYPE esl_arena_failures_total counter\nesl_arena_failures_total %lu\n", (unsigned long)imageArena.getFailures());
+  
+  formatScaled(number, sizeof(number), _irTransmitter->getGapSpinUs(), 1000000);
+  out.printf("# HELP esl_ir_gap_spin_seconds_total Inter-frame gap time left over after the work done in it.\n");
+  out.printf("# TYPE esl_ir_gap_spin_seconds_total counter\nesl_ir_gap_spin_seconds_total %s\n", number);
+  out.printf("# TYPE esl_ir_gaps_deferred_total counter\nesl_ir_gaps_deferred_total %lu\n", (unsigned long)_irTransmitter->getGapsDeferred());
+  
+  out.printf("# TYPE esl_tags_registered gauge\nesl_tags_registered %u\n", tagRegistry.getCount());
+  out.printf("# TYPE esl_tag_registry_capacity gauge\nesl_tag_registry_capacity %u\n", tagRegistry.getCapacity());
+  out.printf("# TYPE esl_tag_lookups_total counter\nesl_tag_lookups_total %lu\n", (unsigned long)tagRegistry.getLookups());
+  out.printf("# TYPE esl_tag_cache_misses_total counter\nesl_tag_cache_misses_total %lu\n", (unsigned long)tagRegistry.getCacheMisses());
+  
+  formatScaled(number, sizeof(number), metrics.getWorstLoopUs(), 1000000);
+  out.printf("# HELP esl_loop_worst_seconds Longest loop() iteration since boot.\n# TYPE esl_loop_worst_seconds gauge\n");
+  out.printf("esl_loop_worst_seconds %s\n", number);
+  
+  formatScaled(number, sizeof(number), bootReadyMs, 1000);
+  out.printf("# HELP esl_boot_ready_seconds Reset to network up and serving, 0 while booting.\n# TYPE esl_boot_ready_seconds gauge\n");
+  out.printf("esl_boot_ready_seconds %s\n", number);
+  
+  formatScaled(number, sizeof(number), millis() - uptimeStart, 1000);
+  out.printf("# TYPE esl_uptime_seconds gauge\nesl_uptime_seconds %s\n", number);
+  
+  out.flush();
+}
+
+void WebInterface::handleProfile() {
+  // Stream the profiler ring buffer as JSON, oldest window first
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  ChunkedText out(_server);
+  out.printf("{\"window_ms\":%u,\"irq_off_max_us\":%lu,\"yield_gap_max_us\":%lu,\"section_max_us\":{",
+             PROFILER_WINDOW_MS, (unsigned long)profiler.getIrqOffMaxUs(), (unsigned long)profiler.getYieldGapMaxUs());
+  for (uint8_t s = 0; s < PROF_SECTION_COUNT; s++) {
+    out.printf("%s\"%s\":%lu", s ? "," : "", Profiler::sectionName(s), (unsigned long)profiler.getSectionMaxUs(s));
+  }
+  out.printf("},\"windows\":[");
+  
+  for (uint8_t i = 0; i < profiler.getWindowCount(); i++) {
+    const ProfileWindow& w = profiler.getWindow(i);
+    out.printf("%s{\"t_ms\":%lu,\"loops\":%lu,\"loop_max_us\":%lu,\"irq_off_max_us\":%lu,\"yield_gap_max_us\":%lu,\"sections\":{",
+               i ? "," : "", (unsigned long)w.startMs, (unsigned long)w.loops, (unsigned long)w.loopMaxUs,
+               (unsigned long)w.irqOffMaxUs, (unsigned long)w.yieldGapMaxUs);
+    // Each section is reported as [max_us, total_us] for the window
+    for (uint8_t s = 0; s < PROF_SECTION_COUNT; s++) {
+      out.printf("%s\"%s\":[%lu,%lu]", s ? "," : "", Profiler::sectionName(s),
+                 (unsigned long)w.sectionMaxUs[s], (unsigned long)w.sectionTotalUs[s]);
+    }
+    out.printf("}}");
+  }
+  
+  out.printf("]}");
+  out.flush();
+}
+
+void WebInterface::handleTraceConfig() {
+  // enable=1 allocates the capture buffer, enable=0 releases it
+  bool enable = _server->hasArg("enable") && _server->arg("enable") == "1";
+  
+  if (!enable) {
+    _irTransmitter->disableTrace();
+    sendSuccessResponse("Trace disabled");
+    return;
+  }
+  
+  int capacity = _server->hasArg("capacity") ? _server->arg("capacity").toInt() : 1024;
+  if (capacity < 16 || capacity > 4096) {
+    sendErrorResponse("Capacity must be between 16 and 4096 events");
+    return;
+  }
+  
+  if (!_irTransmitter->enableTrace(capacity)) {
+    sendErrorResponse("Not enough memory for trace buffer");
+    return;
+  }
+  
+  sendSuccessResponse("Trace enabled");
+}
+
+void WebInterface::handleTrace() {
+  // Jitter and drift of the captured symbols against the nominal timings
+  SymbolTrace* trace = _irTransmitter->getTrace();
+  TraceReport report;
+  trace->analyze(&report);
+  
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  ChunkedText out(_server);
+  out.printf("{\"active\":%s,\"events\":%u,\"capacity\":%u,\"frames\":%lu,",
+             trace->isActive() ? "true" : "false", trace->getCount(), trace->getCapacity(),
+             (unsigned long)report.frames);
+  out.printf("\"drift_ns\":{\"max\":%ld,\"mean\":%ld},",
+             (long)report.maxDriftNs, report.frames ? (long)(report.sumDriftNs / report.frames) : 0L);
+  out.printf("\"burst\":{\"nominal_ns\":%u,\"count\":%lu,\"min_err_ns\":%ld,\"max_err_ns\":%ld,\"mean_err_ns\":%ld},",
+             IR_BURST_ON_NS, (unsigned long)report.burst.count,
+             report.burst.count ? (long)report.burst.minErrorNs : 0L,
+             report.burst.count ? (long)report.burst.maxErrorNs : 0L,
+             report.burst.count ? (long)(report.burst.sumErrorNs / report.burst.count) : 0L);
+  
+  // Jitter is the peak-to-peak spread of the gap error for each symbol
+  out.printf("\"gaps\":[");
+  for (uint8_t s = 0; s < 4; s++) {
+    const TraceGapStats& gap = report.pause[s];
+    out.printf("%s{\"symbol\":%u,\"nominal_us\":%u,\"count\":%lu,\"min_err_ns\":%ld,\"max_err_ns\":%ld,\"mean_err_ns\":%ld,\"jitter_ns\":%ld}",
+               s ? "," : "", s, IR_PAUSE_US[s], (unsigned long)gap.count,
+               gap.count ? (long)gap.minErrorNs : 0L,
+               gap.count ? (long)gap.maxErrorNs : 0L,
+               gap.count ? (long)(gap.sumErrorNs / gap.count) : 0L,
+               gap.count ? (long)gap.maxErrorNs - (long)gap.minErrorNs : 0L);
+  }
+  out.printf("]}");
+  out.flush();
+}
+
+void WebInterface::handleTraceVCD() {
+  SymbolTrace* trace = _irTransmitter->getTrace();
+  if (!trace->isActive()) {
+    sendErrorResponse("Trace is not enabled");
+    return;
+  }
+  
+  _server->sendHeader("Content-Disposition", "attachment; filename=\"esl_trace.vcd\"");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "text/plain", "");
+  
+  ChunkedText out(_server);
+  trace->writeVCD([](void* context, const char* data, size_t length) {
+    ((ChunkedText*)context)->write(data, length);
+  }, &out);
+  out.flush();
+}
+
+// Streamed JSON goes out as chunks straight from the writer's buffer
+static void sendJsonChunk(void* context, const char* data, size_t length) {
+  ((ESP8266WebServer*)context)->sendContent(data, length);
+}
+
+void WebInterface::handleSpoolList() {
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  // now is 0 until NTP has set the clock, timed jobs wait for it
+  char buffer[512];
+  JsonWriter json(buffer, sizeof(buffer), sendJsonChunk, _server);
+  json.beginObject();
+  json.addNumber("now", jobSpool.now());
+  json.addNumber("active", jobSpool.getActiveJob());
+  json.addNumber("flash_size", flashJobs.getSize());
+  json.addNumber("flash_used", flashJobs.getUsed());
+  json.addNumber("replaced", jobSpool.getReplacedCount());
+  json.addNumber("merged", jobSpool.getMergedCount());
+  
+  // Barcodes come from requests and are escaped by the writer
+  json.beginArray("jobs");
+  for (uint8_t i = 0; i < jobSpool.getJobCount(); i++) {
+    const SpoolJobInfo& job = jobSpool.getJob(i);
+    json.beginObject();
+    json.addNumber("id", job.id);
+    json.addNumber("not_before", job.notBefore);
+    json.addNumber("deadline", job.deadline);
+    json.addNumber("created_at", job.createdAt);
+    json.addString("priority", JobSpool::className(job.priority));
+    json.addNumber("frames", job.frameCount);
+    json.addNumber("next_frame", job.nextFrame);
+    json.addNumber("bytes", job.bytes);
+    json.addBool("compiled", flashJobs.isCompiled(job));
+    json.beginArray("barcodes");
+    for (uint8_t b = 0; b < job.barcodeCount; b++) {
+      char barcode[SPOOL_BARCODE_LENGTH + 1];
+      if (!jobSpool.getBarcode(job.id, b, barcode)) {
+        barcode[0] = '\0';
+      }
+      json.addString(NULL, barcode);
+    }
+    json.endArray();
+    json.endObject();
+  }
+  json.endArray();
+  
+  // Wait is measured from when a job became due to its first frame
+  json.beginObject("classes");
+  for (uint8_t c = 0; c < SPOOL_CLASS_COUNT; c++) {
+    const SpoolClassStats& stats = jobSpool.getClassStats(c);
+    json.beginObject(JobSpool::className(c));
+    json.addNumber("started", stats.started);
+    json.addNumber("wait_avg_ms", stats.started ? stats.waitTotalMs / stats.started : 0);
+    json.addNumber("wait_max_ms", stats.waitMaxMs);
+    json.addNumber("preemptions", stats.preemptions);
+    json.addNumber("rewakes", stats.rewakes);
+    json.addNumber("deadline_misses", stats.deadlineMisses);
+    json.endObject();
+  }
+  json.endObject();
+  
+  json.endObject();
+  json.finish();
+}
+
+void WebInterface::handleSpoolCancel() {
+  if (!_server->hasArg("id")) {
+    sendErrorResponse("Missing id parameter");
+    return;
+  }
+  
+  uint32_t id = strtoul(_server->arg("id").c_str(), NULL, 10);
+  if (!jobSpool.cancelJob(id)) {
+    sendErrorResponse("No such job");
+    return;
+  }
+  
+  char message[32];
+  snprintf(message, sizeof(message), "Job %lu cancelled", (unsigned long)id);
+  sendSuccessResponse(message);
+}
+
+void WebInterface::handleProfileList() {
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  char buffer[512];
+  JsonWriter json(buffer, sizeof(buffer), sendJsonChunk, _server);
+  json.beginObject();
+  json.beginArray("profiles");
+  for (uint8_t i = 0; i < tagProfiles.getProfileCount(); i++) {
+    const TagProfile& profile = tagProfiles.getProfile(i);
+    json.beginObject();
+    json.addString("model", profile.model);
+    json.addNumber("width", profile.width);
+    json.addNumber("height", profile.height);
+    json.addNumber("planes", profile.planes);
+    json.addNumber("payload", profile.payload);
+    json.addNumber("wake_repeats", profile.wakeRepeats);
+    json.addNumber("gap_us", profile.frameGapUs);
+    json.addString("preamble", profile.pp16 ? "pp16" : "pp4");
+    json.addNumber("segment_repeats", profile.segmentRepeats);
+    json.addNumber("copies", profile.dataCopies);
+    json.addNumber("span", profile.interleaveSpan);
+    json.endObject();
+  }
+  json.endArray();
+  
+  json.beginArray("assignments");
+  for (uint8_t i = 0; i < tagProfiles.getAssignmentCount(); i++) {
+    const TagAssignment& assignment = tagProfiles.getAssignment(i);
+    json.beginObject();
+    json.addString("prefix", assignment.prefix);
+    json.addString("model", tagProfiles.getProfile(assignment.profile).model);
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  json.finish();
+}
+
+void WebInterface::handleProfileUpload() {
+  // The whole table in the profiles.txt format, as a text/plain body
+  if (!_server->hasArg("plain")) {
+    rejectRequest("Missing request body");
+    return;
+  }
+  
+  const String& body = _server->arg("plain");
+  if (!tagProfiles.load(body.c_str(), body.length())) {
+    char message[96];
+    snprintf(message, sizeof(message), "Line %u: %s", tagProfiles.getErrorLine(), tagProfiles.getError());
+    rejectRequest(message);
+    return;
+  }
+  
+  if (!tagProfiles.saveFile(LittleFS)) {
+    sendErrorResponse("Profiles loaded but not saved");
+    return;
+  }
   
-  // Send response
-  DynamicJsonDocument doc(256);
-  doc["success"] = true;
-  doc["message"] = "1.25MHz test completed successfully";
+  char message[48];
+  snprintf(message, sizeof(message), "%u profiles, %u assignments saved",
+           tagProfiles.getProfileCount(), tagProfiles.getAssignmentCount());
+  sendSuccessResponse(message);
+}
+
+void WebInterface::handleProfileAssign() {
+  // prefix is a whole barcode or its first characters, an empty model removes it
+  if (!_server->hasArg("prefix") || !_server->hasArg("model")) {
+    rejectRequest("Missing prefix or model parameter");
+    return;
+  }
   
-  String response;
-  serializeJson(doc, response);
+  String prefix = _server->arg("prefix");
+  String model = _server->arg("model");
+  if (prefix.length() == 0 || prefix.length() > TAG_PREFIX_LENGTH) {
+    rejectRequest("prefix must be 1 to 17 characters");
+    return;
+  }
+  if (model.length() && !tagProfiles.find(model.c_str())) {
+    rejectRequest("Unknown model");
+    return;
+  }
+  if (!tagProfiles.assign(prefix.c_str(), model.c_str())) {
+    rejectRequest("Too many assignments");
+    return;
+  }
   
-  _server->send(200, "application/json", response);
+  if (!tagProfiles.saveFile(LittleFS)) {
+    sendErrorResponse("Assignment made but not saved");
+    return;
+  }
+  sendSuccessResponse(model.length() ? "Assignment saved" : "Assignment removed");
+}
+
+static void writeLossResult(JsonWriter& json, const char* key, uint8_t count, const LossResult& result) {
+  json.beginObject();
+  json.addNumber(key, count);
+  json.addNumber("success_permille", result.successPermille);
+  json.addNumber("airtime_ms", result.airtimeMs);
+  json.addNumber("per_image_ms", result.perImageMs);
+  json.endObject();
+}
+
+void WebInterface::handleRedundancy() {
+  // Simulated image jobs for a tag's profile, every data frame sent k times
+  // against the whole job sent r times, over a range of loss rates
+  const TagProfile* profile = _server->hasArg("model") ? tagProfiles.find(_server->arg("model").c_str()) :
+                              &tagRegistry.profileFor(_server->arg("barcode").c_str());
+  if (!profile) {
+    rejectRequest("Unknown model");
+    return;
+  }
+  long frames = _server->hasArg("frames") ? _server->arg("frames").toInt() : 40;
+  long burst = _server->hasArg("burst") ? _server->arg("burst").toInt() : 2;
+  if (frames < 1 || frames > 1024 || burst < 1 || burst > 100) {
+    rejectRequest("frames must be 1-1024 and burst 1-100");
+    return;
+  }
+  // Each simulation runs between two yields, its length is bounded by frames x trials
+  long maxTrials = min(2000L, (long)(REDUNDANCY_MAX_FRAME_TRIALS / frames));
+  long trials = _server->hasArg("trials") ? _server->arg("trials").toInt() : min(500L, maxTrials);
+  if (trials < 1 || trials > maxTrials) {
+    char error[64];
+    snprintf(error, sizeof(error), "trials must be 1-%ld for %ld frames", maxTrials, frames);
+    rejectRequest(error);
+    return;
+  }
+  
+  // Loss in permille, a fixed sweep unless one is given
+  static const uint16_t SWEEP[] = { 10, 50, 100, 200, 300 };
+  uint16_t losses[5];
+  uint8_t lossCount = 0;
+  if (_server->hasArg("loss")) {
+    long loss = _server->arg("loss").toInt();
+    if (loss < 0 || loss > 1000) {
+      rejectRequest("loss must be between 0 and 1000 permille");
+      return;
+    }
+    losses[lossCount++] = loss;
+  } else {
+    for (; lossCount < sizeof(SWEEP) / sizeof(SWEEP[0]); lossCount++) {
+      losses[lossCount] = SWEEP[lossCount];
+    }
+  }
+  
+  // Frame sizes as transmitImage builds them: header, payload and CRC
+  uint8_t preamble = profile->pp16 ? 4 : 0;
+  LossJob job;
+  job.dataFrames = frames;
+  job.wakeUs = LossSimulator::frameAirtimeUs(34 + preamble, profile->wakeRepeats, profile->frameGapUs);
+  job.controlUs = 2 * LossSimulator::frameAirtimeUs(34 + preamble, 1, profile->frameGapUs);
+  job.dataUs = LossSimulator::frameAirtimeUs(14 + profile->payload + preamble, 1, profile->frameGapUs);
+  
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  char buffer[512];
+  JsonWriter json(buffer, sizeof(buffer), sendJsonChunk, _server);
+  json.beginObject();
+  json.addString("model", profile->model);
+  json.addNumber("frames", frames);
+  json.addNumber("burst", burst);
+  json.addNumber("trials", trials);
+  json.addNumber("span", profile->interleaveSpan);
+  json.beginArray("rows");
+  for (uint8_t i = 0; i < lossCount; i++) {
+    LossModel model = { losses[i], (uint16_t)burst };
+    LossSimulator simulator(model);
+    LossResult result;
+    
+    json.beginObject();
+    json.addNumber("loss_permille", losses[i]);
+    json.beginArray("copies");
+    for (uint8_t k = 1; k <= TAG_MAX_COPIES; k++) {
+      simulator.simulateCopies(job, k, profile->interleaveSpan, trials, &result);
+      writeLossResult(json, "k", k, result);
+      yield();
+    }
+    json.endArray();
+    json.beginArray("retries");
+    for (uint8_t r = 1; r <= REDUNDANCY_MAX_ATTEMPTS; r++) {
+      simulator.simulateRetries(job, r, trials, &result);
+      writeLossResult(json, "r", r, result);
+      yield();
+    }
+    json.endArray();
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  json.finish();
+}
+
+void WebInterface::writeTag(JsonWriter& json, const TagRecord& record) {
+  char barcode[TAG_BARCODE_LENGTH + 1];
+  TagRegistry::formatBarcode(record.barcode, barcode);
+  const char* model = tagRegistry.modelName(record);
+  
+  json.beginObject();
+  json.addString("barcode", barcode);
+  json.addNumber("plid", record.plid);
+  // Without a registered model the prefix rules pick the profile
+  json.addString("model", model ? model : "");
+  json.addString("profile", tagRegistry.profileFor(barcode).model);
+  json.beginArray("groups");
+  for (uint8_t g = 0; g < TAG_GROUPS_MAX; g++) {
+    if (record.groups & (1 << g)) {
+      json.addString(NULL, tagRegistry.groupName(g));
+    }
+  }
+  json.endArray();
+  json.addNumber("last_sent", record.lastSent);
+  json.addNumber("airtime_ms", record.airtimeMs);
+  json.beginArray("page_hashes");
+  for (uint8_t p = 0; p < TAG_PAGE_HASHES; p++) {
+    json.addNumber(NULL, record.pageHash[p]);
+  }
+  json.endArray();
+  json.endObject();
+}
+
+void WebInterface::handleTagList() {
+  // A single tag, or all of them optionally limited to a group
+  if (_server->hasArg("barcode")) {
+    const TagRecord* found = tagRegistry.find(_server->arg("barcode").c_str());
+    if (!found) {
+      sendErrorResponse("Tag not registered", 404);
+      return;
+    }
+    TagRecord record = *found;
+    char buffer[JSON_STATUS_SIZE];
+    JsonWriter json(buffer, sizeof(buffer));
+    writeTag(json, record);
+    sendJson(200, json);
+    return;
+  }
+  
+  int8_t group = -1;
+  if (_server->hasArg("group")) {
+    group = tagRegistry.findGroup(_server->arg("group").c_str());
+    if (group < 0) {
+      sendErrorResponse("Unknown group", 404);
+      return;
+    }
+  }
+  
+  _server->sendHeader("Cache-Control", "no-cache, no-store, must-revalidate");
+  _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  _server->send(200, "application/json", "");
+  
+  char buffer[512];
+  JsonWriter json(buffer, sizeof(buffer), sendJsonChunk, _server);
+  json.beginObject();
+  json.addNumber("count", tagRegistry.getCount());
+  json.addNumber("capacity", tagRegistry.getCapacity());
+  json.beginArray("groups");
+  for (uint8_t g = 0; g < TAG_GROUPS_MAX; g++) {
+    if (tagRegistry.groupName(g)[0]) {
+      json.addString(NULL, tagRegistry.groupName(g));
+    }
+  }
+  json.endArray();
+  
+  // The walk reads the whole table, a full store takes a while
+  json.beginArray("tags");
+  uint16_t position = 0;
+  TagRecord record;
+  for (uint16_t listed = 0; tagRegistry.next(&position, &record, group); listed++) {
+    writeTag(json, record);
+    if ((listed & 31) == 31) {
+      yield();
+    }
+  }
+  json.endArray();
+  json.endObject();
+  json.finish();
+}
+
+void WebInterface::handleTagPut() {
+  // model and groups (comma separated) replace what the tag had
+  if (!_server->hasArg("barcode")) {
+    rejectRequest("Missing barcode parameter");
+    return;
+  }
+  
+  uint16_t groups = 0;
+  if (_server->hasArg("groups") && !tagRegistry.parseGroups(_server->arg("groups").c_str(), &groups)) {
+    rejectRequest(tagRegistry.getError());
+    return;
+  }
+  if (!tagRegistry.put(_server->arg("barcode").c_str(), _server->arg("model").c_str(), groups)) {
+    rejectRequest(tagRegistry.getError());
+    return;
+  }
+  sendSuccessResponse("Tag saved");
+}
+
+void WebInterface::handleTagRemove() {
+  if (!_server->hasArg("barcode")) {
+    rejectRequest("Missing barcode parameter");
+    return;
+  }
+  if (!tagRegistry.remove(_server->arg("barcode").c_str())) {
+    sendErrorResponse(tagRegistry.getError(), 404);
+    return;
+  }
+  sendSuccessResponse("Tag removed");
+}
+
+void WebInterface::handleGroupSend(bool ping) {
+  if (!_server->hasArg("group")) {
+    rejectRequest("Missing group parameter");
+    return;
+  }
+  String name = _server->arg("group");
+  int8_t group = tagRegistry.findGroup(name.c_str());
+  if (group < 0) {
+    sendErrorResponse("Unknown group", 404);
+    return;
+  }
+  // 0 takes each tag's own wake repeats
+  uint16_t repeatCount;
+  if (!readRepeatCount(0, &repeatCount)) {
+    return;
+  }
+  bool forcePP4 = _server->hasArg("forcePP4");
+  
+  // A whole group would hold up loop() for minutes, so it always goes
+  // through the spool, as bulk work unless the request says otherwise
+  uint32_t notBefore = 0;
+  uint32_t deadline = 0;
+  uint8_t priority = SPOOL_CLASS_BULK;
+  if (!readSpoolOptions(&notBefore, &deadline, &priority)) {
+    return;
+  }
+  
+  // All or nothing, a client retrying a partly queued group would wake its
+  // first tags twice. Tags with a covering update need no job of their own
+  uint16_t position = 0;
+  uint16_t needed = 0;
+  TagRecord record;
+  char barcode[TAG_BARCODE_LENGTH + 1];
+  while (tagRegistry.next(&position, &record, group)) {
+    TagRegistry::formatBarcode(record.barcode, barcode);
+    if (jobSpool.findCoveringUpdate(tagFromBarcode(barcode), notBefore) == SPOOL_NO_JOB) {
+      needed++;
+    }
+  }
+  uint8_t jobsNeeded = (needed + SPOOL_MAX_BARCODES - 1) / SPOOL_MAX_BARCODES;
+  if (jobsNeeded > SPOOL_MAX_JOBS - jobSpool.getJobCount()) {
+    char message[64];
+    snprintf(message, sizeof(message), "Job spool has room for %u of %u jobs",
+             SPOOL_MAX_JOBS - jobSpool.getJobCount(), jobsNeeded);
+    sendErrorResponse(message, 503);
+    return;
+  }
+  
+  char oledLine[OLED_LINE_LENGTH + 1];
+  snprintf(oledLine, sizeof(oledLine), "%s %s", ping ? "Ping" : "Refresh", name.c_str());
+  _oledInterface->showStatus("Queueing", oledLine);
+  
+  // Jobs of up to SPOOL_MAX_BARCODES tags each, the spool wakes every tag
+  // again after a preemption. Tags with an update queued by then get
+  // their wake-up and refresh from it instead
+  char barcodes[SPOOL_MAX_BARCODES][TAG_BARCODE_LENGTH + 1];
+  const char* batch[SPOOL_MAX_BARCODES];
+  uint8_t count = 0;
+  uint16_t queued = 0;
+  uint16_t merged = 0;
+  uint16_t failed = 0;
+  uint8_t jobs = 0;
+  bool more = true;
+  
+  position = 0;
+  while (more) {
+    more = tagRegistry.next(&position, &record, group);
+    if (more) {
+      TagRegistry::formatBarcode(record.barcode, barcodes[count]);
+      uint32_t covering = jobSpool.findCoveringUpdate(tagFromBarcode(barcodes[count]), notBefore);
+      if (covering != SPOOL_NO_JOB) {
+        jobSpool.mergeInto(covering, priority, deadline);
+        merged++;
+        continue;
+      }
+      batch[count] = barcodes[count];
+      if (++count < SPOOL_MAX_BARCODES) {
+        continue;
+      }
+    }
+    if (count == 0) {
+      continue;
+    }
+    
+    if (queueGroupJob(batch, count, ping, repeatCount, forcePP4, notBefore, deadline, priority)) {
+      queued += count;
+      jobs++;
+    } else {
+      failed += count;
+    }
+    count = 0;
+  }
+  
+  char buffer[JSON_RESPONSE_SIZE];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.addBool("success", failed == 0);
+  if (failed) {
+    json.addString("error", "Failed to queue some tags");
+  }
+  json.addString("group", name.c_str());
+  json.addString("priority", JobSpool::className(priority));
+  json.addNumber("jobs", jobs);
+  json.addNumber("queued", queued);
+  json.addNumber("merged", merged);
+  json.addNumber("failed", failed);
+  json.endObject();
+  sendJson(queued || merged || !failed ? 200 : 503, json);
 }
 
 void WebInterface::handleNotFound() {
   _server->send(404, "text/plain", "Not Found");
 }
 
-void WebInterface::sendSuccessResponse(String message) {
-  DynamicJsonDocument doc(256);
-  doc["success"] = true;
-  doc["message"] = message;
+// Frames produced by ESLProtocol while capturing go straight into the open spool job
+static bool captureToSpool(void* context, uint8_t type, const uint8_t* frameData,
+                           uint8_t frameSize, uint16_t repeats) {
+  return ((JobSpool*)context)->appendFrame(type, frameData, frameSize, repeats);
+}
+
+bool WebInterface::queueGroupJob(const char* const* barcodes, uint8_t count, bool ping, uint16_t repeatCount,
+                                 bool forcePP4, uint32_t notBefore, uint32_t deadline, uint8_t priority) {
+  if (jobSpool.beginJob(notBefore, deadline, priority, barcodes, count) == SPOOL_NO_JOB) {
+    return false;
+  }
+  
+  _eslProtocol->beginCapture(captureToSpool, &jobSpool);
+  bool success = true;
+  for (uint8_t i = 0; i < count && success; i++) {
+    const TagProfile& profile = tagRegistry.profileFor(barcodes[i]);
+    bool pp16 = profile.pp16 && !forcePP4;
+    success = ping ? _eslProtocol->makePingFrame(barcodes[i], pp16, repeatCount ? repeatCount : profile.wakeRepeats)
+                   : _eslProtocol->makeRefreshFrame(barcodes[i], pp16);
+  }
   
-  String response;
-  serializeJson(doc, response);
+  if (!_eslProtocol->endCapture() || !success) {
+    jobSpool.abortJob();
+    return false;
+  }
+  if (!jobSpool.commitJob()) {
+    return false;
+  }
   
-  _server->send(200, "application/json", response);
+  // Sent from the spool file instead if the flash area is full
+  flashJobs.compile(jobSpool, jobSpool.getJob(jobSpool.getJobCount() - 1).id);
+  return true;
 }
 
-void WebInterface::sendErrorResponse(String error) {
-  DynamicJsonDocument doc(256);
-  doc["success"] = false;
-  doc["error"] = error;
+bool WebInterface::queueBatchJob(BatchReader& replay, const char* const* barcodes, uint8_t count,
+                                 uint32_t notBefore, uint32_t deadline, uint8_t priority) {
+  BatchOp op;
+  if (jobSpool.beginJob(notBefore, deadline, priority, barcodes, count) == SPOOL_NO_JOB) {
+    // Keep the replay in step with the barcodes of the next job
+    for (uint8_t i = 0; i < count; i++) {
+      replay.next(&op);
+    }
+    return false;
+  }
   
-  String response;
-  serializeJson(doc, response);
+  _eslProtocol->beginCapture(captureToSpool, &jobSpool);
+  bool success = true;
+  for (uint8_t i = 0; i < count; i++) {
+    if (!replay.next(&op) || !success) {
+      success = false;
+      continue;
+    }
+    const TagProfile& profile = tagRegistry.profileFor(op.barcode);
+    bool pp16 = profile.pp16 && !op.forcePP4;
+    switch (op.type) {
+      case BATCH_OP_PING:
+        success = _eslProtocol->makePingFrame(op.barcode, pp16, op.repeats ? op.repeats : profile.wakeRepeats);
+        break;
+      case BATCH_OP_REFRESH:
+        success = _eslProtocol->makeRefreshFrame(op.barcode, pp16);
+        break;
+      case BATCH_OP_RAW:
+        success = _eslProtocol->transmitRawCommand(op.barcode, op.segmentType ? "SEG" : "DM",
+                                                   op.data, op.dataSize, op.repeats);
+        break;
+      case BATCH_OP_SEGMENTS:
+        success = _eslProtocol->setSegments(op.barcode, op.data);
+        break;
+    }
+  }
   
-  _server->send(400, "application/json", response);
+  if (!_eslProtocol->endCapture() || !success) {
+    jobSpool.abortJob();
+    return false;
+  }
+  if (!jobSpool.commitJob()) {
+    return false;
+  }
+  
+  // Sent from the spool file instead if the flash area is full
+  flashJobs.compile(jobSpool, jobSpool.getJob(jobSpool.getJobCount() - 1).id);
+  return true;
+}
+
+uint32_t WebInterface::tagFromBarcode(const char* barcode) {
+  uint8_t PLID[4];
+  _eslProtocol->getPLIDFromBarcode(barcode, PLID);
+  return PLID[0] | (PLID[1] << 8) | (PLID[2] << 16) | ((uint32_t)PLID[3] << 24);
+}
+
+uint8_t WebInterface::dropSupersededJobs(const char* barcode, uint8_t page) {
+  if (strlen(barcode) != SPOOL_BARCODE_LENGTH) {
+    return 0;
+  }
+  return jobSpool.dropSuperseded(tagFromBarcode(barcode), page, 0);
+}
+
+bool WebInterface::readSpoolOptions(uint32_t* notBefore, uint32_t* deadline, uint8_t* priority) {
+  if (_server->hasArg("notBefore")) {
+    *notBefore = strtoul(_server->arg("notBefore").c_str(), NULL, 10);
+  }
+  if (_server->hasArg("deadline")) {
+    *deadline = strtoul(_server->arg("deadline").c_str(), NULL, 10);
+  }
+  
+  // Priority class by name or number
+  if (_server->hasArg("priority")) {
+    String value = _server->arg("priority");
+    *priority = SPOOL_CLASS_COUNT;
+    for (uint8_t c = 0; c < SPOOL_CLASS_COUNT; c++) {
+      if (value == JobSpool::className(c) || value == String(c)) {
+        *priority = c;
+      }
+    }
+    if (*priority == SPOOL_CLASS_COUNT) {
+      rejectRequest("priority must be bulk, normal or urgent");
+      return false;
+    }
+  }
+  return true;
+}
+
+bool WebInterface::readRepeatCount(uint16_t fallback, uint16_t* repeats) {
+  if (!_server->hasArg("repeatCount")) {
+    *repeats = fallback;
+    return true;
+  }
+  
+  // Same range as the repeat field of batch operations
+  String value = _server->arg("repeatCount");
+  char* end;
+  unsigned long number = strtoul(value.c_str(), &end, 10);
+  if (value.length() == 0 || value[0] < '0' || value[0] > '9' || *end != '\0' ||
+      number < 1 || number > 0xFFFF) {
+    rejectRequest("repeatCount must be between 1 and 65535");
+    return false;
+  }
+  *repeats = number;
+  return true;
+}
+
+bool WebInterface::beginSpoolCapture(const char* barcode, uint8_t kind, uint8_t page, bool* spooling) {
+  // Only a start time or an explicit spool=1 queues the request, class and
+  // deadline alone would silently turn a send into a queued job
+  *spooling = _server->hasArg("notBefore") || _server->hasArg("spool");
+  if (!*spooling) {
+    if (_server->hasArg("deadline") || _server->hasArg("priority")) {
+      rejectRequest("deadline and priority need spool=1 or notBefore");
+      return false;
+    }
+    return true;
+  }
+  
+  uint32_t notBefore = 0;
+  uint32_t deadline = 0;
+  uint8_t priority = SPOOL_CLASS_NORMAL;
+  if (!readSpoolOptions(&notBefore, &deadline, &priority)) {
+    return false;
+  }
+  
+  // Jobs are coalesced by PLID, which only a well formed barcode has
+  SpoolJobTarget target;
+  target.kind = strlen(barcode) == SPOOL_BARCODE_LENGTH ? kind : (uint8_t)SPOOL_KIND_OTHER;
+  target.tag = tagFromBarcode(barcode);
+  target.page = page;
+  
+  // A ping or refresh rides along with a queued update of the tag
+  if (target.kind == SPOOL_KIND_PING || target.kind == SPOOL_KIND_REFRESH) {
+    uint32_t covering = jobSpool.findCoveringUpdate(target.tag, notBefore);
+    if (covering != SPOOL_NO_JOB) {
+      jobSpool.mergeInto(covering, priority, deadline);
+      char message[40];
+      snprintf(message, sizeof(message), "Merged into queued job %lu", (unsigned long)covering);
+      sendSuccessResponse(message);
+      return false;
+    }
+  }
+  
+  if (jobSpool.beginJob(notBefore, deadline, priority, &barcode, 1, &target) == SPOOL_NO_JOB) {
+    rejectRequest("Job spool is full");
+    return false;
+  }
+  
+  _oledInterface->showStatus("Queueing", "Job");
+  _eslProtocol->beginCapture(captureToSpool, &jobSpool);
+  return true;
+}
+
+void WebInterface::finishSpoolCapture(bool success) {
+  bool captured = _eslProtocol->endCapture();
+  
+  if (!success || !captured) {
+    jobSpool.abortJob();
+    sendErrorResponse("Failed to queue job");
+    return;
+  }
+  
+  // Committing may drop superseded jobs, the new one is always appended last
+  uint32_t coalesced = jobSpool.getReplacedCount() + jobSpool.getMergedCount();
+  if (!jobSpool.commitJob()) {
+    sendErrorResponse("Failed to queue job");
+    return;
+  }
+  coalesced = jobSpool.getReplacedCount() + jobSpool.getMergedCount() - coalesced;
+  
+  const SpoolJobInfo& job = jobSpool.getJob(jobSpool.getJobCount() - 1);
+  char message[96];
+  int length = snprintf(message, sizeof(message), "Job %lu queued with %u frames",
+                        (unsigned long)job.id, job.frameCount);
+  if (coalesced) {
+    length += snprintf(message + length, sizeof(message) - length, ", superseding %lu queued jobs",
+                       (unsigned long)coalesced);
+  }
+  
+  // Falls back to sending from the spool file if the flash area is full
+  if (flashJobs.compile(jobSpool, job.id)) {
+    snprintf(message + length, sizeof(message) - length, ", compiled to flash");
+  }
+  sendSuccessResponse(message);
+}
+
+void WebInterface::sendJson(int statusCode, JsonWriter& json) {
+  // A full buffer means a handler outgrew its response size
+  if (json.overflowed()) {
+    _server->send(500, "application/json", "{\"success\":false,\"error\":\"Response too large\"}");
+    return;
+  }
+  _server->send(statusCode, "application/json", json.c_str());
+}
+
+void WebInterface::sendSuccessResponse(const char* message) {
+  char buffer[JSON_RESPONSE_SIZE];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.addBool("success", true);
+  json.addString("message", message);
+  json.endObject();
+  sendJson(200, json);
+}
+
+void WebInterface::showStatusNow(const char* line1, const char* line2) {
+  // Nothing is in flight yet, the I2C write only delays the start
+  _oledInterface->showStatus(line1, line2);
+  _oledInterface->update(true);
+}
+
+void WebInterface::rejectRequest(const char* error, int statusCode) {
+  // Invalid input never reaches the transmitter, count it separately
+  metrics.recordJob(JOB_REJECTED, 0);
+  sendErrorResponse(error, statusCode);
+}
+
+void WebInterface::sendErrorResponse(const char* error, int statusCode) {
+  char buffer[JSON_RESPONSE_SIZE];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.addBool("success", false);
+  json.addString("error", error);
+  json.endObject();
+  sendJson(statusCode, json);
 }
 
 void WebInterface::sendHtmlResponse(String html, int statusCode) {
@@ -10,6 +10,16 @@
 
 // Forward declaration to avoid circular dependency
 class ESLProtocol;
+struct ProgressEvent;
+class JsonWriter;
+struct TagRecord;
+class BatchReader;
+
+#define EVENTS_MAX_CLIENTS 4
+#define JSON_RESPONSE_SIZE 192
+#define JSON_STATUS_SIZE 512
+// Uploads above this are refused before anything is staged
+#define IMAGE_MAX_UPLOAD_BYTES 81920
 
 class WebInterface {
   public:
@@ -22,21 +32,53 @@ class WebInterface {
     OLEDInterface* _oledInterface;
     ESLProtocol* _eslProtocol;
     
+    // Open /events streams, the protocol observer is only set while there are any
+    WiFiClient _eventClients[EVENTS_MAX_CLIENTS];
+    
+    // Verdict on the image being uploaded, 0 while it is admitted
+    int _uploadStatus;
+    char _uploadError[64];
+    bool _uploadChecked;
+    
     // Handler functions
     void handleRoot();
     void handleTransmitImage();
     void handleRawCommand();
     void handleSetSegments();
     void handlePing();
+    void handlePingParallel();
     void handleRefresh();
+    void handleBatch();
+    void handleEvents();
     void handleWifiConfig();
     void handleRestart();
     void handleStatus();
     void handleTestFrequency();
+    void handleMetrics();
+    void handleProfile();
+    void handleTrace();
+    void handleTraceConfig();
+    void handleTraceVCD();
+    void handleSpoolList();
+    void handleSpoolCancel();
+    void handleProfileList();
+    void handleProfileUpload();
+    void handleProfileAssign();
+    void handleRedundancy();
+    void handleTagList();
+    void handleTagPut();
+    void handleTagRemove();
+    // Ping or refresh every tag of a registry group
+    void handleGroupSend(bool ping);
     void handleNotFound();
     
     // New image processing functions
-    bool handleFileUpload();
+    void handleFileUpload();
+    // Refuses an upload with 413 if it does not fit the image arena; header is
+    // the start of the BMP file
+    void admitImage(const uint8_t* header, size_t length);
+    void refuseUpload(int statusCode, const char* error);
+    size_t imageMemoryNeeded(uint16_t width, uint16_t height, uint16_t bpp, bool colorMode);
     bool processImage(const char* filename, uint8_t** imageData, 
                      uint16_t* width, uint16_t* height, bool colorMode);
     bool convertToBinary(uint8_t* pixels, uint16_t width, uint16_t height, 
@@ -46,9 +88,44 @@ class WebInterface {
     void applyDithering(uint8_t* pixels, uint16_t width, uint16_t height);
     
     // Helper functions
-    bool parseHexString(String hexString, uint8_t* buffer, uint16_t maxLength, uint16_t* actualLength);
-    void sendSuccessResponse(String message);
-    void sendErrorResponse(String error);
+    // application/octet-stream requests carry frame bytes as the body,
+    // the other parameters stay in the query string
+    bool isBinaryBody();
+    bool readBinaryBody(uint8_t* buffer, uint16_t maxLength, uint16_t* actualLength);
+    // JSON responses are written into stack buffers of these sizes
+    void sendJson(int statusCode, JsonWriter& json);
+    void sendSuccessResponse(const char* message);
+    void sendErrorResponse(const char* error, int statusCode = 400);
+    void rejectRequest(const char* error, int statusCode = 400);
+    // Status for a handler that blocks loop(), drawn at once
+    void showStatusNow(const char* line1, const char* line2);
+    
+    // A transmit request with notBefore (unix seconds) or spool=1 is queued in the
+    // job spool instead of sent, deadline and priority are refused without them;
+    // returns false once the request has been answered.
+    // kind and page (SpoolJobKind) let the spool coalesce work for the same tag
+    bool beginSpoolCapture(const char* barcode, uint8_t kind, uint8_t page, bool* spooling);
+    // notBefore, deadline and priority of the request, the arguments keep their
+    // value when not given; false once a bad priority has been answered
+    bool readSpoolOptions(uint32_t* notBefore, uint32_t* deadline, uint8_t* priority);
+    // repeatCount of the request or fallback; false once a bad value has been answered
+    bool readRepeatCount(uint16_t fallback, uint16_t* repeats);
+    // One spool job pinging or refreshing up to SPOOL_MAX_BARCODES tags of a group
+    bool queueGroupJob(const char* const* barcodes, uint8_t count, bool ping, uint16_t repeatCount,
+                       bool forcePP4, uint32_t notBefore, uint32_t deadline, uint8_t priority);
+    // One spool job with the next count operations of replay, in batch order
+    bool queueBatchJob(BatchReader& replay, const char* const* barcodes, uint8_t count,
+                       uint32_t notBefore, uint32_t deadline, uint8_t priority);
+    // Commit or discard the captured job and answer the request
+    void finishSpoolCapture(bool success);
+    // An update sent right away makes queued older revisions of the page redundant
+    uint8_t dropSupersededJobs(const char* barcode, uint8_t page);
+    uint32_t tagFromBarcode(const char* barcode);
+    void writeTag(JsonWriter& json, const TagRecord& record);
+    // Progress events go to every /events subscriber that has room for them
+    static void progressToEvents(void* context, const ProgressEvent& event);
+    void broadcastEvent(const char* text, size_t length);
+    uint8_t pruneEventClients();
     void sendHtmlResponse(String html, int statusCode = 200);
     void serveStatic(const char* uri, const char* contentType, const char* content);
 };
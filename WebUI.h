@@ -0,0 +1,251 @@
+#ifndef WEB_UI_H
+#define WEB_UI_H
+
+// Control page, gzip compressed. Generated by ui/embed.py from
+// ui/index.html (13877 bytes), do not edit
+
+#include <Arduino.h>
+
+#define WEB_UI_INDEX_ETAG "\"a18ce41a599f7998\""
+#define WEB_UI_INDEX_GZ_LENGTH 3772
+
+static const uint8_t WEB_UI_INDEX_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xbd, 0x1b, 0x6b, 0x73, 0xdb, 0x36,
+  0xf2, 0xbb, 0x7f, 0x05, 0xaa, 0x5c, 0x2b, 0xa9, 0xb1, 0x9e, 0xb6, 0xec, 0x44, 0x96, 0xdc, 0xf1,
+  0xb3, 0xf1, 0x9c, 0xdd, 0x78, 0x22, 0xe7, 0xda, 0x4c, 0x9b, 0x49, 0x21, 0x12, 0x92, 0x50, 0x53,
+  0x24, 0x4b, 0x42, 0x96, 0xdd, 0xd4, 0xff, 0xfd, 0x76, 0xf1, 0x20, 0x41, 0x4a, 0x94, 0xa5, 0xb8,
+  0xe9, 0x64, 0xa2, 0x80, 0xc0, 0xee, 0x62, 0xdf, 0xbb, 0x00, 0x99, 0xde, 0x37, 0xa7, 0x6f, 0x4f,
+  0x6e, 0x3e, 0x5c, 0x9f, 0x91, 0x89, 0x98, 0x7a, 0x87, 0x3d, 0xfc, 0x25, 0x1e, 0xf5, 0xc7, 0xfd,
+  0x12, 0xf3, 0x4b, 0xf0, 0xcc, 0xa8, 0x7b, 0xb8, 0xd5, 0x9b, 0x32, 0x41, 0x89, 0x33, 0xa1, 0x51,
+  0xcc, 0x44, 0xbf, 0xf4, 0xfe, 0xe6, 0xbc, 0xf6, 0x0a, 0x16, 0x05, 0x17, 0x1e, 0x3b, 0x3c, 0x1b,
+  0x5c, 0x92, 0x63, 0x8f, 0xc6, 0x82, 0x45, 0xbd, 0x86, 0x9a, 0xd2, 0x08, 0x3e, 0x9d, 0xb2, 0x7e,
+  0xe9, 0x8e, 0xb3, 0x79, 0x18, 0x44, 0xa2, 0x44, 0x9c, 0xc0, 0x17, 0xcc, 0x07, 0x02, 0x73, 0xee,
+  0x8a, 0x49, 0xdf, 0x65, 0x77, 0xdc, 0x61, 0x35, 0xf9, 0xb0, 0x4d, 0xb8, 0xcf, 0x05, 0xa7, 0x5e,
+  0x2d, 0x76, 0xa8, 0xc7, 0xfa, 0xad, 0x12, 0x10, 0x89, 0xc5, 0x03, 0x12, 0xfb, 0x9e, 0x7c, 0x26,
+  0xc3, 0xe0, 0xbe, 0x16, 0xf3, 0xbf, 0xb8, 0x3f, 0xee, 0xc2, 0x38, 0x72, 0x59, 0x54, 0x83, 0xa9,
+  0x03, 0xf2, 0xb8, 0x35, 0x0c, 0xdc, 0x07, 0x00, 0x18, 0x01, 0xed, 0xda, 0x88, 0x4e, 0xb9, 0xf7,
+  0xd0, 0x25, 0x47, 0x11, 0x50, 0xda, 0x26, 0x31, 0xf5, 0xe3, 0x5a, 0xcc, 0x22, 0x3e, 0x3a, 0x20,
+  0x53, 0x7a, 0xaf, 0x76, 0xea, 0x92, 0x57, 0xcd, 0x66, 0x78, 0x8f, 0x33, 0xd1, 0x98, 0xfb, 0x5d,
+  0xd2, 0x24, 0x74, 0x26, 0x82, 0x03, 0x12, 0x52, 0xd7, 0x95, 0xf4, 0xdb, 0x72, 0xd9, 0x09, 0xbc,
+  0x20, 0xea, 0x92, 0x17, 0x3b, 0x3b, 0x3b, 0x07, 0xc4, 0xe3, 0x3e, 0xab, 0x4d, 0x18, 0x1f, 0x4f,
+  0x44, 0x97, 0xb4, 0xea, 0x7b, 0xb8, 0xf1, 0xa4, 0xb5, 0x4d, 0x26, 0x6d, 0xd8, 0xda, 0x40, 0xb6,
+  0x9d, 0x1d, 0xd6, 0x69, 0x1a, 0xc2, 0x35, 0x11, 0x84, 0x40, 0x5c, 0x41, 0x02, 0x94, 0x60, 0xf7,
+  0xa2, 0x46, 0x3d, 0x3e, 0x86, 0x2d, 0x1d, 0xd0, 0x02, 0x8b, 0x12, 0xc8, 0x61, 0x20, 0x44, 0x30,
+  0x35, 0x1b, 0x3f, 0x6e, 0xd5, 0x05, 0x1d, 0xd6, 0x50, 0x59, 0x14, 0xb6, 0x8d, 0x00, 0x77, 0x05,
+  0x5c, 0x0c, 0xcb, 0x2e, 0x8f, 0x43, 0x8f, 0x82, 0xdc, 0x23, 0x8f, 0xc1, 0x02, 0xfe, 0xd6, 0xe6,
+  0x11, 0x85, 0xed, 0xf1, 0xf7, 0x20, 0x55, 0x98, 0x42, 0x6f, 0x85, 0xf7, 0x24, 0x0e, 0x3c, 0xee,
+  0x92, 0x17, 0x8e, 0xe3, 0x2c, 0x70, 0xd1, 0x4c, 0x58, 0x18, 0xce, 0x60, 0xc6, 0x47, 0xed, 0x53,
+  0xe7, 0x76, 0x1c, 0x05, 0x33, 0xdf, 0xad, 0x19, 0x61, 0x47, 0x2d, 0xfc, 0x63, 0x68, 0x2f, 0x12,
+  0xcd, 0xed, 0xe9, 0x07, 0x3e, 0x4b, 0x26, 0x23, 0xea, 0xf2, 0x59, 0xdc, 0x25, 0xbb, 0x80, 0x83,
+  0x7f, 0x9b, 0xb8, 0x67, 0xa2, 0xfe, 0x16, 0x48, 0x47, 0x5a, 0x9d, 0xd4, 0x44, 0xb5, 0x48, 0xe9,
+  0xdd, 0x9e, 0x32, 0x74, 0x6b, 0x2d, 0x69, 0xab, 0x59, 0x14, 0x23, 0x57, 0x61, 0xc0, 0x95, 0x62,
+  0x45, 0x04, 0xa6, 0x07, 0x7f, 0x0a, 0xd0, 0xbe, 0xf5, 0x9d, 0x18, 0xc8, 0x07, 0xe6, 0x39, 0x62,
+  0x1e, 0x15, 0xfc, 0x0e, 0xd8, 0x91, 0x16, 0x6a, 0x59, 0x3a, 0x57, 0x02, 0x77, 0x27, 0xc1, 0x9d,
+  0x54, 0xfb, 0x12, 0xb1, 0x5d, 0xd7, 0xcd, 0x41, 0xd7, 0xa9, 0x83, 0xd4, 0x96, 0x83, 0xef, 0xec,
+  0xbe, 0x7e, 0xe5, 0x0e, 0x13, 0x67, 0x9a, 0x4f, 0xb8, 0x60, 0xab, 0xec, 0x61, 0xe0, 0x2d, 0x1f,
+  0x00, 0x57, 0xb1, 0x4d, 0xac, 0x14, 0x99, 0xf3, 0xd5, 0x27, 0x8c, 0x20, 0xe5, 0x5c, 0x6a, 0x01,
+  0xd0, 0xbc, 0xb1, 0xc2, 0xc1, 0x52, 0x2b, 0x8f, 0x46, 0x79, 0x66, 0x52, 0x79, 0x13, 0x9e, 0x86,
+  0x5e, 0xe0, 0xdc, 0x4a, 0xb8, 0x51, 0x10, 0x4d, 0x6b, 0x48, 0x23, 0x5c, 0xf4, 0x5a, 0x65, 0xd2,
+  0xc7, 0x2d, 0x8f, 0x0e, 0x99, 0xb7, 0x04, 0x3d, 0x07, 0x2e, 0xa1, 0x65, 0x54, 0xcf, 0x75, 0xdc,
+  0x0d, 0x03, 0x4f, 0x2a, 0x9f, 0xfb, 0xe1, 0x4c, 0xfc, 0x2a, 0x1e, 0x42, 0xd6, 0xc7, 0xa0, 0xfa,
+  0x88, 0xb9, 0x23, 0x99, 0xf1, 0x67, 0xd3, 0x21, 0x8b, 0xb2, 0x73, 0x21, 0x8d, 0xe3, 0x39, 0x08,
+  0x0e, 0xb3, 0x31, 0xf3, 0x98, 0x23, 0xb6, 0x65, 0x34, 0xd2, 0x88, 0x51, 0xe0, 0x43, 0x67, 0x85,
+  0x56, 0xb3, 0xf9, 0x6d, 0xce, 0x0b, 0x97, 0x2a, 0x56, 0x7a, 0xc0, 0xa2, 0x23, 0x6b, 0x5e, 0x21,
+  0x47, 0x31, 0x00, 0xdf, 0x53, 0xa2, 0x2a, 0x0f, 0x51, 0x4c, 0xc4, 0xb3, 0xe1, 0x94, 0x23, 0xb3,
+  0xf6, 0xa4, 0x1a, 0x7f, 0xdc, 0xc4, 0x79, 0x96, 0xc5, 0x89, 0x61, 0xb3, 0x28, 0xca, 0x96, 0x44,
+  0xc8, 0x02, 0xb7, 0x76, 0xd6, 0x6a, 0x35, 0x0b, 0xf9, 0x57, 0xc1, 0xb1, 0x54, 0x8a, 0x55, 0x71,
+  0xd3, 0x7e, 0xfd, 0xaa, 0x39, 0x7c, 0x8d, 0x34, 0x5f, 0xc4, 0x82, 0x8a, 0x59, 0x5c, 0x9b, 0xb2,
+  0x38, 0xa6, 0x63, 0x96, 0xfa, 0x89, 0xdc, 0x59, 0xf9, 0x73, 0x2a, 0xa3, 0x25, 0x5e, 0x56, 0xa0,
+  0x5c, 0x40, 0x80, 0xef, 0xc5, 0x33, 0xc7, 0x01, 0x9a, 0x05, 0x71, 0xbb, 0xcb, 0x5c, 0x97, 0xa6,
+  0x59, 0xbd, 0xd5, 0xe9, 0xec, 0xb7, 0x77, 0x97, 0x47, 0xce, 0x0e, 0xdb, 0x73, 0x54, 0x0c, 0xb2,
+  0x28, 0x0a, 0x0a, 0x04, 0x1a, 0xbd, 0x72, 0xf7, 0x6d, 0x82, 0xfb, 0xed, 0x96, 0x53, 0x40, 0x70,
+  0xd4, 0x71, 0x0c, 0xc1, 0x3f, 0x67, 0xdc, 0xb9, 0xad, 0x61, 0x04, 0x05, 0xfe, 0x3a, 0x99, 0x7b,
+  0x4c, 0x13, 0x6b, 0x14, 0xd5, 0x80, 0x2c, 0xc9, 0x24, 0x65, 0x23, 0x29, 0x40, 0x05, 0x3c, 0x40,
+  0x32, 0x2e, 0xde, 0xd1, 0x48, 0xbd, 0x86, 0x2a, 0xad, 0xbd, 0x86, 0xac, 0xef, 0x3d, 0xac, 0xa1,
+  0x50, 0x6f, 0x27, 0x2d, 0xbb, 0x98, 0x93, 0x13, 0x70, 0x91, 0x28, 0xf0, 0xc8, 0x35, 0xf5, 0x99,
+  0x07, 0xa0, 0x2d, 0x00, 0x71, 0xf9, 0x1d, 0x71, 0x60, 0x3d, 0xee, 0x97, 0x32, 0x1b, 0x63, 0xb9,
+  0xd6, 0x7b, 0x73, 0xb7, 0x5f, 0x52, 0x36, 0x3e, 0x16, 0x7e, 0x89, 0x48, 0x0f, 0x29, 0xa9, 0xb5,
+  0xd2, 0xe1, 0xa9, 0xac, 0xf9, 0x64, 0x20, 0xd7, 0x7b, 0x0d, 0x35, 0x9d, 0xc5, 0x8d, 0x18, 0x60,
+  0x47, 0x62, 0x09, 0xf2, 0x3b, 0xb5, 0x42, 0x14, 0x91, 0xe5, 0xd8, 0x02, 0x60, 0xce, 0x23, 0xf6,
+  0xe7, 0x12, 0xf4, 0x1b, 0x58, 0x82, 0xe2, 0xdd, 0xee, 0x5c, 0xbd, 0xf9, 0xcb, 0x42, 0x6e, 0x80,
+  0x4c, 0x59, 0xc9, 0x32, 0xe5, 0x17, 0xfa, 0x9c, 0xec, 0x92, 0x2d, 0xab, 0x85, 0xa0, 0x67, 0x54,
+  0x76, 0x2c, 0x11, 0x97, 0x0a, 0x5a, 0x03, 0x6e, 0xc7, 0xd8, 0x30, 0x5d, 0x4c, 0xc1, 0xd3, 0x6f,
+  0xe8, 0xb0, 0x74, 0x28, 0x47, 0x8b, 0x9c, 0x2f, 0xd0, 0xc9, 0x11, 0x78, 0x47, 0xe7, 0x12, 0x1d,
+  0xfe, 0x05, 0xb3, 0x4c, 0xa7, 0xd4, 0x77, 0x37, 0x27, 0x32, 0x60, 0xe3, 0x29, 0x24, 0x70, 0x49,
+  0x48, 0x8f, 0xe3, 0xcd, 0xa9, 0x5c, 0x43, 0x60, 0x4a, 0x12, 0x38, 0x68, 0xbc, 0x63, 0x23, 0xb0,
+  0xd7, 0xe4, 0x4b, 0x98, 0x11, 0x02, 0x08, 0xc4, 0x92, 0xd4, 0xcf, 0xfc, 0x9c, 0x13, 0x33, 0xb3,
+  0x39, 0xad, 0xa3, 0x61, 0x30, 0x53, 0x62, 0xc9, 0xd1, 0x72, 0xdb, 0xa2, 0x73, 0x24, 0x76, 0xc8,
+  0x5b, 0x1a, 0x8b, 0xac, 0xb6, 0x1c, 0xc6, 0x41, 0xfb, 0xf0, 0x06, 0x1b, 0x08, 0xc8, 0x77, 0x44,
+  0xa2, 0x40, 0xa7, 0x40, 0x20, 0x32, 0x20, 0x06, 0xda, 0xb0, 0x8c, 0x45, 0x4e, 0x92, 0xe3, 0xb8,
+  0x76, 0x0e, 0x4f, 0x25, 0xc2, 0x7c, 0x47, 0x39, 0xdb, 0x74, 0xe6, 0x09, 0x1e, 0x82, 0x97, 0x36,
+  0x64, 0x2d, 0x44, 0x3e, 0x4b, 0x59, 0xef, 0x4a, 0x6b, 0x24, 0xb8, 0x96, 0x2a, 0x86, 0x30, 0x05,
+  0x6e, 0x4a, 0x23, 0x27, 0x70, 0x81, 0x01, 0x19, 0x83, 0xea, 0x81, 0x54, 0x5a, 0xfb, 0x90, 0x24,
+  0xc6, 0x5c, 0xc4, 0xd5, 0x6e, 0xaf, 0x21, 0xa1, 0x81, 0x9a, 0xac, 0x6d, 0xda, 0xbb, 0xb1, 0x92,
+  0x95, 0x24, 0x3b, 0x86, 0x80, 0xee, 0xbb, 0x93, 0x47, 0x88, 0x86, 0x19, 0x8f, 0x98, 0x0b, 0x69,
+  0x55, 0x40, 0x5c, 0xfb, 0xfd, 0x52, 0xfd, 0x73, 0x6b, 0x7f, 0xbb, 0xb5, 0xff, 0x08, 0x0c, 0x2c,
+  0x7a, 0x7f, 0x11, 0x7f, 0x4a, 0x5a, 0xee, 0x31, 0xed, 0xc5, 0x04, 0xc7, 0x05, 0x4c, 0x8d, 0x10,
+  0xcc, 0xd2, 0x91, 0x7c, 0x54, 0x6c, 0x59, 0x13, 0x14, 0x12, 0x76, 0x28, 0xf4, 0x54, 0xe3, 0xfb,
+  0x94, 0xd3, 0x4d, 0xd8, 0x0a, 0x01, 0x17, 0x9c, 0x11, 0x19, 0xaa, 0x34, 0x6b, 0xad, 0x4e, 0x91,
+  0x9e, 0x54, 0x63, 0xa0, 0x98, 0x92, 0x38, 0x9a, 0x1f, 0x35, 0x86, 0x2c, 0xd9, 0x2f, 0x35, 0x4b,
+  0x78, 0x4c, 0xe8, 0x97, 0x5a, 0x9d, 0x12, 0xb9, 0xa3, 0xde, 0x8c, 0xe1, 0xd4, 0x26, 0xbc, 0xc8,
+  0x62, 0x70, 0x25, 0x8d, 0x78, 0x82, 0x43, 0x82, 0x63, 0x8b, 0x1f, 0xd5, 0x7d, 0x48, 0x16, 0x52,
+  0x50, 0xcd, 0x87, 0x85, 0xdb, 0x0b, 0x42, 0x4c, 0xaa, 0x16, 0x0f, 0x90, 0x92, 0x9d, 0x5b, 0xf2,
+  0x1d, 0xf9, 0x19, 0x7b, 0x80, 0x5e, 0x43, 0xad, 0xe7, 0xe1, 0x5a, 0x7a, 0xd7, 0x74, 0xbd, 0xa1,
+  0x36, 0xdc, 0x48, 0x9d, 0x41, 0xfc, 0x4b, 0xe9, 0xf0, 0x17, 0x72, 0x6d, 0xfa, 0xe5, 0x35, 0xb4,
+  0x89, 0x28, 0x46, 0x9b, 0x72, 0x6c, 0xb4, 0xf9, 0x45, 0x4a, 0x04, 0x12, 0x1f, 0x4a, 0x87, 0x1f,
+  0x36, 0xe4, 0xe0, 0x83, 0xc5, 0xc1, 0x87, 0x67, 0x72, 0x00, 0x3f, 0x0e, 0xbb, 0xbe, 0xde, 0x2d,
+  0xe5, 0xb6, 0x74, 0x26, 0xcc, 0xb9, 0x85, 0x63, 0xa7, 0xda, 0x34, 0x81, 0xd2, 0x1b, 0xa7, 0x58,
+  0xe7, 0x38, 0x22, 0x30, 0x24, 0xd7, 0x51, 0x20, 0x02, 0xb0, 0xac, 0x11, 0xc1, 0x30, 0xa1, 0x13,
+  0x9b, 0x22, 0xab, 0x3a, 0xab, 0x52, 0x2e, 0xe7, 0x24, 0x59, 0xac, 0x27, 0x33, 0xc9, 0x61, 0x3e,
+  0x97, 0xe9, 0x92, 0xb0, 0x24, 0x93, 0xe9, 0x14, 0x36, 0x60, 0xbe, 0x4b, 0x32, 0x05, 0x03, 0x26,
+  0xd3, 0xe4, 0x15, 0xd1, 0xb9, 0x4c, 0x5d, 0xeb, 0xa9, 0x04, 0xa0, 0x8f, 0x9f, 0x9b, 0x9f, 0x2c,
+  0x1a, 0x5f, 0x29, 0x45, 0xb1, 0xd8, 0xbb, 0x81, 0x4d, 0x15, 0x8b, 0x38, 0x5a, 0x1e, 0x7b, 0x06,
+  0x4c, 0x73, 0x21, 0x24, 0x4a, 0x2e, 0x98, 0x4e, 0xaf, 0xa0, 0x59, 0x09, 0x04, 0xb9, 0xa2, 0x22,
+  0xe2, 0xf7, 0xa4, 0x72, 0x7a, 0x55, 0x2d, 0x8a, 0xbb, 0xc1, 0xd9, 0x8f, 0x49, 0x41, 0x25, 0x15,
+  0x78, 0xaa, 0x3e, 0x2b, 0x02, 0x27, 0xec, 0xfe, 0x54, 0x56, 0x8d, 0x37, 0xec, 0x9e, 0xe0, 0x88,
+  0x54, 0xe6, 0x5c, 0x4c, 0xa0, 0xb0, 0x91, 0x11, 0x8f, 0xa0, 0x85, 0x19, 0x3e, 0x08, 0x46, 0xc0,
+  0xa0, 0xe4, 0xe4, 0xdd, 0x89, 0xad, 0xf5, 0xe4, 0x4c, 0x83, 0x32, 0x1a, 0x2a, 0x5a, 0xc6, 0xe4,
+  0x31, 0x0a, 0xe6, 0xb0, 0xf7, 0x6e, 0x26, 0xd7, 0x1a, 0xc4, 0x4d, 0xb8, 0x8c, 0x58, 0xc8, 0xa8,
+  0x38, 0x81, 0x9e, 0x58, 0x60, 0x63, 0x86, 0x0f, 0x44, 0x3e, 0xad, 0x11, 0xae, 0x36, 0xae, 0xe6,
+  0x2f, 0x33, 0x25, 0x83, 0xb7, 0x55, 0xb2, 0xf2, 0xda, 0xca, 0xb8, 0x91, 0x8e, 0x9e, 0xef, 0x8a,
+  0x0a, 0xa2, 0xc6, 0xea, 0x81, 0x56, 0x45, 0x8e, 0x20, 0x69, 0x83, 0x94, 0x89, 0x9a, 0x58, 0x4d,
+  0x6f, 0x10, 0x39, 0x80, 0xf1, 0xec, 0xc8, 0xb1, 0x68, 0x7c, 0xa5, 0xc8, 0x19, 0x72, 0x31, 0xa5,
+  0x61, 0xea, 0xc6, 0xc7, 0xf2, 0x99, 0x54, 0x76, 0xf7, 0x08, 0xb8, 0xce, 0x12, 0x46, 0x33, 0xce,
+  0xa6, 0xb1, 0x0d, 0x6f, 0xfa, 0x69, 0xc1, 0xd5, 0x52, 0x1e, 0x7f, 0x6d, 0xd6, 0x5e, 0x1f, 0xd5,
+  0xce, 0x69, 0x6d, 0xf4, 0xf1, 0xf3, 0xee, 0x9e, 0x64, 0x75, 0xc1, 0x09, 0x0b, 0x6c, 0x6d, 0x9b,
+  0x66, 0xb5, 0xad, 0x4d, 0xa7, 0x5a, 0x6c, 0x68, 0x84, 0x80, 0xaa, 0xaa, 0x9b, 0x58, 0x6c, 0xf1,
+  0xf2, 0xf6, 0x0e, 0x01, 0x62, 0x03, 0x63, 0x23, 0xf8, 0xb3, 0xad, 0x6d, 0x13, 0xf9, 0x4a, 0xe6,
+  0x36, 0xb5, 0x0a, 0x15, 0xb0, 0x5e, 0x95, 0x93, 0x90, 0x5f, 0x50, 0xe9, 0x36, 0x4b, 0x25, 0x8a,
+  0x9f, 0x2f, 0x4f, 0x27, 0x36, 0x97, 0xab, 0x52, 0xca, 0x6e, 0xb3, 0xb9, 0x4e, 0x52, 0x41, 0x72,
+  0x79, 0x2f, 0x93, 0x8e, 0x63, 0x3c, 0xe6, 0x54, 0x9d, 0xdf, 0xf3, 0xa5, 0x55, 0xad, 0x6e, 0x52,
+  0x5e, 0x15, 0xc6, 0xf3, 0x4b, 0x6c, 0x96, 0xce, 0x57, 0xf6, 0x1e, 0xad, 0x85, 0xf5, 0x1c, 0xc8,
+  0x00, 0xff, 0x53, 0xdd, 0xd2, 0x82, 0x09, 0x9e, 0x4a, 0xfc, 0xe9, 0x79, 0xb3, 0x38, 0x21, 0xe4,
+  0x0e, 0xa2, 0x19, 0xab, 0xce, 0xf9, 0x88, 0x6f, 0x60, 0x52, 0x04, 0x1f, 0xc4, 0xdc, 0x35, 0xa7,
+  0xdb, 0xc1, 0xc5, 0xe9, 0x93, 0xe6, 0x4b, 0x70, 0xb4, 0x92, 0x62, 0x39, 0xfe, 0x92, 0x53, 0x11,
+  0x52, 0xba, 0xd6, 0xd7, 0x9e, 0x9a, 0x03, 0xf3, 0x58, 0xc0, 0x85, 0xb9, 0x24, 0x4d, 0x39, 0x49,
+  0xf0, 0x93, 0x93, 0x92, 0xa1, 0xb7, 0x01, 0x23, 0x34, 0x54, 0x67, 0x9a, 0x55, 0x2e, 0xa2, 0x61,
+  0xf4, 0x36, 0x06, 0xe3, 0x48, 0x5d, 0xe7, 0x5d, 0xe3, 0x8d, 0xa5, 0x3c, 0x48, 0x7d, 0x51, 0x6a,
+  0x99, 0xc5, 0xec, 0x92, 0xd1, 0xf8, 0x09, 0x0e, 0x2c, 0xb8, 0x24, 0x7b, 0xa4, 0x98, 0xe7, 0x14,
+  0xba, 0xae, 0xe3, 0x20, 0x10, 0x5d, 0x28, 0x15, 0x30, 0x4d, 0x2e, 0x71, 0xe2, 0xe2, 0x9a, 0x1c,
+  0xb9, 0x2e, 0xf8, 0x60, 0xbc, 0x96, 0xbf, 0x0e, 0xe8, 0x1d, 0x5b, 0xbc, 0xe3, 0x28, 0xf0, 0xd6,
+  0xe4, 0x46, 0xa3, 0xd8, 0x55, 0x25, 0x08, 0xc9, 0xbc, 0x7c, 0x93, 0xb7, 0x13, 0x61, 0xe6, 0x0e,
+  0x8f, 0xc7, 0x84, 0x12, 0xf5, 0xa2, 0x0d, 0x35, 0x42, 0x1c, 0x68, 0x93, 0x66, 0x3e, 0x77, 0x28,
+  0xb2, 0x41, 0xb0, 0xaf, 0x24, 0xb2, 0x41, 0x8d, 0x02, 0x98, 0x24, 0xf1, 0x84, 0x79, 0x23, 0x22,
+  0x85, 0x89, 0x49, 0x05, 0xcb, 0x61, 0x95, 0xcc, 0x62, 0x84, 0xe4, 0xfe, 0x28, 0xa2, 0x98, 0x39,
+  0x62, 0x3e, 0xf6, 0xa9, 0x17, 0xd7, 0x7b, 0x8d, 0x50, 0x6e, 0xd6, 0x8b, 0x11, 0x77, 0x7c, 0xf8,
+  0x86, 0x46, 0xee, 0x1c, 0x20, 0xc8, 0xff, 0x58, 0x14, 0xab, 0x53, 0x9b, 0x5e, 0x21, 0xbd, 0x38,
+  0xa4, 0xea, 0x72, 0x6e, 0x32, 0xd7, 0xab, 0xa5, 0xc3, 0xcb, 0x80, 0xe2, 0x15, 0x6f, 0xbd, 0x0e,
+  0x94, 0x70, 0xfd, 0x30, 0x4f, 0xf0, 0x9c, 0x47, 0xd3, 0x27, 0x09, 0x8e, 0x36, 0x20, 0xf8, 0x1e,
+  0x5a, 0xf2, 0x29, 0x5b, 0x4a, 0x66, 0x26, 0x97, 0xd6, 0x61, 0x2a, 0x62, 0x8c, 0x5c, 0xb1, 0x69,
+  0x10, 0x3d, 0x2c, 0xe7, 0x07, 0xd6, 0xdf, 0x30, 0x6c, 0xa4, 0x9e, 0x24, 0x75, 0x3c, 0xe3, 0x9e,
+  0x8b, 0xfd, 0xbd, 0xcd, 0x52, 0xbb, 0xd9, 0xee, 0xd4, 0x9a, 0x3b, 0xb5, 0xf6, 0x0e, 0x82, 0x5b,
+  0xd0, 0xd2, 0xe3, 0xde, 0x87, 0x6e, 0x11, 0x38, 0x69, 0x76, 0xba, 0xbb, 0xfb, 0xdd, 0x76, 0x87,
+  0xbc, 0xbf, 0x39, 0xc9, 0x6f, 0x35, 0x78, 0x00, 0x5f, 0x98, 0x92, 0xf7, 0x31, 0x8b, 0x2c, 0xe4,
+  0x63, 0x1e, 0x82, 0x4f, 0x87, 0x17, 0x53, 0x7c, 0x39, 0x4b, 0x7d, 0xa1, 0xb0, 0x26, 0x3b, 0xa9,
+  0x29, 0xc1, 0x5b, 0x67, 0x21, 0xb8, 0xd5, 0x0e, 0x72, 0x72, 0xf1, 0x8e, 0x98, 0x03, 0x2a, 0x3a,
+  0x16, 0x38, 0xa3, 0x0f, 0x7e, 0x03, 0x1e, 0x21, 0x02, 0xf2, 0xe3, 0xf5, 0xc5, 0xdb, 0x5d, 0x38,
+  0x23, 0xb5, 0xab, 0x66, 0xeb, 0xc1, 0xe0, 0xb4, 0xb5, 0xd3, 0xdc, 0x23, 0x6f, 0x2f, 0xcf, 0x4e,
+  0xc9, 0x60, 0xc2, 0x19, 0xc8, 0x0a, 0x21, 0x71, 0xd1, 0x3e, 0x81, 0x13, 0xd2, 0xe9, 0x51, 0x63,
+  0x70, 0x72, 0x59, 0x4d, 0x36, 0x3c, 0x01, 0xc7, 0xe2, 0xb2, 0xd5, 0x96, 0x3b, 0x1d, 0x43, 0xd0,
+  0x49, 0x68, 0x48, 0x36, 0xb7, 0x70, 0xda, 0x21, 0xa3, 0x59, 0x14, 0x09, 0x76, 0x4b, 0x2a, 0x7a,
+  0x50, 0x0f, 0xa2, 0xb1, 0xc4, 0x36, 0x61, 0x93, 0x8b, 0x9e, 0xec, 0x1b, 0x86, 0x34, 0x5d, 0xc5,
+  0x4e, 0xc4, 0x43, 0x71, 0xb8, 0x05, 0x74, 0x7c, 0x79, 0x6d, 0x5d, 0xa9, 0xca, 0xd7, 0xb7, 0x7e,
+  0x1c, 0x78, 0xac, 0xee, 0x05, 0xe3, 0x4a, 0x79, 0x20, 0x41, 0x88, 0x07, 0xd6, 0x63, 0x6e, 0xb9,
+  0x7a, 0xb0, 0xe5, 0x06, 0xce, 0x6c, 0x2a, 0x5f, 0x7b, 0xb9, 0xee, 0xd9, 0x1d, 0x0c, 0x2e, 0x39,
+  0x28, 0xd3, 0x67, 0x51, 0xa5, 0x7c, 0xfa, 0xf6, 0xea, 0x44, 0x85, 0xe4, 0xa5, 0x02, 0xdf, 0x26,
+  0xc5, 0x84, 0x01, 0x38, 0xa5, 0x6a, 0x5e, 0x76, 0xf3, 0xbf, 0xd8, 0x51, 0x18, 0x56, 0x60, 0xe2,
+  0x11, 0xb6, 0xe2, 0x23, 0x52, 0x49, 0xb6, 0x83, 0x4e, 0xd8, 0x7d, 0xc0, 0x6b, 0x72, 0x46, 0xfa,
+  0xfd, 0x3e, 0x29, 0x43, 0xe0, 0x86, 0x1e, 0x13, 0xac, 0x4c, 0xfe, 0xfe, 0x9b, 0x14, 0x42, 0xc9,
+  0x97, 0x3b, 0xea, 0x22, 0xb3, 0x0c, 0x2c, 0x6c, 0x91, 0x45, 0x26, 0xa8, 0x27, 0x91, 0x2c, 0x66,
+  0x62, 0x26, 0x6e, 0xc0, 0xfd, 0x21, 0x9d, 0x54, 0x32, 0x7c, 0x6d, 0x93, 0x16, 0x72, 0xb6, 0x65,
+  0x84, 0xca, 0x73, 0x8d, 0x2f, 0xb5, 0xa3, 0x87, 0x64, 0x17, 0xc8, 0xac, 0x74, 0x78, 0x2c, 0xd3,
+  0x5a, 0x4c, 0xfa, 0x29, 0x8f, 0x7f, 0xce, 0x58, 0xf4, 0x30, 0x90, 0x59, 0x26, 0x88, 0x8e, 0x3c,
+  0xaf, 0x52, 0xb6, 0xde, 0x9e, 0xa2, 0x8a, 0x2d, 0x74, 0xad, 0xcf, 0x75, 0xf0, 0x75, 0x36, 0x4c,
+  0x09, 0x24, 0x52, 0x42, 0xde, 0x8c, 0xbb, 0x60, 0x8c, 0x94, 0x9d, 0xba, 0xc7, 0xfc, 0x31, 0x7e,
+  0x64, 0x60, 0x6d, 0xa1, 0xe7, 0x24, 0xba, 0x05, 0x09, 0x49, 0xf2, 0x8c, 0x3a, 0x93, 0xd4, 0x45,
+  0x14, 0x9f, 0x4a, 0x99, 0x84, 0x98, 0x77, 0xbe, 0x0b, 0xce, 0xe0, 0x78, 0xdc, 0xb9, 0xcd, 0x79,
+  0x80, 0xc4, 0x48, 0xa5, 0xc3, 0xcb, 0x6a, 0x10, 0x4c, 0x4c, 0x78, 0x5c, 0x87, 0xe1, 0x91, 0x10,
+  0x11, 0x07, 0x7a, 0xac, 0x52, 0xb6, 0x6e, 0xb3, 0x95, 0x3c, 0x06, 0xcd, 0x96, 0x49, 0x89, 0x84,
+  0x30, 0x09, 0xc8, 0x4a, 0xbe, 0x05, 0x32, 0x4d, 0xe0, 0x9f, 0xba, 0xac, 0x21, 0xc8, 0x2a, 0xf8,
+  0xcb, 0x34, 0xb8, 0x83, 0x0d, 0x8d, 0x8b, 0x28, 0xc7, 0x4b, 0x88, 0x25, 0xba, 0x59, 0xa0, 0xa6,
+  0xb5, 0xad, 0xdd, 0x5a, 0xbe, 0x07, 0x5e, 0x93, 0x2a, 0x4a, 0x9b, 0x82, 0x82, 0xe2, 0x2c, 0xb8,
+  0x25, 0x0a, 0xd2, 0x2c, 0xd8, 0x0e, 0x00, 0xb3, 0x67, 0x1e, 0xc3, 0xe1, 0xf1, 0xc3, 0x85, 0x5b,
+  0xc9, 0xe9, 0x00, 0xa3, 0x26, 0x83, 0x2a, 0xfd, 0xd2, 0x9e, 0x78, 0x6a, 0x7b, 0x9b, 0x86, 0x0a,
+  0x23, 0x53, 0x7e, 0x31, 0x86, 0xc8, 0x4c, 0x66, 0x5d, 0x39, 0x75, 0xe1, 0x8f, 0x02, 0x19, 0xad,
+  0x1a, 0xf3, 0x11, 0x8a, 0x67, 0xcc, 0xac, 0x50, 0x97, 0x2f, 0x0c, 0x2b, 0xe5, 0x2b, 0x1e, 0x63,
+  0xd5, 0xb4, 0x2d, 0xa6, 0x71, 0x94, 0x62, 0xd4, 0x6f, 0x12, 0x57, 0xf1, 0x24, 0x98, 0xab, 0x37,
+  0x62, 0x15, 0x9d, 0xb3, 0xb6, 0xa1, 0x70, 0x9f, 0x21, 0x2d, 0xe3, 0x45, 0xd9, 0x24, 0x25, 0x61,
+  0x91, 0xba, 0x06, 0xd7, 0xa2, 0x28, 0x3d, 0xaa, 0xec, 0x77, 0x0a, 0xb9, 0xb0, 0x58, 0x87, 0xe5,
+  0x6c, 0x8a, 0x34, 0xba, 0x40, 0x3d, 0x7c, 0x93, 0xe0, 0x57, 0x17, 0x05, 0x53, 0x3b, 0x13, 0x4c,
+  0xb4, 0x53, 0x25, 0x23, 0x5a, 0x3b, 0x82, 0x3a, 0x11, 0xf9, 0x46, 0xc4, 0x04, 0xbf, 0x8e, 0x8d,
+  0x6d, 0x6a, 0x4f, 0xbd, 0xd7, 0x41, 0x0e, 0x48, 0x1a, 0xe7, 0x27, 0xe8, 0xb9, 0x00, 0x44, 0x0b,
+  0x4d, 0x7e, 0x20, 0x65, 0xb9, 0x61, 0x99, 0x74, 0x49, 0x59, 0xbf, 0xd7, 0x2d, 0xe7, 0x11, 0xe5,
+  0x2b, 0xcc, 0xba, 0x7e, 0x83, 0x0a, 0xc8, 0x65, 0xf9, 0x1d, 0x81, 0x01, 0x4b, 0x73, 0x5a, 0x26,
+  0x27, 0xaf, 0x40, 0xc7, 0x17, 0xc9, 0x65, 0x10, 0x62, 0x9b, 0x74, 0x9a, 0xcd, 0xa6, 0xb2, 0x53,
+  0x92, 0x9b, 0xb0, 0x4b, 0xc3, 0xac, 0xa4, 0xac, 0x51, 0x4e, 0xde, 0xfc, 0x94, 0x81, 0xc1, 0x86,
+  0xd0, 0x75, 0xb1, 0x26, 0xa7, 0xcb, 0xdb, 0x0a, 0x46, 0x5f, 0xb0, 0x4a, 0x08, 0x18, 0xd7, 0x1c,
+  0x75, 0x43, 0x65, 0x96, 0xad, 0x9b, 0x24, 0x09, 0x02, 0x1c, 0xd7, 0xf4, 0x5c, 0x6c, 0x60, 0xcc,
+  0xed, 0x83, 0x04, 0xc0, 0x87, 0x84, 0x76, 0x7a, 0xc2, 0x54, 0xf4, 0xd5, 0xb3, 0x59, 0x36, 0x47,
+  0x15, 0xb9, 0x86, 0x0f, 0x98, 0x2d, 0x47, 0x7c, 0x5c, 0x46, 0x99, 0x50, 0xb0, 0xb7, 0xc3, 0x3f,
+  0x20, 0x9d, 0xd6, 0x6f, 0xd9, 0x43, 0x5c, 0x91, 0xa2, 0x55, 0x17, 0x43, 0x1e, 0xe7, 0x2f, 0x5c,
+  0xdb, 0x01, 0x95, 0x1a, 0x56, 0xb8, 0x95, 0x46, 0x49, 0x9d, 0x09, 0x27, 0xd2, 0x44, 0x88, 0x4f,
+  0x4b, 0x52, 0xa7, 0xea, 0x90, 0xed, 0xdc, 0xc9, 0x52, 0x1c, 0x42, 0x58, 0x3d, 0x8c, 0x18, 0x62,
+  0x9c, 0xb2, 0x11, 0x9d, 0x79, 0xa2, 0x92, 0x0b, 0x5c, 0xb5, 0xa9, 0xae, 0x7f, 0x89, 0x5d, 0xa4,
+  0xb1, 0xd3, 0xb8, 0x2a, 0xbf, 0x0f, 0xbd, 0xa4, 0x23, 0xc3, 0xad, 0xa0, 0x87, 0x65, 0x56, 0x24,
+  0xdb, 0x02, 0xca, 0x3b, 0xd7, 0x3e, 0xf1, 0xd9, 0x9c, 0x9c, 0xeb, 0xc7, 0x0a, 0xa6, 0x31, 0x6b,
+  0xdf, 0x11, 0x13, 0xa8, 0x2a, 0xd4, 0xdc, 0xaf, 0x6a, 0xff, 0x8f, 0xdb, 0xf8, 0x25, 0x03, 0x13,
+  0x93, 0xc0, 0x05, 0xa5, 0x5f, 0xbf, 0x1d, 0xdc, 0xc0, 0x2e, 0xf8, 0x5e, 0xbd, 0x9b, 0xd2, 0x7c,
+  0xac, 0x26, 0x04, 0x08, 0xa9, 0x8b, 0x09, 0xf3, 0x53, 0x6d, 0x83, 0xf9, 0x42, 0xe0, 0x00, 0x25,
+  0xd7, 0xf1, 0x44, 0xcc, 0x54, 0xfd, 0x8f, 0x18, 0xbd, 0xf7, 0x60, 0x25, 0x3e, 0x96, 0x10, 0x5b,
+  0x6b, 0x46, 0x3b, 0x38, 0x6f, 0x3e, 0x8d, 0xc8, 0xaf, 0x13, 0x5b, 0x43, 0x12, 0x30, 0x49, 0x3f,
+  0x5a, 0x3f, 0x19, 0xf0, 0x24, 0xdb, 0xe5, 0xb1, 0xd4, 0x67, 0x12, 0xd0, 0x97, 0x94, 0x65, 0xf8,
+  0x62, 0xd6, 0x8b, 0x66, 0x59, 0xed, 0x92, 0x1c, 0xf3, 0x70, 0x00, 0xb1, 0x7d, 0x8d, 0xd9, 0xb9,
+  0xce, 0xb6, 0x88, 0x95, 0x7b, 0x24, 0x6d, 0x4c, 0x7a, 0x0a, 0x38, 0xcb, 0x9b, 0x6d, 0xea, 0x9f,
+  0x98, 0x90, 0x9d, 0xa3, 0x84, 0x03, 0x63, 0x90, 0x97, 0x6a, 0x98, 0x4a, 0xa7, 0xd8, 0xcb, 0x30,
+  0x67, 0x9e, 0xcc, 0xa8, 0x28, 0xb5, 0xa3, 0x47, 0x10, 0x3f, 0x40, 0x4f, 0x99, 0xf9, 0x2e, 0xb2,
+  0x63, 0x9c, 0x5e, 0x4a, 0xfb, 0x68, 0xf5, 0x33, 0xc9, 0x47, 0x10, 0x4f, 0x27, 0x62, 0x00, 0x52,
+  0x39, 0x18, 0x4d, 0x96, 0x4c, 0x19, 0x85, 0x24, 0x13, 0x9b, 0xf5, 0x1d, 0xca, 0x49, 0x21, 0xb3,
+  0x48, 0xf4, 0x72, 0xaa, 0xff, 0xe7, 0xb9, 0xde, 0x93, 0x8e, 0x07, 0x6d, 0xaa, 0x66, 0xf9, 0x4a,
+  0x7f, 0xe3, 0x03, 0x91, 0xa9, 0x6b, 0xd6, 0x6f, 0x7e, 0xd9, 0xd6, 0x7b, 0x16, 0xec, 0x65, 0x9f,
+  0xfc, 0x8e, 0x57, 0x15, 0x5d, 0xf2, 0x9f, 0xcf, 0xd2, 0xb1, 0x30, 0x75, 0x7d, 0x9a, 0xc2, 0xd1,
+  0xff, 0xf1, 0x37, 0xff, 0xf7, 0xd5, 0x78, 0x27, 0xe6, 0x3c, 0x92, 0x20, 0x27, 0x27, 0x94, 0xa7,
+  0x91, 0x2f, 0xae, 0x13, 0x2c, 0x1e, 0x3e, 0x0d, 0xae, 0x4f, 0x92, 0x80, 0x82, 0xb6, 0xa7, 0x42,
+  0x3d, 0xab, 0x58, 0x50, 0x47, 0xc9, 0xea, 0xd3, 0x44, 0xe4, 0x51, 0x12, 0xcf, 0x8a, 0x29, 0x9d,
+  0xe3, 0x07, 0xc1, 0x74, 0x48, 0xe1, 0x41, 0xf2, 0xd3, 0x04, 0x56, 0xd7, 0xa2, 0x04, 0xd5, 0x33,
+  0x86, 0xd3, 0x9a, 0x2f, 0x12, 0x31, 0x46, 0x72, 0xee, 0x53, 0x0c, 0x73, 0x0b, 0x04, 0xd2, 0x50,
+  0xc9, 0xd0, 0x5a, 0x0c, 0x7a, 0xdb, 0xe8, 0x4f, 0x07, 0xec, 0xb3, 0x42, 0x30, 0x09, 0xbb, 0x5c,
+  0xdd, 0xb5, 0x3e, 0xe7, 0x59, 0x15, 0x45, 0x16, 0x58, 0x1a, 0x47, 0xd6, 0xa4, 0xe1, 0xd4, 0x9a,
+  0xda, 0x2c, 0x96, 0x6c, 0xe1, 0xf0, 0x3b, 0x22, 0xbc, 0x13, 0xc1, 0xfb, 0x94, 0x0e, 0x74, 0x1a,
+  0xc0, 0xa9, 0x1b, 0x67, 0xca, 0x4a, 0x2e, 0x00, 0x71, 0xd7, 0xda, 0x08, 0xaf, 0xf1, 0x98, 0xef,
+  0x3c, 0xfc, 0x7b, 0x81, 0x58, 0x98, 0xdd, 0xbf, 0xc9, 0x54, 0x85, 0x7f, 0xc2, 0xe0, 0x67, 0xcf,
+  0x35, 0x74, 0xfa, 0xd5, 0xd7, 0x2a, 0x3b, 0xa7, 0x50, 0xa9, 0x99, 0xd3, 0x39, 0xc3, 0x5e, 0x3a,
+  0xb3, 0x99, 0x91, 0x91, 0x9a, 0x6c, 0x94, 0xa2, 0x69, 0xa5, 0x6c, 0x3e, 0x36, 0x53, 0x97, 0x67,
+  0x3f, 0x94, 0xab, 0xb6, 0xf0, 0xc6, 0xb2, 0x7a, 0xa7, 0xf2, 0x62, 0xf1, 0xff, 0xd7, 0x8b, 0xfd,
+  0xc6, 0xc6, 0x5e, 0xb3, 0x43, 0x28, 0x68, 0xa4, 0xe7, 0xdc, 0x77, 0x83, 0x39, 0x9c, 0x47, 0xf0,
+  0x2a, 0x11, 0x4e, 0xc4, 0x11, 0xc3, 0xfe, 0x4a, 0x32, 0x6e, 0x35, 0xd0, 0x56, 0x85, 0x7d, 0x56,
+  0x2b, 0xf0, 0x45, 0xae, 0x96, 0x29, 0xeb, 0x39, 0xa7, 0x4b, 0xce, 0x5e, 0x0b, 0xa7, 0x3b, 0xbd,
+  0x73, 0x41, 0xf1, 0x7c, 0x8e, 0x21, 0x9f, 0x30, 0x62, 0xa1, 0xd3, 0x27, 0xb7, 0xa6, 0xe5, 0x6a,
+  0xee, 0x48, 0x25, 0x4d, 0x37, 0x99, 0x7f, 0xba, 0x53, 0xeb, 0xb2, 0x05, 0x3b, 0xb2, 0x0a, 0x6c,
+  0x21, 0xc9, 0xd1, 0x6a, 0x92, 0xa3, 0x2c, 0xc9, 0x56, 0xbd, 0x59, 0x6f, 0xae, 0x43, 0x56, 0x15,
+  0xbf, 0x05, 0x9a, 0x85, 0x55, 0x72, 0x1d, 0x4e, 0xf5, 0x8d, 0x6a, 0x01, 0xd1, 0xa5, 0x25, 0x33,
+  0xed, 0xe5, 0xb6, 0xd6, 0xf4, 0xb1, 0x65, 0xad, 0xa6, 0x72, 0x0d, 0x4c, 0xf4, 0x54, 0x5e, 0xb5,
+  0x73, 0x70, 0x8f, 0xc5, 0xf6, 0x33, 0x75, 0xa9, 0xcc, 0xf5, 0x5d, 0xe6, 0xd2, 0xaa, 0x52, 0x7e,
+  0x61, 0x6e, 0x14, 0xea, 0xe6, 0xf2, 0x61, 0xc5, 0xcd, 0xc2, 0x23, 0x91, 0xec, 0x12, 0x79, 0x0c,
+  0x2a, 0xee, 0x82, 0x25, 0xb4, 0x75, 0x3b, 0x97, 0xd1, 0xb2, 0xae, 0x4a, 0x55, 0xeb, 0x76, 0xce,
+  0xa5, 0x0f, 0x78, 0x82, 0xbd, 0xa2, 0x62, 0x52, 0x1f, 0x79, 0x01, 0x10, 0xd3, 0x40, 0xa4, 0x41,
+  0x5e, 0xed, 0xed, 0xea, 0x88, 0x35, 0x73, 0xdf, 0xf6, 0xd5, 0x64, 0xda, 0xce, 0x4e, 0x82, 0x59,
+  0x54, 0x48, 0x60, 0x67, 0x6f, 0x11, 0x1f, 0xe7, 0x52, 0xf4, 0x29, 0xf7, 0x67, 0x60, 0xab, 0x22,
+  0x02, 0x7b, 0x0b, 0xe8, 0x7b, 0x12, 0x19, 0x9b, 0x49, 0x08, 0x29, 0x38, 0xf7, 0x61, 0x17, 0x59,
+  0x36, 0x49, 0x5f, 0x0a, 0x73, 0x48, 0x9a, 0x55, 0xb3, 0xf8, 0xb2, 0xaf, 0x04, 0x7c, 0x09, 0x89,
+  0x01, 0x07, 0xdb, 0x44, 0xc2, 0xa6, 0x41, 0x29, 0x81, 0xb4, 0x10, 0x00, 0xd4, 0xc5, 0xfc, 0xa1,
+  0x79, 0xaa, 0x8b, 0x60, 0x20, 0x22, 0xb0, 0x74, 0xa5, 0x5a, 0x0f, 0xa9, 0x3b, 0xc0, 0x94, 0x5e,
+  0x69, 0x03, 0x85, 0x26, 0x1c, 0x23, 0x0d, 0xac, 0xa9, 0xf3, 0x2b, 0x60, 0x0f, 0x16, 0xcd, 0xa1,
+  0xfc, 0x13, 0xbf, 0xd8, 0xd1, 0xb6, 0x40, 0xe6, 0xe5, 0x23, 0xe9, 0x91, 0x56, 0xb3, 0xbd, 0x5b,
+  0x35, 0x2c, 0xaa, 0x49, 0x64, 0x5f, 0x8e, 0x24, 0xf7, 0xf2, 0x08, 0x92, 0xc5, 0xd8, 0x7d, 0xd5,
+  0xd9, 0xdf, 0x4b, 0x90, 0xf4, 0x42, 0x43, 0x91, 0x02, 0xde, 0xce, 0xf9, 0x3d, 0x73, 0x2b, 0x6d,
+  0xc9, 0x36, 0xf9, 0xef, 0x71, 0x4a, 0x65, 0x11, 0x41, 0x51, 0xca, 0xe3, 0x5c, 0x21, 0x0e, 0xf8,
+  0x55, 0x15, 0xbc, 0xb1, 0xd7, 0xd0, 0x37, 0xe6, 0xbd, 0x86, 0xfc, 0x42, 0xbc, 0xd7, 0x90, 0xff,
+  0x49, 0x6c, 0xeb, 0xff, 0xdf, 0x72, 0x3f, 0xab, 0x35, 0x36, 0x00, 0x00
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "WiFiLink.h"
+
+// Settings changes asked for but not started yet
+enum WiFiLinkChange {
+  WIFI_CHANGE_NONE = 0,
+  WIFI_CHANGE_STATION,
+  WIFI_CHANGE_AP
+};
+
+static const char* STATE_NAMES[WIFI_LINK_STATE_COUNT] = {
+  "off", "connecting", "connected", "backoff", "ap", "trial"
+};
+
+static const char* TRIAL_RESULT_NAMES[WIFI_TRIAL_RESULT_COUNT] = {
+  "none", "pending", "ok", "failed"
+};
+
+static void copyString(char* out, const char* text, size_t size) {
+  strncpy(out, text ? text : "", size - 1);
+  out[size - 1] = '\0';
+}
+
+WiFiLink::WiFiLink() {
+  _gotIP = false;
+  _lostLink = false;
+  _ssid[0] = '\0';
+  _password[0] = '\0';
+  _state = WIFI_LINK_OFF;
+  _stateSince = 0;
+  _backoffMs = WIFI_BACKOFF_MIN_MS;
+  _down = false;
+  _downSince = 0;
+  _disconnectedMs = 0;
+  _attempts = 0;
+  _reconnects = 0;
+  _everConnected = false;
+  memset(&_cache, 0, sizeof(_cache));
+  _reuseLease = false;
+  _fastConnect = false;
+  _pending = WIFI_CHANGE_NONE;
+  _trialSsid[0] = '\0';
+  _trialPassword[0] = '\0';
+  _trialFrom = WIFI_LINK_OFF;
+  _trialResult = WIFI_TRIAL_NONE;
+  _commit = NULL;
+  _commitContext = NULL;
+}
+
+const char* WiFiLink::stateName(uint8_t state) {
+  return state < WIFI_LINK_STATE_COUNT ? STATE_NAMES[state] : "unknown";
+}
+
+const char* WiFiLink::trialResultName(uint8_t result) {
+  return result < WIFI_TRIAL_RESULT_COUNT ? TRIAL_RESULT_NAMES[result] : "unknown";
+}
+
+void WiFiLink::enter(uint8_t state) {
+  _state = state;
+  _stateSince = millis();
+}
+
+void WiFiLink::setCommitHandler(WiFiCommitFn commit, void* context) {
+  _commit = commit;
+  _commitContext = context;
+}
+
+void WiFiLink::prepareStation() {
+  // Handlers run in the SDK's event context, they only leave a note for service()
+  if (!_gotIPHandler) {
+    _gotIPHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP&) {
+      _gotIP = true;
+    });
+    _disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected&) {
+      _lostLink = true;
+    });
+  }
+
+  // Retries are timed here, not by the SDK
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+}
+
+void WiFiLink::begin(const char* ssid, const char* password,
+                     const WiFiLinkCache* cache, bool reuseLease) {
+  copyString(_ssid, ssid, sizeof(_ssid));
+  copyString(_password, password, sizeof(_password));
+  if (cache) {
+    _cache = *cache;
+  }
+  _reuseLease = reuseLease;
+
+  prepareStation();
+  WiFi.mode(WIFI_STA);
+
+  linkDown();
+  connect();
+}
+
+void WiFiLink::startAccessPoint() {
+  if (_down) {
+    _disconnectedMs += millis() - _downSince;
+    _down = false;
+  }
+
+  WiFi.disconnect();
+  WiFi.mode(WIFI_AP);
+  WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASSWORD);
+  enter(WIFI_LINK_AP);
+
+  Serial.print("AP IP address: ");
+  Serial.println(WiFi.softAPIP());
+}
+
+void WiFiLink::connect() {
+  _gotIP = false;
+  _lostLink = false;
+  _attempts++;
+
+  _fastConnect = _cache.channel != 0;
+  if (_fastConnect && _reuseLease && _cache.ip) {
+    WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway), IPAddress(_cache.mask), IPAddress(_cache.dns));
+  } else {
+    WiFi.config(0U, 0U, 0U);
+  }
+
+  // With the channel and BSSID known the SDK associates without scanning
+  if (_fastConnect) {
+    WiFi.begin(_ssid, _password, _cache.channel, _cache.bssid, true);
+  } else {
+    WiFi.begin(_ssid, _password);
+  }
+  enter(WIFI_LINK_CONNECTING);
+}
+
+void WiFiLink::linkDown() {
+  if (!_down) {
+    _down = true;
+    _downSince = millis();
+  }
+}
+
+void WiFiLink::linkUp() {
+  if (_down) {
+    _disconnectedMs += millis() - _downSince;
+    _down = false;
+  }
+  if (_everConnected) {
+    _reconnects++;
+  }
+  _everConnected = true;
+  _backoffMs = WIFI_BACKOFF_MIN_MS;
+  enter(WIFI_LINK_CONNECTED);
+
+  memcpy(_cache.bssid, WiFi.BSSID(), sizeof(_cache.bssid));
+  _cache.channel = WiFi.channel();
+  _cache.ip = WiFi.localIP();
+  _cache.gateway = WiFi.gatewayIP();
+  _cache.mask = WiFi.subnetMask();
+  _cache.dns = WiFi.dnsIP(0);
+
+  Serial.print("WiFi connected, IP address: ");
+  Serial.println(WiFi.localIP());
+}
+
+bool WiFiLink::requestStation(const char* ssid, const char* password) {
+  if (_pending != WIFI_CHANGE_NONE || _state == WIFI_LINK_TRIAL) {
+    return false;
+  }
+  copyString(_trialSsid, ssid, sizeof(_trialSsid));
+  copyString(_trialPassword, password, sizeof(_trialPassword));
+  _pending = WIFI_CHANGE_STATION;
+  _trialResult = WIFI_TRIAL_PENDING;
+  return true;
+}
+
+bool WiFiLink::requestAccessPoint(const char* ssid, const char* password) {
+  if (_pending != WIFI_CHANGE_NONE || _state == WIFI_LINK_TRIAL) {
+    return false;
+  }
+  copyString(_trialSsid, ssid, sizeof(_trialSsid));
+  copyString(_trialPassword, password, sizeof(_trialPassword));
+  _pending = WIFI_CHANGE_AP;
+  _trialResult = WIFI_TRIAL_PENDING;
+  return true;
+}
+
+void WiFiLink::startChange() {
+  uint8_t change = _pending;
+  _pending = WIFI_CHANGE_NONE;
+
+  // The own access point cannot fail, it is committed right away; after a
+  // boot in AP mode _ssid is empty, the station settings come with the request
+  if (change == WIFI_CHANGE_AP) {
+    startAccessPoint();
+    copyString(_ssid, _trialSsid, sizeof(_ssid));
+    copyString(_password, _trialPassword, sizeof(_password));
+    _trialResult = WIFI_TRIAL_OK;
+    if (_commit) {
+      _commit(_commitContext, _ssid, _password, true);
+    }
+    return;
+  }
+
+  Serial.printf("Trying WiFi network %s\n", _trialSsid);
+  _trialFrom = _state;
+  prepareStation();
+  if (_state == WIFI_LINK_AP) {
+    // Clients on the access point keep it while the station is tried
+    WiFi.mode(WIFI_AP_STA);
+  } else {
+    WiFi.disconnect();
+    linkDown();
+  }
+
+  _gotIP = false;
+  _lostLink = false;
+  _attempts++;
+  WiFi.config(0U, 0U, 0U);
+  WiFi.begin(_trialSsid, _trialPassword);
+  enter(WIFI_LINK_TRIAL);
+}
+
+void WiFiLink::serviceTrial(uint32_t elapsed) {
+  if (_gotIP && WiFi.status() == WL_CONNECTED) {
+    if (_trialFrom == WIFI_LINK_AP) {
+      WiFi.softAPdisconnect(true);
+      WiFi.mode(WIFI_STA);
+    }
+    copyString(_ssid, _trialSsid, sizeof(_ssid));
+    copyString(_password, _trialPassword, sizeof(_password));
+    memset(&_cache, 0, sizeof(_cache));
+    _trialResult = WIFI_TRIAL_OK;
+    linkUp();
+    if (_commit) {
+      _commit(_commitContext, _ssid, _password, false);
+    }
+    return;
+  }
+
+  if (elapsed < WIFI_CONNECT_TIMEOUT_MS) {
+    return;
+  }
+
+  // Nothing was stored yet, going back is only a matter of the radio
+  Serial.println("New WiFi settings failed, restoring the previous link");
+  _trialResult = WIFI_TRIAL_FAILED;
+  WiFi.disconnect();
+  if (_trialFrom == WIFI_LINK_AP) {
+    WiFi.mode(WIFI_AP);
+    enter(WIFI_LINK_AP);
+  } else {
+    connect();
+  }
+}
+
+bool WiFiLink::service() {
+  uint8_t previous = _state;
+
+  if (_pending != WIFI_CHANGE_NONE) {
+    startChange();
+  }
+
+  uint32_t elapsed = millis() - _stateSince;
+
+  switch (_state) {
+    case WIFI_LINK_CONNECTING:
+      // Disconnect events during an attempt are the SDK retrying, only the
+      // address or the timeout end it
+      if (_gotIP && WiFi.status() == WL_CONNECTED) {
+        linkUp();
+      } else if (_fastConnect && elapsed >= WIFI_FAST_CONNECT_TIMEOUT_MS) {
+        // The access point moved or the lease went elsewhere, scan normally
+        Serial.println("WiFi fast connect failed, scanning");
+        memset(&_cache, 0, sizeof(_cache));
+        WiFi.disconnect();
+        connect();
+      } else if (elapsed >= WIFI_CONNECT_TIMEOUT_MS) {
+        WiFi.disconnect();
+        if (!_everConnected) {
+          Serial.println("WiFi connection failed");
+          startAccessPoint();
+        } else {
+          Serial.printf("WiFi attempt failed, retry in %lus\n", (unsigned long)(_backoffMs / 1000));
+          enter(WIFI_LINK_BACKOFF);
+        }
+      }
+      break;
+
+    case WIFI_LINK_CONNECTED:
+      if (_lostLink || WiFi.status() != WL_CONNECTED) {
+        Serial.println("WiFi disconnected");
+        linkDown();
+        _backoffMs = WIFI_BACKOFF_MIN_MS;
+        enter(WIFI_LINK_BACKOFF);
+      }
+      break;
+
+    case WIFI_LINK_BACKOFF:
+      if (elapsed >= _backoffMs) {
+        _backoffMs = min(_backoffMs * 2, (uint32_t)WIFI_BACKOFF_MAX_MS);
+        connect();
+      }
+      break;
+
+    case WIFI_LINK_TRIAL:
+      serviceTrial(elapsed);
+      break;
+  }
+
+  _lostLink = false;
+  return _state != previous;
+}
+
+uint32_t WiFiLink::getRetryInMs() {
+  if (_state != WIFI_LINK_BACKOFF) {
+    return 0;
+  }
+  uint32_t elapsed = millis() - _stateSince;
+  return elapsed < _backoffMs ? _backoffMs - elapsed : 0;
+}
+
+uint64_t WiFiLink::getDisconnectedMs() {
+  return _disconnectedMs + (_down ? millis() - _downSince : 0);
+}
\ No newline at end of file
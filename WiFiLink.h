@@ -0,0 +1,141 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+// Station link kept up from loop() without ever waiting on it
+//
+// WiFi events only set flags, service() acts on them: a lost link is retried
+// after a backoff that doubles per failed attempt, up to WIFI_BACKOFF_MAX_MS.
+// IR work, serial and the web server keep running in between. If the very
+// first connection after boot fails, the own access point is opened instead,
+// as before, so a device with wrong credentials stays reachable.
+//
+// The association of the last link (BSSID, channel and DHCP lease) can be
+// handed in from storage: the first attempt then skips the channel scan and,
+// with reuseLease, DHCP as well. An attempt with a stale cache gives up after
+// WIFI_FAST_CONNECT_TIMEOUT_MS and is followed at once by a normal one.
+//
+// New settings are applied at runtime. Station credentials are tried first
+// and only handed to the commit handler once they gave an address; if they
+// fail, the previous link is restored. Coming from the access point, the AP
+// stays up during the trial. The radio holds one station association only,
+// so a station to station change drops the old link while trying.
+
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+#define WIFI_SSID_LENGTH 32
+#define WIFI_PASSWORD_LENGTH 64
+#define WIFI_AP_SSID "ESLBlaster"
+#define WIFI_AP_PASSWORD "password"
+
+enum WiFiLinkState {
+  WIFI_LINK_OFF = 0,
+  WIFI_LINK_CONNECTING,   // Association and DHCP in progress
+  WIFI_LINK_CONNECTED,
+  WIFI_LINK_BACKOFF,      // Waiting before the next attempt
+  WIFI_LINK_AP,           // Own access point
+  WIFI_LINK_TRIAL,        // Trying new settings, rolled back on failure
+  WIFI_LINK_STATE_COUNT
+};
+
+enum WiFiTrialResult {
+  WIFI_TRIAL_NONE = 0,
+  WIFI_TRIAL_PENDING,
+  WIFI_TRIAL_OK,
+  WIFI_TRIAL_FAILED,
+  WIFI_TRIAL_RESULT_COUNT
+};
+
+struct WiFiLinkCache {
+  uint8_t bssid[6];
+  uint8_t channel;          // 0 = cache not valid
+  uint32_t ip;              // Lease of the last link, in network byte order
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+};
+
+// Settings that proved to work, for the caller to store
+typedef void (*WiFiCommitFn)(void* context, const char* ssid, const char* password, bool apMode);
+
+class WiFiLink {
+  public:
+    WiFiLink();
+
+    // Start connecting and return, service() takes it from there; cache is
+    // the association of an earlier link to the same network, or NULL
+    void begin(const char* ssid, const char* password,
+               const WiFiLinkCache* cache = NULL, bool reuseLease = false);
+    void startAccessPoint();
+
+    // Advance the state machine, never blocks; true when the state changed
+    bool service();
+
+    // Changes start on the next service(), after the request asking for them
+    // has been answered; false while another change is still being tried.
+    // The access point commits ssid and password as the station settings to
+    // return to, they are not tried
+    bool requestStation(const char* ssid, const char* password);
+    bool requestAccessPoint(const char* ssid, const char* password);
+    void setCommitHandler(WiFiCommitFn commit, void* context);
+    void setReuseLease(bool reuseLease) { _reuseLease = reuseLease; }
+
+    uint8_t getState() { return _state; }
+    bool isConnected() { return _state == WIFI_LINK_CONNECTED; }
+    // Outcome of the last settings change
+    uint8_t getTrialResult() { return _trialResult; }
+    // Milliseconds until the next attempt while backing off
+    uint32_t getRetryInMs();
+    // Station time without a link since boot, including the current outage
+    uint64_t getDisconnectedMs();
+    uint32_t getAttempts() { return _attempts; }
+    uint32_t getReconnects() { return _reconnects; }
+    // Association of the current link, worth storing for the next boot
+    const WiFiLinkCache& getCache() { return _cache; }
+
+    static const char* stateName(uint8_t state);
+    static const char* trialResultName(uint8_t result);
+
+  private:
+    WiFiEventHandler _gotIPHandler;
+    WiFiEventHandler _disconnectedHandler;
+    volatile bool _gotIP;          // Set from the WiFi event callbacks
+    volatile bool _lostLink;
+    char _ssid[WIFI_SSID_LENGTH + 1];
+    char _password[WIFI_PASSWORD_LENGTH + 1];
+    uint8_t _state;
+    uint32_t _stateSince;          // millis() when the current state was entered
+    uint32_t _backoffMs;
+    bool _down;                    // Station wanted but without a link
+    uint32_t _downSince;
+    uint64_t _disconnectedMs;      // Closed outages
+    uint32_t _attempts;
+    uint32_t _reconnects;          // Links restored after a drop
+    bool _everConnected;
+    WiFiLinkCache _cache;
+    bool _reuseLease;
+    bool _fastConnect;             // Current attempt uses the cache
+
+    // Settings change waiting for service(), and the one being tried
+    uint8_t _pending;
+    char _trialSsid[WIFI_SSID_LENGTH + 1];
+    char _trialPassword[WIFI_PASSWORD_LENGTH + 1];
+    uint8_t _trialFrom;            // State to roll back to
+    uint8_t _trialResult;
+    WiFiCommitFn _commit;
+    void* _commitContext;
+
+    void enter(uint8_t state);
+    void prepareStation();
+    void connect();
+    void linkDown();
+    void linkUp();
+    void startChange();
+    void serviceTrial(uint32_t elapsed);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+// decodeHex against the parser it replaced, on the input shapes the web
+// interface gets: plain hex, spaced bytes and "0x12, 0x34" lists
+
+#include "HexDecode.h"
+#include "check.h"
+#include <string>
+#include <string.h>
+#include <chrono>
+
+#define BENCH_BYTES 240
+#define BENCH_ROUNDS 50000
+#define BENCH_REPEATS 7        // The fastest run counts, the rest is noise
+
+// The former WebInterface::parseHexString with Arduino's String swapped for
+// std::string: the argument is copied, then trimmed and stripped of each
+// separator in turn before the pairs are converted
+static void removeAll(std::string& text, const char* token) {
+  size_t length = strlen(token);
+  size_t at = 0;
+  while ((at = text.find(token, at)) != std::string::npos) {
+    text.erase(at, length);
+  }
+}
+
+static bool oldParseHex(std::string hexString, uint8_t* buffer, uint16_t maxLength, uint16_t* actualLength) {
+  size_t first = hexString.find_first_not_of(" \t\r\n");
+  size_t last = hexString.find_last_not_of(" \t\r\n");
+  hexString = first == std::string::npos ? "" : hexString.substr(first, last - first + 1);
+  removeAll(hexString, " ");
+  removeAll(hexString, "\n");
+  removeAll(hexString, "\r");
+  removeAll(hexString, ",");
+  removeAll(hexString, "0x");
+  removeAll(hexString, "0X");
+
+  if (hexString.length() % 2 != 0 || hexString.length() / 2 > maxLength) {
+    return false;
+  }
+  *actualLength = hexString.length() / 2;
+
+  for (uint16_t i = 0; i < *actualLength; i++) {
+    uint8_t nibbles[2];
+    for (int n = 0; n < 2; n++) {
+      char c = hexString[i * 2 + n];
+      if (c >= '0' && c <= '9') {
+        nibbles[n] = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        nibbles[n] = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        nibbles[n] = c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    buffer[i] = (nibbles[0] << 4) | nibbles[1];
+  }
+  return true;
+}
+
+static std::string format(const uint8_t* data, const char* byteFormat) {
+  std::string text;
+  char part[8];
+  for (int i = 0; i < BENCH_BYTES; i++) {
+    snprintf(part, sizeof(part), byteFormat, data[i]);
+    text += part;
+  }
+  return text;
+}
+
+static double nsPerCall(std::chrono::steady_clock::duration elapsed) {
+  return std::chrono::duration<double, std::nano>(elapsed).count() / BENCH_ROUNDS;
+}
+
+int main() {
+  uint8_t data[BENCH_BYTES];
+  for (int i = 0; i < BENCH_BYTES; i++) {
+    data[i] = (uint8_t)(i * 37 + 11);
+  }
+
+  struct Shape {
+    const char* name;
+    std::string text;
+  } shapes[] = {
+    { "plain", format(data, "%02x") },
+    { "spaced", format(data, "%02X ") },
+    { "0x list", format(data, "0x%02x, ") },
+  };
+
+  printf("%-8s %6s %12s %12s %8s\n", "input", "chars", "old ns", "new ns", "speedup");
+  for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+    const std::string& text = shapes[s].text;
+    uint8_t out[BENCH_BYTES];
+    uint16_t length = 0;
+    uint32_t sink = 0;
+
+    // Both give the same bytes before anything is timed
+    CHECK(oldParseHex(text, out, BENCH_BYTES, &length) && length == BENCH_BYTES);
+    CHECK(memcmp(out, data, BENCH_BYTES) == 0);
+    memset(out, 0, sizeof(out));
+    CHECK(decodeHex(text.c_str(), text.length(), out, BENCH_BYTES, &length) && length == BENCH_BYTES);
+    CHECK(memcmp(out, data, BENCH_BYTES) == 0);
+
+    double oldNs = 0;
+    double newNs = 0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < BENCH_ROUNDS; r++) {
+        oldParseHex(text, out, BENCH_BYTES, &length);
+        sink += out[r % BENCH_BYTES];
+      }
+      double ns = nsPerCall(std::chrono::steady_clock::now() - start);
+      oldNs = repeat == 0 || ns < oldNs ? ns : oldNs;
+
+      start = std::chrono::steady_clock::now();
+      for (int r = 0; r < BENCH_ROUNDS; r++) {
+        decodeHex(text.c_str(), text.length(), out, BENCH_BYTES, &length);
+        sink += out[r % BENCH_BYTES];
+      }
+      ns = nsPerCall(std::chrono::steady_clock::now() - start);
+      newNs = repeat == 0 || ns < newNs ? ns : newNs;
+    }
+
+    printf("%-8s %6u %12.0f %12.0f %7.1fx\n", shapes[s].name, (unsigned)text.length(), oldNs, newNs,
+           oldNs / newNs);
+    CHECK(sink != 0xFFFFFFFF);
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+// Arena under a long mix of requests shaped like the image pipeline's
+//
+// Each request replays the allocations of /transmit-image (processImage, then
+// transmitImage) or of a multi-channel ping, in the same order and scopes.
+// Images are admitted with the sizing of WebInterface::imageMemoryNeeded.
+// Admitted requests must never see a failed allocation, every request must
+// leave the arena empty, and the high-water mark must end up at the largest
+// request's peak without growing past it. The process heap is not touched.
+
+#include "Arena.h"
+#include "check.h"
+#include <string.h>
+#include <new>
+
+#define ARENA_SIZE 24576    // IMAGE_ARENA_SIZE of the sketch
+#define REQUESTS 20000
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* memory = malloc(size ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  free(memory);
+}
+
+static uint8_t memory[ARENA_SIZE + 4] __attribute__((aligned(4)));
+// Handed over off the alignment, the arena skips to the next boundary
+static Arena arena(memory + 1, ARENA_SIZE + 3);
+static size_t peak;
+
+static uint32_t state = 7;
+
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+static uint8_t* take(size_t size) {
+  uint8_t* block = (uint8_t*)arena.allocate(size);
+  if (block) {
+    CHECK(((uintptr_t)block & (ARENA_ALIGN - 1)) == 0);
+    // Scribble over the block, overlapping blocks would corrupt each other
+    memset(block, (uint8_t)size, size);
+    if (arena.getUsed() > peak) {
+      peak = arena.getUsed();
+    }
+  }
+  return block;
+}
+
+static size_t imageMemoryNeeded(uint16_t width, uint16_t height, uint16_t bpp, bool colorMode) {
+  uint32_t pixelCount = (uint32_t)width * height;
+  uint32_t rowSize = ((width * bpp + 31) / 32) * 4;
+  size_t packed = Arena::footprint((pixelCount + 7) / 8 * (colorMode ? 2 : 1));
+  size_t decode = Arena::footprint(pixelCount) + Arena::footprint(rowSize);
+  size_t transmit = Arena::footprint(pixelCount * (colorMode ? 2 : 1)) + Arena::footprint(pixelCount * 2);
+  return packed + (decode > transmit ? decode : transmit);
+}
+
+// processImage and transmitImage, false if an allocation failed
+static bool imageRequest(uint16_t width, uint16_t height, uint16_t bpp, bool colorMode) {
+  ArenaScope scope(arena);
+  uint32_t pixelCount = (uint32_t)width * height;
+  uint32_t rowSize = ((width * bpp + 31) / 32) * 4;
+
+  uint8_t* packed = take((pixelCount + 7) / 8 * (colorMode ? 2 : 1));
+  if (!packed) {
+    return false;
+  }
+  {
+    ArenaScope scratch(arena);
+    if (!take(pixelCount) || !take(rowSize)) {
+      return false;
+    }
+  }
+
+  // The packed image must have survived the scratch scope untouched
+  uint8_t fill = (uint8_t)((pixelCount + 7) / 8 * (colorMode ? 2 : 1));
+  CHECK(packed[0] == fill);
+
+  ArenaScope scratch(arena);
+  return take(pixelCount * (colorMode ? 2 : 1)) && take(pixelCount * 2);
+}
+
+// makePingFrames: one 256 byte frame per channel
+static bool pingRequest(uint8_t channels) {
+  ArenaScope scratch(arena);
+  return take(channels * 256) != NULL;
+}
+
+int main() {
+  CHECK(arena.getSize() == ARENA_SIZE);
+
+  size_t largestPeak = 0;
+  unsigned long admitted = 0;
+  unsigned long refused = 0;
+  unsigned long pings = 0;
+  unsigned long lastGrowth = 0;
+
+  for (unsigned long r = 1; r <= REQUESTS; r++) {
+    peak = 0;
+    uint32_t failures = arena.getFailures();
+
+    if (random32() % 4 == 0) {
+      CHECK(pingRequest(1 + random32() % 4));
+      pings++;
+    } else {
+      // Sizes from a small tag up to well past what fits
+      uint16_t width = 8 * (1 + random32() % 40);
+      uint16_t height = 1 + random32() % 160;
+      uint16_t bpp = (random32() & 1) ? 24 : 8;
+      bool colorMode = random32() % 3 == 0;
+      // Refused with 413 before anything is allocated
+      if ((uint32_t)width * height > 0xFFFF || imageMemoryNeeded(width, height, bpp, colorMode) > arena.getSize()) {
+        refused++;
+      } else {
+        CHECK(imageRequest(width, height, bpp, colorMode));
+        // Admission asks for exactly what the pipeline takes at its peak
+        CHECK(peak == imageMemoryNeeded(width, height, bpp, colorMode));
+        admitted++;
+      }
+    }
+
+    CHECK(arena.getFailures() == failures);
+    CHECK(arena.getUsed() == 0);
+    if (peak > largestPeak) {
+      largestPeak = peak;
+      lastGrowth = r;
+    }
+    CHECK(arena.getHighWater() == largestPeak);
+
+    if (r % (REQUESTS / 10) == 0) {
+      printf("request %5lu  high water %5zu of %u  last growth at %lu\n",
+             r, arena.getHighWater(), (unsigned)arena.getSize(), lastGrowth);
+    }
+  }
+
+  // Requests that would not fit fail cleanly and leave the arena as it was
+  size_t highWater = arena.getHighWater();
+  CHECK(!imageRequest(320, 200, 24, true));
+  CHECK(arena.getUsed() == 0 && arena.getHighWater() >= highWater);
+  CHECK(arena.getFailures() == 1);
+
+  CHECK(allocations == 0);
+  printf("ok, %lu images, %lu refused, %lu pings\n", admitted, refused, pings);
+  return 0;
+}
\ No newline at end of file
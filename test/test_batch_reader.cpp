@@ -0,0 +1,188 @@
+// BatchReader on good and bad /batch bodies: every bad body must end in an
+// error at the right operation without reading past the text
+
+#include "BatchReader.h"
+#include "check.h"
+#include <string.h>
+#include <string>
+
+#define BARCODE "04123456789012345"
+#define BITMAP "0102030405060708090A0B0C0D0E0F1011121314151617"
+
+static const char* GOOD =
+  "[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\",\"repeat\":400},\n"
+  " {\"op\":\"raw\",\"barcode\":\"" BARCODE "\",\"type\":\"SEG\",\"data\":\"85 AB,0x00\",\"repeat\":10},\n"
+  " {\"op\":\"segments\",\"barcode\":\"" BARCODE "\",\"bitmap\":\"" BITMAP "\"},\n"
+  " { \"pp4\" : true , \"op\" : \"refresh\" , \"barcode\" : \"" BARCODE "\" }]\n";
+
+// Reads the whole body from an exact-size copy, no terminator behind it;
+// returns the error, NULL for a good body
+static const char* readAll(const std::string& body, uint16_t* count) {
+  char* text = (char*)malloc(body.size() ? body.size() : 1);
+  memcpy(text, body.data(), body.size());
+  BatchReader reader(text, body.size());
+  BatchOp op;
+  while (reader.next(&op)) {
+  }
+  CHECK(!reader.next(&op));
+  *count = reader.getIndex();
+  const char* error = reader.getError();
+  free(text);
+  return error;
+}
+
+static void expectError(const std::string& body, const char* error, uint16_t index) {
+  uint16_t count;
+  const char* actual = readAll(body, &count);
+  if (!actual || strcmp(actual, error) != 0 || count != index) {
+    fprintf(stderr, "%s\n  gave %s at %u\n", body.c_str(), actual ? actual : "no error", count);
+  }
+  CHECK(actual && strcmp(actual, error) == 0);
+  CHECK(count == index);
+}
+
+static std::string single(const std::string& fields) {
+  return "[{" + fields + "}]";
+}
+
+static void testGood() {
+  BatchReader reader(GOOD, strlen(GOOD));
+  BatchOp op;
+
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    CHECK(reader.next(&op));
+    CHECK(op.type == BATCH_OP_PING && strcmp(op.barcode, BARCODE) == 0);
+    CHECK(op.repeats == 400 && !op.forcePP4);
+
+    CHECK(reader.next(&op));
+    CHECK(op.type == BATCH_OP_RAW && op.segmentType && op.repeats == 10);
+    CHECK(op.dataSize == 3 && op.data[0] == 0x85 && op.data[1] == 0xAB && op.data[2] == 0x00);
+
+    CHECK(reader.next(&op));
+    CHECK(op.type == BATCH_OP_SEGMENTS && op.dataSize == BATCH_BITMAP_SIZE);
+    CHECK(op.data[0] == 0x01 && op.data[BATCH_BITMAP_SIZE - 1] == 0x17);
+
+    CHECK(reader.next(&op));
+    CHECK(op.type == BATCH_OP_REFRESH && op.forcePP4 && op.repeats == 0);
+
+    CHECK(!reader.next(&op));
+    CHECK(!reader.getError() && reader.getIndex() == 4);
+
+    // The second pass of handleBatch sees the same operations
+    reader.rewind();
+  }
+
+  uint16_t count;
+  CHECK(!readAll("[]", &count) && count == 0);
+  CHECK(!readAll(" \r\n[ \t]\n", &count) && count == 0);
+  CHECK(!readAll(single("\"op\":\"raw\",\"barcode\":\"" BARCODE "\",\"type\":\"DM\",\"data\":\"00\",\"repeat\":65535"),
+                 &count) && count == 1);
+}
+
+// Every cut of a good body is an error, none reads past the end
+static void testTruncated() {
+  std::string body = GOOD;
+  size_t end = body.find_last_of(']') + 1;
+  for (size_t length = 0; length < end; length++) {
+    uint16_t count;
+    const char* error = readAll(body.substr(0, length), &count);
+    CHECK(error != NULL);
+    CHECK(count <= 4);
+  }
+
+  expectError("", "Body must be a JSON array", 0);
+  expectError("[", "Operation must be an object", 0);
+  expectError("[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\"}", "Expected , or ] after an operation", 1);
+  expectError("[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\"},", "Operation must be an object", 1);
+  expectError("[{\"op\":\"ping\",\"barcode\":\"0412345", "barcode must be 17 characters", 0);
+  expectError("[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\",\"repeat\":", "repeat must be between 1 and 65535", 0);
+}
+
+static void testNested() {
+  expectError("[[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\"}]]", "Operation must be an object", 0);
+  expectError("{\"op\":\"ping\",\"barcode\":\"" BARCODE "\"}", "Body must be a JSON array", 0);
+  expectError(single("\"op\":{\"name\":\"ping\"},\"barcode\":\"" BARCODE "\""), "op must be a string", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\":[\"" BARCODE "\"]"), "barcode must be 17 characters", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\":\"" BARCODE "\",\"pp4\":{\"value\":true}"), "pp4 must be true or false", 0);
+  expectError(single("\"op\":\"raw\",\"barcode\":\"" BARCODE "\",\"type\":\"DM\",\"data\":[\"85\"],\"repeat\":1"),
+              "data must be 1 to 240 bytes of hex", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\":\"" BARCODE "\",\"extra\":{}"), "Unknown field", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\":\"" BARCODE "\"}{"), "Expected , or ] after an operation", 1);
+  expectError("[{\"op\":\"ping\",\"barcode\":\"" BARCODE "\"}] []", "Data after the array", 1);
+}
+
+static std::string rawWithData(const std::string& data) {
+  return single("\"op\":\"raw\",\"barcode\":\"" BARCODE "\",\"type\":\"DM\",\"data\":\"" + data + "\",\"repeat\":1");
+}
+
+static void testData() {
+  // BATCH_MAX_DATA bytes fit, one more does not, with or without separators
+  std::string hex;
+  std::string spaced;
+  for (uint16_t i = 0; i < BATCH_MAX_DATA; i++) {
+    hex += "A5";
+    spaced += i ? " 0xA5" : "0xA5";
+  }
+  uint16_t count;
+  CHECK(!readAll(rawWithData(hex), &count) && count == 1);
+  CHECK(!readAll(rawWithData(spaced), &count) && count == 1);
+  expectError(rawWithData(hex + "00"), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData(spaced + " 00"), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData(""), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData(" , "), "data must be 1 to 240 bytes of hex", 0);
+
+  // Bad hex
+  expectError(rawWithData("85A"), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData("8G"), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData("85-AB"), "data must be 1 to 240 bytes of hex", 0);
+  expectError(rawWithData("85\\u0041B"), "data must be 1 to 240 bytes of hex", 0);
+
+  // The bitmap is exactly BATCH_BITMAP_SIZE bytes
+  std::string segments = "\"op\":\"segments\",\"barcode\":\"" BARCODE "\",\"bitmap\":\"";
+  expectError(single(segments + std::string(BITMAP).substr(2) + "\""), "bitmap must be exactly 46 hex digits", 0);
+  expectError(single(segments + BITMAP "00\""), "bitmap must be exactly 46 hex digits", 0);
+  expectError(single(segments + std::string(BITMAP).substr(1) + "\""), "bitmap must be exactly 46 hex digits", 0);
+}
+
+static void testFields() {
+  std::string ping = "\"op\":\"ping\",\"barcode\":\"" BARCODE "\"";
+  expectError(single(ping + ",\"repeat\":0"), "repeat must be between 1 and 65535", 0);
+  expectError(single(ping + ",\"repeat\":65536"), "repeat must be between 1 and 65535", 0);
+  expectError(single(ping + ",\"repeat\":99999999999999999999"), "repeat must be between 1 and 65535", 0);
+  expectError(single(ping + ",\"repeat\":4294967696"), "repeat must be between 1 and 65535", 0);
+  expectError(single(ping + ",\"repeat\":-1"), "repeat must be between 1 and 65535", 0);
+  expectError(single(ping + ",\"pp4\":1"), "pp4 must be true or false", 0);
+  expectError(single("\"op\":\"blink\",\"barcode\":\"" BARCODE "\""), "op must be ping, refresh, raw or segments", 0);
+  expectError(single("\"barcode\":\"" BARCODE "\""), "Missing op", 0);
+  expectError("[{}]", "Missing op", 0);
+  expectError(single("\"op\":\"ping\""), "Missing field for this op", 0);
+  expectError(single("\"op\":\"refresh\",\"barcode\":\"" BARCODE "\",\"repeat\":3"), "Field not valid for this op", 0);
+  expectError(single("\"op\":\"raw\",\"barcode\":\"" BARCODE "\",\"type\":\"IR\",\"data\":\"00\",\"repeat\":1"),
+              "type must be DM or SEG", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\":\"0412345678901234\\\"\""), "barcode must be 17 characters", 0);
+  expectError(single("\"op\":\"ping\",\"bar\\u0063ode\":\"" BARCODE "\""), "Malformed field", 0);
+  expectError(single("\"op\":\"ping\",\"barcode\" \"" BARCODE "\""), "Malformed field", 0);
+  expectError(single("\"op\":\"ping\" \"barcode\":\"" BARCODE "\""), "Expected , or } in an operation", 0);
+}
+
+// BATCH_MAX_OPS operations are fine, the one after them is refused
+static void testTooMany() {
+  std::string body = "[";
+  for (uint16_t i = 0; i < BATCH_MAX_OPS; i++) {
+    body += i ? ",{\"op\":\"refresh\",\"barcode\":\"" BARCODE "\"}" : "{\"op\":\"refresh\",\"barcode\":\"" BARCODE "\"}";
+  }
+  uint16_t count;
+  CHECK(!readAll(body + "]", &count) && count == BATCH_MAX_OPS);
+  expectError(body + ",{\"op\":\"refresh\",\"barcode\":\"" BARCODE "\"}]", "Too many operations", BATCH_MAX_OPS);
+}
+
+int main() {
+  testGood();
+  testTruncated();
+  testNested();
+  testData();
+  testFields();
+  testTooMany();
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
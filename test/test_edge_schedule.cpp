@@ -0,0 +1,148 @@
+// Merged multi-channel edge schedules against the nominal symbol timings
+
+#include "EdgeSchedule.h"
+#include "check.h"
+
+static void testTiming() {
+  // 48 carrier periods of 800ns come closest to the nominal 39us
+  CHECK(IR_BURST_ON_NS == 38400);
+  CHECK(IR_BURST_US * 1000 - IR_BURST_ON_NS < 1000000 / IR_CARRIER_KHZ);
+}
+
+static void testSingleChannel() {
+  // Symbols 0, 1, 2, 3 and the final burst
+  static const uint8_t data[] = { 0x1B };
+  static const uint32_t starts[] = { 0, 94400, 369800, 525200, 741600 };
+  ChannelFrame frame = { data, 1, 0 };
+
+  EdgeMerger merger;
+  merger.begin(&frame, 1);
+  ScheduleEdge edge;
+  for (uint8_t b = 0; b < 5; b++) {
+    CHECK(merger.next(&edge));
+    CHECK(edge.timeNs == starts[b] && edge.mask == 1);
+    CHECK(merger.next(&edge));
+    CHECK(edge.timeNs == starts[b] + 38400 && edge.mask == 0);
+  }
+  CHECK(!merger.next(&edge));
+  CHECK(verifyMergedSchedule(&frame, 1));
+}
+
+static void testSharedEdges() {
+  // The same frame on two channels at once switches both in every edge
+  static const uint8_t data[] = { 0x85, 0x12 };
+  ChannelFrame frames[2] = { { data, 2, 0 }, { data, 2, 0 } };
+
+  EdgeMerger merger;
+  merger.begin(frames, 2);
+  ScheduleEdge edge;
+  int edges = 0;
+  while (merger.next(&edge)) {
+    CHECK(edge.mask == ((edges & 1) ? 0 : 3));
+    edges++;
+  }
+  CHECK(edges == 2 * (2 * 4 + 1));
+  CHECK(verifyMergedSchedule(frames, 2));
+}
+
+static void testMixedFrames() {
+  static const uint8_t a[] = { 0x85, 0x12, 0x34, 0xFF, 0x00, 0xC3 };
+  static const uint8_t b[] = { 0x84, 0x00, 0xAB };
+  static const uint8_t c[] = { 0x1B, 0xE4 };
+  static const uint8_t d[] = { 0x55 };
+
+  // Overlapping, offset by part of a burst, starting later, and an idle channel
+  ChannelFrame frames[4] = { { a, 6, 0 }, { b, 3, 17200 }, { c, 2, 40000 }, { d, 1, 38400 } };
+  CHECK(verifyMergedSchedule(frames, 4));
+
+  frames[2].data = NULL;
+  CHECK(verifyMergedSchedule(frames, 4));
+
+  // The channel bits only ever change one transition at a time per channel
+  EdgeMerger merger;
+  merger.begin(frames, 4);
+  ScheduleEdge edge;
+  uint32_t lastNs = 0;
+  int edges = 0;
+  while (merger.next(&edge)) {
+    CHECK(edges == 0 || edge.timeNs > lastNs);
+    CHECK((edge.mask & 4) == 0);
+    lastNs = edge.timeNs;
+    edges++;
+  }
+  CHECK(edges > 0 && edge.mask == 0);
+
+  CHECK(!verifyMergedSchedule(frames, EDGE_MAX_CHANNELS + 1));
+}
+
+// Carrier periods each channel gets from the segments transmitParallel sends:
+// every burst exactly IR_BURST_PERIODS long, however other channels split it
+static void checkPeriods(const ChannelFrame* frames, uint8_t count) {
+  const uint32_t periodNs = 1000000 / IR_CARRIER_KHZ;
+  uint32_t run[EDGE_MAX_CHANNELS] = { 0 };
+  uint32_t runEndNs[EDGE_MAX_CHANNELS] = { 0 };
+  uint32_t bursts[EDGE_MAX_CHANNELS] = { 0 };
+
+  SegmentStream segments;
+  segments.begin(frames, count);
+  CarrierSegment segment;
+  uint32_t lastEndNs = 0;
+  while (segments.next(&segment)) {
+    CHECK(segment.periods > 0 && segment.startNs % periodNs == 0);
+    CHECK(segment.startNs >= lastEndNs);
+    lastEndNs = segment.startNs + segment.periods * periodNs;
+
+    for (uint8_t c = 0; c < count; c++) {
+      if (!(segment.mask & (1 << c))) {
+        continue;
+      }
+      // A burst goes on in the segment that starts where its last one ended
+      if (run[c] != 0 && segment.startNs != runEndNs[c]) {
+        CHECK(run[c] == IR_BURST_PERIODS);
+        bursts[c]++;
+        run[c] = 0;
+      }
+      run[c] += segment.periods;
+      runEndNs[c] = lastEndNs;
+    }
+  }
+
+  for (uint8_t c = 0; c < count; c++) {
+    if (run[c] != 0) {
+      CHECK(run[c] == IR_BURST_PERIODS);
+      bursts[c]++;
+    }
+    uint32_t expected = frames[c].data ? frames[c].size * 4 + 1 : 0;
+    CHECK(bursts[c] == expected);
+  }
+}
+
+static void testPeriods() {
+  static const uint8_t a[] = { 0x85, 0x12, 0x34, 0xFF, 0x00, 0xC3 };
+  static const uint8_t b[] = { 0x84, 0x00, 0xAB };
+  static const uint8_t c[] = { 0x1B, 0xE4 };
+
+  ChannelFrame single = { a, 6, 0 };
+  checkPeriods(&single, 1);
+
+  // Offsets off the period grid split bursts at half and odd periods
+  static const uint32_t OFFSETS[] = { 0, 1, 399, 400, 401, 17200, 38000, 38400, 40100 };
+  for (size_t i = 0; i < sizeof(OFFSETS) / sizeof(OFFSETS[0]); i++) {
+    for (size_t j = 0; j < sizeof(OFFSETS) / sizeof(OFFSETS[0]); j++) {
+      ChannelFrame frames[3] = { { a, 6, 0 }, { b, 3, OFFSETS[i] }, { c, 2, OFFSETS[j] } };
+      checkPeriods(frames, 3);
+      frames[1].data = NULL;
+      checkPeriods(frames, 3);
+    }
+  }
+}
+
+int main() {
+  testTiming();
+  testSingleChannel();
+  testSharedEdges();
+  testMixedFrames();
+  testPeriods();
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,428 @@
+// JobSpool on a host directory with a fake clock
+
+#include "JobSpool.h"
+#include "check.h"
+#include <string.h>
+
+#define STORE "build/job_spool_store"
+
+// No NTP: the unix clock stays unset unless a test sets it
+static uint32_t unixTime = 0;
+static uint32_t nowMs = 1;
+
+static uint32_t unixClock() {
+  return unixTime;
+}
+
+static uint32_t millisClock() {
+  return nowMs;
+}
+
+static void removeEntry(void* context, const char* name, uint32_t) {
+  ((SpoolStorage*)context)->remove(name);
+}
+
+// Counts the progress files written, the flash wear the spool causes per frame
+class CountingStorage : public DirSpoolStorage {
+  public:
+    CountingStorage(const char* directory) : DirSpoolStorage(directory), progressWrites(0) {}
+
+    bool write(const char* name, const void* data, size_t length) {
+      if (strstr(name, ".pos")) {
+        progressWrites++;
+      }
+      return DirSpoolStorage::write(name, data, length);
+    }
+
+    uint32_t progressWrites;
+};
+
+// Frames handed to the transmitter, the first two data bytes of each
+struct Sent {
+  uint8_t first[64];
+  uint8_t second[64];
+  uint8_t count;
+};
+
+static bool collect(void* context, const SpoolFrame& frame) {
+  Sent* sent = (Sent*)context;
+  CHECK(sent->count < sizeof(sent->first));
+  sent->second[sent->count] = frame.size > 1 ? frame.data[1] : 0;
+  sent->first[sent->count++] = frame.data[0];
+  return true;
+}
+
+// Jobs reported done, with the outcome and latency of the last one
+struct Done {
+  uint32_t completed;
+  uint32_t failed;
+  uint32_t lastId;
+  uint32_t lastLatencyMs;
+};
+
+static void jobDone(void* context, const SpoolJobInfo& job, bool completed, uint32_t latencyMs) {
+  Done* done = (Done*)context;
+  if (completed) {
+    done->completed++;
+  } else {
+    done->failed++;
+  }
+  done->lastId = job.id;
+  done->lastLatencyMs = latencyMs;
+}
+
+static uint32_t queuePing(JobSpool& spool, const char* barcode, uint8_t marker) {
+  uint32_t id = spool.beginJob(0, 0, SPOOL_CLASS_NORMAL, &barcode, 1);
+  CHECK(id != SPOOL_NO_JOB);
+  uint8_t frame[8] = { marker };
+  CHECK(spool.appendFrame(1, frame, sizeof(frame), 400));
+  CHECK(spool.commitJob());
+  return id;
+}
+
+static uint32_t queueTargeted(JobSpool& spool, uint8_t kind, uint8_t page, uint32_t notBefore,
+                              uint32_t deadline, uint8_t priority, uint8_t marker) {
+  const char* barcode = "04123456789012345";
+  SpoolJobTarget target = { kind, 0x1234, page };
+  uint32_t id = spool.beginJob(notBefore, deadline, priority, &barcode, 1, &target);
+  CHECK(id != SPOOL_NO_JOB);
+  uint8_t frame[8] = { marker };
+  CHECK(spool.appendFrame(1, frame, sizeof(frame), 1));
+  CHECK(spool.commitJob());
+  return id;
+}
+
+// A wake frame (type 1) then data frames (type 2), marker and frame index in
+// the first two bytes
+#define WAKE_TYPE 1
+#define DATA_TYPE 2
+#define WAKE_WINDOW_MS 3000
+
+static uint32_t queueFrames(JobSpool& spool, uint8_t priority, uint32_t deadline,
+                            uint16_t frames, uint8_t marker) {
+  const char* barcode = "04123456789012345";
+  uint32_t id = spool.beginJob(0, deadline, priority, &barcode, 1);
+  CHECK(id != SPOOL_NO_JOB);
+  for (uint16_t f = 0; f < frames; f++) {
+    uint8_t frame[8] = { marker, (uint8_t)f };
+    CHECK(spool.appendFrame(f == 0 ? WAKE_TYPE : DATA_TYPE, frame, sizeof(frame), 1));
+  }
+  CHECK(spool.commitJob());
+  return id;
+}
+
+static void reset(DirSpoolStorage& storage) {
+  CHECK(storage.begin());
+  storage.list(removeEntry, &storage);
+}
+
+// A drained spool must not hand out the same id again after a reboot: with
+// the clock unset and one frame each, id, created-at and frame count of two
+// pings are alike, and the compiled copy of the old one would be sent instead
+static void testIdsAfterReboot(DirSpoolStorage& storage) {
+  reset(storage);
+  uint32_t first;
+  {
+    JobSpool spool(storage, unixClock, millisClock);
+    CHECK(spool.begin());
+    first = queuePing(spool, "04123456789012345", 0xA1);
+    CHECK(spool.getJob(0).createdAt == 0 && spool.getJob(0).frameCount == 1);
+
+    Sent sent = { { 0 }, { 0 }, 0 };
+    CHECK(spool.service(collect, &sent));
+    CHECK(!spool.service(collect, &sent));
+    CHECK(sent.count == 1 && sent.first[0] == 0xA1);
+    CHECK(spool.getJobCount() == 0);
+  }
+
+  // Reboot with nothing queued
+  JobSpool spool(storage, unixClock, millisClock);
+  CHECK(spool.begin());
+  CHECK(spool.getJobCount() == 0);
+  uint32_t second = queuePing(spool, "04999999999999999", 0xB2);
+  CHECK(second > first);
+
+  // Still true for a job that was queued, then aborted before the reboot
+  uint32_t aborted = spool.beginJob(0, 0, SPOOL_CLASS_NORMAL, NULL, 0);
+  CHECK(aborted > second);
+  spool.abortJob();
+  JobSpool rebooted(storage, unixClock, millisClock);
+  CHECK(rebooted.begin());
+  CHECK(rebooted.getJobCount() == 1);
+  CHECK(queuePing(rebooted, "04123456789012345", 0xC3) > aborted);
+}
+
+// Revisions of a page, pings and refreshes of one tag collapse into the
+// newest update that would go out no later than them
+static void testCoalescing(DirSpoolStorage& storage) {
+  reset(storage);
+  unixTime = 1700000000;
+  uint32_t tomorrow = unixTime + 86400;
+  JobSpool spool(storage, unixClock, millisClock);
+  CHECK(spool.begin());
+
+  // Tomorrow's price is queued first, today's updates must not drop it
+  uint32_t later = queueTargeted(spool, SPOOL_KIND_UPDATE, 0, tomorrow, 0, SPOOL_CLASS_NORMAL, 1);
+  uint32_t first = queueTargeted(spool, SPOOL_KIND_UPDATE, 0, 0, 0, SPOOL_CLASS_NORMAL, 2);
+  CHECK(spool.getJobCount() == 2);
+  uint32_t second = queueTargeted(spool, SPOOL_KIND_UPDATE, 0, 0, 0, SPOOL_CLASS_NORMAL, 3);
+  CHECK(spool.getJobCount() == 2 && spool.getReplacedCount() == 1);
+  CHECK(!spool.findJobInfo(first) && spool.findJobInfo(later) && spool.findJobInfo(second));
+
+  // Another page of the tag is left alone
+  uint32_t other = queueTargeted(spool, SPOOL_KIND_UPDATE, 1, 0, 0, SPOOL_CLASS_NORMAL, 4);
+  CHECK(spool.getJobCount() == 3);
+
+  // An update sent right away makes only what is due by now redundant
+  CHECK(spool.dropSuperseded(0x1234, 0, 0) == 1);
+  CHECK(!spool.findJobInfo(second) && spool.findJobInfo(later) && spool.findJobInfo(other));
+
+  // Pings and refreshes queued before an update pass their class and
+  // deadline on to it when stricter
+  queueTargeted(spool, SPOOL_KIND_PING, 0, 0, unixTime + 600, SPOOL_CLASS_URGENT, 5);
+  queueTargeted(spool, SPOOL_KIND_REFRESH, 0, 0, unixTime + 300, SPOOL_CLASS_BULK, 6);
+  uint32_t merged = spool.getMergedCount();
+  uint32_t update = queueTargeted(spool, SPOOL_KIND_UPDATE, 1, 0, unixTime + 900, SPOOL_CLASS_NORMAL, 7);
+  CHECK(spool.getMergedCount() == merged + 2);
+  CHECK(!spool.findJobInfo(other));
+  const SpoolJobInfo* job = spool.findJobInfo(update);
+  CHECK(job && job->priority == SPOOL_CLASS_URGENT && job->deadline == unixTime + 300);
+
+  // A ping due by then rides along and tightens the queued update
+  CHECK(spool.findCoveringUpdate(0x1234, 0) == update);
+  CHECK(spool.mergeInto(update, SPOOL_CLASS_BULK, unixTime + 120));
+  CHECK(job->priority == SPOOL_CLASS_URGENT && job->deadline == unixTime + 120);
+
+  // The stricter class and deadline are in the file, not only in the index
+  JobSpool rebooted(storage, unixClock, millisClock);
+  CHECK(rebooted.begin());
+  CHECK(rebooted.getJobCount() == 2);
+  job = rebooted.findJobInfo(update);
+  CHECK(job && job->priority == SPOOL_CLASS_URGENT && job->deadline == unixTime + 120);
+  job = rebooted.findJobInfo(later);
+  CHECK(job && job->notBefore == tomorrow && job->priority == SPOOL_CLASS_NORMAL);
+  unixTime = 0;
+}
+
+// Progress reaches flash every SPOOL_PROGRESS_FRAMES frames and when a job
+// is preempted, a reboot resumes from there after a new wake frame
+static void testProgress(CountingStorage& storage) {
+  reset(storage);
+  nowMs = 1000;
+  {
+    JobSpool spool(storage, unixClock, millisClock);
+    spool.setFrameRoles(WAKE_TYPE, DATA_TYPE, WAKE_WINDOW_MS);
+    CHECK(spool.begin());
+    uint32_t id = queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 40, 0xA0);
+
+    storage.progressWrites = 0;
+    Sent sent = { { 0 }, { 0 }, 0 };
+    for (uint8_t f = 0; f < 20; f++) {
+      CHECK(spool.service(collect, &sent));
+      nowMs += 10;
+    }
+    CHECK(storage.progressWrites == 20 / SPOOL_PROGRESS_FRAMES);
+    CHECK(spool.findJobInfo(id)->nextFrame == 20);
+  }
+
+  // Frames since the last save go out again, behind a fresh wake frame
+  {
+    JobSpool spool(storage, unixClock, millisClock);
+    spool.setFrameRoles(WAKE_TYPE, DATA_TYPE, WAKE_WINDOW_MS);
+    CHECK(spool.begin());
+    CHECK(spool.getJob(0).nextFrame == SPOOL_PROGRESS_FRAMES);
+
+    Sent sent = { { 0 }, { 0 }, 0 };
+    while (spool.service(collect, &sent)) {
+      nowMs += 10;
+    }
+    CHECK(sent.count == 1 + 40 - SPOOL_PROGRESS_FRAMES);
+    CHECK(sent.second[0] == 0 && sent.second[1] == SPOOL_PROGRESS_FRAMES && sent.second[sent.count - 1] == 39);
+    CHECK(spool.getJobCount() == 0);
+  }
+
+  // A preempted job saves where it stopped
+  {
+    JobSpool spool(storage, unixClock, millisClock);
+    spool.setFrameRoles(WAKE_TYPE, DATA_TYPE, WAKE_WINDOW_MS);
+    CHECK(spool.begin());
+    uint32_t bulk = queueFrames(spool, SPOOL_CLASS_BULK, 0, 40, 0xB0);
+    Sent sent = { { 0 }, { 0 }, 0 };
+    for (uint8_t f = 0; f < 5; f++) {
+      CHECK(spool.service(collect, &sent));
+    }
+    storage.progressWrites = 0;
+    queueFrames(spool, SPOOL_CLASS_URGENT, 0, 2, 0xC0);
+    CHECK(spool.service(collect, &sent));
+    CHECK(sent.first[sent.count - 1] == 0xC0);
+    CHECK(storage.progressWrites == 1);
+    CHECK(spool.findJobInfo(bulk)->nextFrame == 5);
+  }
+  JobSpool spool(storage, unixClock, millisClock);
+  CHECK(spool.begin());
+  CHECK(spool.getJobCount() == 2);
+  CHECK(spool.getJob(0).nextFrame == 5);
+  nowMs = 1;
+}
+
+// Every job that leaves the queue by sending or failing is reported once,
+// latency from the job becoming due
+static void testDone(DirSpoolStorage& storage) {
+  reset(storage);
+  nowMs = 5000;
+  JobSpool spool(storage, unixClock, millisClock);
+  CHECK(spool.begin());
+  Done done = { 0, 0, 0, 0 };
+  spool.setDoneHandler(jobDone, &done);
+
+  uint32_t id = queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 3, 0xD0);
+  Sent sent = { { 0 }, { 0 }, 0 };
+  CHECK(spool.service(collect, &sent));
+  nowMs += 200;
+  CHECK(spool.service(collect, &sent));
+  CHECK(done.completed == 0);
+  nowMs += 300;
+  CHECK(spool.service(collect, &sent));
+  CHECK(done.completed == 1 && done.failed == 0);
+  CHECK(done.lastId == id && done.lastLatencyMs == 500);
+
+  // Frames sent from elsewhere finish the job the same way
+  id = queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 1, 0xD1);
+  SpoolJobInfo job;
+  uint16_t frameIndex;
+  CHECK(spool.getDueJob(&job, &frameIndex) && job.id == id && frameIndex == 0);
+  nowMs += 40;
+  CHECK(spool.frameSent(id, frameIndex, 8));
+  CHECK(done.completed == 2 && done.lastId == id && done.lastLatencyMs == 40);
+
+  // An unreadable job is dropped as failed, a cancelled one is not reported
+  id = queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 2, 0xD2);
+  char name[16];
+  snprintf(name, sizeof(name), "%08lx.job", (unsigned long)id);
+  CHECK(storage.remove(name));
+  CHECK(!spool.service(collect, &sent));
+  CHECK(done.failed == 1 && done.lastId == id && spool.getJobCount() == 0);
+  id = queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 2, 0xD3);
+  CHECK(spool.cancelJob(id));
+  CHECK(done.completed == 2 && done.failed == 1);
+  nowMs = 1;
+}
+
+// Single-frame jobs go out by class, then earliest deadline, then start time
+static void testOrdering(DirSpoolStorage& storage) {
+  reset(storage);
+  unixTime = 1700000000;
+  JobSpool spool(storage, unixClock, millisClock);
+  spool.setFrameRoles(WAKE_TYPE, DATA_TYPE, WAKE_WINDOW_MS);
+  CHECK(spool.begin());
+
+  queueFrames(spool, SPOOL_CLASS_BULK, 0, 1, 1);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, unixTime + 600, 1, 2);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 1, 3);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, unixTime + 300, 1, 4);
+  queueFrames(spool, SPOOL_CLASS_URGENT, 0, 1, 5);
+  queueTargeted(spool, SPOOL_KIND_OTHER, 0, unixTime + 60, 0, SPOOL_CLASS_URGENT, 6);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 1, 7);
+
+  static const uint8_t ORDER[] = { 5, 4, 2, 3, 7, 1 };
+  Sent sent = { { 0 }, { 0 }, 0 };
+  while (spool.service(collect, &sent)) {
+  }
+  CHECK(sent.count == sizeof(ORDER));
+  CHECK(memcmp(sent.first, ORDER, sizeof(ORDER)) == 0);
+
+  // The timed job waits for its start, then overtakes everything queued
+  queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 1, 8);
+  unixTime += 60;
+  CHECK(spool.service(collect, &sent) && sent.first[sent.count - 1] == 6);
+  CHECK(spool.service(collect, &sent) && sent.first[sent.count - 1] == 8);
+  CHECK(spool.getJobCount() == 0);
+
+  // Within a class a job already started is finished first, also once it
+  // has been interrupted by a higher class
+  queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 3, 9);
+  CHECK(spool.service(collect, &sent));
+  queueFrames(spool, SPOOL_CLASS_URGENT, 0, 1, 10);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, unixTime + 10, 1, 11);
+  while (spool.service(collect, &sent)) {
+  }
+  static const uint8_t STARTED[] = { 9, 10, 9, 9, 11 };
+  CHECK(sent.count == sizeof(ORDER) + 2 + sizeof(STARTED));
+  CHECK(memcmp(&sent.first[sent.count - sizeof(STARTED)], STARTED, sizeof(STARTED)) == 0);
+  CHECK(spool.getClassStats(SPOOL_CLASS_NORMAL).preemptions == 1);
+  unixTime = 0;
+}
+
+// A higher class interrupts a running job only in front of a data frame; the
+// job resumes right away inside its tag's wake window, behind a new wake
+// frame after it
+static void testPreemption(DirSpoolStorage& storage) {
+  reset(storage);
+  nowMs = 1000;
+  JobSpool spool(storage, unixClock, millisClock);
+  spool.setFrameRoles(WAKE_TYPE, DATA_TYPE, WAKE_WINDOW_MS);
+  CHECK(spool.begin());
+
+  // Wake, a parameter frame, then data
+  const char* barcode = "04123456789012345";
+  CHECK(spool.beginJob(0, 0, SPOOL_CLASS_BULK, &barcode, 1) != SPOOL_NO_JOB);
+  static const uint8_t TYPES[] = { WAKE_TYPE, 3, DATA_TYPE, DATA_TYPE, DATA_TYPE };
+  for (uint8_t f = 0; f < sizeof(TYPES); f++) {
+    uint8_t frame[8] = { 0xB0, f };
+    CHECK(spool.appendFrame(TYPES[f], frame, sizeof(frame), 1));
+  }
+  CHECK(spool.commitJob());
+
+  Sent sent = { { 0 }, { 0 }, 0 };
+  CHECK(spool.service(collect, &sent));
+  queueFrames(spool, SPOOL_CLASS_URGENT, 0, 2, 0xE0);
+  queueFrames(spool, SPOOL_CLASS_NORMAL, 0, 1, 0xF0);
+
+  // The parameter frame still follows the wake frame
+  CHECK(spool.service(collect, &sent));
+  CHECK(sent.first[1] == 0xB0 && sent.second[1] == 1);
+
+  // In front of the first data frame both waiting jobs go first
+  for (uint8_t f = 0; f < 3; f++) {
+    CHECK(spool.service(collect, &sent));
+    nowMs += 100;
+  }
+  CHECK(sent.first[2] == 0xE0 && sent.first[3] == 0xE0 && sent.first[4] == 0xF0);
+  CHECK(spool.getClassStats(SPOOL_CLASS_BULK).preemptions == 1);
+
+  // Back within the wake window: straight on with the data
+  CHECK(spool.service(collect, &sent));
+  CHECK(sent.first[5] == 0xB0 && sent.second[5] == 2);
+  CHECK(spool.getClassStats(SPOOL_CLASS_BULK).rewakes == 0);
+
+  // Interrupted again for longer than the window: woken first
+  queueFrames(spool, SPOOL_CLASS_URGENT, 0, 1, 0xE1);
+  CHECK(spool.service(collect, &sent) && sent.first[6] == 0xE1);
+  nowMs += WAKE_WINDOW_MS + 1;
+  CHECK(spool.service(collect, &sent));
+  CHECK(spool.service(collect, &sent));
+  CHECK(sent.first[7] == 0xB0 && sent.second[7] == 0);
+  CHECK(sent.first[8] == 0xB0 && sent.second[8] == 3);
+  CHECK(spool.getClassStats(SPOOL_CLASS_BULK).preemptions == 2);
+  CHECK(spool.getClassStats(SPOOL_CLASS_BULK).rewakes == 1);
+
+  // A job of the same class waits for the running one
+  queueFrames(spool, SPOOL_CLASS_BULK, 0, 1, 0xD0);
+  CHECK(spool.service(collect, &sent));
+  CHECK(sent.first[9] == 0xB0 && sent.second[9] == 4);
+  CHECK(spool.service(collect, &sent) && sent.first[10] == 0xD0);
+  CHECK(!spool.service(collect, &sent));
+  nowMs = 1;
+}
+
+int main() {
+  CountingStorage storage(STORE);
+  testIdsAfterReboot(storage);
+  testCoalescing(storage);
+  testProgress(storage);
+  testDone(storage);
+  testOrdering(storage);
+  testPreemption(storage);
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+// JsonWriter soak: the response shapes of the web handlers, written over
+// and over through small buffers, must never touch the heap
+//
+// Every allocation of the process is counted; the heap figures are printed
+// along the way so a long run shows whether the free space or its largest
+// block at the top of the heap shrink. Pass a round count to run longer.
+
+#include "JsonWriter.h"
+#include "check.h"
+#include <string.h>
+#include <new>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define SOAK_ROUNDS 100000
+#define SOAK_REPORTS 10
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* memory = malloc(size ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  free(memory);
+}
+
+// Collects the streamed text, like the chunks written to the client
+struct Output {
+  char text[16384];
+  size_t length;
+  unsigned long chunks;
+};
+
+static void collect(void* context, const char* data, size_t length) {
+  Output* out = (Output*)context;
+  CHECK(out->length + length < sizeof(out->text));
+  memcpy(out->text + out->length, data, length);
+  out->length += length;
+  out->chunks++;
+}
+
+// Just enough of a JSON parser to reject malformed output
+struct Validator {
+  const char* p;
+  const char* end;
+
+  void space() {
+    while (p < end && (*p == ' ' || *p == '\n')) {
+      p++;
+    }
+  }
+
+  bool string() {
+    if (p >= end || *p++ != '"') {
+      return false;
+    }
+    while (p < end && *p != '"') {
+      if ((uint8_t)*p < 0x20) {
+        return false;
+      }
+      if (*p == '\\') {
+        p++;
+      }
+      p++;
+    }
+    return p++ < end;
+  }
+
+  bool value() {
+    space();
+    if (p >= end) {
+      return false;
+    }
+    if (*p == '"') {
+      return string();
+    }
+    if (*p == '{' || *p == '[') {
+      char close = *p == '{' ? '}' : ']';
+      bool object = *p++ == '{';
+      space();
+      if (p < end && *p == close) {
+        p++;
+        return true;
+      }
+      while (true) {
+        if (object) {
+          space();
+          if (!string()) {
+            return false;
+          }
+          space();
+          if (p >= end || *p++ != ':') {
+            return false;
+          }
+        }
+        if (!value()) {
+          return false;
+        }
+        space();
+        if (p >= end) {
+          return false;
+        }
+        if (*p == close) {
+          p++;
+          return true;
+        }
+        if (*p++ != ',') {
+          return false;
+        }
+      }
+    }
+    const char* start = p;
+    while (p < end && (*p == '-' || *p == '.' || (*p >= '0' && *p <= '9') || (*p >= 'a' && *p <= 'z'))) {
+      p++;
+    }
+    return p > start;
+  }
+
+  static bool valid(const char* text, size_t length) {
+    Validator v = { text, text + length };
+    if (!v.value()) {
+      return false;
+    }
+    v.space();
+    return v.p == v.end;
+  }
+};
+
+static uint32_t state = 1;
+
+static uint32_t random32() {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// Names with the characters that need escaping, as SSIDs and barcodes may
+static void randomText(char* out, size_t size) {
+  static const char CHARS[] = "abcXYZ0189 _-\"\\\n\t\x01/";
+  size_t length = random32() % (size - 1);
+  for (size_t i = 0; i < length; i++) {
+    out[i] = CHARS[random32() % (sizeof(CHARS) - 1)];
+  }
+  out[length] = '\0';
+}
+
+// Status report with nested objects and arrays, streamed through a buffer
+// the size the handlers use
+static void writeStatus(Output* out) {
+  char buffer[256];
+  char name[40];
+  JsonWriter json(buffer, sizeof(buffer), collect, out);
+
+  json.beginObject();
+  json.addString("status", "running");
+  json.addNumber("uptime", random32());
+  json.addSigned("rssi", -(int32_t)(random32() % 100));
+  json.addBool("spooling", random32() & 1);
+  json.beginObject("wifi");
+  randomText(name, sizeof(name));
+  json.addString("ssid", name);
+  json.addRaw("frequency", "1.25");
+  json.endObject();
+  json.beginArray("jobs");
+  for (uint32_t j = random32() % 40; j > 0; j--) {
+    json.beginObject();
+    json.addNumber("id", j);
+    randomText(name, sizeof(name));
+    json.addString("barcode", name);
+    json.beginArray("pages");
+    for (uint32_t p = random32() % 8; p > 0; p--) {
+      json.addNumber(NULL, p);
+    }
+    json.endArray();
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  json.finish();
+}
+
+// Short success or error reply, written whole into a stack buffer
+static bool writeReply(char* buffer, size_t size) {
+  char message[96];
+  randomText(message, sizeof(message));
+  JsonWriter json(buffer, size);
+  json.beginObject();
+  json.addString("status", (random32() & 1) ? "success" : "error");
+  json.addString("message", message);
+  json.endObject();
+  json.finish();
+  return !json.overflowed();
+}
+
+static void report(unsigned long round) {
+#ifdef __GLIBC__
+  struct mallinfo2 info = mallinfo2();
+  printf("round %7lu  allocations %lu  in use %zu  free %zu  top block %zu\n",
+         round, allocations, info.uordblks, info.fordblks, info.keepcost);
+#else
+  printf("round %7lu  allocations %lu\n", round, allocations);
+#endif
+}
+
+int main(int argc, char** argv) {
+  unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 10) : SOAK_ROUNDS;
+  static Output out;
+
+  // Baseline after stdio has set up its buffers
+  printf("JsonWriter soak, %lu rounds\n", rounds);
+  report(0);
+  unsigned long baseline = allocations;
+#ifdef __GLIBC__
+  size_t inUse = mallinfo2().uordblks;
+#endif
+
+  unsigned long overflows = 0;
+  for (unsigned long round = 1; round <= rounds; round++) {
+    out.length = 0;
+    writeStatus(&out);
+    CHECK(Validator::valid(out.text, out.length));
+
+    // Replies are valid when they fit, and cut short otherwise
+    char reply[128];
+    if (writeReply(reply, sizeof(reply))) {
+      CHECK(Validator::valid(reply, strlen(reply)));
+    } else {
+      CHECK(strlen(reply) == sizeof(reply) - 1);
+      overflows++;
+    }
+
+    if (round % (rounds / SOAK_REPORTS ? rounds / SOAK_REPORTS : 1) == 0) {
+      report(round);
+    }
+  }
+
+  // Nothing allocated and nothing left over, so nothing to fragment
+  CHECK(allocations == baseline);
+#ifdef __GLIBC__
+  CHECK(mallinfo2().uordblks == inUse);
+#endif
+  printf("ok, %lu chunks streamed, %lu replies cut short\n", out.chunks, overflows);
+  return 0;
+}
\ No newline at end of file
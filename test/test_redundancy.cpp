@@ -0,0 +1,210 @@
+// Interleaved copies and the loss model: frame order, loss statistics against
+// the two-state channel worked out by hand, and copies against retries
+
+#include "Redundancy.h"
+#include "IRTiming.h"
+#include "check.h"
+#include <string.h>
+#include <time.h>
+
+static void testInterleaver() {
+  static const uint16_t FRAMES[] = { 0, 1, 7, 40, 100, 1024 };
+  static const uint8_t SPANS[] = { 1, 3, 8, 16, 255 };
+  static uint16_t sent[1024];
+  static int32_t lastAt[1024];
+
+  for (size_t f = 0; f < sizeof(FRAMES) / sizeof(FRAMES[0]); f++) {
+    for (uint8_t copies = 1; copies <= 4; copies++) {
+      for (size_t s = 0; s < sizeof(SPANS); s++) {
+        uint16_t frames = FRAMES[f];
+        uint8_t span = SPANS[s];
+        FrameInterleaver order(frames, copies, span);
+        memset(sent, 0, sizeof(sent));
+        for (uint16_t i = 0; i < 1024; i++) {
+          lastAt[i] = -1;
+        }
+
+        // Every frame copies times, the next copy of a frame one block on,
+        // a block never longer than span
+        int32_t position = 0;
+        uint16_t frame;
+        while (order.next(&frame)) {
+          CHECK(frame < frames);
+          if (lastAt[frame] >= 0) {
+            int32_t distance = position - lastAt[frame];
+            CHECK(distance >= 1 && distance <= span);
+            CHECK(distance >= frames / ((frames + span - 1) / span));
+          }
+          lastAt[frame] = position++;
+          sent[frame]++;
+        }
+        CHECK((uint32_t)position == order.getLength());
+        CHECK((uint32_t)position == (uint32_t)frames * copies);
+        for (uint16_t i = 0; i < frames; i++) {
+          CHECK(sent[i] == copies);
+        }
+        CHECK(!order.next(&frame));
+      }
+    }
+  }
+}
+
+static void testAirtime() {
+  CHECK(LossSimulator::frameAirtimeUs(0, 1, 0) == IR_BURST_US);
+  uint32_t one = LossSimulator::frameAirtimeUs(20, 1, 2000);
+  CHECK(LossSimulator::frameAirtimeUs(20, 5, 2000) == 5 * one);
+  CHECK(LossSimulator::frameAirtimeUs(21, 1, 2000) > one);
+}
+
+static LossJob makeJob(uint16_t frames) {
+  LossJob job;
+  job.dataFrames = frames;
+  job.wakeUs = LossSimulator::frameAirtimeUs(34, 400, 2000);
+  job.controlUs = 2 * LossSimulator::frameAirtimeUs(34, 1, 2000);
+  job.dataUs = LossSimulator::frameAirtimeUs(54, 1, 2000);
+  return job;
+}
+
+static void testExtremes() {
+  LossJob job = makeJob(40);
+  LossResult result;
+
+  LossModel clear = { 0, 3 };
+  LossSimulator lossless(clear);
+  for (uint8_t k = 1; k <= 4; k++) {
+    lossless.simulateCopies(job, k, 8, 200, &result);
+    CHECK(result.successPermille == 1000);
+    CHECK(result.perImageMs == result.airtimeMs);
+    CHECK(result.airtimeMs == (job.wakeUs + job.controlUs + 40UL * k * job.dataUs) / 1000);
+  }
+  lossless.simulateRetries(job, 3, 200, &result);
+  CHECK(result.successPermille == 1000);
+  CHECK(result.airtimeMs == 3 * (job.wakeUs + job.controlUs + 40UL * job.dataUs) / 1000);
+
+  LossModel dead = { 1000, 3 };
+  LossSimulator hopeless(dead);
+  hopeless.simulateCopies(job, 4, 8, 200, &result);
+  CHECK(result.successPermille == 0 && result.perImageMs == 0);
+  hopeless.simulateRetries(job, 4, 200, &result);
+  CHECK(result.successPermille == 0 && result.perImageMs == 0);
+}
+
+// Chance that one frame sent copies times gets through, summed over every
+// loss pattern of parameters, copies and refresh on the two-state channel
+static double singleFrameSuccess(double loss, double burst, uint8_t copies) {
+  double enter = loss / (burst * (1 - loss));
+  double leave = 1 / burst;
+  uint8_t steps = copies + 2;
+  double total = 0;
+  for (uint32_t pattern = 0; pattern < (1UL << steps); pattern++) {
+    // Bit i set: frame i lost
+    bool bad = pattern & 1;
+    double chance = bad ? loss : 1 - loss;
+    for (uint8_t i = 1; i < steps; i++) {
+      bool next = pattern & (1UL << i);
+      chance *= bad ? (next ? 1 - leave : leave) : (next ? enter : 1 - enter);
+      bad = next;
+    }
+    uint32_t dataLost = (pattern >> 1) & ((1UL << copies) - 1);
+    if (!(pattern & 1) && !(pattern & (1UL << (steps - 1))) && dataLost != (1UL << copies) - 1) {
+      total += chance;
+    }
+  }
+  return total;
+}
+
+// A single copy succeeds when all frames + 2 in a row arrive: the first with
+// the stationary chance, each further one if no burst starts
+static void testStatistics() {
+  static const uint16_t LOSSES[] = { 20, 100, 300 };
+  static const uint16_t BURSTS[] = { 1, 2, 5 };
+  const uint16_t frames = 20;
+  const uint16_t trials = 20000;
+  LossJob job = makeJob(frames);
+
+  for (size_t l = 0; l < sizeof(LOSSES) / sizeof(LOSSES[0]); l++) {
+    for (size_t b = 0; b < sizeof(BURSTS) / sizeof(BURSTS[0]); b++) {
+      double loss = LOSSES[l] / 1000.0;
+      double enter = loss / (BURSTS[b] * (1 - loss));
+      double expected = (1 - loss);
+      for (uint16_t i = 1; i < frames + 2; i++) {
+        expected *= 1 - enter;
+      }
+
+      LossModel model = { LOSSES[l], BURSTS[b] };
+      LossSimulator simulator(model, 1 + l * 3 + b);
+      LossResult copies;
+      LossResult retries;
+      simulator.simulateCopies(job, 1, 8, trials, &copies);
+      simulator.simulateRetries(job, 1, trials, &retries);
+
+      // Within about four standard deviations of 20000 trials
+      double measured = copies.successPermille / 1000.0;
+      CHECK(measured > expected - 0.015 && measured < expected + 0.015);
+      measured = retries.successPermille / 1000.0;
+      CHECK(measured > expected - 0.015 && measured < expected + 0.015);
+
+      // Copies of one frame back to back, which only all get lost inside a burst
+      LossJob single = makeJob(1);
+      simulator.simulateCopies(single, 3, 1, trials, &copies);
+      expected = singleFrameSuccess(loss, BURSTS[b], 3);
+      measured = copies.successPermille / 1000.0;
+      CHECK(measured > expected - 0.015 && measured < expected + 0.015);
+    }
+  }
+}
+
+static void testCopiesAgainstRetries() {
+  // A long wake-up makes every retry expensive, a second copy of the data is not
+  LossJob job = makeJob(40);
+  LossModel model = { 100, 2 };
+  LossSimulator simulator(model, 7);
+  LossResult copies;
+  LossResult retries;
+
+  simulator.simulateCopies(job, 2, 8, 2000, &copies);
+  simulator.simulateRetries(job, 1, 2000, &retries);
+  CHECK(copies.successPermille > retries.successPermille);
+  simulator.simulateRetries(job, 2, 2000, &retries);
+  CHECK(copies.airtimeMs < retries.airtimeMs);
+  CHECK(copies.perImageMs < retries.perImageMs);
+  printf("loss 10%%, bursts of 2: 2 copies %u permille %u ms/image, 2 attempts %u permille %u ms/image\n",
+         copies.successPermille, (unsigned)copies.perImageMs, retries.successPermille, (unsigned)retries.perImageMs);
+
+  // The same seed gives the same answer
+  LossSimulator first(model, 11);
+  LossSimulator second(model, 11);
+  first.simulateCopies(job, 3, 8, 500, &copies);
+  second.simulateCopies(job, 3, 8, 500, &retries);
+  CHECK(copies.successPermille == retries.successPermille);
+}
+
+// The largest single call the device makes, for a feel of the time between yields
+static void timeDeviceLimit() {
+  uint16_t frames = 1024;
+  uint16_t trials = REDUNDANCY_MAX_FRAME_TRIALS / frames;
+  LossJob job = makeJob(frames);
+  LossModel model = { 100, 2 };
+  LossSimulator simulator(model);
+  LossResult result;
+
+  clock_t start = clock();
+  simulator.simulateCopies(job, 4, 8, trials, &result);
+  double copiesMs = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+  start = clock();
+  simulator.simulateRetries(job, REDUNDANCY_MAX_ATTEMPTS, trials, &result);
+  double retriesMs = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+  printf("%u frames x %u trials: 4 copies %.2f ms, %u attempts %.2f ms on this host\n",
+         frames, trials, copiesMs, REDUNDANCY_MAX_ATTEMPTS, retriesMs);
+}
+
+int main() {
+  testInterleaver();
+  testAirtime();
+  testExtremes();
+  testStatistics();
+  testCopiesAgainstRetries();
+  timeDeviceLimit();
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
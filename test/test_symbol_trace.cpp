@@ -0,0 +1,157 @@
+// SymbolTrace analysis and VCD export against synthetic captures
+
+#include "SymbolTrace.h"
+#include "check.h"
+#include <string.h>
+
+#define CPU_MHZ 160
+
+static uint32_t nsToCycles(uint32_t ns) {
+  return (uint32_t)((uint64_t)ns * CPU_MHZ / 1000);
+}
+
+// Records one frame of symbols; burstErrorNs lengthens every burst, pauseErrorNs
+// every pause, and the frame's final burst follows the last symbol
+static uint32_t recordFrame(SymbolTrace& trace, uint32_t cycle, const uint8_t* symbols, uint8_t count,
+                            int32_t burstErrorNs, int32_t pauseErrorNs) {
+  trace.record(TRACE_FRAME_START, 0, cycle);
+  cycle += 100;
+  for (uint8_t i = 0; i <= count; i++) {
+    trace.record(TRACE_BURST_START, 0, cycle);
+    cycle += nsToCycles(IR_BURST_ON_NS + burstErrorNs);
+    trace.record(TRACE_BURST_END, 0, cycle);
+    if (i == count) {
+      break;
+    }
+    cycle += nsToCycles(IR_PAUSE_US[symbols[i]] * 1000 + pauseErrorNs);
+    trace.record(TRACE_PAUSE_END, symbols[i], cycle);
+  }
+  return cycle + nsToCycles(IR_FRAME_GAP_US * 1000);
+}
+
+struct Capture {
+  char text[8192];
+  size_t length;
+};
+
+static void capture(void* context, const char* data, size_t length) {
+  Capture* out = (Capture*)context;
+  CHECK(out->length + length < sizeof(out->text));
+  memcpy(out->text + out->length, data, length);
+  out->length += length;
+  out->text[out->length] = '\0';
+}
+
+static int countLines(const char* text, const char* line) {
+  int count = 0;
+  size_t length = strlen(line);
+  for (const char* p = text; (p = strstr(p, line)) != NULL; p += length) {
+    if (p == text || p[-1] == '\n') {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void testExactTiming() {
+  static const uint8_t symbols[] = { 0, 1, 2, 3, 3, 2, 1, 0 };
+  SymbolTrace trace;
+  CHECK(trace.begin(256, CPU_MHZ));
+
+  // Starts just before the cycle counter wraps
+  uint32_t cycle = 0xFFFFF000UL;
+  for (int f = 0; f < 3; f++) {
+    cycle = recordFrame(trace, cycle, symbols, sizeof(symbols), 0, 0);
+  }
+
+  TraceReport report;
+  trace.analyze(&report);
+  CHECK(report.frames == 3);
+  CHECK(report.maxDriftNs == 0);
+  CHECK(report.burst.count == 3 * 9);
+  CHECK(report.burst.minErrorNs == 0 && report.burst.maxErrorNs == 0);
+  for (uint8_t s = 0; s < 4; s++) {
+    CHECK(report.pause[s].count == 3 * 2);
+    CHECK(report.pause[s].minErrorNs == 0 && report.pause[s].maxErrorNs == 0);
+  }
+}
+
+static void testErrors() {
+  static const uint8_t symbols[] = { 1, 1, 1, 1 };
+  SymbolTrace trace;
+  CHECK(trace.begin(64, CPU_MHZ));
+
+  // Long bursts with pauses shortened by the same amount keep the frame on time
+  recordFrame(trace, 1000, symbols, sizeof(symbols), 500, -500);
+
+  TraceReport report;
+  trace.analyze(&report);
+  CHECK(report.frames == 1);
+  CHECK(report.burst.count == 5);
+  CHECK(report.burst.minErrorNs == 500 && report.burst.maxErrorNs == 500);
+  CHECK(report.pause[1].count == 4);
+  CHECK(report.pause[1].minErrorNs == -500 && report.pause[1].maxErrorNs == -500);
+  CHECK(report.maxDriftNs == 0);
+
+  // Long pauses alone push every later burst further out
+  trace.clear();
+  recordFrame(trace, 1000, symbols, sizeof(symbols), 0, 250);
+  trace.analyze(&report);
+  CHECK(report.pause[1].minErrorNs == 250);
+  CHECK(report.maxDriftNs == 4 * 250);
+}
+
+static void testWrappedBuffer() {
+  static const uint8_t symbols[] = { 2, 0, 3 };
+  SymbolTrace trace;
+  // Room for one and a half frames of 12 events each
+  CHECK(trace.begin(18, CPU_MHZ));
+
+  uint32_t cycle = 0;
+  for (int f = 0; f < 4; f++) {
+    cycle = recordFrame(trace, cycle, symbols, sizeof(symbols), 0, 0);
+  }
+  CHECK(trace.getCount() == 18);
+
+  // The partial frame at the start of the buffer is skipped
+  TraceReport report;
+  trace.analyze(&report);
+  CHECK(report.frames == 1);
+  CHECK(report.burst.count == 4);
+}
+
+static void testVCD() {
+  static const uint8_t symbols[] = { 3, 0 };
+  SymbolTrace trace;
+  CHECK(trace.begin(64, CPU_MHZ));
+  recordFrame(trace, 0, symbols, sizeof(symbols), 0, 0);
+
+  Capture out;
+  out.length = 0;
+  trace.writeVCD(capture, &out);
+
+  CHECK(strstr(out.text, "$enddefinitions $end\n") != NULL);
+  // Three bursts, measured and intended, and one value per pause
+  CHECK(countLines(out.text, "1a\n") == 3);
+  CHECK(countLines(out.text, "0a\n") == 3 + 1);
+  CHECK(countLines(out.text, "1i\n") == 3);
+  CHECK(countLines(out.text, "0i\n") == 3 + 1);
+  CHECK(countLines(out.text, "b11 s\n") == 1);
+  CHECK(countLines(out.text, "b00 s\n") == 1 + 1);
+
+  // The intended waveform ends where the nominal timings put it, counted
+  // from the first burst 100 cycles after the frame start
+  char last[32];
+  snprintf(last, sizeof(last), "#%lu\n", (unsigned long)(100 * 1000 / CPU_MHZ + 3 * IR_BURST_ON_NS +
+                                                          (IR_PAUSE_US[3] + IR_PAUSE_US[0]) * 1000));
+  CHECK(strstr(out.text, last) != NULL);
+}
+
+int main() {
+  testExactTiming();
+  testErrors();
+  testWrappedBuffer();
+  testVCD();
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+// TagRegistry on a host directory: lookups, removal inside probe sequences,
+// groups, statistics written back, and everything found again after a restart
+
+#include "TagRegistry.h"
+#include "check.h"
+#include <string.h>
+
+#define STORE "build/tag_registry_store"
+#define TAGS 3000
+
+static uint32_t unixTime = 1700000000;
+static uint32_t nowMs = 0;
+
+static uint32_t unixClock() {
+  return unixTime;
+}
+
+static uint32_t millisClock() {
+  return nowMs;
+}
+
+// Distinct PLIDs for i below 100000: digits 2-6 step through every value
+static void makeBarcode(uint32_t i, char* out) {
+  snprintf(out, TAG_BARCODE_LENGTH + 1, "04%05u12345%05u", (unsigned)(i * 7919 % 100000), (unsigned)(i % 100000));
+}
+
+static void removeEntry(void* context, const char* name, uint32_t) {
+  ((SpoolStorage*)context)->remove(name);
+}
+
+static void testBarcodes() {
+  uint64_t value;
+  uint32_t plid;
+  CHECK(TagRegistry::parseBarcode("04123456789012345", &value, &plid));
+  CHECK(value == 4123456789012345ULL);
+  CHECK(plid == (uint32_t)(12345 + (67890UL << 16)));
+
+  char text[TAG_BARCODE_LENGTH + 1];
+  TagRegistry::formatBarcode(value, text);
+  CHECK(strcmp(text, "04123456789012345") == 0);
+
+  CHECK(!TagRegistry::parseBarcode("0412345678901234", &value, &plid));
+  CHECK(!TagRegistry::parseBarcode("041234567890123456", &value, &plid));
+  CHECK(!TagRegistry::parseBarcode("0412345678901234x", &value, &plid));
+  CHECK(!TagRegistry::parseBarcode("00000000000000000", &value, &plid));
+}
+
+static void testRegistry(SpoolStorage& storage, TagProfiles& profiles) {
+  TagRegistry registry(storage, profiles, unixClock, millisClock);
+  CHECK(registry.begin());
+  CHECK(registry.getCount() == 0);
+
+  uint16_t dairy;
+  uint16_t both;
+  CHECK(registry.parseGroups("dairy", &dairy));
+  CHECK(registry.parseGroups("aisle-5, dairy", &both));
+  CHECK(both == (dairy | (1 << registry.findGroup("aisle-5"))));
+  CHECK(!registry.parseGroups("no spaces", &both));
+  CHECK(!registry.parseGroups("a-name-longer-than-15", &both));
+
+  char barcode[TAG_BARCODE_LENGTH + 1];
+  for (uint32_t i = 0; i < TAGS; i++) {
+    makeBarcode(i, barcode);
+    CHECK(registry.put(barcode, i % 3 == 0 ? "dm-hd" : "", i % 10 == 5 ? dairy : 0));
+  }
+  CHECK(registry.getCount() == TAGS);
+  CHECK(!registry.put("04123456789012345", "no-such-model", 0));
+  CHECK(!registry.put("123", "", 0));
+
+  // Changing a tag keeps the count
+  makeBarcode(1, barcode);
+  CHECK(registry.put(barcode, "dm-hd", dairy));
+  CHECK(registry.getCount() == TAGS);
+  CHECK(strcmp(registry.profileFor(barcode).model, "dm-hd") == 0);
+  makeBarcode(2, barcode);
+  CHECK(strcmp(registry.profileFor(barcode).model, "default") == 0);
+
+  // Every tag is found, with its model and groups
+  for (uint32_t i = 0; i < TAGS; i++) {
+    makeBarcode(i, barcode);
+    const TagRecord* record = registry.find(barcode);
+    CHECK(record != NULL);
+    CHECK(registry.modelName(*record) == NULL || i % 3 == 0 || i == 1);
+    CHECK((record->groups == dairy) == (i % 10 == 5 || i == 1));
+  }
+  makeBarcode(TAGS, barcode);
+  CHECK(registry.find(barcode) == NULL);
+
+  // Removing every other tag must not cut the probe sequences of the rest
+  for (uint32_t i = 0; i < TAGS; i += 2) {
+    makeBarcode(i, barcode);
+    CHECK(registry.remove(barcode));
+  }
+  CHECK(!registry.remove(barcode));
+  CHECK(registry.getCount() == TAGS / 2);
+  for (uint32_t i = 0; i < TAGS; i++) {
+    makeBarcode(i, barcode);
+    CHECK((registry.find(barcode) != NULL) == (i % 2 == 1));
+  }
+
+  // Walking the table returns each tag once, and a group only its members
+  uint16_t position = 0;
+  TagRecord record;
+  uint32_t walked = 0;
+  while (registry.next(&position, &record)) {
+    walked++;
+  }
+  CHECK(walked == registry.getCount());
+  int8_t group = registry.findGroup("dairy");
+  uint32_t members = 0;
+  for (position = 0; registry.next(&position, &record, group); ) {
+    CHECK(record.groups & (1 << group));
+    members++;
+  }
+  CHECK(members == 1 + TAGS / 10);
+
+  // Sending registers unknown tags and keeps statistics in the cache
+  makeBarcode(TAGS + 1, barcode);
+  uint32_t plid = registry.useTag(barcode);
+  CHECK(plid != 0);
+  CHECK(registry.getCount() == TAGS / 2 + 1);
+  registry.recordAirtime(plid, 2500000);
+  registry.recordAirtime(plid, 1500000);
+  static const uint8_t payload[] = { 1, 2, 3, 4 };
+  registry.recordPayload(plid, 3, payload, sizeof(payload));
+  CHECK(registry.useTag("bad") == 0);
+
+  // Repeated lookups of one tag are served from the cache
+  uint32_t misses = registry.getCacheMisses();
+  for (int i = 0; i < 100; i++) {
+    CHECK(registry.find(barcode) != NULL);
+  }
+  CHECK(registry.getCacheMisses() == misses);
+
+  // Written back once the flush interval has passed
+  nowMs += TAG_REGISTRY_FLUSH_MS;
+  registry.service();
+}
+
+static void testReopen(SpoolStorage& storage, TagProfiles& profiles) {
+  TagRegistry registry(storage, profiles, unixClock, millisClock);
+  CHECK(registry.begin());
+  CHECK(registry.getCount() == TAGS / 2 + 1);
+  CHECK(registry.findGroup("aisle-5") >= 0);
+
+  char barcode[TAG_BARCODE_LENGTH + 1];
+  makeBarcode(TAGS + 1, barcode);
+  const TagRecord* record = registry.find(barcode);
+  CHECK(record != NULL);
+  CHECK(record->airtimeMs == 4000);
+  CHECK(record->lastSent == unixTime);
+  CHECK(record->pageHash[3] != 0 && record->pageHash[2] == 0);
+
+  makeBarcode(3, barcode);
+  record = registry.find(barcode);
+  CHECK(record != NULL && strcmp(registry.modelName(*record), "dm-hd") == 0);
+  makeBarcode(4, barcode);
+  CHECK(registry.find(barcode) == NULL);
+}
+
+static void testFull(SpoolStorage& storage, TagProfiles& profiles) {
+  storage.list(removeEntry, &storage);
+  TagRegistry registry(storage, profiles, unixClock, millisClock);
+  CHECK(registry.begin());
+
+  // Registration stops at the load limit, lookups still find every tag
+  char barcode[TAG_BARCODE_LENGTH + 1];
+  uint32_t i = 0;
+  for (; i < TAG_REGISTRY_MAX_TAGS; i++) {
+    makeBarcode(i, barcode);
+    CHECK(registry.put(barcode, "", 0));
+  }
+  makeBarcode(i, barcode);
+  CHECK(!registry.put(barcode, "", 0));
+  CHECK(strcmp(registry.getError(), "Tag registry is full") == 0);
+  CHECK(registry.useTag(barcode) == 0);
+
+  uint32_t lookups = registry.getLookups();
+  uint32_t misses = registry.getCacheMisses();
+  for (i = 0; i < TAG_REGISTRY_MAX_TAGS; i += 7) {
+    makeBarcode(i, barcode);
+    CHECK(registry.find(barcode) != NULL);
+  }
+  printf("full table: %u tags, %u lookups, %u cache misses\n", (unsigned)registry.getCount(),
+         (unsigned)(registry.getLookups() - lookups), (unsigned)(registry.getCacheMisses() - misses));
+}
+
+int main() {
+  DirSpoolStorage storage(STORE);
+  CHECK(storage.begin());
+  storage.list(removeEntry, &storage);
+
+  TagProfiles profiles;
+  static const char TABLE[] = "profile dm-hd size=296x128 planes=2\n";
+  CHECK(profiles.load(TABLE, sizeof(TABLE) - 1));
+
+  testBarcodes();
+  testRegistry(storage, profiles);
+  testReopen(storage, profiles);
+  testFull(storage, profiles);
+  printf("ok\n");
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+# Compress the web UI and write it as a PROGMEM array into WebUI.h
+#
+# Run from the repository root after editing ui/index.html:
+#   python3 ui/embed.py
+# The output only depends on the input, so an unchanged page keeps its ETag
+
+import gzip
+import hashlib
+import os
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, "ui", "index.html")
+TARGET = os.path.join(ROOT, "WebUI.h")
+
+
+def main():
+    with open(SOURCE, "rb") as f:
+        html = f.read()
+
+    # mtime=0 keeps the gzip header, and with it the ETag, reproducible
+    data = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(data).hexdigest()[:16]
+
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]))
+
+    with open(TARGET, "w") as f:
+        f.write("#ifndef WEB_UI_H\n#define WEB_UI_H\n\n")
+        f.write("// Control page, gzip compressed. Generated by ui/embed.py from\n")
+        f.write("// ui/index.html (%d bytes), do not edit\n\n" % len(html))
+        f.write("#include <Arduino.h>\n\n")
+        f.write("#define WEB_UI_INDEX_ETAG \"\\\"%s\\\"\"\n" % etag)
+        f.write("#define WEB_UI_INDEX_GZ_LENGTH %d\n\n" % len(data))
+        f.write("static const uint8_t WEB_UI_INDEX_GZ[] PROGMEM = {\n")
+        f.write(",\n".join(rows))
+        f.write("\n};\n\n#endif")
+
+    print("%s: %d -> %d bytes, ETag %s" % (os.path.relpath(TARGET, ROOT), len(html), len(data), etag))
+
+
+if __name__ == "__main__":
+    main()